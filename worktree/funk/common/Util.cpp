@@ -3,6 +3,16 @@
 #include "Debug.h"
 #include <fstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 using namespace funk;
 
 char * TextFileRead( const char * fileName, int * numBytes )
@@ -28,4 +38,51 @@ char * TextFileRead( const char * fileName, int * numBytes )
 	if ( numBytes ) *numBytes = size;
 
 	return data;
-}
\ No newline at end of file
+}
+
+MappedFile::MappedFile( const char * fileName ) : m_data(0), m_size(0)
+{
+#ifdef _WIN32
+	m_mapping = 0;
+	m_file = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( m_file == INVALID_HANDLE_VALUE ) 
+	{
+		m_file = 0;
+		return;
+	}
+
+	m_size = (int)GetFileSize( m_file, NULL );
+	if ( m_size <= 0 ) return;
+
+	m_mapping = CreateFileMappingA( m_file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( m_mapping ) m_data = (const char *)MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+#else
+	int fd = open( fileName, O_RDONLY );
+	if ( fd < 0 ) return;
+
+	struct stat info;
+	if ( fstat( fd, &info ) == 0 && info.st_size > 0 )
+	{
+		void * data = mmap( 0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( data != MAP_FAILED )
+		{
+			m_data = (const char *)data;
+			m_size = (int)info.st_size;
+		}
+	}
+
+	// the mapping keeps its own reference to the file
+	close( fd );
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if ( m_data ) UnmapViewOfFile( m_data );
+	if ( m_mapping ) CloseHandle( m_mapping );
+	if ( m_file ) CloseHandle( m_file );
+#else
+	if ( m_data ) munmap( (void *)m_data, (size_t)m_size );
+#endif
+}
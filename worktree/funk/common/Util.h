@@ -3,6 +3,29 @@
 
 char * TextFileRead( const char * file, int * numBytes = 0 );
 
+// read only view of a whole file mapped into memory, pages are loaded on first touch and never copied to the heap
+class MappedFile
+{
+public:
+	MappedFile( const char * file );
+	~MappedFile();
+
+	bool IsOpen() const { return m_data != 0; }
+	const char * GetData() const { return m_data; }
+	int GetSize() const { return m_size; }
+
+private:
+	const char * m_data;
+	int m_size;
+#ifdef _WIN32
+	void * m_file;
+	void * m_mapping;
+#endif
+
+	MappedFile( const MappedFile & );
+	MappedFile & operator=( const MappedFile & );
+};
+
 inline int IsLittleEndian() 
 {
 	union 
@@ -0,0 +1,265 @@
+/*
+    _____               __  ___          __            ____        _      __
+   / ___/__ ___ _  ___ /  |/  /__  ___  / /_____ __ __/ __/_______(_)__  / /_
+  / (_ / _ `/  ' \/ -_) /|_/ / _ \/ _ \/  '_/ -_) // /\ \/ __/ __/ / _ \/ __/
+  \___/\_,_/_/_/_/\__/_/  /_/\___/_//_/_/\_\\__/\_, /___/\__/_/ /_/ .__/\__/
+                                               /___/             /_/
+
+  See Copyright Notice in gmMachine.h
+
+*/
+
+#include "gmConfig.h"
+#include "gmAllocProfiler.h"
+
+#if GMMACHINE_ALLOCPROFILER
+
+#include "gmMachine.h"
+#include "gmThread.h"
+#include "gmFunctionObject.h"
+
+#include <limits.h>
+#include <algorithm>
+
+static const char * s_ageNames[gmAllocProfiler::NUM_AGES] = { "0", "1", "2-3", "4-7", "8-15", "16+" };
+
+//
+//
+// Implementation of gmAllocProfiler
+//
+//
+
+gmAllocProfiler::gmAllocProfiler()
+{
+  Reset();
+}
+
+
+
+void gmAllocProfiler::Reset()
+{
+  m_siteIndex.clear();
+  m_sites.clear();
+  m_types.clear();
+  m_live.clear();
+
+  // site 0 is everything allocated outside a script function
+  Site host;
+  host.m_name = "(host)";
+  memset(&host.m_stats, 0, sizeof(Stats));
+  m_sites.push_back(host);
+}
+
+
+
+void gmAllocProfiler::Allocated(gmMachine * a_machine, gmObject * a_object, int a_bytes)
+{
+  Record record;
+  record.m_site = GetSite(a_machine);
+  record.m_type = a_object->GetType();
+  record.m_bytes = a_bytes;
+  record.m_birthTime = a_machine->GetTime();
+  record.m_birthCycle = GetCycle(a_machine);
+
+  m_live[a_object] = record;
+
+  Stats * stats[2];
+  stats[0] = &m_sites[record.m_site].m_stats;
+  std::map<int, Type>::iterator type = m_types.find(record.m_type);
+  if(type == m_types.end())
+  {
+    type = m_types.insert(std::make_pair(record.m_type, Type())).first;
+    const char * name = a_machine->GetTypeName((gmType) record.m_type);
+    type->second.m_name = (name) ? name : "?";
+    memset(&type->second.m_stats, 0, sizeof(Stats));
+  }
+  stats[1] = &type->second.m_stats;
+
+  int i;
+  for(i = 0; i < 2; ++i)
+  {
+    ++stats[i]->m_allocs;
+    stats[i]->m_bytes += a_bytes;
+    stats[i]->m_liveBytes += a_bytes;
+  }
+}
+
+
+
+void gmAllocProfiler::Freed(gmMachine * a_machine, gmObject * a_object)
+{
+  // a function object's address may be reused by another function, its sites are complete
+  if(a_object->GetType() == GM_FUNCTION)
+  {
+    const gmFunctionObject * fn = (const gmFunctionObject *) a_object;
+    m_siteIndex.erase(m_siteIndex.lower_bound(SiteKey(fn, INT_MIN)), m_siteIndex.upper_bound(SiteKey(fn, INT_MAX)));
+  }
+
+  std::map<const gmObject *, Record>::iterator it = m_live.find(a_object);
+  if(it == m_live.end()) return;
+
+  const Record &record = it->second;
+  const int age = GetAge(GetCycle(a_machine) - record.m_birthCycle);
+
+  Stats * stats[2];
+  stats[0] = &m_sites[record.m_site].m_stats;
+  stats[1] = &m_types[record.m_type].m_stats;
+
+  int i;
+  for(i = 0; i < 2; ++i)
+  {
+    ++stats[i]->m_frees;
+    stats[i]->m_liveBytes -= record.m_bytes;
+    stats[i]->m_lifetime += (double) (a_machine->GetTime() - record.m_birthTime);
+    ++stats[i]->m_freedAge[age];
+  }
+
+  m_live.erase(it);
+}
+
+
+
+int gmAllocProfiler::GetSite(gmMachine * a_machine)
+{
+  gmThread * thread = a_machine->GetCurrentThread();
+  if(thread == NULL) return 0;
+
+  // natives and operators allocate for the script function that called them, found as gmThread::LogCallStack walks
+  const gmVariable * base = thread->GetBase();
+  const gmuint8 * ip = thread->GetInstruction();
+  const gmStackFrame * frame = thread->GetFrame();
+
+  while(frame)
+  {
+    const gmVariable * fnVar = base - 1;
+    if(fnVar->m_type == GM_FUNCTION)
+    {
+      const gmFunctionObject * fn = (const gmFunctionObject *) GM_MOBJECT(a_machine, fnVar->m_value.m_ref);
+      if(fn->GetByteCode())
+      {
+        const int line = (ip) ? fn->GetLine(ip) : 0;
+        std::map<SiteKey, int>::iterator it = m_siteIndex.find(SiteKey(fn, line));
+        if(it != m_siteIndex.end()) return it->second;
+
+        const char * source = NULL;
+        const char * file = NULL;
+        if(!a_machine->GetSourceCode(fn->GetSourceId(), source, file) || !file) file = "?";
+        const char * slash = strrchr(file, '/');
+        if(slash) file = slash + 1;
+
+        char name[256];
+        _gmsnprintf(name, sizeof(name), "%s (%s:%d)", fn->GetDebugName(), file, line);
+        name[sizeof(name) - 1] = '\0';
+
+        Site site;
+        site.m_name = name;
+        memset(&site.m_stats, 0, sizeof(Stats));
+        m_sites.push_back(site);
+
+        const int index = (int) m_sites.size() - 1;
+        m_siteIndex[SiteKey(fn, line)] = index;
+        return index;
+      }
+    }
+
+    base = thread->GetBottom() + frame->m_returnBase;
+    ip = frame->m_returnAddress;
+    frame = frame->m_prev;
+  }
+
+  return 0;
+}
+
+
+
+int gmAllocProfiler::GetCycle(gmMachine * a_machine)
+{
+  // completed cycles, the counts go up after the collect so objects it frees did not survive it; a nursery
+  // collection is a cycle for the objects it frees or promotes
+  return a_machine->GetStatsGCNumIncCollects() + a_machine->GetStatsGCNumFullCollects() + a_machine->GetStatsGCNumMinorCollects();
+}
+
+
+
+int gmAllocProfiler::GetAge(int a_cycles)
+{
+  int age = 0;
+  while(a_cycles > 0 && age < NUM_AGES - 1)
+  {
+    a_cycles >>= 1;
+    ++age;
+  }
+  return age;
+}
+
+
+
+void gmAllocProfiler::Print(FILE * a_fp, gmMachine * a_machine, int a_top) const
+{
+  // ages of the objects still live
+  const int now = GetCycle(a_machine);
+  std::vector<int> siteLiveAge(m_sites.size() * NUM_AGES, 0);
+  std::map<int, std::vector<int> > typeLiveAge;
+  std::map<const gmObject *, Record>::const_iterator live;
+  for(live = m_live.begin(); live != m_live.end(); ++live)
+  {
+    const int age = GetAge(now - live->second.m_birthCycle);
+    ++siteLiveAge[live->second.m_site * NUM_AGES + age];
+    std::vector<int> &typeAge = typeLiveAge[live->second.m_type];
+    typeAge.resize(NUM_AGES, 0);
+    ++typeAge[age];
+  }
+
+  Stats total;
+  memset(&total, 0, sizeof(Stats));
+  std::vector< std::pair<double, int> > order;
+  int i, j;
+  for(i = 0; i < (int) m_sites.size(); ++i)
+  {
+    const Stats &stats = m_sites[i].m_stats;
+    total.m_allocs += stats.m_allocs;
+    total.m_frees += stats.m_frees;
+    total.m_bytes += stats.m_bytes;
+    total.m_liveBytes += stats.m_liveBytes;
+    if(stats.m_allocs) order.push_back(std::make_pair(-stats.m_bytes, i));
+  }
+  std::sort(order.begin(), order.end());
+
+  fprintf(a_fp, "allocation profile, %d allocations, %.0f bytes, %d live objects, %.0f live bytes, %d gc cycles"GM_NL,
+    total.m_allocs, total.m_bytes, total.m_allocs - total.m_frees, total.m_liveBytes, now);
+  fprintf(a_fp, "  survived is the number of objects by gc cycles survived, freed / live, for cycles");
+  for(j = 0; j < NUM_AGES; ++j) fprintf(a_fp, " %s", s_ageNames[j]);
+  fprintf(a_fp, GM_NL GM_NL);
+
+  fprintf(a_fp, "  sites by bytes allocated"GM_NL);
+  for(i = 0; i < (int) order.size() && i < a_top; ++i)
+  {
+    const Site &site = m_sites[order[i].second];
+    PrintStats(a_fp, site.m_name.c_str(), site.m_stats, &siteLiveAge[order[i].second * NUM_AGES]);
+  }
+
+  fprintf(a_fp, GM_NL"  types"GM_NL);
+  std::map<int, Type>::const_iterator type;
+  for(type = m_types.begin(); type != m_types.end(); ++type)
+  {
+    static const int noneLive[NUM_AGES] = { 0 };
+    std::map<int, std::vector<int> >::const_iterator typeAge = typeLiveAge.find(type->first);
+    PrintStats(a_fp, type->second.m_name.c_str(), type->second.m_stats, (typeAge != typeLiveAge.end()) ? &typeAge->second[0] : noneLive);
+  }
+}
+
+
+
+void gmAllocProfiler::PrintStats(FILE * a_fp, const char * a_name, const Stats &a_stats, const int * a_liveAge) const
+{
+  fprintf(a_fp, "  %s"GM_NL, a_name);
+  fprintf(a_fp, "    %d allocs, %.0f bytes, %d live, %.0f live bytes, %.1f ms average life of the freed"GM_NL,
+    a_stats.m_allocs, a_stats.m_bytes, a_stats.m_allocs - a_stats.m_frees, a_stats.m_liveBytes,
+    (a_stats.m_frees) ? a_stats.m_lifetime / a_stats.m_frees : 0.0);
+  fprintf(a_fp, "    survived");
+  int j;
+  for(j = 0; j < NUM_AGES; ++j) fprintf(a_fp, " %d/%d", a_stats.m_freedAge[j], a_liveAge[j]);
+  fprintf(a_fp, GM_NL);
+}
+
+#endif // GMMACHINE_ALLOCPROFILER
@@ -0,0 +1,105 @@
+/*
+    _____               __  ___          __            ____        _      __
+   / ___/__ ___ _  ___ /  |/  /__  ___  / /_____ __ __/ __/_______(_)__  / /_
+  / (_ / _ `/  ' \/ -_) /|_/ / _ \/ _ \/  '_/ -_) // /\ \/ __/ __/ / _ \/ __/
+  \___/\_,_/_/_/_/\__/_/  /_/\___/_//_/_/\_\\__/\_, /___/\__/_/ /_/ .__/\__/
+                                               /___/             /_/
+
+  See Copyright Notice in gmMachine.h
+
+*/
+
+#ifndef _GMALLOCPROFILER_H_
+#define _GMALLOCPROFILER_H_
+
+#include "gmConfig.h"
+
+#if GMMACHINE_ALLOCPROFILER
+
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class gmMachine;
+class gmObject;
+class gmFunctionObject;
+
+/// \class gmAllocProfiler
+/// \brief gmAllocProfiler records each object allocation by site (script function and line) and by type, with the bytes,
+///        the lifetime and the number of garbage collection cycles the object survived.  Attach one with
+///        gmMachine::EnableAllocProfiler().  Names and lines need scripts compiled in debug mode.
+///        Bytes are those counted at allocation, the object and string characters.  Table nodes and function byte code
+///        allocated later are not included.
+class gmAllocProfiler
+{
+public:
+
+  /// \brief survivor histogram buckets, objects that survived 0, 1, 2-3, 4-7, 8-15 and 16 or more cycles
+  enum { NUM_AGES = 6 };
+
+  struct Stats
+  {
+    int m_allocs;
+    int m_frees;
+    double m_bytes;               //!< bytes allocated
+    double m_liveBytes;           //!< bytes allocated and not yet freed
+    double m_lifetime;            //!< machine ms lived by the freed objects
+    int m_freedAge[NUM_AGES];     //!< freed objects by the cycles they survived
+  };
+
+  gmAllocProfiler();
+
+  void Reset();
+
+  /// \brief Allocated() records a_object as allocated by the current thread at its current instruction.
+  void Allocated(gmMachine * a_machine, gmObject * a_object, int a_bytes);
+
+  /// \brief Freed() records the end of a_object, ignoring objects allocated before the profiler was attached.
+  void Freed(gmMachine * a_machine, gmObject * a_object);
+
+  /// \brief Print() will print the a_top sites by bytes allocated, the types, and survivor histograms including the
+  ///        live objects.
+  void Print(FILE * a_fp, gmMachine * a_machine, int a_top) const;
+
+  inline int GetNumLive() const { return (int) m_live.size(); }
+
+private:
+
+  struct Site
+  {
+    std::string m_name;           //!< "function (file:line)"
+    Stats m_stats;
+  };
+
+  struct Type
+  {
+    std::string m_name;
+    Stats m_stats;
+  };
+
+  struct Record
+  {
+    int m_site;
+    int m_type;
+    int m_bytes;
+    gmuint32 m_birthTime;
+    int m_birthCycle;
+  };
+
+  typedef std::pair<const gmFunctionObject *, int> SiteKey;
+
+  std::map<SiteKey, int> m_siteIndex; //!< sites of live function objects, by function and line
+  std::vector<Site> m_sites;
+  std::map<int, Type> m_types;
+  std::map<const gmObject *, Record> m_live;
+
+  int GetSite(gmMachine * a_machine);
+  static int GetCycle(gmMachine * a_machine);
+  static int GetAge(int a_cycles);
+  void PrintStats(FILE * a_fp, const char * a_name, const Stats &a_stats, const int * a_liveAge) const;
+};
+
+#endif // GMMACHINE_ALLOCPROFILER
+
+#endif // _GMALLOCPROFILER_H_
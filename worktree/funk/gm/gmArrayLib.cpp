@@ -289,6 +289,10 @@ static void GM_CDECL gmArraySetInd(gmThread * a_thread, gmVariable * a_operands)
     {
       a_thread->GetMachine()->GetGC()->WriteBarrier((gmObject*)oldVar.m_value.m_ref);
     }
+    if(a_operands[2].IsReference())
+    {
+      a_thread->GetMachine()->GetGC()->WriteBarrierStore(arrayObject, (gmObject*)a_operands[2].m_value.m_ref);
+    }
 #endif //GM_USE_INCGC
 
     array->SetAt(index, a_operands[2]);
@@ -0,0 +1,1089 @@
+#include "gmBench.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdarg.h>
+
+#include <common/Util.h>
+#include <common/Timer.h>
+#include <vm/GCPacer.h>
+#include <vm/GCMarker.h>
+#include <math/FloatBuffer.h>
+#include <math/v2.h>
+
+#include "gmMachine.h"
+#include "gmTableObject.h"
+#include "gmStringLib.h"
+#include "gmMathLib.h"
+#include "gmStreamBuffer.h"
+#include "gmByteCodeOpt.h"
+#include "gmSampleProfiler.h"
+#include "gmAllocProfiler.h"
+#include "gmBind.h"
+#include "gmUtilEx.h"
+
+#include <SDL_timer.h>
+
+using namespace funk;
+
+void gmBenchmarkLoad( gmMachine *vm, const char ** files, int numFiles, int iterations )
+{
+	// compile each script to a lib next to it
+	std::vector<std::string> libs;
+	int sourceBytes = 0;
+	int libBytes = 0;
+
+	for( int i = 0; i < numFiles; ++i )
+	{
+		int numBytes;
+		char * code = TextFileRead( files[i], &numBytes );
+		if ( !code ) return;
+
+		gmStreamBufferDynamic lib;
+		int err = vm->CompileStringToLib( code, lib );
+		delete [] code;
+
+		if ( err )
+		{
+			printf("BenchmarkLoad: failed to compile '%s'\n", files[i] );
+			vm->GetLog().Reset();
+			return;
+		}
+
+		std::string libFile = std::string(files[i]) + "lib";
+		std::ofstream fh( libFile.c_str(), std::ios::binary );
+		fh.write( lib.GetData(), lib.GetSize() );
+		fh.close();
+
+		libs.push_back( libFile );
+		sourceBytes += numBytes;
+		libBytes += lib.GetSize();
+	}
+
+	int threadId;
+	float textMs, readMs, mapMs;
+
+	// source text, read and compiled every time
+	{
+		Timer timer;
+		for( int n = 0; n < iterations; ++n )
+		{
+			for( int i = 0; i < numFiles; ++i )
+			{
+				char * code = TextFileRead( files[i] );
+				vm->ExecuteString( code, &threadId, true, files[i] );
+				delete [] code;
+			}
+		}
+		textMs = timer.GetTimeMs();
+	}
+
+	// lib read into a heap buffer
+	{
+		Timer timer;
+		for( int n = 0; n < iterations; ++n )
+		{
+			for( size_t i = 0; i < libs.size(); ++i )
+			{
+				int numBytes;
+				char * lib = TextFileRead( libs[i].c_str(), &numBytes );
+				gmStreamBufferStatic readBuffer( lib, numBytes );
+				vm->ExecuteLib( readBuffer, &threadId, true, libs[i].c_str() );
+				delete [] lib;
+			}
+		}
+		readMs = timer.GetTimeMs();
+	}
+
+	// lib mapped and bound in place
+	{
+		Timer timer;
+		for( int n = 0; n < iterations; ++n )
+		{
+			for( size_t i = 0; i < libs.size(); ++i )
+			{
+				gmExecuteLibFile( vm, libs[i].c_str() );
+			}
+		}
+		mapMs = timer.GetTimeMs();
+	}
+
+	for( size_t i = 0; i < libs.size(); ++i ) remove( libs[i].c_str() );
+
+	printf("BenchmarkLoad: %d files, %d source bytes, %d lib bytes, %d iterations\n", numFiles, sourceBytes, libBytes, iterations );
+	printf("  text: %.2f ms per load\n", textMs / iterations );
+	printf("  lib read: %.2f ms per load (%d bytes copied to heap)\n", readMs / iterations, libBytes );
+	printf("  lib mmap: %.2f ms per load\n", mapMs / iterations );
+}
+
+void gmBenchmarkCompile( gmMachine *vm, const char ** files, int numFiles, int numThreads, int iterations )
+{
+	// file counts double up to this, cycling through the files given
+	const int maxFiles = 64;
+
+	std::vector<const char*> names;
+	for( int i = 0; i < maxFiles; ++i ) names.push_back( files[i % numFiles] );
+
+	printf("BenchmarkCompile: %d scripts, %d threads, %d iterations, compiled to libs and bound (not executed)\n", numFiles, numThreads, iterations );
+
+	for( int count = 1; count <= maxFiles; count *= 2 )
+	{
+		float ms[2];
+
+		for( int pass = 0; pass < 2; ++pass )
+		{
+			Timer timer;
+			for( int n = 0; n < iterations; ++n )
+			{
+				const int failed = gmCompileBindFiles( vm, &names[0], count, pass ? numThreads : 1 );
+				if ( failed )
+				{
+					printf("BenchmarkCompile: %d of %d files failed to compile\n", failed, count );
+					return;
+				}
+			}
+			ms[pass] = timer.GetTimeMs() / iterations;
+		}
+
+		printf("  %2d files: 1 thread %8.2f ms %7.0f files/s, %d threads %8.2f ms %7.0f files/s, x%.2f\n", count, 
+			ms[0], count * 1000.0f / ms[0], numThreads, ms[1], count * 1000.0f / ms[1], ms[0] / ms[1] );
+	}
+}
+
+// The benchmarks below each run on a machine of their own.  Execute() can't be called from inside a running script,
+// and a fresh heap, string pool and thread pool keep what one benchmark leaves behind out of the next one's numbers.
+class gmBenchmarkMachine : public gmMachine
+{
+public:
+	gmBenchmarkMachine() : m_bytes(0) {}
+
+	// runs a script built from a printf format, how the benchmarks pass their sizes in
+	void Run( const char * a_format, ... )
+	{
+		char script[512];
+		va_list args;
+		va_start( args, a_format );
+		Format( script, sizeof(script), a_format, args );
+		va_end( args );
+		ExecuteString( script );
+	}
+
+	// runs a script body a_iterations times in one loop, r counting the iterations, and returns the time taken in ms.
+	// GetBytes() is then what the loop allocated.
+	float Time( int a_iterations, const char * a_format, ... )
+	{
+		char body[384];
+		va_list args;
+		va_start( args, a_format );
+		Format( body, sizeof(body), a_format, args );
+		va_end( args );
+
+		char script[512];
+		sprintf( script, "for(r = 0; r < %d; r += 1) { %s }", a_iterations, body );
+
+		const int memBefore = GetCurrentMemoryUsage();
+		Timer timer;
+		ExecuteString( script );
+		const float ms = timer.GetTimeMs();
+		m_bytes = GetCurrentMemoryUsage() - memBefore;
+		return ms;
+	}
+
+	int GetBytes() const { return m_bytes; }
+
+	// a count the script keeps in a global table, as g_wakes.count
+	int GetCount( const char * a_table, const char * a_field )
+	{
+		gmTableObject * table = GetGlobals()->Get( this, a_table ).GetTableObjectSafe();
+		return table ? table->Get( this, a_field ).GetInt() : 0;
+	}
+
+private:
+	static void Format( char * a_buffer, int a_size, const char * a_format, va_list a_args )
+	{
+		_gmvsnprintf( a_buffer, a_size, a_format, a_args );
+		a_buffer[a_size - 1] = '\0';
+	}
+
+	int m_bytes;
+};
+
+void gmBenchmarkSleep( int numThreads, int frames )
+{
+	gmBenchmarkMachine machine;
+
+	// periods of 1 to 97 frames at 60Hz, so every frame wakes a different mix of threads
+	machine.ExecuteString(
+		"global g_wakes = { count = 0 };"
+		"global Sleeper = function(seconds) { while(true) { sleep(seconds); g_wakes.count += 1; } };"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { thread(Sleeper, ((i % 97) + 1) / 60.0f); } };" );
+
+	// every thread runs to its first sleep
+	Timer spawnTimer;
+	machine.Run( "Spawn(%d);", numThreads );
+	machine.Execute( 0 );
+	float spawnMs = spawnTimer.GetTimeMs();
+
+	Timer frameTimer;
+	for( int i = 0; i < frames; ++i )
+	{
+		machine.Execute( 16 );
+	}
+	float frameMs = frameTimer.GetTimeMs();
+
+	int wakes = machine.GetCount( "g_wakes", "count" );
+
+	printf("BenchmarkSleep: %d threads, %d frames\n", numThreads, frames );
+	printf("  spawn and first sleep: %.2f ms (%.0f sleeps/ms)\n", spawnMs, numThreads / (spawnMs > 0.0f ? spawnMs : 0.001f) );
+	printf("  %.3f ms per frame, %d wakes per frame\n", frameMs / frames, wakes / (frames > 0 ? frames : 1) );
+}
+
+void gmBenchmarkSignal( int numThreads, int frames, int signalsPerFrame )
+{
+	gmBenchmarkMachine machine;
+
+	// every thread waits on an event of its own and on one event shared by all of them
+	machine.ExecuteString(
+		"global g_wakes = { count = 0 };"
+		"global g_events = {};"
+		"global g_ids = {};"
+		"global Waiter = function(ev) { while(true) { block(ev, \"shared\"); g_wakes.count += 1; } };"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { ev = {}; g_events[i] = ev; g_ids[i] = thread(Waiter, ev); } };"
+		"global Broadcast = function(n, first, count) { for(i = 0; i < count; i += 1) { signal(g_events[(first + i) % n]); } };"
+		"global Directed = function(n, first, count) { for(i = 0; i < count; i += 1) { signal(\"shared\", g_ids[(first + i) % n]); } };" );
+
+	// every thread runs to its first block
+	Timer spawnTimer;
+	machine.Run( "Spawn(%d);", numThreads );
+	machine.Execute( 0 );
+	float spawnMs = spawnTimer.GetTimeMs();
+
+	// signal on each thread's own event
+	Timer broadcastTimer;
+	for( int i = 0; i < frames; ++i )
+	{
+		machine.Run( "Broadcast(%d, %d, %d);", numThreads, i * signalsPerFrame, signalsPerFrame );
+		machine.Execute( 16 );
+	}
+	float broadcastMs = broadcastTimer.GetTimeMs();
+
+	// signal the shared event at one thread at a time
+	Timer directedTimer;
+	for( int i = 0; i < frames; ++i )
+	{
+		machine.Run( "Directed(%d, %d, %d);", numThreads, i * signalsPerFrame, signalsPerFrame );
+		machine.Execute( 16 );
+	}
+	float directedMs = directedTimer.GetTimeMs();
+
+	int wakes = machine.GetCount( "g_wakes", "count" );
+
+	printf("BenchmarkSignal: %d threads, %d frames, %d signals per frame\n", numThreads, frames, signalsPerFrame );
+	printf("  spawn and first block: %.2f ms\n", spawnMs );
+	printf("  %.3f ms per frame signalling distinct events\n", broadcastMs / frames );
+	printf("  %.3f ms per frame signalling a shared event by thread id\n", directedMs / frames );
+	printf("  %d wakes\n", wakes );
+}
+
+static void gmBenchmarkGCRun( int numEntities, int frames, int memLimit, int nurseryLimit )
+{
+	gmBenchmarkMachine machine;
+	machine.SetAutoMemoryUsage( false );
+	machine.SetDesiredByteMemoryUsageHard( memLimit );
+	machine.SetDesiredByteMemoryUsageSoft( memLimit * 9 / 10 );
+	machine.GetGC()->SetNurseryLimit( nurseryLimit );
+
+	// long lived entities, each frame makes log strings, draw closures and tables that die young,
+	// and hands a few young objects to the old entities
+	machine.ExecuteString(
+		"global g_world = {};"
+		"global g_log = { count = 0, last = null };"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { g_world[i] = { id = i, name = \"ent\" + i, kids = {} }; } };"
+		"global Entity = function(n, seed) {"
+		"  frame = 0;"
+		"  while(true) {"
+		"    frame += 1;"
+		"    for(i = 0; i < 20; i += 1) {"
+		"      draw = { fn = function(x) { return x + 1; }, args = { i, frame } };"
+		"      g_log.last = \"frame \" + frame + \" entity \" + seed + \" step \" + i;"
+		"      g_log.count += 1;"
+		"    }"
+		"    e = g_world[(seed * 7 + frame) % n];"
+		"    e.kids[frame % 4] = { born = frame, tag = \"kid\" + frame };"
+		"    yield();"
+		"  }"
+		"};"
+		"global Start = function(n, threads) { Spawn(n); for(i = 0; i < threads; i += 1) { thread(Entity, n, i); } };" );
+
+	machine.Run( "Start(%d, 8);", numEntities );
+
+	float totalMs = 0.0f;
+	float worstMs = 0.0f;
+	for( int i = 0; i < frames; ++i )
+	{
+		machine.Execute( 16, false );
+
+		Timer gcTimer;
+		machine.CollectGarbage();
+		float gcMs = gcTimer.GetTimeMs();
+		totalMs += gcMs;
+		if ( gcMs > worstMs ) worstMs = gcMs;
+	}
+
+	printf("  nursery %5d: %4d full, %4d inc, %5d minor collects, %d warnings, %.3f ms gc per frame, worst %.3f ms\n",
+		nurseryLimit, machine.GetStatsGCNumFullCollects(), machine.GetStatsGCNumIncCollects(), machine.GetStatsGCNumMinorCollects(),
+		machine.GetStatsGCNumWarnings(), totalMs / frames, worstMs );
+}
+
+void gmBenchmarkGC( int numEntities, int frames, int memLimit )
+{
+	printf("BenchmarkGC: %d entities, %d frames, %d byte memory limit\n", numEntities, frames, memLimit );
+	gmBenchmarkGCRun( numEntities, frames, memLimit, 0 );
+	gmBenchmarkGCRun( numEntities, frames, memLimit, GM_GC_DEFAULT_NURSERY_LIMIT );
+}
+
+static void gmBenchmarkGCPacingRun( int numEntities, int frames, int memTarget, float budgetMs, bool paced )
+{
+	gmBenchmarkMachine machine;
+	machine.SetAutoMemoryUsage( false );
+	machine.SetDesiredByteMemoryUsageHard( memTarget * 2 );
+	machine.SetDesiredByteMemoryUsageSoft( memTarget );
+	machine.GetGC()->SetWorkPerIncrement( 400 );
+	machine.GetGC()->SetDestructPerIncrement( 250 );
+
+	// long lived entities, and temporaries made at a rate the host changes from frame to frame
+	machine.ExecuteString(
+		"global g_world = {};"
+		"global g_load = { steps = 1 };"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { g_world[i] = { id = i, name = \"ent\" + i, kids = {} }; } };"
+		"global Entity = function(n, seed) {"
+		"  frame = 0;"
+		"  while(true) {"
+		"    frame += 1;"
+		"    for(i = 0; i < g_load.steps; i += 1) {"
+		"      draw = { fn = function(x) { return x + 1; }, args = { i, frame } };"
+		"      msg = \"frame \" + frame + \" entity \" + seed + \" step \" + i;"
+		"    }"
+		"    e = g_world[(seed * 7 + frame) % n];"
+		"    e.kids[frame % 4] = { born = frame, tag = \"kid\" + frame };"
+		"    yield();"
+		"  }"
+		"};"
+		"global Start = function(n, threads) { Spawn(n); for(i = 0; i < threads; i += 1) { thread(Entity, n, i); } };" );
+
+	machine.Run( "Start(%d, 8);", numEntities );
+
+	GCPacer pacer;
+	if ( paced ) pacer.Init( &machine, budgetMs, memTarget );
+
+	gmTableObject * load = machine.GetGlobals()->Get( &machine, "g_load" ).GetTableObjectSafe();
+
+	float totalMs = 0.0f;
+	float worstMs = 0.0f;
+	int overBudget = 0;
+	int maxMem = 0;
+	for( int i = 0; i < frames; ++i )
+	{
+		// quiet, busy and bursting stretches
+		const int phase = ( i / 100 ) % 3;
+		const int steps = phase == 0 ? 2 : phase == 1 ? 10 : 40;
+		load->Set( &machine, "steps", gmVariable( steps ) );
+
+		machine.Execute( 16, false );
+
+		float gcMs;
+		if ( paced )
+		{
+			gcMs = pacer.Collect();
+		}
+		else
+		{
+			Timer gcTimer;
+			machine.CollectGarbage();
+			gcMs = gcTimer.GetTimeMs();
+		}
+
+		totalMs += gcMs;
+		if ( gcMs > worstMs ) worstMs = gcMs;
+		if ( gcMs > budgetMs ) ++overBudget;
+		if ( machine.GetCurrentMemoryUsage() > maxMem ) maxMem = machine.GetCurrentMemoryUsage();
+	}
+
+	printf("  %s: %.3f ms gc per frame, worst %.3f ms, %d frames over budget, %d full, %d inc collects, %d warnings, %d bytes max\n",
+		paced ? "paced " : "static", totalMs / frames, worstMs, overBudget, machine.GetStatsGCNumFullCollects(),
+		machine.GetStatsGCNumIncCollects(), machine.GetStatsGCNumWarnings(), maxMem );
+}
+
+void gmBenchmarkGCPacing( int numEntities, int frames, int memTarget, float budgetMs )
+{
+	printf("BenchmarkGCPacing: %d entities, %d frames, %d byte memory target, %.2f ms budget\n", numEntities, frames, memTarget, budgetMs );
+	gmBenchmarkGCPacingRun( numEntities, frames, memTarget, budgetMs, false );
+	gmBenchmarkGCPacingRun( numEntities, frames, memTarget, budgetMs, true );
+}
+
+static float gmBenchmarkProfilerRun( int frames, int periodMs, const char * foldedFile )
+{
+	gmBenchmarkMachine machine;
+	machine.SetDebugMode( true );
+
+	// a few threads splitting their time between a loop of calls and a long loop, a line each
+	machine.ExecuteString(
+		"global Light = function(n) { s = 0; for(i = 0; i < n; i += 1) { s += i * 2; } return s; };\n"
+		"global Heavy = function(n) { s = 0; for(i = 0; i < n; i += 1) { s += Light(2); } return s; };\n"
+		"global Update = function(n) { while(true) {\n"
+		"  Heavy(n);\n"
+		"  Light(n * 6);\n"
+		"  yield(); } };\n"
+		"for(t = 0; t < 4; t += 1) { thread(Update, 2000); }\n" );
+
+	gmSampleProfiler * profiler = periodMs > 0 ? new gmSampleProfiler( &machine, periodMs ) : NULL;
+
+	Timer timer;
+	for( int i = 0; i < frames; ++i )
+	{
+		if ( profiler ) profiler->BeginExecute();
+		machine.Execute( 16, false );
+		if ( profiler ) profiler->EndExecute();
+		if ( profiler ) profiler->EndFrame();
+	}
+	const float msPerFrame = timer.GetTimeMs() / frames;
+
+	if ( profiler )
+	{
+		std::vector<gmSampleProfiler::Function> functions;
+		profiler->GetFunctions( functions, false );
+		printf("  sampling every %d ms: %.3f ms per frame, %d samples\n", periodMs, msPerFrame, profiler->GetTotalSamples() );
+		for( int i = 0; i < (int)functions.size() && i < 4; ++i )
+		{
+			printf("    %5.1f%% self %5.1f%% total  %s\n", 100.0f * functions[i].self / profiler->GetTotalSamples(),
+				100.0f * functions[i].total / profiler->GetTotalSamples(), functions[i].name.c_str() );
+		}
+		if ( foldedFile && profiler->WriteFolded( foldedFile ) ) printf("    folded stacks written to %s\n", foldedFile );
+		delete profiler;
+	}
+	else
+	{
+		printf("  no profiler: %.3f ms per frame\n", msPerFrame );
+	}
+
+	return msPerFrame;
+}
+
+void gmBenchmarkProfiler( int frames, int periodMs, const char * foldedFile )
+{
+	printf("BenchmarkProfiler: %d frames\n", frames );
+	if ( !gmSampleProfiler::IsSupported() )
+	{
+		printf("  built without GMTHREAD_SAMPLING, define GM_PROFILE_BUILD\n");
+		return;
+	}
+	const float off = gmBenchmarkProfilerRun( frames, 0, NULL );
+	const float on = gmBenchmarkProfilerRun( frames, periodMs, foldedFile );
+	printf("  overhead %.1f%%\n", 100.0f * ( on - off ) / off );
+}
+
+#if GMMACHINE_ALLOCPROFILER
+
+static float gmBenchmarkAllocProfilerRun( int numEntities, int frames, bool profile, const char * reportFile )
+{
+	gmBenchmarkMachine machine;
+	machine.SetDebugMode( true );
+	machine.SetAutoMemoryUsage( false );
+	machine.SetDesiredByteMemoryUsageHard( 4000000 );
+	machine.SetDesiredByteMemoryUsageSoft( 3600000 );
+
+	// long lived entities with kids replaced every few frames, log strings and draw closures that die young
+	machine.ExecuteString(
+		"global g_world = {};\n"
+		"global g_log = { last = null };\n"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { g_world[i] = { id = i, name = \"ent\" + i, kids = {} }; } };\n"
+		"global Entity = function(n, seed) {\n"
+		"  frame = 0;\n"
+		"  while(true) {\n"
+		"    frame += 1;\n"
+		"    for(i = 0; i < 20; i += 1) {\n"
+		"      draw = { fn = function(x) { return x + 1; }, args = { i, frame } };\n"
+		"      g_log.last = \"frame \" + frame + \" entity \" + seed + \" step \" + i;\n"
+		"    }\n"
+		"    e = g_world[(seed * 7 + frame) % n];\n"
+		"    e.kids[frame % 4] = { born = frame, tag = \"kid\" + frame };\n"
+		"    yield();\n"
+		"  }\n"
+		"};\n"
+		"global Start = function(n, threads) { Spawn(n); for(i = 0; i < threads; i += 1) { thread(Entity, n, i); } };\n" );
+
+	if ( profile ) machine.EnableAllocProfiler( true );
+
+	machine.Run( "Start(%d, 8);", numEntities );
+
+	Timer timer;
+	for( int i = 0; i < frames; ++i )
+	{
+		machine.Execute( 16, false );
+		machine.CollectGarbage();
+	}
+	const float msPerFrame = timer.GetTimeMs() / frames;
+
+	if ( profile )
+	{
+		printf("  profiling: %.3f ms per frame, %d live objects recorded\n", msPerFrame, machine.GetAllocProfiler()->GetNumLive() );
+
+		FILE * fp = reportFile ? fopen( reportFile, "w" ) : NULL;
+		machine.GetAllocProfiler()->Print( fp ? fp : stdout, &machine, 10 );
+		if ( fp )
+		{
+			fclose( fp );
+			printf("  report written to %s\n", reportFile );
+		}
+	}
+	else
+	{
+		printf("  no profiler: %.3f ms per frame\n", msPerFrame );
+	}
+
+	return msPerFrame;
+}
+
+void gmBenchmarkAllocProfiler( int numEntities, int frames, const char * reportFile )
+{
+	printf("BenchmarkAllocProfiler: %d entities, %d frames\n", numEntities, frames );
+	const float off = gmBenchmarkAllocProfilerRun( numEntities, frames, false, NULL );
+	const float on = gmBenchmarkAllocProfilerRun( numEntities, frames, true, reportFile );
+	printf("  profiling costs %.1f%%\n", 100.0f * ( on - off ) / off );
+}
+
+#else // !GMMACHINE_ALLOCPROFILER
+
+void gmBenchmarkAllocProfiler( int numEntities, int frames, const char * reportFile )
+{
+	printf("BenchmarkAllocProfiler: %d entities, %d frames\n", numEntities, frames );
+	printf("  built without GMMACHINE_ALLOCPROFILER, define GM_PROFILE_BUILD\n");
+}
+
+#endif // !GMMACHINE_ALLOCPROFILER
+
+void gmBenchmarkStringKeys( int iterations, int numStrings )
+{
+	const int kFields = 64;
+
+	// collecting would free the interned strings under test
+	gmBenchmarkMachine machine;
+	machine.EnableGC( false );
+
+	char names[kFields][32];
+	char missing[kFields][32];
+	gmStringKey keys[kFields];
+	gmTableObject * table = machine.AllocTableObject();
+	for( int i = 0; i < kFields; ++i )
+	{
+		sprintf( names[i], "field%d", i );
+		sprintf( missing[i], "missing%d", i );
+		keys[i] = gmStringKey( names[i] );
+		table->Set( &machine, names[i], gmVariable( i ) );
+	}
+
+	printf("BenchmarkStringKeys: %d lookups, %d strings\n", iterations * kFields, numStrings );
+
+	int sum = 0;
+	Timer timer;
+	for( int n = 0; n < iterations; ++n )
+	{
+		for( int i = 0; i < kFields; ++i ) sum += table->Get( &machine, names[i] ).m_value.m_int;
+	}
+	printf("  get by c string:    %.1f ns\n", timer.GetTimeMs() * 1000000.0f / ( iterations * kFields ) );
+
+	timer.Start();
+	for( int n = 0; n < iterations; ++n )
+	{
+		for( int i = 0; i < kFields; ++i ) sum += table->Get( &machine, keys[i] ).m_value.m_int;
+	}
+	printf("  get by string key:  %.1f ns\n", timer.GetTimeMs() * 1000000.0f / ( iterations * kFields ) );
+
+	// a key that no table holds used to be interned to find that out
+	const int memBefore = machine.GetCurrentMemoryUsage();
+	timer.Start();
+	for( int n = 0; n < iterations; ++n )
+	{
+		for( int i = 0; i < kFields; ++i ) sum += table->Get( &machine, missing[i] ).m_value.m_int;
+	}
+	printf("  get missing key:    %.1f ns, %d bytes allocated\n", timer.GetTimeMs() * 1000000.0f / ( iterations * kFields ),
+		machine.GetCurrentMemoryUsage() - memBefore );
+
+	// interning grows the pool, then finds every string already in it
+	char ** strings = new char * [numStrings];
+	for( int i = 0; i < numStrings; ++i )
+	{
+		strings[i] = new char[32];
+		sprintf( strings[i], "string%d", i );
+	}
+
+	timer.Start();
+	for( int i = 0; i < numStrings; ++i ) machine.AllocStringObject( strings[i] );
+	printf("  intern new string:  %.1f ns\n", timer.GetTimeMs() * 1000000.0f / numStrings );
+
+	timer.Start();
+	for( int i = 0; i < numStrings; ++i ) machine.AllocStringObject( strings[i] );
+	printf("  intern old string:  %.1f ns\n", timer.GetTimeMs() * 1000000.0f / numStrings );
+
+	for( int i = 0; i < numStrings; ++i ) delete [] strings[i];
+	delete [] strings;
+
+	// keeps the lookups from being optimized away
+	if ( sum == 42 ) printf("  %d\n", sum );
+}
+
+void gmBenchmarkTableArray( int numElements, int iterations )
+{
+	// collecting would free the tables under test
+	gmBenchmarkMachine machine;
+	machine.EnableGC( false );
+
+	printf("BenchmarkTableArray: %d elements, %d iterations\n", numElements, iterations );
+
+	// filled in order, as scripts fill lists, and backwards
+	const int memBefore = machine.GetCurrentMemoryUsage();
+	Timer timer;
+	gmTableObject * table = machine.AllocTableObject();
+	for( int i = 0; i < numElements; ++i ) table->Set( &machine, i, gmVariable( i ) );
+	const float appendMs = timer.GetTimeMs();
+	const int memAppended = machine.GetCurrentMemoryUsage();
+
+	gmTableObject * backwards = machine.AllocTableObject();
+	for( int i = numElements - 1; i >= 0; --i ) backwards->Set( &machine, i, gmVariable( i ) );
+	const int memBackwards = machine.GetCurrentMemoryUsage();
+
+	printf("  append:            %.1f ns, %.1f bytes per element\n", appendMs * 1000000.0f / numElements,
+		(float)( memAppended - memBefore ) / numElements );
+	printf("  filled backwards:  %.1f bytes per element\n", (float)( memBackwards - memAppended ) / numElements );
+
+	int sum = 0;
+	timer.Start();
+	for( int n = 0; n < iterations; ++n )
+	{
+		for( int i = 0; i < numElements; ++i ) sum += table->Get( i ).m_value.m_int;
+	}
+	printf("  get by index:      %.1f ns\n", timer.GetTimeMs() * 1000000.0f / ( (float)iterations * numElements ) );
+
+	// the same from script
+	machine.GetGlobals()->Set( &machine, "g_list", gmVariable( table ) );
+	machine.ExecuteString(
+		"global Fill = function(n) { t = table(); for(i = 0; i < n; i += 1) { t[i] = i; } return t; };\n"
+		"global Sum = function(t, n) { s = 0; for(i = 0; i < n; i += 1) { s += t[i]; } return s; };\n"
+		"global Each = function(t) { s = 0; foreach(k and v in t) { s += v; } return s; };\n" );
+
+	float ms = machine.Time( iterations, "Fill(%d);", numElements );
+	printf("  script append:     %.1f ns\n", ms * 1000000.0f / ( (float)iterations * numElements ) );
+
+	ms = machine.Time( iterations, "Sum(g_list, %d);", numElements );
+	printf("  script index:      %.1f ns\n", ms * 1000000.0f / ( (float)iterations * numElements ) );
+
+	ms = machine.Time( iterations, "Each(g_list);" );
+	printf("  script foreach:    %.1f ns\n", ms * 1000000.0f / ( (float)iterations * numElements ) );
+
+	// keeps the lookups from being optimized away
+	if ( sum == 42 ) printf("  %d\n", sum );
+}
+
+void gmBenchmarkFloatBuffer( int numSamples, int iterations )
+{
+	// only the buffer type bound
+	gmBenchmarkMachine machine;
+	GM_BIND_INIT( FloatBuffer, &machine );
+
+	printf("BenchmarkFloatBuffer: %d samples, %d iterations\n", numSamples, iterations );
+
+	// the same mix, scale and sum of two signals, a sample at a time from script and in bulk
+	machine.ExecuteString(
+		"global MixTable = function(a, b, n) { s = 0.0; for(i = 0; i < n; i += 1) { a[i] = (a[i] + b[i]) * 0.5; s += a[i]; } return s; };\n"
+		"global MixBuffer = function(a, b, n) { s = 0.0; for(i = 0; i < n; i += 1) { v = (a.Get(i) + b.Get(i)) * 0.5; a.Set(i, v); s += v; } return s; };\n"
+		"global MixBulk = function(a, b) { a.Add(b); a.Scale(0.5); return a.Sum(); };\n"
+		"global Analyse = function(a, b, r) { a.Clamp(0.1, 0.9); r.Resample(a); return a.Dot(b) + a.Min() + a.Max(); };\n" );
+
+	machine.Run(
+		"global g_ta = table(); global g_tb = table(); global g_ba = FloatBuffer(%d); global g_bb = FloatBuffer(%d); global g_br = FloatBuffer(%d);\n"
+		"for(i = 0; i < %d; i += 1) { v = (i %% 100) * 0.01; g_ta[i] = v; g_tb[i] = v; g_ba.Set(i, v); g_bb.Set(i, v); }",
+		numSamples, numSamples, numSamples / 3 + 1, numSamples );
+
+	const float samples = (float)iterations * numSamples;
+	printf("  script table:     %.2f ns per sample\n", machine.Time( iterations, "MixTable(g_ta, g_tb, %d);", numSamples ) * 1000000.0f / samples );
+	printf("  script Get/Set:   %.2f ns per sample\n", machine.Time( iterations, "MixBuffer(g_ba, g_bb, %d);", numSamples ) * 1000000.0f / samples );
+	printf("  bulk mix:         %.2f ns per sample\n", machine.Time( iterations, "MixBulk(g_ba, g_bb);" ) * 1000000.0f / samples );
+	printf("  bulk analyse:     %.2f ns per sample\n", machine.Time( iterations, "Analyse(g_ba, g_bb, g_br);" ) * 1000000.0f / samples );
+}
+
+void gmBenchmarkStringConcat( int numLines, int iterations )
+{
+	// collection off, so the bytes allocated include every intermediate string
+	gmBenchmarkMachine machine;
+	machine.EnableGC( false );
+	gmBindStringLib( &machine );
+
+	printf("BenchmarkStringConcat: %d lines, %d iterations\n", numLines, iterations );
+
+	// the same status line, a piece at a time, as one chain of adds, and appended to a builder
+	machine.ExecuteString(
+		"global LinePieces = function(i) { s = \"unit \"; s = s + i; s = s + \" hp \"; s = s + (i * 7); s = s + \"/\"; s = s + 100; s = s + \" at \"; s = s + (i * 0.5); s = s + \", \"; s = s + (i * 2); s = s + \" state \"; s = s + \"idle\"; return s; };\n"
+		"global LineChain = function(i) { return \"unit \" + i + \" hp \" + (i * 7) + \"/\" + 100 + \" at \" + (i * 0.5) + \", \" + (i * 2) + \" state \" + \"idle\"; };\n"
+		"global g_sb = StringBuilder(128);\n"
+		"global LineBuilder = function(i) { return g_sb.Clear().Append(\"unit \", i, \" hp \", i * 7, \"/\", 100, \" at \", i * 0.5, \", \", i * 2, \" state \", \"idle\").String(); };\n" );
+
+	const char * functions[] = { "LinePieces", "LineChain", "LineBuilder" };
+	const char * names[] = { "a piece at a time:", "chain of adds:    ", "StringBuilder:    " };
+	for( int f = 0; f < 3; ++f )
+	{
+		const float ms = machine.Time( iterations, "for(i = 0; i < %d; i += 1) { %s(r * %d + i); }", numLines, functions[f], numLines );
+		printf("  %s %.0f ns, %.0f bytes per line\n", names[f], ms * 1000000.0f / ( (float)iterations * numLines ),
+			(float)machine.GetBytes() / ( (float)iterations * numLines ) );
+
+		// every form builds the same lines, later runs would find them interned already
+		machine.EnableGC( true );
+		machine.CollectGarbage( true );
+		machine.EnableGC( false );
+	}
+}
+
+void gmBenchmarkVariableLayout( int count, int iterations )
+{
+	// collection off, so the bytes include every vec boxed along the way
+	gmBenchmarkMachine machine;
+	machine.EnableGC( false );
+	gmBindMathLib( &machine );
+
+	printf("BenchmarkVariableLayout: %d entries, %d iterations, %s variables of %d bytes, table nodes of %d bytes\n", count, iterations,
+		GM_COMPACT_VARIABLE ? "compact" : "wide", (int)sizeof(gmVariable), (int)sizeof(gmTableNode) );
+
+	// numbers in the array and the hash part of a table, calls that only move numbers on the stack, and vec math on table members
+	machine.ExecuteString(
+		"global Fill = function(n) { t = {}; for(i = 0; i < n; i += 1) { t[i] = i * 0.5; t[-1 - i] = i; } return t; };\n"
+		"global Sum = function(t) { s = 0.0; foreach(k and v in t) { s = s + v; } return s; };\n"
+		"global Fib = function(n) { if(n < 2) { return n; } return Fib(n - 1) + Fib(n - 2); };\n"
+		"global Spawn = function(n) { ps = {}; for(i = 0; i < n; i += 1) { ps[i] = { pos = v2(i, 0), vel = v2(1, 2) }; } return ps; };\n"
+		"global Move = function(ps, n) { g = v2(0, -9.8) * 0.016; for(i = 0; i < n; i += 1) { p = ps[i]; p.pos = p.pos + p.vel * 0.016; p.vel = p.vel + g; } };\n" );
+
+	float ms = machine.Time( 1, "global g_t = Fill(%d);", count );
+	printf("  number table:  %.1f bytes per entry, fill %.0f ns per entry", (float)machine.GetBytes() / ( 2.0f * count ), ms * 1000000.0f / ( 2.0f * count ) );
+	ms = machine.Time( iterations, "Sum(g_t);" );
+	printf(", sum %.1f ns per entry\n", ms * 1000000.0f / ( 2.0f * count * iterations ) );
+
+	// Fib(20) makes 21891 calls
+	ms = machine.Time( iterations, "Fib(20);" );
+	printf("  calls:         %.1f ns per call\n", ms * 1000000.0f / ( 21891.0f * iterations ) );
+
+	machine.Time( 1, "global g_ps = Spawn(%d);", count );
+	printf("  vec particles: %.1f bytes per particle", (float)machine.GetBytes() / count );
+	ms = machine.Time( iterations, "Move(g_ps, %d);", count );
+	printf(", move %.0f ns and %.1f bytes allocated per particle\n", ms * 1000000.0f / ( (float)count * iterations ), (float)machine.GetBytes() / ( (float)count * iterations ) );
+}
+
+static void gmBenchmarkThreadSpawnRun( int poolSize, int threadsPerFrame, int frames, bool deep )
+{
+	gmBenchmarkMachine machine;
+	machine.SetThreadPoolSize( poolSize );
+
+	// a burst of short tweens a frame, with every eighth thread recursing deep enough to grow its stack
+	machine.ExecuteString(
+		"global Tween = function(n) { x = 0.0; for(i = 0; i < n; i += 1) { x += i * 0.5; } };\n"
+		"global Deep = function(d) { if(d > 0) { return Deep(d - 1) + 1; } return 0; };\n"
+		"global Burst = function(n, deep) { for(i = 0; i < n; i += 1) { if(deep && (i % 8) == 0) { thread(Deep, 40); } else { thread(Tween, 8); } } };\n"
+		"global Spawner = function(n, frames, deep) { for(f = 0; f < frames; f += 1) { Burst(n, deep); yield(); } };\n" );
+	machine.ResetStatsThreads();
+
+	Timer timer;
+	machine.Run( "thread(Spawner, %d, %d, %d);", threadsPerFrame, frames, deep ? 1 : 0 );
+	while( machine.Execute( 16 ) > 0 ) {}
+	const float ms = timer.GetTimeMs();
+
+	const int created = machine.GetStatsThreadsCreated();
+	printf("  pool %4d: %.0f ns per thread, %3d%% reused, %.2f stack grows per thread, %d stack bytes\n", poolSize,
+		ms * 1000000.0f / created, (int)( 100.0f * machine.GetStatsThreadsReused() / created ),
+		(float)machine.GetStatsThreadStackGrows() / created, machine.GetThreadStackBytes() );
+}
+
+void gmBenchmarkThreadSpawn( int threadsPerFrame, int frames )
+{
+	printf("BenchmarkThreadSpawn: %d threads per frame, %d frames\n", threadsPerFrame, frames );
+
+	// no pool, the pool size this used to be fixed at, and the default
+	const int poolSizes[] = { 0, 16, GMMACHINE_MAXKILLEDTHREADS };
+	for( int deep = 0; deep < 2; ++deep )
+	{
+		printf(" %s\n", deep ? "tweens and deep threads:" : "tweens:" );
+		for( int i = 0; i < 3; ++i ) gmBenchmarkThreadSpawnRun( poolSizes[i], threadsPerFrame, frames, deep != 0 );
+	}
+}
+
+// a native the size of NoteBrain's getters, for gmBenchmarkNativeCall
+class gmNativeCallBench
+{
+public:
+	static int s_gmUserTypeId;
+
+	gmNativeCallBench() : m_forgetRate(0.0f) { for( int i = 0; i < 12; ++i ) m_confidence[i] = i / 12.0f; }
+
+	float GetBestNoteConfidence( int rank ) { return m_confidence[(unsigned)rank % 12]; }
+	float GetNoteConfidence( int octave, int note ) { return m_confidence[(unsigned)(octave + note) % 12] * m_forgetRate; }
+	void SetForgetRate( float rate ) { m_forgetRate = rate; }
+
+	float m_confidence[12];
+	float m_forgetRate;
+};
+
+int gmNativeCallBench::s_gmUserTypeId = GM_NULL;
+
+// the bindings as the GM_GEN_MEMFUNC_ macros used to expand them
+namespace gmfNativeCallBenchMacro
+{
+	int GM_CDECL gmfGetBestNoteConfidence( gmThread * a_thread )
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_INT_PARAM( v0, 0 );
+		GM_GET_THIS_PTR(gmNativeCallBench, ptr);
+		a_thread->PushFloat( ptr->GetBestNoteConfidence(v0) );
+		return GM_OK;
+	}
+
+	int GM_CDECL gmfGetNoteConfidence( gmThread * a_thread )
+	{
+		GM_CHECK_NUM_PARAMS(2);
+		GM_CHECK_INT_PARAM( val0, 0 );
+		GM_CHECK_INT_PARAM( val1, 1 );
+		GM_GET_THIS_PTR(gmNativeCallBench, ptr);
+		a_thread->PushFloat( (float)ptr->GetNoteConfidence(val0, val1) );
+		return GM_OK;
+	}
+
+	int GM_CDECL gmfSetForgetRate( gmThread * a_thread )
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_FLOAT_PARAM( val, 0 );
+		GM_GET_THIS_PTR(gmNativeCallBench, ptr);
+		ptr->SetForgetRate(val);
+		return GM_OK;
+	}
+}
+
+// and as they expand now, through gmBindCall
+namespace gmfNativeCallBenchThunk
+{
+	GM_GEN_MEMFUNC_FLOAT_INT( gmNativeCallBench, GetBestNoteConfidence )
+	GM_GEN_MEMFUNC_FLOAT_INT_INT( gmNativeCallBench, GetNoteConfidence )
+	GM_GEN_MEMFUNC_VOID_FLOAT( gmNativeCallBench, SetForgetRate )
+}
+
+void gmBenchmarkNativeCall( int iterations )
+{
+	gmNativeCallBench bench;
+
+	// the native bound twice over, the machine declared after it so it goes first
+	gmBenchmarkMachine machine;
+	gmNativeCallBench::s_gmUserTypeId = machine.CreateUserType( "NativeCallBench" );
+
+	gmFunctionEntry functions[] =
+	{
+		{ "MacroGetBestNoteConfidence", gmfNativeCallBenchMacro::gmfGetBestNoteConfidence },
+		{ "MacroGetNoteConfidence", gmfNativeCallBenchMacro::gmfGetNoteConfidence },
+		{ "MacroSetForgetRate", gmfNativeCallBenchMacro::gmfSetForgetRate },
+		{ "GetBestNoteConfidence", gmfNativeCallBenchThunk::gmfGetBestNoteConfidence },
+		{ "GetNoteConfidence", gmfNativeCallBenchThunk::gmfGetNoteConfidence },
+		{ "SetForgetRate", gmfNativeCallBenchThunk::gmfSetForgetRate },
+	};
+	machine.RegisterTypeLibrary( gmNativeCallBench::s_gmUserTypeId, functions, sizeof(functions) / sizeof(functions[0]) );
+	machine.GetGlobals()->Set( &machine, "g_brain", gmVariable( machine.AllocUserObject( &bench, gmNativeCallBench::s_gmUserTypeId ) ) );
+
+	printf("BenchmarkNativeCall: %d iterations\n", iterations );
+
+	// the loop on its own, then each call, the loop taken off
+	const char * calls[] = { "", "GetBestNoteConfidence(r)", "GetNoteConfidence(4, r)", "SetForgetRate(0.5)" };
+	float loopMs = 0.0f;
+	for( int c = 0; c < 4; ++c )
+	{
+		float ms[2];
+		for( int thunk = 0; thunk < 2; ++thunk )
+		{
+			if ( c == 0 ) ms[thunk] = machine.Time( iterations, "g_brain;" );
+			else ms[thunk] = machine.Time( iterations, "g_brain.%s%s;", thunk ? "" : "Macro", calls[c] );
+		}
+
+		if ( c == 0 )
+		{
+			loopMs = ( ms[0] + ms[1] ) * 0.5f;
+			printf("  loop:                      %.1f ns per iteration\n", loopMs * 1000000.0f / iterations );
+			continue;
+		}
+
+		printf("  %-26s macro %.1f ns, thunk %.1f ns per call\n", calls[c],
+			( ms[0] - loopMs ) * 1000000.0f / iterations, ( ms[1] - loopMs ) * 1000000.0f / iterations );
+	}
+}
+
+struct gmLineOpsBench
+{
+	const char * m_name;
+	const char * m_source;	// a statement per line, as scripts are written
+	const char * m_call;
+	int m_calls;			// script function calls made by one m_call
+};
+
+static float gmBenchmarkLineOpsRun( const gmLineOpsBench & bench, bool lineOps, int iterations, int & instructions, int & tableBytes )
+{
+	// debug, where BC_LINE used to be emitted unconditionally
+	gmBenchmarkMachine machine;
+	machine.SetDebugMode( true );
+	machine.SetLineOpsMode( lineOps );
+	machine.ExecuteString( bench.m_source );
+
+	gmVariable var = machine.GetGlobals()->Get( &machine, bench.m_name );
+	gmFunctionObject * fn = var.GetFunctionObjectSafe();
+	gmByteCodeOpt counter;
+	instructions = counter.Count( fn->GetByteCode(), fn->GetByteCodeLength() );
+	tableBytes = fn->GetLineTableSize();
+
+	// the fastest of a few runs, the difference is small next to a noisy run
+	float bestMs = 0.0f;
+	for( int run = 0; run < 5; ++run )
+	{
+		const float ms = machine.Time( iterations, "%s;", bench.m_call );
+		if ( run == 0 || ms < bestMs ) bestMs = ms;
+	}
+	return bestMs;
+}
+
+void gmBenchmarkLineOps( int iterations )
+{
+	const gmLineOpsBench benches[] =
+	{
+		{ "Integrate",
+			"global Integrate = function(n)\n{\n  x = 0.0;\n  v = 1.0;\n  for(i = 0; i < n; i += 1)\n  {\n    a = -x * 0.5;\n"
+			"    v += a * 0.016;\n    x += v * 0.016;\n    if(x > 100.0)\n    {\n      x = 100.0;\n    }\n  }\n  return x;\n};\n",
+			"Integrate(100)", 1 },
+		{ "Fib",
+			"global Fib = function(n)\n{\n  if(n < 2)\n  {\n    return n;\n  }\n  return Fib(n - 1) + Fib(n - 2);\n};\n",
+			"Fib(15)", 1973 },
+		{ "Tables",
+			"global Tables = function(n)\n{\n  t = {};\n  for(i = 0; i < n; i += 1)\n  {\n    t[i] = i * 2;\n  }\n"
+			"  s = 0;\n  foreach(v in t)\n  {\n    s += v;\n  }\n  return s;\n};\n",
+			"Tables(100)", 1 },
+		{ "Brain",
+			"global Brain = function(state, hunger, fear)\n{\n  if(state == 0)\n  {\n    if(hunger > 0.5)\n    {\n      state = 1;\n    }\n  }\n"
+			"  else if(state == 1)\n  {\n    hunger -= 0.1;\n    if(fear > hunger)\n    {\n      state = 2;\n    }\n  }\n"
+			"  else\n  {\n    fear -= 0.2;\n    if(fear < 0.1)\n    {\n      state = 0;\n    }\n  }\n  return state;\n};\n",
+			"Brain(r % 3, 0.7, 0.4)", 1 },
+	};
+	const int numBenches = sizeof(benches) / sizeof(benches[0]);
+
+	printf("BenchmarkLineOps: %d iterations, debug compiles with and without BC_LINE\n", iterations );
+
+	for( int b = 0; b < numBenches; ++b )
+	{
+		int instructions[2], tableBytes[2];
+		float ms[2];
+		for( int lineOps = 1; lineOps >= 0; --lineOps )
+		{
+			ms[lineOps] = gmBenchmarkLineOpsRun( benches[b], lineOps != 0, iterations, instructions[lineOps], tableBytes[lineOps] );
+		}
+
+		const float calls = (float)iterations * benches[b].m_calls;
+		printf("  %-10s %3d -> %3d instructions, %4.0f -> %4.0f ns per call (%.1f%% faster), %d byte line table\n",
+			benches[b].m_name, instructions[1], instructions[0],
+			ms[1] * 1000000.0f / calls, ms[0] * 1000000.0f / calls, 100.0f * ( ms[1] - ms[0] ) / ms[1], tableBytes[0] );
+	}
+}
+
+static void gmBenchmarkConcurrentMarkRun( int numEntities, int frames, int idleMs, int workPerIncrement, bool concurrent )
+{
+	gmBenchmarkMachine machine;
+
+	// a soft limit of 0 restarts collection as soon as a cycle ends, so marking is always under way
+	machine.SetAutoMemoryUsage( false );
+	machine.SetDesiredByteMemoryUsageHard( 256 * 1024 * 1024 );
+	machine.SetDesiredByteMemoryUsageSoft( 0 );
+	machine.GetGC()->SetWorkPerIncrement( workPerIncrement );
+
+	// a large old heap that workers keep rewiring, and a checker that walks it and counts anything collected too early
+	machine.ExecuteString(
+		"global g_world = {};"
+		"global g_check = { errors = 0, checked = 0 };"
+		"global Spawn = function(n) { for(i = 0; i < n; i += 1) { g_world[i] = { id = i, name = \"ent\" + i, kids = { { born = 0, tag = \"kid0\" } } }; } };"
+		"global Worker = function(n, seed) {"
+		"  frame = 0;"
+		"  while(true) {"
+		"    frame += 1;"
+		"    for(i = 0; i < 20; i += 1) { tmp = { a = i, s = \"tmp \" + seed + \" \" + frame + \" \" + i }; }"
+		"    for(i = 0; i < 50; i += 1) {"
+		"      a = g_world[(seed * 7919 + frame * 31 + i * 101) % n];"
+		"      b = g_world[(seed * 104729 + frame * 17 + i * 13) % n];"
+		"      kids = a.kids; a.kids = b.kids; b.kids = kids;"
+		"      b.kids[frame % 4] = { born = frame, tag = \"kid\" + frame };"
+		"    }"
+		"    if(frame % 10 == 0) { i = (seed * 31 + frame) % n; g_world[i] = { id = i, name = \"ent\" + i, kids = {} }; }"
+		"    yield();"
+		"  }"
+		"};"
+		"global Checker = function(n) {"
+		"  next = 0;"
+		"  while(true) {"
+		"    for(c = 0; c < 1000; c += 1) {"
+		"      e = g_world[next];"
+		"      if(e.id != next || e.name != \"ent\" + next) { g_check.errors += 1; }"
+		"      foreach(kid in e.kids) { if(kid.tag != \"kid\" + kid.born) { g_check.errors += 1; } }"
+		"      g_check.checked += 1;"
+		"      next = (next + 1) % n;"
+		"    }"
+		"    yield();"
+		"  }"
+		"};"
+		"global Start = function(n, threads) { Spawn(n); for(i = 0; i < threads; i += 1) { thread(Worker, n, i); } thread(Checker, n); };" );
+
+	machine.Run( "Start(%d, 4);", numEntities );
+
+	GCMarker * marker = concurrent ? new GCMarker( &machine ) : NULL;
+
+	float gcMs = 0.0f;
+	float worstGcMs = 0.0f;
+	float markMs = 0.0f;
+	for( int i = 0; i < frames; ++i )
+	{
+		if ( marker )
+		{
+			marker->Sync();
+			markMs += marker->GetMarkMs();
+		}
+
+		machine.Execute( 16, false );
+
+		Timer gcTimer;
+		machine.CollectGarbage();
+		float ms = gcTimer.GetTimeMs();
+		gcMs += ms;
+		if ( ms > worstGcMs ) worstGcMs = ms;
+
+		// the host renders and presents, the machine is idle
+		if ( marker ) marker->Begin();
+		SDL_Delay( idleMs );
+	}
+
+	if ( marker )
+	{
+		marker->Sync();
+		markMs += marker->GetMarkMs();
+		delete marker;
+	}
+
+	int errors = machine.GetCount( "g_check", "errors" );
+	int checked = machine.GetCount( "g_check", "checked" );
+
+	machine.CollectGarbage( true );
+
+	printf("  %s: %.3f ms gc per frame on the main thread, worst %.3f ms, %.3f ms marking thread, %d inc, %d full collects\n",
+		concurrent ? "marking thread" : "main thread   ", gcMs / frames, worstGcMs, markMs / frames,
+		machine.GetStatsGCNumIncCollects(), machine.GetStatsGCNumFullCollects() - 1 );
+	printf("  %d entities checked, %d errors, %d bytes after a full collect\n", checked, errors, machine.GetCurrentMemoryUsage() );
+}
+
+void gmBenchmarkConcurrentMark( int numEntities, int frames, int idleMs, int workPerIncrement )
+{
+	printf("BenchmarkConcurrentMark: %d entities, %d frames, %d ms idle per frame, %d work per increment\n", numEntities, frames, idleMs, workPerIncrement );
+	gmBenchmarkConcurrentMarkRun( numEntities, frames, idleMs, workPerIncrement, false );
+	gmBenchmarkConcurrentMarkRun( numEntities, frames, idleMs, workPerIncrement, true );
+}
@@ -0,0 +1,61 @@
+#ifndef _INCLUDE_GM_BENCH_H_
+#define _INCLUDE_GM_BENCH_H_
+
+// Benchmarks for the script engine, bound to scripts by gmBindBenchLib. Only bench runs register that lib, so none of
+// this is reachable from the game or its ScriptWorkers.
+
+class gmMachine;
+
+// prints time to load files as source text, as libs read into memory and as memory mapped libs
+void gmBenchmarkLoad( gmMachine *vm, const char ** files, int numFiles, int iterations );
+
+// prints time to compile and bind 1 to 64 files, cycling through the given files, on one thread and on numThreads threads
+void gmBenchmarkCompile( gmMachine *vm, const char ** files, int numFiles, int numThreads, int iterations );
+
+// prints time for numThreads script threads to sleep, then wake on staggered periods for the given frames
+void gmBenchmarkSleep( int numThreads, int frames );
+
+// prints time for numThreads blocked script threads to be signalled, signalsPerFrame threads per frame
+void gmBenchmarkSignal( int numThreads, int frames, int signalsPerFrame );
+
+// prints garbage collection counts and time per frame for a game like load of temporaries, without and with the nursery
+void gmBenchmarkGC( int numEntities, int frames, int memLimit );
+
+// prints main thread garbage collection time per frame and checks a large heap, with marking on the main thread and on a marking thread
+void gmBenchmarkConcurrentMark( int numEntities, int frames, int idleMs, int workPerIncrement );
+
+// prints garbage collection time per frame against a frame budget and the peak heap against a memory target, under a load
+// that changes over time, with the static settings and with funk::GCPacer
+void gmBenchmarkGCPacing( int numEntities, int frames, int memTarget, float budgetMs );
+
+// prints script time per frame without and with a gmSampleProfiler, and the functions it found busiest. NULL foldedFile writes no stacks
+void gmBenchmarkProfiler( int frames, int periodMs, const char * foldedFile );
+
+// prints script time per frame without and with the allocation profiler, and its report, to stdout when reportFile is NULL
+void gmBenchmarkAllocProfiler( int numEntities, int frames, const char * reportFile );
+
+// prints time per table lookup by c string, by precomputed gmStringKey and for a missing key, and per string interned
+void gmBenchmarkStringKeys( int iterations, int numStrings );
+
+// prints bytes per element, and time per append, indexed get and foreach step, of a table used as an array
+void gmBenchmarkTableArray( int numElements, int iterations );
+
+// prints time per sample mixing two signals from script a sample at a time, in tables and in FloatBuffers, and with the bulk ops
+void gmBenchmarkFloatBuffer( int numSamples, int iterations );
+
+// prints time and bytes allocated per status line built by adding one piece at a time, by one chain of adds, and with a StringBuilder
+void gmBenchmarkStringConcat( int numLines, int iterations );
+
+// prints the gmVariable layout, then the memory and time of tables of numbers, script calls and vec math, to compare GM_COMPACT_VARIABLE builds
+void gmBenchmarkVariableLayout( int count, int iterations );
+
+// prints time per short lived thread spawned and killed in bursts a frame, and how many the thread pool served, with the pool off, small and at its default size
+void gmBenchmarkThreadSpawn( int threadsPerFrame, int frames );
+
+// prints time per call to a bound native, through the GM_GEN_MEMFUNC_ macros as they used to expand and through gmBindCall
+void gmBenchmarkNativeCall( int iterations );
+
+// prints instructions and time per call of script functions compiled in debug mode with and without BC_LINE, and the size of the line table kept instead
+void gmBenchmarkLineOps( int iterations );
+
+#endif
\ No newline at end of file
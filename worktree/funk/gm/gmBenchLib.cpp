@@ -0,0 +1,243 @@
+#include "gmBenchLib.h"
+
+#include "gmThread.h"
+#include "gmMachine.h"
+#include "gmHelpers.h"
+#include "gmTableObject.h"
+#include "gmUtilEx.h"
+#include "gmBench.h"
+
+#include <gm/gmBind.h>
+
+#include <vector>
+
+namespace funk
+{
+struct gmfBenchmarkLib
+{
+	// string values of a table in key order
+	static void TableFileNames(gmTableObject * a_table, std::vector<const char*> & a_files)
+	{
+		std::vector<gmVariable> keys;
+		gmSortTableKeys( a_table, keys );
+
+		for( size_t i = 0; i < keys.size(); ++i )
+		{
+			gmVariable file = a_table->Get(keys[i]);
+			if ( file.IsString() ) a_files.push_back( file.GetCStringSafe() );
+		}
+	}
+
+	static int GM_CDECL gmfLoad(gmThread * a_thread) // table of filenames, iterations (20)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_TABLE_PARAM(table, 0);
+		GM_INT_PARAM(iterations, 1, 20);
+
+		std::vector<const char*> files;
+		TableFileNames( table, files );
+
+		if ( !files.empty() ) gmBenchmarkLoad( a_thread->GetMachine(), &files[0], (int)files.size(), iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfCompile(gmThread * a_thread) // table of filenames, threads (4), iterations (5)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_TABLE_PARAM(table, 0);
+		GM_INT_PARAM(threads, 1, 4);
+		GM_INT_PARAM(iterations, 2, 5);
+
+		std::vector<const char*> files;
+		TableFileNames( table, files );
+
+		if ( !files.empty() ) gmBenchmarkCompile( a_thread->GetMachine(), &files[0], (int)files.size(), threads, iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfSleep(gmThread * a_thread) // threads (10000), frames (300)
+	{
+		GM_INT_PARAM(threads, 0, 10000);
+		GM_INT_PARAM(frames, 1, 300);
+
+		gmBenchmarkSleep( threads, frames );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfSignal(gmThread * a_thread) // threads (10000), frames (100), signals per frame (1000)
+	{
+		GM_INT_PARAM(threads, 0, 10000);
+		GM_INT_PARAM(frames, 1, 100);
+		GM_INT_PARAM(signals, 2, 1000);
+
+		gmBenchmarkSignal( threads, frames, signals );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfGC(gmThread * a_thread) // entities (500), frames (600), memory limit (4000000)
+	{
+		GM_INT_PARAM(entities, 0, 500);
+		GM_INT_PARAM(frames, 1, 600);
+		GM_INT_PARAM(memLimit, 2, 4000000);
+
+		gmBenchmarkGC( entities, frames, memLimit );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfConcurrentMark(gmThread * a_thread) // entities (10000), frames (300), idle ms (8), work per increment (20000)
+	{
+		GM_INT_PARAM(entities, 0, 10000);
+		GM_INT_PARAM(frames, 1, 300);
+		GM_INT_PARAM(idleMs, 2, 8);
+		GM_INT_PARAM(work, 3, 20000);
+
+		gmBenchmarkConcurrentMark( entities, frames, idleMs, work );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfGCPacing(gmThread * a_thread) // entities (500), frames (900), memory target (2000000), budget ms (0.5)
+	{
+		GM_INT_PARAM(entities, 0, 500);
+		GM_INT_PARAM(frames, 1, 900);
+		GM_INT_PARAM(memTarget, 2, 2000000);
+		GM_FLOAT_OR_INT_PARAM(budgetMs, 3, 0.5f);
+
+		gmBenchmarkGCPacing( entities, frames, memTarget, budgetMs );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfProfiler(gmThread * a_thread) // frames (300), sample ms (1), folded stacks file (null)
+	{
+		GM_INT_PARAM(frames, 0, 300);
+		GM_INT_PARAM(periodMs, 1, 1);
+		GM_STRING_PARAM(foldedFile, 2, NULL);
+
+		gmBenchmarkProfiler( frames, periodMs, foldedFile );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfAllocProfiler(gmThread * a_thread) // entities (500), frames (600), report file (null)
+	{
+		GM_INT_PARAM(entities, 0, 500);
+		GM_INT_PARAM(frames, 1, 600);
+		GM_STRING_PARAM(reportFile, 2, NULL);
+
+		gmBenchmarkAllocProfiler( entities, frames, reportFile );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfStringKeys(gmThread * a_thread) // iterations (20000), strings (200000)
+	{
+		GM_INT_PARAM(iterations, 0, 20000);
+		GM_INT_PARAM(strings, 1, 200000);
+
+		gmBenchmarkStringKeys( iterations, strings );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfTableArray(gmThread * a_thread) // elements (100000), iterations (20)
+	{
+		GM_INT_PARAM(elements, 0, 100000);
+		GM_INT_PARAM(iterations, 1, 20);
+
+		gmBenchmarkTableArray( elements, iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfFloatBuffer(gmThread * a_thread) // samples (65536), iterations (20)
+	{
+		GM_INT_PARAM(samples, 0, 65536);
+		GM_INT_PARAM(iterations, 1, 20);
+
+		gmBenchmarkFloatBuffer( samples, iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfStringConcat(gmThread * a_thread) // lines (10000), iterations (10)
+	{
+		GM_INT_PARAM(lines, 0, 10000);
+		GM_INT_PARAM(iterations, 1, 10);
+
+		gmBenchmarkStringConcat( lines, iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfVariableLayout(gmThread * a_thread) // entries (10000), iterations (10)
+	{
+		GM_INT_PARAM(count, 0, 10000);
+		GM_INT_PARAM(iterations, 1, 10);
+
+		gmBenchmarkVariableLayout( count, iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfThreadSpawn(gmThread * a_thread) // threads per frame (64), frames (600)
+	{
+		GM_INT_PARAM(threads, 0, 64);
+		GM_INT_PARAM(frames, 1, 600);
+
+		gmBenchmarkThreadSpawn( threads, frames );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfNativeCall(gmThread * a_thread) // iterations (1000000)
+	{
+		GM_INT_PARAM(iterations, 0, 1000000);
+
+		gmBenchmarkNativeCall( iterations );
+
+		return GM_OK;
+	}
+
+	static int GM_CDECL gmfLineOps(gmThread * a_thread) // iterations (10000)
+	{
+		GM_INT_PARAM(iterations, 0, 10000);
+
+		gmBenchmarkLineOps( iterations );
+
+		return GM_OK;
+	}
+};
+
+static gmFunctionEntry s_gmBenchmarkLib[] = 
+{
+	GM_LIBFUNC_ENTRY(Load, Benchmark)
+	GM_LIBFUNC_ENTRY(Compile, Benchmark)
+	GM_LIBFUNC_ENTRY(Sleep, Benchmark)
+	GM_LIBFUNC_ENTRY(Signal, Benchmark)
+	GM_LIBFUNC_ENTRY(GC, Benchmark)
+	GM_LIBFUNC_ENTRY(ConcurrentMark, Benchmark)
+	GM_LIBFUNC_ENTRY(GCPacing, Benchmark)
+	GM_LIBFUNC_ENTRY(Profiler, Benchmark)
+	GM_LIBFUNC_ENTRY(AllocProfiler, Benchmark)
+	GM_LIBFUNC_ENTRY(StringKeys, Benchmark)
+	GM_LIBFUNC_ENTRY(TableArray, Benchmark)
+	GM_LIBFUNC_ENTRY(FloatBuffer, Benchmark)
+	GM_LIBFUNC_ENTRY(StringConcat, Benchmark)
+	GM_LIBFUNC_ENTRY(VariableLayout, Benchmark)
+	GM_LIBFUNC_ENTRY(ThreadSpawn, Benchmark)
+	GM_LIBFUNC_ENTRY(NativeCall, Benchmark)
+	GM_LIBFUNC_ENTRY(LineOps, Benchmark)
+};
+
+void gmBindBenchLib( gmMachine * a_machine )
+{
+	a_machine->RegisterLibrary(s_gmBenchmarkLib, sizeof(s_gmBenchmarkLib) / sizeof(s_gmBenchmarkLib[0]), "Benchmark" );
+}
+
+}
\ No newline at end of file
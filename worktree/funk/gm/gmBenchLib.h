@@ -0,0 +1,12 @@
+#ifndef _INCLUDE_GM_BENCH_LIB_H_
+#define _INCLUDE_GM_BENCH_LIB_H_
+
+class gmMachine;
+
+namespace funk
+{
+	// Benchmark.Sleep(), Benchmark.GC() and the rest of gmBench.h, for the scripts in scripts/bench
+	void gmBindBenchLib( gmMachine * a_machine );
+}
+
+#endif
\ No newline at end of file
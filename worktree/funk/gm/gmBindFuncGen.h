@@ -8,170 +8,254 @@
 ///////////////////////////////////////////////////////////////////////////////
 #define GM_LIBFUNC_ENTRY(FUNC,CLASS) {#FUNC, gmf##CLASS##Lib::gmf##FUNC},
 
+///////////////////////////////////////////////////////////////////////////////
+//			NATIVE CALL THUNKS
+///////////////////////////////////////////////////////////////////////////////
+
+// gmBindCall<TYPE>( a_thread, &TYPE::MEMFUNC ) calls a member function of up to 3 params
+// on the bound 'this', with the param and return types deduced from the member pointer.
+// each param is checked with one tag compare and read in place on the thread's stack.
+// an overloaded member needs its pointer cast to the one wanted
+
+// param types, anything not specialised is taken to be int-like (enums, unsigned)
+template<class A> struct gmBindParam
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_INT; }
+	static A Get( gmThread * a_thread, const gmVariable & a_var ) { return (A)a_var.m_value.m_int; }
+	static const char * Name() { return "int"; }
+};
+
+template<class A> struct gmBindParam<const A> : gmBindParam<A> {};
+template<class A> struct gmBindParam<const A &> : gmBindParam<A> {};
+
+template<> struct gmBindParam<bool>
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_INT; }
+	static bool Get( gmThread * a_thread, const gmVariable & a_var ) { return a_var.m_value.m_int != 0; }
+	static const char * Name() { return "int"; }
+};
+
+template<> struct gmBindParam<float>
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_FLOAT; }
+	static float Get( gmThread * a_thread, const gmVariable & a_var ) { return a_var.m_value.m_float; }
+	static const char * Name() { return "float"; }
+};
+
+template<> struct gmBindParam<funk::v2>
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_VEC2; }
+	static funk::v2 Get( gmThread * a_thread, const gmVariable & a_var ) { return a_var.GetVec2(); }
+	static const char * Name() { return "vec2"; }
+};
+
+template<> struct gmBindParam<funk::v3>
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_VEC3; }
+	static funk::v3 Get( gmThread * a_thread, const gmVariable & a_var ) { return a_var.GetVec3(); }
+	static const char * Name() { return "vec3"; }
+};
+
+template<> struct gmBindParam<const char *>
+{
+	static bool Is( const gmVariable & a_var ) { return a_var.m_type == GM_STRING; }
+	static const char * Get( gmThread * a_thread, const gmVariable & a_var ) { return ((gmStringObject *) GM_MOBJECT(a_thread->GetMachine(), a_var.m_value.m_ref))->GetString(); }
+	static const char * Name() { return "string"; }
+};
+
+// return types, anything not specialised is pushed as an int (bool, enums, unsigned)
+template<class R> struct gmBindResult
+{
+	static void Push( gmThread * a_thread, R a_val ) { a_thread->PushInt( (int)a_val ); }
+};
+
+template<class R> struct gmBindResult<const R> : gmBindResult<R> {};
+template<class R> struct gmBindResult<const R &> : gmBindResult<R> {};
+
+template<> struct gmBindResult<float>
+{
+	static void Push( gmThread * a_thread, float a_val ) { a_thread->PushFloat( a_val ); }
+};
+
+template<> struct gmBindResult<double>
+{
+	static void Push( gmThread * a_thread, double a_val ) { a_thread->PushFloat( (float)a_val ); }
+};
+
+template<> struct gmBindResult<funk::v2>
+{
+	static void Push( gmThread * a_thread, const funk::v2 & a_val ) { a_thread->PushVec2( a_val ); }
+};
+
+template<> struct gmBindResult<funk::v3>
+{
+	static void Push( gmThread * a_thread, const funk::v3 & a_val ) { a_thread->PushVec3( a_val ); }
+};
+
+template<> struct gmBindResult<const char *>
+{
+	static void Push( gmThread * a_thread, const char * a_val ) { a_thread->PushNewString( a_val ); }
+};
+
+// calls through the member pointer and pushes what it returns, F is the pointer type, const or not
+template<class R> struct gmBindInvoke
+{
+	template<class T, class F>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func )
+	{ gmBindResult<R>::Push( a_thread, (a_ptr->*a_func)() ); }
+
+	template<class T, class F, class A0>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0 )
+	{ gmBindResult<R>::Push( a_thread, (a_ptr->*a_func)(a0) ); }
+
+	template<class T, class F, class A0, class A1>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0, A1 a1 )
+	{ gmBindResult<R>::Push( a_thread, (a_ptr->*a_func)(a0, a1) ); }
+
+	template<class T, class F, class A0, class A1, class A2>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0, A1 a1, A2 a2 )
+	{ gmBindResult<R>::Push( a_thread, (a_ptr->*a_func)(a0, a1, a2) ); }
+};
+
+template<> struct gmBindInvoke<void>
+{
+	template<class T, class F>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func )
+	{ (a_ptr->*a_func)(); }
+
+	template<class T, class F, class A0>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0 )
+	{ (a_ptr->*a_func)(a0); }
+
+	template<class T, class F, class A0, class A1>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0, A1 a1 )
+	{ (a_ptr->*a_func)(a0, a1); }
+
+	template<class T, class F, class A0, class A1, class A2>
+	static void Call( gmThread * a_thread, T * a_ptr, F a_func, A0 a0, A1 a1, A2 a2 )
+	{ (a_ptr->*a_func)(a0, a1, a2); }
+};
+
+// the same 'this' and messages as GM_GET_THIS_PTR and the GM_CHECK_ macros
+template<class TYPE> inline TYPE * gmBindThis( gmThread * a_thread )
+{
+#ifndef _DEBUG
+	return (TYPE*)a_thread->ThisUser_NoChecks();
+#else
+	return (TYPE*)a_thread->ThisUserCheckType( TYPE::s_gmUserTypeId );
+#endif
+}
+
+inline int gmBindNumParamsError( gmThread * a_thread, int a_numParams )
+{
+	a_thread->GetMachine()->GetLog().LogEntry( "expecting %d param(s)", a_numParams );
+	return GM_EXCEPTION;
+}
+
+inline int gmBindParamError( gmThread * a_thread, int a_param, const char * a_typeName )
+{
+	a_thread->GetMachine()->GetLog().LogEntry( "expecting param %d as %s", a_param, a_typeName );
+	return GM_EXCEPTION;
+}
+
+#define _GM_BIND_CHECK_PARAM( A, PARAM ) \
+	if( !gmBindParam<A>::Is( params[PARAM] ) ) return gmBindParamError( a_thread, PARAM, gmBindParam<A>::Name() )
+
+template<class TYPE, class R, class F>
+inline int gmBindCall0( gmThread * a_thread, F a_func )
+{
+	gmBindInvoke<R>::Call( a_thread, gmBindThis<TYPE>(a_thread), a_func );
+	return GM_OK;
+}
+
+template<class TYPE, class R, class A0, class F>
+inline int gmBindCall1( gmThread * a_thread, F a_func )
+{
+	if( a_thread->GetNumParams() < 1 ) return gmBindNumParamsError( a_thread, 1 );
+	const gmVariable * params = a_thread->GetBase();
+	_GM_BIND_CHECK_PARAM( A0, 0 );
+	gmBindInvoke<R>::Call( a_thread, gmBindThis<TYPE>(a_thread), a_func,
+		gmBindParam<A0>::Get( a_thread, params[0] ) );
+	return GM_OK;
+}
+
+template<class TYPE, class R, class A0, class A1, class F>
+inline int gmBindCall2( gmThread * a_thread, F a_func )
+{
+	if( a_thread->GetNumParams() < 2 ) return gmBindNumParamsError( a_thread, 2 );
+	const gmVariable * params = a_thread->GetBase();
+	_GM_BIND_CHECK_PARAM( A0, 0 );
+	_GM_BIND_CHECK_PARAM( A1, 1 );
+	gmBindInvoke<R>::Call( a_thread, gmBindThis<TYPE>(a_thread), a_func,
+		gmBindParam<A0>::Get( a_thread, params[0] ), gmBindParam<A1>::Get( a_thread, params[1] ) );
+	return GM_OK;
+}
+
+template<class TYPE, class R, class A0, class A1, class A2, class F>
+inline int gmBindCall3( gmThread * a_thread, F a_func )
+{
+	if( a_thread->GetNumParams() < 3 ) return gmBindNumParamsError( a_thread, 3 );
+	const gmVariable * params = a_thread->GetBase();
+	_GM_BIND_CHECK_PARAM( A0, 0 );
+	_GM_BIND_CHECK_PARAM( A1, 1 );
+	_GM_BIND_CHECK_PARAM( A2, 2 );
+	gmBindInvoke<R>::Call( a_thread, gmBindThis<TYPE>(a_thread), a_func,
+		gmBindParam<A0>::Get( a_thread, params[0] ), gmBindParam<A1>::Get( a_thread, params[1] ), gmBindParam<A2>::Get( a_thread, params[2] ) );
+	return GM_OK;
+}
+
+// deduce the types from the member pointer
+template<class TYPE, class T, class R>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)() ) { return gmBindCall0<TYPE, R>( a_thread, a_func ); }
+template<class TYPE, class T, class R>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)() const ) { return gmBindCall0<TYPE, R>( a_thread, a_func ); }
+
+template<class TYPE, class T, class R, class A0>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0) ) { return gmBindCall1<TYPE, R, A0>( a_thread, a_func ); }
+template<class TYPE, class T, class R, class A0>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0) const ) { return gmBindCall1<TYPE, R, A0>( a_thread, a_func ); }
+
+template<class TYPE, class T, class R, class A0, class A1>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0, A1) ) { return gmBindCall2<TYPE, R, A0, A1>( a_thread, a_func ); }
+template<class TYPE, class T, class R, class A0, class A1>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0, A1) const ) { return gmBindCall2<TYPE, R, A0, A1>( a_thread, a_func ); }
+
+template<class TYPE, class T, class R, class A0, class A1, class A2>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0, A1, A2) ) { return gmBindCall3<TYPE, R, A0, A1, A2>( a_thread, a_func ); }
+template<class TYPE, class T, class R, class A0, class A1, class A2>
+inline int gmBindCall( gmThread * a_thread, R (T::*a_func)(A0, A1, A2) const ) { return gmBindCall3<TYPE, R, A0, A1, A2>( a_thread, a_func ); }
+
 ///////////////////////////////////////////////////////////////////////////////
 //			GENERATE FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////////
 #define _GM_GEN_MEMFUNC_BEGIN( FUNC_NAME ) int GM_CDECL gmf##FUNC_NAME( gmThread * a_thread ) {
 #define _GM_GEN_MEMFUNC_END() }
 
-#define GM_GEN_MEMFUNC_VOID_VOID( TYPE, MEMFUNC ) \
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(0);								\
-	GM_GET_THIS_PTR(TYPE, ptr);							\
-	ptr->MEMFUNC();										\
-	return GM_OK;										\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_FLOAT( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)						\
-	GM_CHECK_NUM_PARAMS(1);								\
-	GM_CHECK_FLOAT_PARAM( val,	0 );					\
-	GM_GET_THIS_PTR(TYPE, ptr);							\
-	ptr->MEMFUNC(val);									\
-	return GM_OK;										\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_INT( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)						\
-	GM_CHECK_NUM_PARAMS(1);								\
-	GM_CHECK_INT_PARAM( val,	0 );					\
-	GM_GET_THIS_PTR(TYPE, ptr);							\
-	ptr->MEMFUNC(val);									\
-	return GM_OK;										\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_INT_V2( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)						\
-	GM_CHECK_NUM_PARAMS(2);								\
-	GM_CHECK_INT_PARAM( val0,	0 );					\
-	GM_CHECK_VEC2_PARAM( val1,	1 );					\
-	GM_GET_THIS_PTR(TYPE, ptr);							\
-	ptr->MEMFUNC(val0,val1);							\
-	return GM_OK;										\
-	_GM_GEN_MEMFUNC_END()
-
-
-#define GM_GEN_MEMFUNC_VOID_STRING( TYPE, MEMFUNC )				\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)								\
-	GM_CHECK_NUM_PARAMS(1);										\
-	GM_CHECK_STRING_PARAM( val,	0 );							\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	ptr->MEMFUNC(val);											\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_INT_INT( TYPE, MEMFUNC )			\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)								\
-	GM_CHECK_NUM_PARAMS(2);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_CHECK_INT_PARAM( v1,	1 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	ptr->MEMFUNC(v0,v1);										\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_INT_FLOAT( TYPE, MEMFUNC )			\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)								\
-	GM_CHECK_NUM_PARAMS(2);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_CHECK_FLOAT_PARAM( v1,	1 );							\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	ptr->MEMFUNC(v0,v1);										\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_V2( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(1);									\
-	GM_CHECK_VEC2_PARAM( val,	0 );						\
-	GM_GET_THIS_PTR(TYPE, ptr);								\
-	ptr->MEMFUNC(val);										\
-	return GM_OK;											\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_V2_V2( TYPE, MEMFUNC )\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(2);									\
-	GM_CHECK_VEC2_PARAM( v0,	0 );						\
-	GM_CHECK_VEC2_PARAM( v1,	1 );						\
-	GM_GET_THIS_PTR(TYPE, ptr);								\
-	ptr->MEMFUNC(v0,v1);									\
-	return GM_OK;											\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_V3( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(1);									\
-	GM_CHECK_VEC3_PARAM( val,	0 );						\
-	GM_GET_THIS_PTR(TYPE, ptr);								\
-	ptr->MEMFUNC(val);										\
-	return GM_OK;											\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_VOID_FLOAT_FLOAT( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(2);											\
-	GM_CHECK_FLOAT_PARAM( val0,	0 );								\
-	GM_CHECK_FLOAT_PARAM( val1,	1 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);										\
-	ptr->MEMFUNC(val0, val1);										\
-	return GM_OK;													\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_INT_VOID( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(0);										\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushInt( (int)ptr->MEMFUNC());					\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_INT_INT( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(1);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushInt( (int)ptr->MEMFUNC(v0));				    \
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_INT_INT_INT( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(2);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_CHECK_INT_PARAM( v1,	1 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushInt( (int)ptr->MEMFUNC(v0,v1));				\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_FLOAT_INT_INT( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)						\
-	GM_CHECK_NUM_PARAMS(2);								\
-	GM_CHECK_INT_PARAM( val0,	0 );					\
-	GM_CHECK_INT_PARAM( val1,	1 );					\
-	GM_GET_THIS_PTR(TYPE, ptr);							\
-	a_thread->PushFloat( (float)ptr->MEMFUNC(val0, val1) );\
-	return GM_OK;										\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_V2_VOID( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(0);										\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushVec2( ptr->MEMFUNC());						\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_V2_INT( TYPE, MEMFUNC )		\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(1);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushVec2( ptr->MEMFUNC(v0));						\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
+// the types are taken from the member function, the ones in the macro names only say what is bound
+#define GM_GEN_MEMFUNC( TYPE, MEMFUNC ) \
+	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) return gmBindCall<TYPE>( a_thread, &TYPE::MEMFUNC ); _GM_GEN_MEMFUNC_END()
+
+#define GM_GEN_MEMFUNC_VOID_VOID( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_FLOAT( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_INT( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_INT_V2( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_STRING( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_INT_INT( TYPE, MEMFUNC )		GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_INT_FLOAT( TYPE, MEMFUNC )		GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_V2( TYPE, MEMFUNC )				GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_V2_V2( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_V3( TYPE, MEMFUNC )				GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_VOID_FLOAT_FLOAT( TYPE, MEMFUNC )	GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_INT_VOID( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_INT_INT( TYPE, MEMFUNC )				GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_INT_INT_INT( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_FLOAT_INT_INT( TYPE, MEMFUNC )		GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_V2_VOID( TYPE, MEMFUNC )				GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_V2_INT( TYPE, MEMFUNC )				GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_FLOAT_VOID( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+#define GM_GEN_MEMFUNC_FLOAT_INT( TYPE, MEMFUNC )			GM_GEN_MEMFUNC( TYPE, MEMFUNC )
+
+// takes an int for the float too, so it can't come from the member pointer
 #define GM_GEN_MEMFUNC_V2_FLOAT( TYPE, MEMFUNC )				\
 	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC)								\
 	GM_CHECK_NUM_PARAMS(1);										\
@@ -181,24 +265,6 @@
 	return GM_OK;												\
 	_GM_GEN_MEMFUNC_END()
 
-
-#define GM_GEN_MEMFUNC_FLOAT_VOID( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(0);										\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushFloat( ptr->MEMFUNC());						\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
-#define GM_GEN_MEMFUNC_FLOAT_INT( TYPE, MEMFUNC )	\
-	_GM_GEN_MEMFUNC_BEGIN(MEMFUNC) \
-	GM_CHECK_NUM_PARAMS(1);										\
-	GM_CHECK_INT_PARAM( v0,	0 );								\
-	GM_GET_THIS_PTR(TYPE, ptr);									\
-	a_thread->PushFloat( ptr->MEMFUNC(v0));						\
-	return GM_OK;												\
-	_GM_GEN_MEMFUNC_END()
-
 ///////////////////////////////////////////////////////////////////////////////
 //			GET/SET DOT OPERATORS
 ///////////////////////////////////////////////////////////////////////////////
@@ -215,8 +281,8 @@
 // GETDOT params
 #define GM_GETDOT_PARAM_USER_PTR(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetUser( ptr->PARAM ); }
 #define GM_GETDOT_PARAM_STR(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetString( ptr->PARAM ); }
-#define GM_GETDOT_PARAM_VEC2(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetVec2( ptr->PARAM ); }
-#define GM_GETDOT_PARAM_VEC3(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetVec3( ptr->PARAM ); }
+#define GM_GETDOT_PARAM_VEC2(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetVec2( a_thread->GetMachine(), ptr->PARAM ); }
+#define GM_GETDOT_PARAM_VEC3(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetVec3( a_thread->GetMachine(), ptr->PARAM ); }
 #define GM_GETDOT_PARAM_FLOAT(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetFloat( ptr->PARAM ); }
 #define GM_GETDOT_PARAM_INT(NAME,PARAM) else if ( stricmp(memberStr,NAME)==0 ) { a_operands[0].SetInt( ptr->PARAM ); }
 
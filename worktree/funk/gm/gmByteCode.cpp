@@ -13,6 +13,109 @@
 #include "gmByteCode.h"
 
 
+const char * gmGetByteCodeName(gmuint32 a_byteCode)
+{
+  switch(a_byteCode)
+  {
+    case BC_NOP : return "nop";
+    case BC_LINE : return "line";
+    case BC_GETDOT : return "get dot";
+    case BC_SETDOT : return "set dot";
+    case BC_GETIND : return "get index";
+    case BC_SETIND : return "set index";
+    case BC_BRA : return "bra";
+    case BC_BRZ : return "brz";
+    case BC_BRNZ : return "brnz";
+    case BC_BRZK : return "brzk";
+    case BC_BRNZK : return "brnzk";
+    case BC_CALL : return "call";
+    case BC_RET : return "ret";
+    case BC_RETV : return "retv";
+    case BC_FOREACH : return "foreach";
+    case BC_POP : return "pop";
+    case BC_POP2 : return "pop2";
+    case BC_DUP : return "dup";
+    case BC_DUP2 : return "dup2";
+    case BC_SWAP : return "swap";
+    case BC_PUSHNULL : return "push null";
+    case BC_PUSHINT : return "push int";
+    case BC_PUSHINT0 : return "push int 0";
+    case BC_PUSHINT1 : return "push int 1";
+    case BC_PUSHFP : return "push fp";
+    case BC_PUSHSTR : return "push str";
+    case BC_PUSHTBL : return "push tbl";
+    case BC_PUSHFN : return "push fn";
+    case BC_PUSHTHIS : return "push this";
+    case BC_GETLOCAL : return "get local";
+    case BC_SETLOCAL : return "set local";
+    case BC_GETGLOBAL : return "get global";
+    case BC_SETGLOBAL : return "set global";
+    case BC_GETTHIS : return "get this";
+    case BC_SETTHIS : return "set this";
+    case BC_OP_ADD : return "add";
+    case BC_OP_SUB : return "sub";
+    case BC_OP_MUL : return "mul";
+    case BC_OP_DIV : return "div";
+    case BC_OP_REM : return "rem";
+    case BC_BIT_OR : return "bor";
+    case BC_BIT_XOR : return "bxor";
+    case BC_BIT_AND : return "band";
+    case BC_BIT_INV : return "binv";
+    case BC_BIT_SHL : return "bshl";
+    case BC_BIT_SHR : return "bshr";
+    case BC_OP_NEG : return "neg";
+    case BC_OP_POS : return "pos";
+    case BC_OP_NOT : return "not";
+    case BC_OP_LT : return "lt";
+    case BC_OP_GT : return "gt";
+    case BC_OP_LTE : return "lte";
+    case BC_OP_GTE : return "gte";
+    case BC_OP_EQ : return "eq";
+    case BC_OP_NEQ : return "neq";
+    case BC_PUSHLASTIND : return "pushlastind";
+    case BC_ISNOTNULL : return "isnotnull";
+#if GM_USE_FORK
+    case BC_FORK : return "fork";
+#endif //GM_USE_FORK
+    case BC_CONCAT : return "concat";
+    case BC_CONCATEND : return "concat end";
+    case BC_OP_ADD_INT : return "add int";
+    case BC_OP_SUB_INT : return "sub int";
+    case BC_OP_MUL_INT : return "mul int";
+    case BC_OP_LT_INT : return "lt int";
+    case BC_OP_GT_INT : return "gt int";
+    case BC_OP_LTE_INT : return "lte int";
+    case BC_OP_GTE_INT : return "gte int";
+    case BC_OP_EQ_INT : return "eq int";
+    case BC_OP_NEQ_INT : return "neq int";
+    case BC_OP_ADD_FP : return "add fp";
+    case BC_OP_SUB_FP : return "sub fp";
+    case BC_OP_MUL_FP : return "mul fp";
+    case BC_OP_DIV_FP : return "div fp";
+    case BC_OP_LT_FP : return "lt fp";
+    case BC_OP_GT_FP : return "gt fp";
+    case BC_OP_LTE_FP : return "lte fp";
+    case BC_OP_GTE_FP : return "gte fp";
+    case BC_OP_ADD_V2 : return "add v2";
+    case BC_OP_SUB_V2 : return "sub v2";
+    case BC_OP_MUL_V2F : return "mul v2 fp";
+    case BC_OP_ADD_V3 : return "add v3";
+    case BC_OP_SUB_V3 : return "sub v3";
+    case BC_OP_MUL_V3F : return "mul v3 fp";
+    case BC_GETLOCAL2 : return "get local 2";
+    case BC_GETLOCAL_GETDOT : return "get local get dot";
+    case BC_GETTHIS_GETDOT : return "get this get dot";
+    case BC_INCLOCAL : return "inc local";
+    case BC_LOCAL_LT_BRZ : return "local lt brz";
+    case BC_LOCAL_LTE_BRZ : return "local lte brz";
+    case BC_LOCAL_GT_BRZ : return "local gt brz";
+    case BC_LOCAL_GTE_BRZ : return "local gte brz";
+    default : break;
+  }
+  return "ERROR";
+}
+
+
 #if GM_COMPILE_DEBUG
 
 void gmByteCodePrint(FILE * a_fp, const void * a_byteCode, int a_byteCodeLength)
@@ -37,80 +140,45 @@ void gmByteCodePrint(FILE * a_fp, const void * a_byteCode, int a_byteCodeLength)
 
     int addr = (int)(instruction - start);
 
+    cp = gmGetByteCodeName(*instruction);
     switch(*instruction)
     {
-      case BC_NOP : cp = "nop"; break;
-      case BC_LINE : cp = "line"; break;
-
-      case BC_GETDOT : cp = "get dot"; opiptr = true; break;
-      case BC_SETDOT : cp = "set dot"; opiptr = true; break;
-      case BC_GETIND : cp = "get index"; break;
-      case BC_SETIND : cp = "set index"; break;
-
-      case BC_BRA : cp = "bra"; opiptr = true; break;
-      case BC_BRZ : cp = "brz"; opiptr = true; break;
-      case BC_BRNZ : cp = "brnz"; opiptr = true; break;
-      case BC_BRZK : cp = "brzk"; opiptr = true; break;
-      case BC_BRNZK : cp = "brnzk"; opiptr = true; break;
-      case BC_CALL : cp = "call"; opiptr = true; break;
-      case BC_RET : cp = "ret"; break;
-      case BC_RETV : cp = "retv"; break;
-      case BC_FOREACH : cp = "foreach"; opiptr = true; break;
-      
-      case BC_POP : cp = "pop"; break;
-      case BC_POP2 : cp = "pop2"; break;
-      case BC_DUP : cp = "dup"; break;
-      case BC_DUP2 : cp = "dup2"; break;
-      case BC_SWAP : cp = "swap"; break;
-      case BC_PUSHNULL : cp = "push null"; break;
-      case BC_PUSHINT : cp = "push int"; opi32 = true; break;
-      case BC_PUSHINT0 : cp = "push int 0"; break;
-      case BC_PUSHINT1 : cp = "push int 1"; break;
-      case BC_PUSHFP : cp = "push fp"; opf32 = true; break;
-      case BC_PUSHSTR : cp = "push str"; opiptr = true; break;
-      case BC_PUSHTBL : cp = "push tbl"; break;
-      case BC_PUSHFN : cp = "push fn"; opiptr = true; break;
-      case BC_PUSHTHIS : cp = "push this"; break;
-      
-      case BC_GETLOCAL : cp = "get local"; opi32 = true; break;
-      case BC_SETLOCAL : cp = "set local"; opi32 = true; break;
-      case BC_GETGLOBAL : cp = "get global"; opiptr = true; break;
-      case BC_SETGLOBAL : cp = "set global"; opiptr = true; break;
-      case BC_GETTHIS : cp = "get this"; opiptr = true; break;
-      case BC_SETTHIS : cp = "set this"; opiptr = true; break;
-      
-      case BC_OP_ADD : cp = "add"; break;
-      case BC_OP_SUB : cp = "sub"; break;
-      case BC_OP_MUL : cp = "mul"; break;
-      case BC_OP_DIV : cp = "div"; break;
-      case BC_OP_REM : cp = "rem"; break;
-
-      case BC_BIT_OR : cp = "bor"; break;
-      case BC_BIT_XOR : cp = "bxor"; break;
-      case BC_BIT_AND : cp = "band"; break;
-      case BC_BIT_INV : cp = "binv"; break;
-      case BC_BIT_SHL : cp = "bshl"; break;
-      case BC_BIT_SHR : cp = "bshr"; break;
-      
-      case BC_OP_NEG : cp = "neg"; break;
-      case BC_OP_POS : cp = "pos"; break;
-      case BC_OP_NOT : cp = "not"; break;
-      
-      case BC_OP_LT : cp = "lt"; break;
-      case BC_OP_GT : cp = "gt"; break;
-      case BC_OP_LTE : cp = "lte"; break;
-      case BC_OP_GTE : cp = "gte"; break;
-      case BC_OP_EQ : cp = "eq"; break;
-      case BC_OP_NEQ : cp = "neq"; break;
-
-	  case BC_PUSHLASTIND : cp = "pushlastind"; break;
-	  case BC_ISNOTNULL : cp = "isnotnull"; break;
-
+      case BC_GETDOT :
+      case BC_SETDOT :
+      case BC_BRA :
+      case BC_BRZ :
+      case BC_BRNZ :
+      case BC_BRZK :
+      case BC_BRNZK :
+      case BC_PUSHSTR :
+      case BC_PUSHFN :
+      case BC_GETGLOBAL :
+      case BC_SETGLOBAL :
+      case BC_GETTHIS :
+      case BC_SETTHIS :
+      case BC_GETTHIS_GETDOT :
 #if GM_USE_FORK
-      case BC_FORK : cp = "fork"; opiptr = true; break;
+      case BC_FORK :
 #endif //GM_USE_FORK
+        opiptr = true; break;
 
-      default : cp = "ERROR"; break;
+      case BC_PUSHINT :
+      case BC_CALL :
+      case BC_FOREACH :
+      case BC_GETLOCAL :
+      case BC_SETLOCAL :
+      case BC_GETLOCAL2 :
+      case BC_GETLOCAL_GETDOT :
+      case BC_INCLOCAL :
+      case BC_LOCAL_LT_BRZ :
+      case BC_LOCAL_LTE_BRZ :
+      case BC_LOCAL_GT_BRZ :
+      case BC_LOCAL_GTE_BRZ :
+        opi32 = true; break;
+
+      case BC_PUSHFP : opf32 = true; break;
+
+      default : break;
     }
 
     ++instruction32;
@@ -143,3 +211,83 @@ void gmByteCodePrint(FILE * a_fp, const void * a_byteCode, int a_byteCodeLength)
 
 #endif // GM_COMPILE_DEBUG
 
+
+
+#if GMTHREAD_BYTECODEHISTOGRAM
+
+//
+//
+// Implementation of gmByteCodeHistogram
+//
+//
+
+gmByteCodeHistogram::gmByteCodeHistogram()
+{
+  m_triples = GM_NEW( gmuint32[BC_MAX * BC_MAX * BC_MAX] );
+  Reset();
+}
+
+
+
+gmByteCodeHistogram::~gmByteCodeHistogram()
+{
+  delete [] m_triples;
+}
+
+
+
+void gmByteCodeHistogram::Reset()
+{
+  memset(m_count, 0, sizeof(m_count));
+  memset(m_pairs, 0, sizeof(m_pairs));
+  memset(m_triples, 0, sizeof(gmuint32) * BC_MAX * BC_MAX * BC_MAX);
+  m_last = m_last2 = BC_NOP;
+  m_total = 0;
+}
+
+
+
+void gmByteCodeHistogram::Print(FILE * a_fp, int a_top) const
+{
+  fprintf(a_fp, "byte code histogram, %u dispatches"GM_NL, m_total);
+  PrintTop(a_fp, "byte codes", m_count, BC_MAX, 1, a_top);
+  PrintTop(a_fp, "pairs", m_pairs, BC_MAX * BC_MAX, 2, a_top);
+  PrintTop(a_fp, "triples", m_triples, BC_MAX * BC_MAX * BC_MAX, 3, a_top);
+}
+
+
+
+void gmByteCodeHistogram::PrintTop(FILE * a_fp, const char * a_title, const gmuint32 * a_counts, int a_numCounts, int a_length, int a_top) const
+{
+  // keep the a_top largest counts in descending order with an insertion sort
+  int * top = (int *) alloca(sizeof(int) * a_top);
+  int numTop = 0, i, j;
+  for(i = 0; i < a_numCounts; ++i)
+  {
+    if(a_counts[i] == 0 || (numTop == a_top && a_counts[i] <= a_counts[top[numTop - 1]])) continue;
+    if(numTop < a_top) ++numTop;
+    for(j = numTop - 1; j > 0 && a_counts[top[j - 1]] < a_counts[i]; --j)
+    {
+      top[j] = top[j - 1];
+    }
+    top[j] = i;
+  }
+
+  fprintf(a_fp, "  %s"GM_NL, a_title);
+  for(i = 0; i < numTop; ++i)
+  {
+    gmuint32 count = a_counts[top[i]];
+    fprintf(a_fp, "  %10u %5.2f%%  ", count, (m_total) ? 100.0f * count / m_total : 0.0f);
+    int index = top[i], div = 1;
+    for(j = 1; j < a_length; ++j) div *= BC_MAX;
+    for(j = 0; j < a_length; ++j)
+    {
+      fprintf(a_fp, (j) ? ", %s" : "%s", gmGetByteCodeName(index / div));
+      index %= div;
+      div /= BC_MAX;
+    }
+    fprintf(a_fp, GM_NL);
+  }
+}
+
+#endif // GMTHREAD_BYTECODEHISTOGRAM
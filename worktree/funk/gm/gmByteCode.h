@@ -14,6 +14,10 @@
 
 #include "gmConfig.h"
 
+/// \brief GM_BYTECODE_VERSION must be bumped whenever byte code encoding or meaning changes, so stale compiled
+///        libs cached on disk are rejected rather than executed.
+#define GM_BYTECODE_VERSION 3
+
 /// \enum gmByteCode
 /// \brief gmByteCode are the op codes for the game monkey scripting.  The first byte codes MUST match the gmOperator
 ///        enum.
@@ -99,12 +103,105 @@ enum gmByteCode
 #if GM_USE_FORK
   BC_FORK,            // Fork
 #endif //GM_USE_FORK  
+
+  // string building, emitted for a chain of '+' holding a string constant.  a string result is built in the thread's
+  // buffer instead of interned, see gmThread::Concat().
+  BC_CONCAT,          // tos-1 + tos, --tos
+  BC_CONCATEND,       // tos-1 + tos, interns the string built, --tos
+
+  // typed operators, never emitted by the compiler. gmThread rewrites (quickens) BC_OP_* to these when
+  // it sees int, float or vec operands and rewrites them back to BC_OP_* when the operand types change.
+  BC_OP_ADD_INT,
+  BC_OP_SUB_INT,
+  BC_OP_MUL_INT,
+  BC_OP_LT_INT,
+  BC_OP_GT_INT,
+  BC_OP_LTE_INT,
+  BC_OP_GTE_INT,
+  BC_OP_EQ_INT,
+  BC_OP_NEQ_INT,
+  BC_OP_ADD_FP,       // int or float operands, at least one float
+  BC_OP_SUB_FP,
+  BC_OP_MUL_FP,
+  BC_OP_DIV_FP,
+  BC_OP_LT_FP,
+  BC_OP_GT_FP,
+  BC_OP_LTE_FP,
+  BC_OP_GTE_FP,
+  BC_OP_ADD_V2,       // vec2 + vec2
+  BC_OP_SUB_V2,
+  BC_OP_MUL_V2F,      // vec2 * int or float
+  BC_OP_ADD_V3,       // vec3 + vec3
+  BC_OP_SUB_V3,
+  BC_OP_MUL_V3F,      // vec3 * int or float
+
+  // superinstructions, written by gmByteCodeOpt over the first byte code of a common sequence.  the rest of the
+  // sequence is left in place, so branches into the sequence and the fallback when operand types don't match
+  // (which runs the first byte code as generic code) execute the original byte codes.
+  BC_GETLOCAL2,       // get local op16, get local op16
+  BC_GETLOCAL_GETDOT, // get local op16, get dot opptr
+  BC_GETTHIS_GETDOT,  // get this opptr, get dot opptr
+  BC_INCLOCAL,        // get local op16, push int op32 or push int 1, add, set local op16
+  BC_LOCAL_LT_BRZ,    // get local op16, get local op16 or push int op32 or push fp op32, lt, brz opptr
+  BC_LOCAL_LTE_BRZ,
+  BC_LOCAL_GT_BRZ,
+  BC_LOCAL_GTE_BRZ,
+
+  BC_MAX,             // number of byte codes, must be last
 };
 
+/// \brief gmGetByteCodeName() returns the disassembly name of a byte code, "ERROR" if it is not a byte code.
+const char * gmGetByteCodeName(gmuint32 a_byteCode);
+
 #if GM_COMPILE_DEBUG
 
 void gmByteCodePrint(FILE * a_fp, const void * a_byteCode, int a_byteCodeLength);
 
 #endif // GM_COMPILE_DEBUG
 
+#if GMTHREAD_BYTECODEHISTOGRAM
+
+/// \class gmByteCodeHistogram
+/// \brief gmByteCodeHistogram counts executed byte codes and the byte code pairs and triples they were executed in.
+///        Attach one with gmMachine::EnableByteCodeHistogram(), the thread loop then records every dispatch.
+///        Counts are of dispatches, so typed and fused byte codes are counted as what was executed.
+class gmByteCodeHistogram
+{
+public:
+
+  gmByteCodeHistogram();
+  ~gmByteCodeHistogram();
+
+  inline void Record(gmuint32 a_byteCode)
+  {
+    ++m_count[a_byteCode];
+    ++m_pairs[m_last * BC_MAX + a_byteCode];
+    ++m_triples[(m_last2 * BC_MAX + m_last) * BC_MAX + a_byteCode];
+    m_last2 = m_last;
+    m_last = a_byteCode;
+    ++m_total;
+  }
+
+  void Reset();
+
+  /// \brief Print() will print the a_top most frequent byte codes, pairs and triples with their share of all dispatches.
+  void Print(FILE * a_fp, int a_top) const;
+
+  inline gmuint32 GetTotal() const { return m_total; }
+  inline gmuint32 GetCount(gmuint32 a_byteCode) const { return m_count[a_byteCode]; }
+  inline gmuint32 GetPairCount(gmuint32 a_first, gmuint32 a_second) const { return m_pairs[a_first * BC_MAX + a_second]; }
+
+private:
+
+  gmuint32 m_count[BC_MAX];
+  gmuint32 m_pairs[BC_MAX * BC_MAX];
+  gmuint32 * m_triples; //!< BC_MAX^3 counts
+  gmuint32 m_last, m_last2;
+  gmuint32 m_total;
+
+  void PrintTop(FILE * a_fp, const char * a_title, const gmuint32 * a_counts, int a_numCounts, int a_length, int a_top) const;
+};
+
+#endif // GMTHREAD_BYTECODEHISTOGRAM
+
 #endif
@@ -154,6 +154,9 @@ void gmByteCodeGen::AdjustStack(gmByteCode a_instruction)
 #if GM_USE_FORK
     case BC_FORK : m_tos += 2; break; // two variables are popped as a result of BC_FORK (one in each thread)
 #endif //GM_USE_FORK
+
+    case BC_CONCAT : --m_tos; break;
+    case BC_CONCATEND : --m_tos; break;
   }
 
   if(m_tos > m_maxTos) m_maxTos = m_tos;
@@ -0,0 +1,830 @@
+/*
+    _____               __  ___          __            ____        _      __
+   / ___/__ ___ _  ___ /  |/  /__  ___  / /_____ __ __/ __/_______(_)__  / /_
+  / (_ / _ `/  ' \/ -_) /|_/ / _ \/ _ \/  '_/ -_) // /\ \/ __/ __/ / _ \/ __/
+  \___/\_,_/_/_/_/\__/_/  /_/\___/_//_/_/\_\\__/\_, /___/\__/_/ /_/ .__/\__/
+                                               /___/             /_/
+
+  See Copyright Notice in gmMachine.h
+*/
+
+#include "gmConfig.h"
+#include "gmByteCodeOpt.h"
+#include "gmVariable.h"
+
+#define GMBYTECODEOPT_MAXPASSES   16    // stop iterating passes after this many, each pass only ever shrinks the code
+#define GMBYTECODEOPT_MAXTHREAD   16    // max branch chain length followed when threading jumps
+
+/// \brief gmHasPtrOperand() returns true if the byte code is followed by a gmptr operand, as emitted by gmCodeGen.
+static bool gmHasPtrOperand(gmuint32 a_byteCode)
+{
+  switch(a_byteCode)
+  {
+    case BC_GETDOT :
+    case BC_SETDOT :
+    case BC_BRA :
+    case BC_BRZ :
+    case BC_BRNZ :
+    case BC_BRZK :
+    case BC_BRNZK :
+    case BC_PUSHSTR :
+    case BC_PUSHFN :
+    case BC_GETGLOBAL :
+    case BC_SETGLOBAL :
+    case BC_GETTHIS :
+    case BC_SETTHIS :
+    case BC_GETTHIS_GETDOT :
+#if GM_USE_FORK
+    case BC_FORK : // emitted as 32 bit into a SIZEOF_BC_BRA slot, but read as gmptr
+#endif //GM_USE_FORK
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+
+/// \brief gmHasOperand32() returns true if the byte code is followed by a 32 bit operand.
+static bool gmHasOperand32(gmuint32 a_byteCode)
+{
+  switch(a_byteCode)
+  {
+    case BC_CALL :
+    case BC_FOREACH :
+    case BC_PUSHINT :
+    case BC_PUSHFP :
+    case BC_GETLOCAL :
+    case BC_SETLOCAL :
+    case BC_GETLOCAL2 :
+    case BC_GETLOCAL_GETDOT :
+    case BC_INCLOCAL :
+    case BC_LOCAL_LT_BRZ :
+    case BC_LOCAL_LTE_BRZ :
+    case BC_LOCAL_GT_BRZ :
+    case BC_LOCAL_GTE_BRZ :
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+
+/// \brief gmInstructionSize() returns the size of the byte code and its operand.
+static int gmInstructionSize(gmuint32 a_byteCode)
+{
+  if(gmHasPtrOperand(a_byteCode)) return sizeof(gmuint32) + sizeof(gmptr);
+  if(gmHasOperand32(a_byteCode)) return sizeof(gmuint32) + sizeof(gmuint32);
+  return sizeof(gmuint32);
+}
+
+
+/// \brief gmIsBranch() returns true if the byte code operand is a branch address.
+static bool gmIsBranch(gmuint32 a_byteCode)
+{
+  switch(a_byteCode)
+  {
+    case BC_BRA :
+    case BC_BRZ :
+    case BC_BRNZ :
+    case BC_BRZK :
+    case BC_BRNZK :
+#if GM_USE_FORK
+    case BC_FORK :
+#endif //GM_USE_FORK
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+
+/// \brief gmIsPurePush() returns true if the byte code pushes one value without side effects.
+static bool gmIsPurePush(gmuint32 a_byteCode)
+{
+  switch(a_byteCode)
+  {
+    case BC_PUSHNULL :
+    case BC_PUSHINT :
+    case BC_PUSHINT0 :
+    case BC_PUSHINT1 :
+    case BC_PUSHFP :
+    case BC_PUSHSTR :
+    case BC_PUSHTHIS :
+    case BC_GETLOCAL :
+    case BC_GETGLOBAL :
+    case BC_DUP :
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+
+/// \brief gmLocalCompareBranch() returns the superinstruction for a get local, compare, brz sequence, or BC_NOP.
+static gmuint32 gmLocalCompareBranch(gmuint32 a_compare)
+{
+  switch(a_compare)
+  {
+    case BC_OP_LT : return BC_LOCAL_LT_BRZ;
+    case BC_OP_LTE : return BC_LOCAL_LTE_BRZ;
+    case BC_OP_GT : return BC_LOCAL_GT_BRZ;
+    case BC_OP_GTE : return BC_LOCAL_GTE_BRZ;
+    default:
+      break;
+  }
+  return BC_NOP;
+}
+
+
+/// \brief gmGetConstant() will get the value pushed by a constant push instruction.
+/// \return false if the instruction is not a constant int, float or null push.
+static bool gmGetConstant(gmuint32 a_byteCode, gmuint32 a_operand32, gmVariable &a_value)
+{
+  switch(a_byteCode)
+  {
+    case BC_PUSHNULL : a_value.m_type = GM_NULL; a_value.m_value.m_int = 0; return true;
+    case BC_PUSHINT0 : a_value.m_type = GM_INT; a_value.m_value.m_int = 0; return true;
+    case BC_PUSHINT1 : a_value.m_type = GM_INT; a_value.m_value.m_int = 1; return true;
+    case BC_PUSHINT : a_value.m_type = GM_INT; a_value.m_value.m_int = (gmint) a_operand32; return true;
+    case BC_PUSHFP : a_value.m_type = GM_FLOAT; a_value.m_value.m_int = (gmint) a_operand32; return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+
+/// \brief gmSetConstant() will make a push instruction for an int or float constant.
+static void gmSetConstant(gmuint32 &a_byteCode, gmuint32 &a_operand32, const gmVariable &a_value)
+{
+  a_operand32 = (gmuint32) a_value.m_value.m_int;
+  if(a_value.m_type == GM_FLOAT)
+  {
+    a_byteCode = BC_PUSHFP;
+  }
+  else if(a_value.m_value.m_int == 0)
+  {
+    a_byteCode = BC_PUSHINT0;
+  }
+  else if(a_value.m_value.m_int == 1)
+  {
+    a_byteCode = BC_PUSHINT1;
+  }
+  else
+  {
+    a_byteCode = BC_PUSHINT;
+  }
+}
+
+
+/// \brief gmIsZero() tests a constant the same way the branch instructions do.
+static bool gmIsZero(const gmVariable &a_value)
+{
+  return (a_value.m_value.m_int == 0);
+}
+
+
+/// \brief gmFoldUnary() will fold a unary operator on a constant.  folds are only done where the result is the
+///        same as the run time gmOperators.
+static bool gmFoldUnary(gmuint32 a_byteCode, const gmVariable &a_a, gmVariable &a_r)
+{
+  if(a_a.m_type == GM_INT)
+  {
+    gmint a = a_a.m_value.m_int;
+    a_r.m_type = GM_INT;
+    switch(a_byteCode)
+    {
+      case BC_OP_NEG : a_r.m_value.m_int = (gmint) (0u - (gmuint32) a); return true;
+      case BC_OP_POS : a_r.m_value.m_int = a; return true;
+      case BC_OP_NOT : a_r.m_value.m_int = !a; return true;
+      case BC_BIT_INV : a_r.m_value.m_int = ~a; return true;
+      default: break;
+    }
+  }
+  else if(a_a.m_type == GM_FLOAT)
+  {
+    gmfloat a = a_a.m_value.m_float;
+    a_r.m_type = GM_FLOAT;
+    switch(a_byteCode)
+    {
+      case BC_OP_NEG : a_r.m_value.m_float = -a; return true;
+      case BC_OP_POS : a_r.m_value.m_float = a; return true;
+      case BC_OP_NOT : a_r.m_type = GM_INT; a_r.m_value.m_int = (a == 0.0f); return true;
+      default: break;
+    }
+  }
+  return false;
+}
+
+
+/// \brief gmFoldBinary() will fold a binary operator on two constants.  the higher type processes the operation,
+///        as in gmThread.  divide by zero and shifts out of range are left for run time.
+static bool gmFoldBinary(gmuint32 a_byteCode, const gmVariable &a_a, const gmVariable &a_b, gmVariable &a_r)
+{
+  if(a_a.m_type == GM_INT && a_b.m_type == GM_INT)
+  {
+    gmint a = a_a.m_value.m_int, b = a_b.m_value.m_int;
+    a_r.m_type = GM_INT;
+    switch(a_byteCode)
+    {
+      case BC_OP_ADD : a_r.m_value.m_int = (gmint) ((gmuint32) a + (gmuint32) b); return true;
+      case BC_OP_SUB : a_r.m_value.m_int = (gmint) ((gmuint32) a - (gmuint32) b); return true;
+      case BC_OP_MUL : a_r.m_value.m_int = (gmint) ((gmuint32) a * (gmuint32) b); return true;
+      case BC_OP_DIV : if(b == 0 || (b == -1 && a == (gmint) 0x80000000)) return false; a_r.m_value.m_int = a / b; return true;
+      case BC_OP_REM : if(b == 0 || (b == -1 && a == (gmint) 0x80000000)) return false; a_r.m_value.m_int = a % b; return true;
+      case BC_BIT_OR : a_r.m_value.m_int = a | b; return true;
+      case BC_BIT_XOR : a_r.m_value.m_int = a ^ b; return true;
+      case BC_BIT_AND : a_r.m_value.m_int = a & b; return true;
+      case BC_BIT_SHL : if(b < 0 || b > 31) return false; a_r.m_value.m_int = (gmint) ((gmuint32) a << b); return true;
+      case BC_BIT_SHR : if(b < 0 || b > 31) return false; a_r.m_value.m_int = a >> b; return true;
+      case BC_OP_LT : a_r.m_value.m_int = (a < b); return true;
+      case BC_OP_GT : a_r.m_value.m_int = (a > b); return true;
+      case BC_OP_LTE : a_r.m_value.m_int = (a <= b); return true;
+      case BC_OP_GTE : a_r.m_value.m_int = (a >= b); return true;
+      case BC_OP_EQ : a_r.m_value.m_int = (a == b); return true;
+      case BC_OP_NEQ : a_r.m_value.m_int = (a != b); return true;
+      default: break;
+    }
+  }
+  else if((a_a.m_type == GM_INT || a_a.m_type == GM_FLOAT) && (a_b.m_type == GM_INT || a_b.m_type == GM_FLOAT))
+  {
+    gmfloat a = (a_a.m_type == GM_INT) ? (gmfloat) a_a.m_value.m_int : a_a.m_value.m_float;
+    gmfloat b = (a_b.m_type == GM_INT) ? (gmfloat) a_b.m_value.m_int : a_b.m_value.m_float;
+    a_r.m_type = GM_FLOAT;
+    switch(a_byteCode)
+    {
+      case BC_OP_ADD : a_r.m_value.m_float = a + b; return true;
+      case BC_OP_SUB : a_r.m_value.m_float = a - b; return true;
+      case BC_OP_MUL : a_r.m_value.m_float = a * b; return true;
+      case BC_OP_DIV : if(b == 0.0f) return false; a_r.m_value.m_float = a / b; return true;
+      case BC_OP_REM : if(b == 0.0f) return false; a_r.m_value.m_float = fmodf(a, b); return true;
+      default: break;
+    }
+    a_r.m_type = GM_INT;
+    switch(a_byteCode)
+    {
+      case BC_OP_LT : a_r.m_value.m_int = (a < b); return true;
+      case BC_OP_GT : a_r.m_value.m_int = (a > b); return true;
+      case BC_OP_LTE : a_r.m_value.m_int = (a <= b); return true;
+      case BC_OP_GTE : a_r.m_value.m_int = (a >= b); return true;
+      case BC_OP_EQ : a_r.m_value.m_int = (a == b); return true;
+      case BC_OP_NEQ : a_r.m_value.m_int = (a != b); return true;
+      default: break;
+    }
+  }
+  return false;
+}
+
+
+
+//
+//
+// Implementation of gmByteCodeOpt
+//
+//
+
+gmByteCodeOpt::gmByteCodeOpt()
+{
+}
+
+
+
+gmByteCodeOpt::~gmByteCodeOpt()
+{
+  FreeMemory();
+}
+
+
+
+void gmByteCodeOpt::FreeMemory()
+{
+  m_instructions.ResetAndFreeMemory();
+  m_work.ResetAndFreeMemory();
+  m_byteCode.ResetAndFreeMemory();
+}
+
+
+
+bool gmByteCodeOpt::Optimise(const void * a_byteCode, int a_byteCodeLength, gmArraySimple<gmLineInfo> &a_lineInfo, gmCodeGenStats &a_stats)
+{
+  m_byteCode.Reset();
+
+  if(!Decode(a_byteCode, a_byteCodeLength))
+  {
+    return false;
+  }
+
+  const int count = m_instructions.Count();
+  a_stats.m_instructions += count;
+
+  // run the passes until nothing changes
+  int pass;
+  for(pass = 0; pass < GMBYTECODEOPT_MAXPASSES; ++pass)
+  {
+    bool changed = false;
+    MarkTargets();
+    changed |= FoldConstants(a_stats);
+    MarkTargets();
+    changed |= FoldBranches(a_stats);
+    MarkTargets();
+    changed |= ThreadJumps(a_stats);
+    MarkTargets();
+    changed |= RemovePushPops(a_stats);
+    changed |= RemoveUnreachable(a_stats);
+    if(!changed) break;
+  }
+
+#if GMCODEGEN_SUPERINSTRUCTIONS
+  FuseInstructions(a_stats);
+#endif // GMCODEGEN_SUPERINSTRUCTIONS
+
+  int i;
+  for(i = 0; i < count; ++i)
+  {
+    if(m_instructions[i].m_live) ++a_stats.m_optimisedInstructions;
+  }
+
+  Encode(a_lineInfo);
+  return true;
+}
+
+
+
+int gmByteCodeOpt::Count(const void * a_byteCode, int a_byteCodeLength) const
+{
+  const gmuint8 * instruction = (const gmuint8 *) a_byteCode;
+  const gmuint8 * end = instruction + a_byteCodeLength;
+  int count = 0;
+  while(instruction < end)
+  {
+    instruction += gmInstructionSize(*((const gmuint32 *) instruction));
+    ++count;
+  }
+  return count;
+}
+
+
+
+bool gmByteCodeOpt::Decode(const void * a_byteCode, int a_byteCodeLength)
+{
+  m_instructions.Reset();
+
+  const gmuint8 * start = (const gmuint8 *) a_byteCode;
+  const gmuint8 * instruction = start;
+  const gmuint8 * end = start + a_byteCodeLength;
+
+  while(instruction < end)
+  {
+    if(instruction + sizeof(gmuint32) > end) return false;
+
+    Instruction &ins = m_instructions.InsertLast();
+    ins.m_address = (gmuint32) (instruction - start);
+    ins.m_byteCode = *((const gmuint32 *) instruction);
+    ins.m_operand32 = 0;
+    ins.m_operandPtr = 0;
+    ins.m_target = -1;
+    ins.m_live = true;
+    ins.m_isTarget = false;
+    ins.m_reached = false;
+    instruction += sizeof(gmuint32);
+
+    if(ins.m_byteCode >= BC_MAX) return false;
+
+    int size = gmInstructionSize(ins.m_byteCode) - sizeof(gmuint32);
+    if(instruction + size > end) return false;
+    if(gmHasPtrOperand(ins.m_byteCode))
+    {
+      ins.m_operandPtr = *((const gmptr *) instruction);
+    }
+    else if(gmHasOperand32(ins.m_byteCode))
+    {
+      ins.m_operand32 = *((const gmuint32 *) instruction);
+    }
+    instruction += size;
+  }
+
+  // resolve branch targets to instruction indices
+  const int count = m_instructions.Count();
+  int i;
+  for(i = 0; i < count; ++i)
+  {
+    Instruction &ins = m_instructions[i];
+    if(gmIsBranch(ins.m_byteCode))
+    {
+      if(ins.m_operandPtr == (gmptr) a_byteCodeLength)
+      {
+        ins.m_target = count;
+      }
+      else
+      {
+        ins.m_target = FindInstruction((gmuint32) ins.m_operandPtr);
+        if(ins.m_target < 0 || m_instructions[ins.m_target].m_address != (gmuint32) ins.m_operandPtr)
+        {
+          return false; // branch into an operand, leave this function alone.
+        }
+      }
+    }
+  }
+
+  return (count > 0);
+}
+
+
+
+int gmByteCodeOpt::FindInstruction(gmuint32 a_address) const
+{
+  // first instruction at or after a_address
+  int lo = 0, hi = m_instructions.Count();
+  while(lo < hi)
+  {
+    int mid = (lo + hi) >> 1;
+    if(m_instructions[mid].m_address < a_address) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+
+
+int gmByteCodeOpt::Next(int a_index) const
+{
+  const int count = m_instructions.Count();
+  for(++a_index; a_index < count; ++a_index)
+  {
+    if(m_instructions[a_index].m_live) break;
+  }
+  return a_index;
+}
+
+
+
+int gmByteCodeOpt::Resolve(int a_index) const
+{
+  // removed instructions fall through to the next live instruction
+  const int count = m_instructions.Count();
+  while(a_index < count && !m_instructions[a_index].m_live) ++a_index;
+  return a_index;
+}
+
+
+
+void gmByteCodeOpt::MarkTargets()
+{
+  const int count = m_instructions.Count();
+  int i;
+  for(i = 0; i < count; ++i)
+  {
+    m_instructions[i].m_isTarget = false;
+  }
+  for(i = 0; i < count; ++i)
+  {
+    Instruction &ins = m_instructions[i];
+    if(ins.m_live && ins.m_target >= 0)
+    {
+      ins.m_target = Resolve(ins.m_target);
+      if(ins.m_target < count) m_instructions[ins.m_target].m_isTarget = true;
+    }
+  }
+}
+
+
+
+bool gmByteCodeOpt::FoldConstants(gmCodeGenStats &a_stats)
+{
+  // push a, push b, op -> push (a op b)
+  // push a, op -> push (op a)
+  // only the first instruction of a pattern may be a branch target.
+  const int count = m_instructions.Count();
+  bool changed = false;
+  gmVariable a, b, r;
+  int i;
+  for(i = Resolve(0); i < count; i = Next(i))
+  {
+    if(!gmGetConstant(m_instructions[i].m_byteCode, m_instructions[i].m_operand32, a)) continue;
+    int j = Next(i);
+    if(j >= count || m_instructions[j].m_isTarget) continue;
+
+    if(gmFoldUnary(m_instructions[j].m_byteCode, a, r))
+    {
+      m_instructions[i].m_live = false;
+      gmSetConstant(m_instructions[j].m_byteCode, m_instructions[j].m_operand32, r);
+      ++a_stats.m_folded;
+      changed = true;
+      continue;
+    }
+
+    if(!gmGetConstant(m_instructions[j].m_byteCode, m_instructions[j].m_operand32, b)) continue;
+    int k = Next(j);
+    if(k >= count || m_instructions[k].m_isTarget) continue;
+
+    if(gmFoldBinary(m_instructions[k].m_byteCode, a, b, r))
+    {
+      m_instructions[i].m_live = false;
+      m_instructions[j].m_live = false;
+      gmSetConstant(m_instructions[k].m_byteCode, m_instructions[k].m_operand32, r);
+      ++a_stats.m_folded;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+
+
+bool gmByteCodeOpt::FoldBranches(gmCodeGenStats &a_stats)
+{
+  // push const, brz -> bra or nothing.  the keep variants leave the constant on the stack.
+  const int count = m_instructions.Count();
+  bool changed = false;
+  gmVariable a;
+  int i;
+  for(i = Resolve(0); i < count; i = Next(i))
+  {
+    if(!gmGetConstant(m_instructions[i].m_byteCode, m_instructions[i].m_operand32, a)) continue;
+    int j = Next(i);
+    if(j >= count || m_instructions[j].m_isTarget) continue;
+
+    Instruction &branch = m_instructions[j];
+    bool zero = gmIsZero(a);
+    bool taken;
+
+    switch(branch.m_byteCode)
+    {
+      case BC_BRZ : taken = zero; break;
+      case BC_BRNZ : taken = !zero; break;
+      case BC_BRZK : taken = zero; break;
+      case BC_BRNZK : taken = !zero; break;
+      default: continue;
+    }
+
+    if(branch.m_byteCode == BC_BRZ || branch.m_byteCode == BC_BRNZ)
+    {
+      m_instructions[i].m_live = false;
+    }
+    if(taken)
+    {
+      branch.m_byteCode = BC_BRA;
+    }
+    else
+    {
+      branch.m_live = false;
+      branch.m_target = -1;
+    }
+    ++a_stats.m_branchesRemoved;
+    changed = true;
+  }
+  return changed;
+}
+
+
+
+bool gmByteCodeOpt::ThreadJumps(gmCodeGenStats &a_stats)
+{
+  const int count = m_instructions.Count();
+  bool changed = false;
+  int i;
+  for(i = Resolve(0); i < count; i = Next(i))
+  {
+    Instruction &ins = m_instructions[i];
+    if(ins.m_target < 0) continue;
+
+    // follow bra chains
+    int target = Resolve(ins.m_target), hops = 0;
+    while(target < count && target != i && m_instructions[target].m_byteCode == BC_BRA && hops++ < GMBYTECODEOPT_MAXTHREAD)
+    {
+      target = Resolve(m_instructions[target].m_target);
+    }
+    if(target != ins.m_target)
+    {
+      ins.m_target = target;
+      ++a_stats.m_jumpsThreaded;
+      changed = true;
+    }
+
+    if(ins.m_byteCode != BC_BRA) continue;
+
+    // bra to the next instruction
+    if(target == Next(i))
+    {
+      ins.m_live = false;
+      ins.m_target = -1;
+      ++a_stats.m_branchesRemoved;
+      changed = true;
+    }
+    // bra to a return, return here
+    else if(target < count && (m_instructions[target].m_byteCode == BC_RET || m_instructions[target].m_byteCode == BC_RETV))
+    {
+      ins.m_byteCode = m_instructions[target].m_byteCode;
+      ins.m_target = -1;
+      ++a_stats.m_jumpsThreaded;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+
+
+bool gmByteCodeOpt::RemovePushPops(gmCodeGenStats &a_stats)
+{
+  const int count = m_instructions.Count();
+  bool changed = false;
+  int i;
+  for(i = Resolve(0); i < count; i = Next(i))
+  {
+    if(!gmIsPurePush(m_instructions[i].m_byteCode)) continue;
+    int j = Next(i);
+    if(j >= count || m_instructions[j].m_isTarget) continue;
+
+    if(m_instructions[j].m_byteCode == BC_POP)
+    {
+      m_instructions[i].m_live = false;
+      m_instructions[j].m_live = false;
+    }
+    else if(m_instructions[j].m_byteCode == BC_POP2)
+    {
+      m_instructions[i].m_live = false;
+      m_instructions[j].m_byteCode = BC_POP;
+    }
+    else continue;
+
+    ++a_stats.m_pushPopsRemoved;
+    changed = true;
+  }
+  return changed;
+}
+
+
+
+bool gmByteCodeOpt::RemoveUnreachable(gmCodeGenStats &a_stats)
+{
+  const int count = m_instructions.Count();
+  int i;
+  for(i = 0; i < count; ++i)
+  {
+    m_instructions[i].m_reached = false;
+  }
+
+  m_work.Reset();
+  m_work.InsertLast(Resolve(0));
+  while(m_work.Count())
+  {
+    int at = m_work[m_work.Count() - 1];
+    m_work.RemoveLast();
+
+    while(at < count && !m_instructions[at].m_reached)
+    {
+      Instruction &ins = m_instructions[at];
+      ins.m_reached = true;
+      if(ins.m_target >= 0)
+      {
+        m_work.InsertLast(Resolve(ins.m_target));
+      }
+      if(ins.m_byteCode == BC_BRA || ins.m_byteCode == BC_RET || ins.m_byteCode == BC_RETV)
+      {
+        break;
+      }
+      at = Next(at);
+    }
+  }
+
+  bool changed = false;
+  for(i = 0; i < count; ++i)
+  {
+    Instruction &ins = m_instructions[i];
+    if(ins.m_live && !ins.m_reached)
+    {
+      ins.m_live = false;
+      ins.m_target = -1;
+      ++a_stats.m_unreachableRemoved;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+
+
+void gmByteCodeOpt::FuseInstructions(gmCodeGenStats &a_stats)
+{
+  // the superinstruction replaces the first byte code of a sequence, the rest is left as is.  sequence members
+  // are never the start of another sequence so the superinstruction handlers can rely on their byte codes.
+  const int count = m_instructions.Count();
+  int i = Resolve(0);
+  while(i < count)
+  {
+    int seq[4];
+    int length = 0;
+    seq[0] = i;
+    seq[1] = Next(seq[0]);
+    seq[2] = (seq[1] < count) ? Next(seq[1]) : count;
+    seq[3] = (seq[2] < count) ? Next(seq[2]) : count;
+    gmuint32 bc[4];
+    int k;
+    for(k = 0; k < 4; ++k)
+    {
+      bc[k] = (seq[k] < count) ? m_instructions[seq[k]].m_byteCode : BC_NOP;
+    }
+
+    gmuint32 fused = BC_NOP;
+    if(bc[0] == BC_GETLOCAL)
+    {
+      if((bc[1] == BC_GETLOCAL || bc[1] == BC_PUSHINT || bc[1] == BC_PUSHFP) && bc[3] == BC_BRZ &&
+         (fused = gmLocalCompareBranch(bc[2])) != BC_NOP)
+      {
+        length = 4;
+      }
+      else if((bc[1] == BC_PUSHINT || bc[1] == BC_PUSHINT1) && bc[2] == BC_OP_ADD && bc[3] == BC_SETLOCAL)
+      {
+        fused = BC_INCLOCAL;
+        length = 4;
+      }
+      else if(bc[1] == BC_GETDOT)
+      {
+        fused = BC_GETLOCAL_GETDOT;
+        length = 2;
+      }
+      else if(bc[1] == BC_GETLOCAL && bc[2] != BC_GETDOT) // leave the second get local to fuse with the get dot
+      {
+        fused = BC_GETLOCAL2;
+        length = 2;
+      }
+    }
+    else if(bc[0] == BC_GETTHIS && bc[1] == BC_GETDOT)
+    {
+      fused = BC_GETTHIS_GETDOT;
+      length = 2;
+    }
+
+    if(length)
+    {
+      m_instructions[i].m_byteCode = fused;
+      ++a_stats.m_superInstructions;
+      i = seq[length - 1];
+    }
+    i = Next(i);
+  }
+}
+
+
+
+void gmByteCodeOpt::Encode(gmArraySimple<gmLineInfo> &a_lineInfo)
+{
+  const int count = m_instructions.Count();
+  int i;
+
+  // new instruction addresses
+  m_work.SetCount(count + 1);
+  gmuint32 address = 0;
+  for(i = 0; i < count; ++i)
+  {
+    m_work[i] = (int) address;
+    if(m_instructions[i].m_live)
+    {
+      address += gmInstructionSize(m_instructions[i].m_byteCode);
+    }
+  }
+  m_work[count] = (int) address;
+
+  // relocate line info, removed instructions map onto the next live instruction
+  int d = -1;
+  for(i = 0; i < (int) a_lineInfo.Count(); ++i)
+  {
+    int at = FindInstruction((gmuint32) a_lineInfo[i].m_address);
+    a_lineInfo[i].m_address = m_work[Resolve(at)];
+    if(d >= 0 && a_lineInfo[d].m_address == a_lineInfo[i].m_address)
+    {
+      a_lineInfo[d] = a_lineInfo[i];
+    }
+    else
+    {
+      a_lineInfo[++d] = a_lineInfo[i];
+    }
+  }
+  a_lineInfo.SetCount(d + 1);
+
+  // write out the live instructions
+  for(i = 0; i < count; ++i)
+  {
+    const Instruction &ins = m_instructions[i];
+    if(!ins.m_live) continue;
+
+    m_byteCode << ins.m_byteCode;
+    if(gmIsBranch(ins.m_byteCode))
+    {
+      m_byteCode << (gmptr) m_work[Resolve(ins.m_target)];
+    }
+    else if(gmHasPtrOperand(ins.m_byteCode))
+    {
+      m_byteCode << ins.m_operandPtr;
+    }
+    else if(gmHasOperand32(ins.m_byteCode))
+    {
+      m_byteCode << ins.m_operand32;
+    }
+  }
+}
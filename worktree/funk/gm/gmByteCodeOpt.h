@@ -0,0 +1,84 @@
+/*
+    _____               __  ___          __            ____        _      __
+   / ___/__ ___ _  ___ /  |/  /__  ___  / /_____ __ __/ __/_______(_)__  / /_
+  / (_ / _ `/  ' \/ -_) /|_/ / _ \/ _ \/  '_/ -_) // /\ \/ __/ __/ / _ \/ __/
+  \___/\_,_/_/_/_/\__/_/  /_/\___/_//_/_/\_\\__/\_, /___/\__/_/ /_/ .__/\__/
+                                               /___/             /_/
+
+  See Copyright Notice in gmMachine.h
+*/
+
+#ifndef _GMBYTECODEOPT_H_
+#define _GMBYTECODEOPT_H_
+
+#include "gmConfig.h"
+#include "gmStreamBuffer.h"
+#include "gmArraySimple.h"
+#include "gmByteCode.h"
+#include "gmCodeGen.h"
+#include "gmCodeGenHooks.h"
+
+/// \class gmByteCodeOpt
+/// \brief gmByteCodeOpt is the optimisation pass gmCodeGen runs over each function before handing it to the
+///        gmCodeGenHooks.  It folds constant expressions, removes constant branches and unreachable code, threads
+///        branch chains and removes push, pop pairs.  Branch operands and line info are relocated to the new code.
+///        Finally common byte code sequences are fused into superinstructions (GMCODEGEN_SUPERINSTRUCTIONS).
+class gmByteCodeOpt
+{
+public:
+
+  gmByteCodeOpt();
+  ~gmByteCodeOpt();
+
+  /// \brief Optimise() will optimise one function's byte code.
+  /// \param a_byteCode is the byte code as generated by gmByteCodeGen, must be in native byte order.
+  /// \param a_lineInfo line info for the function, addresses are relocated in place.
+  /// \param a_stats has the instruction counts added to it.
+  /// \return false if the byte code could not be optimised, in which case the original byte code should be used.
+  bool Optimise(const void * a_byteCode, int a_byteCodeLength, gmArraySimple<gmLineInfo> &a_lineInfo, gmCodeGenStats &a_stats);
+
+  /// \brief Count() will return the number of instructions in the byte code.
+  int Count(const void * a_byteCode, int a_byteCodeLength) const;
+
+  /// \brief GetByteCode() will return the optimised byte code, valid until the next Optimise().
+  inline const void * GetByteCode() const { return m_byteCode.GetData(); }
+  inline int GetByteCodeLength() const { return (int) m_byteCode.Tell(); }
+
+  void FreeMemory();
+
+private:
+
+  // Instruction
+  struct Instruction
+  {
+    gmuint32 m_address;     //!< address in the source byte code
+    gmuint32 m_byteCode;
+    gmuint32 m_operand32;   //!< operand for 32 bit operand instructions
+    gmptr m_operandPtr;     //!< operand for pointer sized operand instructions
+    int m_target;           //!< instruction index of branch target
+    bool m_live;
+    bool m_isTarget;
+    bool m_reached;
+  };
+
+  gmArraySimple<Instruction> m_instructions;
+  gmArraySimple<int> m_work;
+  gmStreamBufferDynamic m_byteCode;
+
+  bool Decode(const void * a_byteCode, int a_byteCodeLength);
+  int FindInstruction(gmuint32 a_address) const;
+  int Next(int a_index) const;
+  int Resolve(int a_index) const;
+  void MarkTargets();
+
+  bool FoldConstants(gmCodeGenStats &a_stats);
+  bool FoldBranches(gmCodeGenStats &a_stats);
+  bool ThreadJumps(gmCodeGenStats &a_stats);
+  bool RemovePushPops(gmCodeGenStats &a_stats);
+  bool RemoveUnreachable(gmCodeGenStats &a_stats);
+  void FuseInstructions(gmCodeGenStats &a_stats);
+
+  void Encode(gmArraySimple<gmLineInfo> &a_lineInfo);
+};
+
+#endif // _GMBYTECODEOPT_H_
@@ -12,6 +12,7 @@
 #include "gmCodeGen.h"
 #include "gmCodeTree.h"
 #include "gmByteCodeGen.h"
+#include "gmByteCodeOpt.h"
 #include "gmArraySimple.h"
 #include "gmListDouble.h"
 
@@ -26,21 +27,18 @@ static void gmSortDebugLines(gmArraySimple<gmLineInfo> &a_lineInfo)
 {
   int count = a_lineInfo.Count();
 
-  // sort by address
+  // sort by address, lines are recorded nearly in address order so an insertion sort is about one pass
   int i;
-  for(i = 0; i < count; ++i)
+  for(i = 1; i < count; ++i)
   {
-    int min = i, j;
-    for(j = i + 1; j < count; ++j)
+    gmLineInfo t = a_lineInfo[i];
+    int j = i;
+    while(j > 0 && a_lineInfo[j - 1].m_address > t.m_address)
     {
-      if(a_lineInfo[j].m_address < a_lineInfo[min].m_address) 
-      {
-        min = j;
-      }
+      a_lineInfo[j] = a_lineInfo[j - 1];
+      --j;
     }
-    gmLineInfo t = a_lineInfo[min];
-    a_lineInfo[min] = a_lineInfo[i];
-    a_lineInfo[i] = t;
+    a_lineInfo[j] = t;
   }
 
   // remove duplicate line numbers
@@ -71,8 +69,9 @@ public:
   // implementation
 
   virtual void FreeMemory();
-  virtual int Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log);
+  virtual int Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log, bool a_optimise, bool a_lineOps);
   virtual int Unlock();
+  virtual const gmCodeGenStats &GetStats() const { return m_stats; }
 
   // helpers
 
@@ -96,6 +95,7 @@ public:
   bool GenExprOpUnary(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
   bool GenExprOpArrayIndex(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
   bool GenExprOpAr(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
+  bool GenExprOpAdd(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode, bool a_end, bool &a_string, bool &a_concat);
   bool GenExprOpShift(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
   bool GenExprOpComparison(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
   bool GenExprOpBitwise(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode);
@@ -112,6 +112,11 @@ public:
   gmLog * m_log;
   gmCodeGenHooks * m_hooks;
   bool m_debug;
+  bool m_optimise;
+  bool m_lineOps; //!< emit BC_LINE, debug only
+  int m_line; //!< line of the last BC_LINE emitted
+  gmCodeGenStats m_stats;
+  gmByteCodeOpt m_optimiser;
 
   // Variable
   struct Variable
@@ -172,6 +177,7 @@ public:
   void PushLoop();
   void PopLoop();
   void ApplyPatches(int a_patches, gmByteCodeGen * a_byteCode, gmuint32 a_value);
+  void OptimiseFunction(gmFunctionInfo &a_info);
 };
 
 
@@ -205,6 +211,20 @@ gmCodeGen& gmCodeGen::Get()
 
 
 
+gmCodeGen * gmCodeGen::Create()
+{
+  return GM_NEW( gmCodeGenPrivate() );
+}
+
+
+
+void gmCodeGen::Destroy(gmCodeGen * a_codeGen)
+{
+  delete a_codeGen;
+}
+
+
+
 //
 //
 // Implementation of gmCodeGenPrivate
@@ -218,6 +238,10 @@ gmCodeGenPrivate::gmCodeGenPrivate()
   m_log = NULL;
   m_hooks = NULL;
   m_debug = false;
+  m_optimise = false;
+  m_lineOps = false;
+  m_line = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
 
   m_currentLoop = -1;
   m_currentFunction = NULL;
@@ -241,12 +265,13 @@ void gmCodeGenPrivate::FreeMemory()
     m_loopStack.ResetAndFreeMemory();
     m_functionStack.RemoveAndDeleteAll();
     m_patches.ResetAndFreeMemory();
+    m_optimiser.FreeMemory();
   }
 }
 
 
 
-int gmCodeGenPrivate::Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log)
+int gmCodeGenPrivate::Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log, bool a_optimise, bool a_lineOps)
 {
   if(m_locked == true) return 1;
 
@@ -256,6 +281,10 @@ int gmCodeGenPrivate::Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a
   m_log = a_log;
   m_hooks = a_hooks;
   m_debug = a_debug;
+  m_optimise = a_optimise;
+  m_lineOps = a_debug && a_lineOps;
+  m_line = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
 
   GM_ASSERT(m_hooks != NULL);
 
@@ -312,6 +341,7 @@ int gmCodeGenPrivate::Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a
     info.m_lineInfoCount = m_currentFunction->m_lineInfo.Count();
     info.m_lineInfo = m_currentFunction->m_lineInfo.GetData();
     info.m_debugName = "__main";
+    OptimiseFunction(info);
     m_hooks->AddFunction(info);
 
     //gmByteCodePrint(stdout, info.m_byteCode, info.m_byteCodeLength);
@@ -333,6 +363,8 @@ int gmCodeGenPrivate::Unlock()
   m_log = NULL;
   m_hooks = NULL;
   m_debug = false;
+  m_optimise = false;
+  m_lineOps = false;
   m_currentLoop = -1;
   m_loopStack.Reset();
   m_patches.Reset();
@@ -348,15 +380,15 @@ bool gmCodeGenPrivate::Generate(const gmCodeTreeNode * a_node, gmByteCodeGen * a
   while(a_node)
   {
     // record line number
-    static int s_line = 0;
     if(m_currentFunction) m_currentFunction->m_currentLine = a_node->m_lineNumber;
 
-    // if we are in debug, emit a BC_LINE instruction
-    if(m_debug && (s_line != a_node->m_lineNumber) && 
+    // if we are in debug with line ops, emit a BC_LINE instruction
+    if(m_lineOps && (m_line != a_node->m_lineNumber) && 
        !(a_node->m_type == CTNT_STATEMENT && a_node->m_subType == CTNST_COMPOUND))
     {
       a_byteCode->Emit(BC_LINE);
-      s_line = a_node->m_lineNumber;
+      m_line = a_node->m_lineNumber;
+      ++m_stats.m_lineInstructions;
     }
 
     switch(a_node->m_type)
@@ -596,6 +628,7 @@ bool gmCodeGenPrivate::GenExprFunction(const gmCodeTreeNode * a_node, gmByteCode
     info.m_lineInfoCount = m_currentFunction->m_lineInfo.Count();
     info.m_lineInfo = m_currentFunction->m_lineInfo.GetData();
     info.m_debugName = m_currentFunction->m_debugName;
+    OptimiseFunction(info);
     m_hooks->AddFunction(info);
 
     //gmByteCodePrint(stdout, info.m_byteCode, info.m_byteCodeLength);
@@ -1031,6 +1064,12 @@ bool gmCodeGenPrivate::GenExprOpAr(const gmCodeTreeNode * a_node, gmByteCodeGen
 {
   GM_ASSERT(a_node->m_type == CTNT_EXPRESSION && a_node->m_subType == CTNET_OPERATION);
 
+  if(a_node->m_subTypeType == CTNOT_ADD)
+  {
+    bool string = false, concat = false;
+    return GenExprOpAdd(a_node, a_byteCode, true, string, concat);
+  }
+
   if(!Generate(a_node->m_children[0], a_byteCode)) return false;
   if(!Generate(a_node->m_children[1], a_byteCode)) return false;
 
@@ -1039,7 +1078,6 @@ bool gmCodeGenPrivate::GenExprOpAr(const gmCodeTreeNode * a_node, gmByteCodeGen
     case CTNOT_TIMES : return a_byteCode->Emit(BC_OP_MUL);
     case CTNOT_DIVIDE : return a_byteCode->Emit(BC_OP_DIV);
     case CTNOT_REM : return a_byteCode->Emit(BC_OP_REM);
-    case CTNOT_ADD : return a_byteCode->Emit(BC_OP_ADD);
     case CTNOT_MINUS : return a_byteCode->Emit(BC_OP_SUB);
     default :
     {
@@ -1051,6 +1089,45 @@ bool gmCodeGenPrivate::GenExprOpAr(const gmCodeTreeNode * a_node, gmByteCodeGen
 
 
 
+static bool gmIsStringConstant(const gmCodeTreeNode * a_node)
+{
+  return (a_node->m_type == CTNT_EXPRESSION && a_node->m_subType == CTNET_CONSTANT && a_node->m_subTypeType == CTNCT_STRING);
+}
+
+
+
+/// \brief GenExprOpAdd() generates a chain of adds, a + b + c is ((a + b) + c).  Once a string constant is in the chain
+///        the adds are BC_CONCAT, so the thread builds the string and interns it only at the closing BC_CONCATEND.
+///        a_string is set when a string constant has been seen, a_concat when a BC_CONCAT has been emitted.
+bool gmCodeGenPrivate::GenExprOpAdd(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode, bool a_end, bool &a_string, bool &a_concat)
+{
+  const gmCodeTreeNode * left = a_node->m_children[0];
+  if(left->m_type == CTNT_EXPRESSION && left->m_subType == CTNET_OPERATION && left->m_subTypeType == CTNOT_ADD)
+  {
+    if(!GenExprOpAdd(left, a_byteCode, false, a_string, a_concat)) return false;
+  }
+  else
+  {
+    if(!Generate(left, a_byteCode)) return false;
+    a_string = gmIsStringConstant(left);
+  }
+  if(!Generate(a_node->m_children[1], a_byteCode)) return false;
+  a_string = a_string || gmIsStringConstant(a_node->m_children[1]);
+
+  if(a_string && !a_end)
+  {
+    a_concat = true;
+    return a_byteCode->Emit(BC_CONCAT);
+  }
+  if(a_concat)
+  {
+    return a_byteCode->Emit(BC_CONCATEND);
+  }
+  return a_byteCode->Emit(BC_OP_ADD);
+}
+
+
+
 bool gmCodeGenPrivate::GenExprOpShift(const gmCodeTreeNode * a_node, gmByteCodeGen * a_byteCode)
 {
   GM_ASSERT(a_node->m_type == CTNT_EXPRESSION && a_node->m_subType == CTNET_OPERATION);
@@ -1549,11 +1626,8 @@ gmCodeGenPrivate::FunctionState * gmCodeGenPrivate::PushFunction()
 
   m_currentFunction->m_byteCode.SetSwapEndianOnWrite(m_hooks->SwapEndian());
 
-  // if we are debugging, set up some line number debugging.
-  if(m_debug)
-  {
-    m_currentFunction->m_byteCode.m_emitCallback = gmLineNumberCallback;
-  }
+  // record the line table, debug or not, so errors and profilers can name lines without BC_LINE in the byte code.
+  m_currentFunction->m_byteCode.m_emitCallback = gmLineNumberCallback;
 
   return m_currentFunction;
 }
@@ -1613,3 +1687,24 @@ void gmCodeGenPrivate::ApplyPatches(int a_patches, gmByteCodeGen * a_byteCode, g
   }
   a_byteCode->Seek(pos);
 }
+
+
+
+void gmCodeGenPrivate::OptimiseFunction(gmFunctionInfo &a_info)
+{
+  // swapped endian byte code is left as generated, the optimiser reads operands in native order.
+  if(m_optimise && !m_hooks->SwapEndian() &&
+     m_optimiser.Optimise(a_info.m_byteCode, a_info.m_byteCodeLength, m_currentFunction->m_lineInfo, m_stats))
+  {
+    a_info.m_byteCode = m_optimiser.GetByteCode();
+    a_info.m_byteCodeLength = m_optimiser.GetByteCodeLength();
+    a_info.m_lineInfoCount = m_currentFunction->m_lineInfo.Count();
+    a_info.m_lineInfo = m_currentFunction->m_lineInfo.GetData();
+  }
+  else
+  {
+    int count = m_optimiser.Count(a_info.m_byteCode, a_info.m_byteCodeLength);
+    m_stats.m_instructions += count;
+    m_stats.m_optimisedInstructions += count;
+  }
+}
@@ -19,6 +19,21 @@
 // fwd decl
 struct gmCodeTreeNode;
 
+/// \struct gmCodeGenStats
+/// \brief gmCodeGenStats counts the instructions generated by a gmCodeGen::Lock(), before and after optimisation.
+struct gmCodeGenStats
+{
+  int m_instructions;             //!< instructions generated
+  int m_lineInstructions;         //!< BC_LINE instructions among them, none unless compiled with debug and line ops
+  int m_optimisedInstructions;    //!< instructions remaining after optimisation
+  int m_folded;                   //!< constant expressions folded
+  int m_branchesRemoved;          //!< constant and redundant branches removed
+  int m_jumpsThreaded;            //!< branches retargeted through branch chains or onto a return
+  int m_pushPopsRemoved;          //!< push, pop pairs removed
+  int m_unreachableRemoved;       //!< unreachable instructions removed
+  int m_superInstructions;        //!< sequences fused into a superinstruction
+};
+
 /// \class gmCodeGen
 /// \brief gmCodeGen will create byte code for a given code tree.  after parsing script into a code tree using gmCodeTree,
 ///        turn it into byte code using this class.  After the code gen has been run, the gmCodeTree may be unlocked.
@@ -30,6 +45,13 @@ public:
   /// \brief Get() will return the singleton code generator.
   static gmCodeGen& Get();
 
+  /// \brief Create() will return a new code generator, for compiling on a thread other than the one using Get().
+  ///        Release with Destroy().
+  static gmCodeGen * Create();
+
+  /// \brief Destroy() will delete a code generator returned by Create().
+  static void Destroy(gmCodeGen * a_codeGen);
+
   /// \brief FreeMemory() will free all memory allocated by the code tree.  must be unlocked
   virtual void FreeMemory() = 0;
 
@@ -38,11 +60,19 @@ public:
   /// \param a_hooks is the byte code authoring object.
   /// \param a_debug is true if debug info is required.
   /// \param a_log is the compile log.
+  /// \param a_optimise is true if the byte code should be run through gmByteCodeOpt.
+  /// \param a_lineOps is true if debug byte code should mark each new source line with a BC_LINE for the debugger.
+  ///        the line table given to the hooks is recorded either way.
   /// \return the number of errors encounted
-  virtual int Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log) = 0;
+  virtual int Lock(const gmCodeTreeNode * a_codeTree, gmCodeGenHooks * a_hooks, bool a_debug, gmLog * a_log, bool a_optimise = false, bool a_lineOps = true) = 0;
+
+  /// \brief GetStats() will return the instruction counts for the last Lock().
+  virtual const gmCodeGenStats &GetStats() const = 0;
  
   /// \brief Unlock() will reset the code generator.
   virtual int Unlock() = 0;
+
+  virtual ~gmCodeGen() {}
 };
 
 
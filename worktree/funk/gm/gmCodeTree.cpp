@@ -12,14 +12,16 @@
 #include "gmConfig.h"
 #include "gmCodeTree.h"
 
-gmCodeTreeNode * g_codeTree = NULL;
+// parser state is per thread, so independent scripts may be parsed concurrently each with its own gmCodeTree
+GM_THREAD_LOCAL gmCodeTreeNode * g_codeTree = NULL;
+static GM_THREAD_LOCAL gmCodeTree * s_currentCodeTree = NULL;
 
 
 
 gmCodeTree::gmCodeTree() :
   m_mem(1, GMCODETREE_CHAINSIZE)
 {
-  g_codeTree = NULL;
+  m_root = NULL;
   m_locked = false;
   m_errors = 0;
   m_log = 0;
@@ -42,6 +44,14 @@ gmCodeTree &gmCodeTree::Get()
 
 
 
+gmCodeTree &gmCodeTree::Current()
+{
+  GM_ASSERT(s_currentCodeTree != NULL);
+  return (s_currentCodeTree) ? *s_currentCodeTree : Get();
+}
+
+
+
 void gmCodeTree::FreeMemory()
 {
   if(m_locked == false)
@@ -59,17 +69,22 @@ int gmCodeTree::Lock(const char * a_script, gmLog * a_log)
   m_errors = 0;
   m_locked = true;
   m_log = a_log;
+  m_root = NULL;
   g_codeTree = NULL;
   //gmdebug = 1;
-  gmlineno = 1;
 
   // create a scan buffer
-  YY_BUFFER_STATE buffer = gm_scan_string(a_script);
-  if(buffer)
+  gmScanState scan;
+  if(gmScanBegin(&scan, a_script))
   {
+    gmCodeTree * current = s_currentCodeTree;
+    s_currentCodeTree = this;
     m_errors = gmparse();
-    gm_delete_buffer(buffer);
+    m_root = g_codeTree;
+    g_codeTree = NULL;
+    s_currentCodeTree = current;
   }
+  gmScanEnd(&scan);
   return m_errors;
 }
 
@@ -78,7 +93,7 @@ int gmCodeTree::Lock(const char * a_script, gmLog * a_log)
 int gmCodeTree::Unlock()
 {
   m_mem.Reset();
-  g_codeTree = NULL;
+  m_root = NULL;
   m_locked = false;
   m_errors = 0;
   m_log = NULL;
@@ -89,7 +104,7 @@ int gmCodeTree::Unlock()
 
 const gmCodeTreeNode * gmCodeTree::GetCodeTree() const
 {
-  return g_codeTree;
+  return m_root;
 }
 
 
@@ -261,7 +276,7 @@ void gmCodeTree::Print(FILE * a_fp)
 {
   if(m_locked)
   {
-    PrintRecursive(g_codeTree, a_fp, true);
+    PrintRecursive(m_root, a_fp, true);
   }
 }
 
@@ -272,7 +287,7 @@ void gmCodeTree::Print(FILE * a_fp)
 
 gmCodeTreeNode * gmCodeTreeNode::Create(gmCodeTreeNodeType a_type, int a_subType, int a_lineNumber, int a_subTypeType)
 {
-  gmCodeTreeNode * node = (gmCodeTreeNode *) gmCodeTree::Get().Alloc(sizeof(gmCodeTreeNode), GM_DEFAULT_ALLOC_ALIGNMENT);
+  gmCodeTreeNode * node = (gmCodeTreeNode *) gmCodeTree::Current().Alloc(sizeof(gmCodeTreeNode), GM_DEFAULT_ALLOC_ALIGNMENT);
   GM_ASSERT(node != NULL);
   memset(node, 0, sizeof(gmCodeTreeNode));
   node->m_type = a_type;
@@ -330,7 +345,7 @@ static bool gmFold(float &a_r, float a_a, float a_b, int a_op)
   {
     case CTNOT_TIMES : a_r = a_a * a_b; break;
     case CTNOT_DIVIDE : if(a_b == 0) return false; a_r = a_a / a_b; break;
-    case CTNOT_REM : a_r = fmodf(a_a, a_b); break;
+    case CTNOT_REM : if(a_b == 0) return false; a_r = fmodf(a_a, a_b); break;
     case CTNOT_ADD : a_r = a_a + a_b; break;
     case CTNOT_MINUS : a_r = a_a - a_b; break;
     default: return false;
@@ -345,7 +360,7 @@ static bool gmFold(int &a_r, int a_a, int a_b, int a_op)
   {
     case CTNOT_TIMES : a_r = a_a * a_b; break;
     case CTNOT_DIVIDE : if(a_b == 0) return false; a_r = a_a / a_b; break;
-    case CTNOT_REM : a_r = a_a % a_b; break;
+    case CTNOT_REM : if(a_b == 0) return false; a_r = a_a % a_b; break;
     case CTNOT_ADD : a_r = a_a + a_b; break;
     case CTNOT_MINUS : a_r = a_a - a_b; break;
     case CTNOT_BIT_OR : a_r = a_a | a_b; break;
@@ -431,29 +446,38 @@ bool gmCodeTreeNode::ConstantFold()
         if((l->m_subTypeType == CTNCT_INT || (l->m_subTypeType == CTNCT_FLOAT && !intOnly)) && 
            (r->m_subTypeType == CTNCT_INT || (r->m_subTypeType == CTNCT_FLOAT && !intOnly)))
         {
-          // we can fold....
-          m_children[0] = NULL; m_children[1] = NULL;
-          m_subType = CTNET_CONSTANT;
+          // we can fold, unless the operation would fault, ie divide by zero, leave that for run time
+          int iValue = 0;
+          float fValue = 0.0f;
+          bool folded = false;
+          int constantType = CTNCT_FLOAT;
           if(l->m_subTypeType == CTNCT_INT && r->m_subTypeType == CTNCT_INT)
           {
-            gmFold(m_data.m_iValue, l->m_data.m_iValue, r->m_data.m_iValue, m_subTypeType);
-            m_subTypeType = CTNCT_INT;
+            folded = gmFold(iValue, l->m_data.m_iValue, r->m_data.m_iValue, m_subTypeType);
+            constantType = CTNCT_INT;
           }
           else if(l->m_subTypeType == CTNCT_FLOAT && r->m_subTypeType == CTNCT_FLOAT)
           {
-            gmFold(m_data.m_fValue, l->m_data.m_fValue, r->m_data.m_fValue, m_subTypeType);
-            m_subTypeType = CTNCT_FLOAT;
+            folded = gmFold(fValue, l->m_data.m_fValue, r->m_data.m_fValue, m_subTypeType);
           }
           else if(l->m_subTypeType == CTNCT_INT && r->m_subTypeType == CTNCT_FLOAT)
           {
-            gmFold(m_data.m_fValue, (float) l->m_data.m_iValue, r->m_data.m_fValue, m_subTypeType);
-            m_subTypeType = CTNCT_FLOAT;
+            folded = gmFold(fValue, (float) l->m_data.m_iValue, r->m_data.m_fValue, m_subTypeType);
           }
           else if(l->m_subTypeType == CTNCT_FLOAT && r->m_subTypeType == CTNCT_INT)
           {
-            gmFold(m_data.m_fValue, l->m_data.m_fValue, (float) r->m_data.m_iValue, m_subTypeType);
-            m_subTypeType = CTNCT_FLOAT;
+            folded = gmFold(fValue, l->m_data.m_fValue, (float) r->m_data.m_iValue, m_subTypeType);
           }
+          if(!folded)
+          {
+            return false;
+          }
+
+          m_children[0] = NULL; m_children[1] = NULL;
+          m_subType = CTNET_CONSTANT;
+          m_subTypeType = constantType;
+          if(constantType == CTNCT_INT) m_data.m_iValue = iValue;
+          else m_data.m_fValue = fValue;
           return true;
         }
       }
@@ -544,7 +568,7 @@ void gmProcessDoubleQuoteString(char * a_string)
 
 int gmerror(char * a_message)
 {
-  gmCodeTree & ct = gmCodeTree::Get();
+  gmCodeTree & ct = gmCodeTree::Current();
   if(ct.GetLog())
   {
     ct.GetLog()->LogEntry("error (%d) %s", gmlineno, a_message);
@@ -24,18 +24,20 @@
 struct gmCodeTreeNode;
 
 /// \class gmCodeTree
-/// \brief gmCodeTree is a singleton class for creating code trees.
+/// \brief gmCodeTree is a class for creating code trees.  Get() returns the code tree shared by the machines, a thread
+///        compiling scripts concurrently with other threads should use its own gmCodeTree.
 class gmCodeTree
 {
-protected:
-  gmCodeTree();
-
 public:
+  gmCodeTree();
   ~gmCodeTree();
 
   /// \brief Get() will return the singlton parser.
   static gmCodeTree &Get();
 
+  /// \brief Current() will return the code tree being built by Lock() on the calling thread.  Used by the parser.
+  static gmCodeTree &Current();
+
   /// \brief FreeMemory() will free all memory allocated by the code tree.  must be unlocked
   void FreeMemory();
 
@@ -46,7 +48,7 @@ public:
   /// \sa Unlock()
   int Lock(const char * a_script, gmLog * a_log = NULL);
 
-  /// \brief Unlock() will unlock the singleton code tree such that it may be used again.
+  /// \brief Unlock() will unlock the code tree such that it may be used again.
   /// \return 0 on success
   /// \sa Lock()
   int Unlock();
@@ -76,6 +78,7 @@ private:
   bool m_locked;
   int m_errors;
   gmLog * m_log;
+  gmCodeTreeNode * m_root;
   gmMemChain m_mem;
 };
 
@@ -50,11 +50,23 @@ enum gmEndian
 // COMPILER CODE GENERATOR
 
 #define GM_COMPILE_PASS_THIS_ALWAYS 0         // set to 1 to pass current this to each function call
+#define GMCODEGEN_OPTIMISE          1         // default gmMachine::SetOptimiseMode(), run byte code through gmByteCodeOpt (folding, dead code, jump threading)
+#define GMCODEGEN_SUPERINSTRUCTIONS 1         // gmByteCodeOpt fuses common byte code sequences into superinstructions
+#define GMCODEGEN_LINEOPS           1         // default gmMachine::SetLineOpsMode(), emit BC_LINE in debug compiles so gmDebug can break and step by line.
+                                              // Off, lines resolve through each function's line table only, which every compile records
 
 // RUNTIME THREAD
 
 #define GMTHREAD_INITIALBYTESIZE    512       // initial stack byte size for a single thread
 #define GMTHREAD_MAXBYTESIZE        (150*1024) //1024  // max stack byte size for a single thread (Sample scripts like it big)
+#define GMTHREAD_THREADED_DISPATCH  1         // Use computed goto (direct threaded) opcode dispatch where the compiler supports it (gcc, clang), else switch
+#define GMTHREAD_QUICKEN            1         // Rewrite arithmetic byte codes to int, float and vec typed byte codes at run time, reverting if operand types change
+#define GMTHREAD_BYTECODEHISTOGRAM  0         // Allow gmMachine::EnableByteCodeHistogram() to count executed byte codes, pairs and triples (profiling only)
+#ifdef GM_PROFILE_BUILD
+  #define GMTHREAD_SAMPLING         1         // Allow gmMachine::RequestSample() to have the running thread call back at its next call or loop back edge (sampling profilers)
+#else //GM_PROFILE_BUILD
+  #define GMTHREAD_SAMPLING         0         // a flag test on every call and loop back edge, profiling builds only
+#endif //GM_PROFILE_BUILD
 
 // MACHINE
 
@@ -62,18 +74,21 @@ enum gmEndian
 #define GMMACHINE_REMOVECOMPILER    0         // Remove compiler code, will only be able to run precompiled libs
 #define GMMACHINE_GMCHECKDIVBYZERO  0         // Let GM operator check for divide by zero and possibly cause GM run time exception (rather than OS exception)
 #define GMMACHINE_NULL_VAR_CTOR     0         // Nullify gmVariable in constructor.  Not recommended for real-time / time critical applications.
+#define GM_COMPACT_VARIABLE         0         // gmVariable holds a type and one word, vec2 and vec3 are boxed in immutable gc objects.  Halves
+                                              // stack and table slots (8 bytes on 32 bit, 16 on 64 bit) at the cost of an allocation per vec result
 #define GMMACHINE_USERTYPEGROWBY    16        // allocate user types in chunks of this size
 #define GMMACHINE_OBJECTCHUNKSIZE   32        // default object chunk allocation size
 #define GMMACHINE_TBLCHUNKSIZE      32        // table object chunk allocation size
 #define GMMACHINE_STRINGCHUNKSIZE   128       // default object chunk allocation size
+#define GMMACHINE_VECCHUNKSIZE      128       // boxed vec chunk allocation size, GM_COMPACT_VARIABLE only
 #define GMMACHINE_STACKFCHUNKSIZE   128       // stack frame chunk size
 #define GMMACHINE_AUTOMEM           true      // automatically decide garbage collection limit
 #define GMMACHINE_AUTOMEMMULTIPY    2.5f      // after gc cycle, set limit = current * GMMACHINE_AUTOMEMMULTIPY (This is for atomic GC)
 #define GMMACHINE_AUTOMEMALLOWSHRINK 0        // Allow memory liimits to shrink, otherwise memory will grow when needed only
 #define GMMACHINE_INITIALGCHARDLIMIT 128*1024  // default gc hard memory limit.
 #define GMMACHINE_INITIALGCSOFTLIMIT (GMMACHINE_INITIALGCHARDLIMIT * 9 / 10) // default gc soft memory limit
-#define GMMACHINE_STRINGHASHSIZE    8192      // this will be dynamic... todo
-#define GMMACHINE_MAXKILLEDTHREADS  16        // max size of the free thread list (don't make too large, ie, < 32)
+#define GMMACHINE_STRINGHASHSIZE    8192      // initial size, grows with the number of strings
+#define GMMACHINE_MAXKILLEDTHREADS  64        // default size of the pool of killed threads kept for reuse, see gmMachine::SetThreadPoolSize()
 #define GMMACHINE_GCEVERYALLOC      0         // define this to check garbage collection every allocate.
 #define GMMACHINE_SUPERPARANOIDGC   0         // validate references (only for debugging purposes)
 #define GMMACHINE_THREEPASSGC       0         // 1 for safe gc of persisting objects that reference other objects, 
@@ -90,10 +105,17 @@ enum gmEndian
 #define GMMACHINE_GC_MIN_FRAMES_SINCE_RESTART       100    // if gc is restarting within this many frames/calls, it is probably configured bad
 #define GM_GC_DEFAULT_WORK_INCREMENT                200    // Desired number of objects to trace per frame
 #define GM_GC_DEFAULT_DESTRUCT_INCREMENT            200    // Desired number of old objects to free per frame
+#define GM_GC_DEFAULT_NURSERY_LIMIT                 4096   // Young objects allocated before a minor collection, 0 allocates straight into the old generation
 
 #define GMMACHINE_CPPOWNEDGMOBJHASHSIZE 1024  // default hash table size for objects owned by cpp code, necessary for GC.
 
+#define GMMACHINE_DOTCACHESIZE      1024      // member access (BC_GETDOT, BC_SETDOT) inline cache entries, power of 2, 0 to disable
 #define GMMACHINE_TRACK_THREAD_ALLOC_COUNTS			1  // track object allocations per-thread
+#ifdef GM_PROFILE_BUILD
+  #define GMMACHINE_ALLOCPROFILER   1         // Allow gmMachine::EnableAllocProfiler() to record allocations by site and type, with lifetimes
+#else //GM_PROFILE_BUILD
+  #define GMMACHINE_ALLOCPROFILER   0         // a store of the instruction before byte codes that may allocate, profiling builds only
+#endif //GM_PROFILE_BUILD
 
 // DEBUGGING
 
@@ -47,21 +47,46 @@
   #endif
 //  #define GM_X86
 #endif //_WIN32
+#if defined(__GNUC__) // gcc, clang (linux hosts, NAO cross toolchain)
+  #define GM_LITTLE_ENDIAN      1
+  #if defined(__LP64__) // 64bit target
+    #define GM_DEFAULT_ALLOC_ALIGNMENT 16
+    #define GM_PTR_SIZE_64 // Ptr size is 64bit
+  #else // 32bit target
+    #define GM_DEFAULT_ALLOC_ALIGNMENT 4
+    #define GM_PTR_SIZE_32 // Ptr size is 32bit
+  #endif
+  #define GM_HAS_COMPUTED_GOTO // compiler supports labels as values (goto *ptr)
+#endif //__GNUC__
 
 //#define GM_COMPILER_MSVC6
 
-#define GM_CDECL              __cdecl
+#if defined(__GNUC__)
+  #define GM_CDECL
+  #define GM_THREAD_LOCAL     __thread // compiler state, one per compiling thread
+#else //!__GNUC__
+  #define GM_CDECL            __cdecl
+  #define GM_THREAD_LOCAL     __declspec(thread)
+#endif //!__GNUC__
 #ifdef _DEBUG
   #define GM_ASSERT(A)        assert(A)
 #else //_DEBUG
   #define GM_ASSERT(A)
 #endif //_DEBUG
 #define GM_NL                 "\r\n" // "\n"
-#define GM_FORCEINLINE        __forceinline // inline
 #define GM_INLINE             inline
-#define _gmstricmp            stricmp // strcasecmp
-#define _gmsnprintf           _snprintf // snprintf
-#define _gmvsnprintf          _vsnprintf // vsnprintf
+#if defined(__GNUC__)
+  #include <strings.h> // strcasecmp
+  #define GM_FORCEINLINE      inline __attribute__((always_inline))
+  #define _gmstricmp          strcasecmp
+  #define _gmsnprintf         snprintf
+  #define _gmvsnprintf        vsnprintf
+#else //!__GNUC__
+  #define GM_FORCEINLINE      __forceinline // inline
+  #define _gmstricmp          stricmp // strcasecmp
+  #define _gmsnprintf         _snprintf // snprintf
+  #define _gmvsnprintf        _vsnprintf // vsnprintf
+#endif //!__GNUC__
 #ifdef _DEBUG
   #define GM_DEBUG_BUILD
 #endif // _DEBUG
@@ -119,7 +144,12 @@ typedef unsigned int gmuint32;
 typedef int gmint;
 typedef unsigned int gmuint;
 typedef float gmfloat;
-#ifdef GM_PTR_SIZE_64
+#if defined(GM_PTR_SIZE_64) && defined(__GNUC__)
+  typedef long long gmptr; // machine pointer size as int
+  typedef unsigned long long gmuptr; // machine pointer size as int
+  typedef long long gmint64;
+  typedef unsigned long long gmuint64;
+#elif defined(GM_PTR_SIZE_64)
   typedef __int64 gmptr; // machine pointer size as int
   typedef unsigned __int64 gmuptr; // machine pointer size as int
   typedef __int64 gmint64;
@@ -130,7 +160,9 @@ typedef float gmfloat;
 #endif //!GM_PTR_SIZE_64
 
 
-#define GM_CRT_DEBUG
+#if defined(_MSC_VER)
+  #define GM_CRT_DEBUG
+#endif //_MSC_VER
 //#undef GM_CRT_DEBUG
 
 #ifdef GM_CRT_DEBUG
@@ -78,3 +78,18 @@ gmuint32 gmCrc32String(const char *p_string)
   return ~crc32;
 }
 
+
+gmuint32 gmCrc32Buffer(const void *p_buffer, unsigned int p_size)
+{
+  register gmuint32 crc32;
+  const gmuint8 * p_byte = (const gmuint8 *) p_buffer;
+
+  crc32 = 0xffffffff;
+
+  for (; p_size; --p_size, ++p_byte)
+  {
+    crc32 = _gmUPDC32(*p_byte, crc32);
+  }
+
+  return ~crc32;
+}
@@ -15,5 +15,6 @@
 #include "gmConfig.h"
 
 gmuint32 gmCrc32String(const char *p_string);
+gmuint32 gmCrc32Buffer(const void *p_buffer, unsigned int p_size);
 
 #endif // _GMCRC_H_
@@ -13,11 +13,48 @@
 #include "gmFunctionObject.h"
 #include "gmMachine.h"
 
+//
+// The line table holds an entry per change of source line, in address order, as the address and line deltas from the
+// entry before.  Each delta is a 7 bit per byte varint, the line delta zig zag encoded, so most entries take 2 bytes.
+//
+
+#define GM_LINETABLE_MAXVARINT 5
+
+static int gmLineTableWrite(gmuint8 * a_table, gmuint32 a_value)
+{
+  int size = 0;
+  while(a_value >= 0x80)
+  {
+    a_table[size++] = (gmuint8) (a_value | 0x80);
+    a_value >>= 7;
+  }
+  a_table[size++] = (gmuint8) a_value;
+  return size;
+}
+
+static gmuint32 gmLineTableRead(const gmuint8 * &a_entry)
+{
+  gmuint32 value = 0;
+  int shift = 0;
+  while(*a_entry & 0x80)
+  {
+    value |= (gmuint32) (*(a_entry++) & 0x7f) << shift;
+    shift += 7;
+  }
+  return value | ((gmuint32) *(a_entry++) << shift);
+}
+
+static inline gmuint32 gmLineTableZigZag(int a_delta) { return (a_delta < 0) ? (((gmuint32) ~a_delta) << 1) | 1 : ((gmuint32) a_delta) << 1; }
+static inline int gmLineTableUnZigZag(gmuint32 a_value) { return (a_value & 1) ? ~((int) (a_value >> 1)) : (int) (a_value >> 1); }
+
+
 gmFunctionObject::gmFunctionObject()
 {
   m_cFunction = NULL;
   m_cUserData = NULL;
   m_debugInfo = NULL;
+  m_lineTable = NULL;
+  m_lineTableSize = 0;
   m_byteCode = NULL;
   m_byteCodeLength = 0;
   m_maxStackSize = 1; // return value
@@ -40,10 +77,15 @@ void gmFunctionObject::Destruct(gmMachine * a_machine)
     a_machine->Sys_Free(m_byteCode);
     m_byteCode = NULL;
   }
+  if(m_lineTable)
+  {
+    a_machine->Sys_Free(m_lineTable);
+    m_lineTable = NULL;
+    m_lineTableSize = 0;
+  }
   if(m_debugInfo)
   {
     if(m_debugInfo->m_debugName) { a_machine->Sys_Free(m_debugInfo->m_debugName); }
-    if(m_debugInfo->m_lineInfo) { a_machine->Sys_Free(m_debugInfo->m_lineInfo); }
     if(m_debugInfo->m_symbols)
     {
       int i;
@@ -145,17 +187,28 @@ bool gmFunctionObject::Init(gmMachine * a_machine, bool a_debug, gmFunctionInfo
         case BC_BRNZ :
         case BC_BRZK :
         case BC_BRNZK :
-        case BC_FOREACH :
+#if GM_USE_FORK
+        case BC_FORK :
+#endif //GM_USE_FORK
         case BC_GETGLOBAL :
         case BC_SETGLOBAL :
         case BC_GETTHIS :
-        case BC_SETTHIS : instruction += sizeof(gmptr); break;
+        case BC_SETTHIS :
+        case BC_GETTHIS_GETDOT : instruction += sizeof(gmptr); break;
         case BC_PUSHINT : instruction += sizeof(gmint); break;
         case BC_PUSHFP : instruction += sizeof(gmfloat); break;
       
         case BC_CALL :
+        case BC_FOREACH :
         case BC_GETLOCAL :
-        case BC_SETLOCAL : instruction += sizeof(gmuint32); break;
+        case BC_SETLOCAL :
+        case BC_GETLOCAL2 :
+        case BC_GETLOCAL_GETDOT :
+        case BC_INCLOCAL :
+        case BC_LOCAL_LT_BRZ :
+        case BC_LOCAL_LTE_BRZ :
+        case BC_LOCAL_GT_BRZ :
+        case BC_LOCAL_GTE_BRZ : instruction += sizeof(gmuint32); break;
 
         case BC_PUSHSTR :
         case BC_PUSHFN :
@@ -184,6 +237,25 @@ bool gmFunctionObject::Init(gmMachine * a_machine, bool a_debug, gmFunctionInfo
 
     delete [] (char*) references;
   }
+
+  // line table
+  m_lineTable = NULL;
+  m_lineTableSize = 0;
+  if(a_info.m_lineInfo && a_info.m_lineInfoCount > 0)
+  {
+    gmuint8 * table = GM_NEW( gmuint8[a_info.m_lineInfoCount * 2 * GM_LINETABLE_MAXVARINT] );
+    int address = 0, line = 0;
+    for(int i = 0; i < a_info.m_lineInfoCount; ++i)
+    {
+      m_lineTableSize += gmLineTableWrite(table + m_lineTableSize, (gmuint32) (a_info.m_lineInfo[i].m_address - address));
+      m_lineTableSize += gmLineTableWrite(table + m_lineTableSize, gmLineTableZigZag(a_info.m_lineInfo[i].m_lineNumber - line));
+      address = a_info.m_lineInfo[i].m_address;
+      line = a_info.m_lineInfo[i].m_lineNumber;
+    }
+    m_lineTable = (gmuint8 *) a_machine->Sys_Alloc(m_lineTableSize);
+    memcpy(m_lineTable, table, m_lineTableSize);
+    delete [] table;
+  }
   
   // debug info
   m_debugInfo = NULL;
@@ -215,15 +287,6 @@ bool gmFunctionObject::Init(gmMachine * a_machine, bool a_debug, gmFunctionInfo
         memcpy(m_debugInfo->m_symbols[i], a_info.m_symbols[i], len);
       }
     }
-
-    // line number debugging.
-    if(a_info.m_lineInfo)
-    {
-      // alloc and copy
-      m_debugInfo->m_lineInfo = (gmLineInfo *) a_machine->Sys_Alloc(sizeof(gmLineInfo) * a_info.m_lineInfoCount);
-      memcpy(m_debugInfo->m_lineInfo, a_info.m_lineInfo, sizeof(gmLineInfo) * a_info.m_lineInfoCount);
-      m_debugInfo->m_lineInfoCount = a_info.m_lineInfoCount;
-    }
   }
   
   return true;
@@ -233,19 +296,22 @@ bool gmFunctionObject::Init(gmMachine * a_machine, bool a_debug, gmFunctionInfo
 
 int gmFunctionObject::GetLine(int a_address) const
 {
-  if(m_debugInfo && m_debugInfo->m_lineInfo)
+  if(m_lineTable)
   {
-    int i;
-    for(i = 0; i < m_debugInfo->m_lineInfoCount; ++i)
+    // the line of the last entry at or before the address, the first entry's line for addresses before it
+    const gmuint8 * entry = m_lineTable, * end = m_lineTable + m_lineTableSize;
+    int address = (int) gmLineTableRead(entry);
+    int line = gmLineTableUnZigZag(gmLineTableRead(entry));
+    while(entry < end)
     {
-      if(a_address < m_debugInfo->m_lineInfo[i].m_address)
+      address += (int) gmLineTableRead(entry);
+      if(a_address < address)
       {
-        // return entry before
-        if(i > 0) --i;
-        return m_debugInfo->m_lineInfo[i].m_lineNumber;
+        break;
       }
+      line += gmLineTableUnZigZag(gmLineTableRead(entry));
     }
-    return m_debugInfo->m_lineInfo[i - 1].m_lineNumber;
+    return line;
   }
   return 0;
 }
@@ -254,15 +320,18 @@ int gmFunctionObject::GetLine(int a_address) const
 
 const void * gmFunctionObject::GetInstructionAtLine(int a_line) const
 {
-  if(m_debugInfo && m_debugInfo->m_lineInfo && m_byteCode)
+  if(m_lineTable && m_byteCode)
   {
     // serach for the first address using this line.
-    int i;
-    for(i = 0; i < m_debugInfo->m_lineInfoCount; ++i)
+    const gmuint8 * entry = m_lineTable, * end = m_lineTable + m_lineTableSize;
+    int address = 0, line = 0;
+    while(entry < end)
     {
-      if(m_debugInfo->m_lineInfo[i].m_lineNumber == a_line)
+      address += (int) gmLineTableRead(entry);
+      line += gmLineTableUnZigZag(gmLineTableRead(entry));
+      if(line == a_line)
       {
-        return (void *) ((char *) m_byteCode + m_debugInfo->m_lineInfo[i].m_address);
+        return (void *) ((char *) m_byteCode + address);
       }
     }
   }
@@ -85,13 +85,19 @@ public:
   /// \brief GetDebugName()
   inline const char * GetDebugName() const;
 
-  /// \brief GetLine() will return the source line for the given address
+  /// \brief GetByteCodeLength()
+  inline int GetByteCodeLength() const { return m_byteCodeLength; }
+
+  /// \brief GetLine() will return the source line for the given address, or 0 if the function has no line table
   int GetLine(int a_address) const;
   int GetLine(const void * a_instruction) const { return GetLine( (int)((const char * ) a_instruction - (char *) m_byteCode) ); }
 
   /// \brief GetInstructionAtLine() will return the instruction at the given line, or NULL of line was not within this function
   const void * GetInstructionAtLine(int a_line) const;
 
+  /// \brief GetLineTableSize() will return the bytes taken by the line table
+  inline int GetLineTableSize() const { return m_lineTableSize; }
+
   /// \brief GetSourceId() will get the source code id when in debug mode, else 0
   gmuint32 GetSourceId() const;
 
@@ -117,12 +123,12 @@ private:
   {
     char * m_debugName;
     char ** m_symbols;
-    int m_lineInfoCount;
     gmuint32 m_sourceId; // source code id.
-    gmLineInfo * m_lineInfo;
   };
 
   gmFunctionObjectDebugInfo * m_debugInfo;
+  gmuint8 * m_lineTable; //!< address and line deltas per line change, kept in release as well as debug
+  int m_lineTableSize;
   void * m_byteCode;
   int m_byteCodeLength;
   int m_maxStackSize;
@@ -121,7 +121,12 @@ public:
   /// \brief Find()
   T * Find(const KEY &a_key);
 
+  /// \brief Resize() will rehash all items into a table of a_size slots, a_size must be a power of 2.
+  ///        invalidates iterators.
+  void Resize(gmuint a_size);
+
   inline gmuint Count() const { return m_count; }
+  inline gmuint GetTableSize() const { return m_size; }
   inline Iterator First() const { return Iterator(this); }
 
 private:
@@ -341,6 +346,33 @@ T * QUAL::Find(const KEY &a_key)
   return NULL;
 }
 
+
+TMPL
+void QUAL::Resize(gmuint a_size)
+{
+  GM_ASSERT((a_size & (a_size - 1)) == 0);
+  T ** table = m_table;
+  gmuint size = m_size;
+
+  m_size = a_size;
+  m_table = GM_NEW(T * [a_size]);
+  RemoveAll();
+
+  // re-insert to keep each slot chain sorted by key
+  gmuint i;
+  for(i = 0; i < size; ++i)
+  {
+    T * node = table[i], * next;
+    while(node)
+    {
+      next = node->NQUAL::m_next;
+      Insert(node);
+      node = next;
+    }
+  }
+  delete [] table;
+}
+
 #undef TMPL
 #undef QUAL
 #undef NQUAL
@@ -467,6 +467,8 @@ void gmGCColorSet::Allocate(gmGCObjBase* a_obj)
 #endif //GM_GC_STATS
 
   a_obj->SetPersist(false);
+  a_obj->SetAge(GM_GC_AGE_OLD);
+  a_obj->SetRemembered(false);
 
   a_obj->SetColor(m_gc->GetCurShadeColor());
 
@@ -489,6 +491,31 @@ void gmGCColorSet::Allocate(gmGCObjBase* a_obj)
 }
 
 
+void gmGCColorSet::AllocateGray(gmGCObjBase* a_obj)
+{
+#if GM_GC_STATS
+  ++m_numAllocated;
+#endif //GM_GC_STATS
+
+  a_obj->SetPersist(false);
+  a_obj->SetAge(GM_GC_AGE_OLD);
+  a_obj->SetRemembered(false);
+
+  a_obj->SetColor(m_gc->GetCurShadeColor());
+
+#if GM_GC_DEBUG
+  GM_ASSERT(a_obj->m_curPosColor == GM_GC_DEBUG_COL_INVALID);
+  a_obj->m_curPosColor = GM_GC_DEBUG_COL_GRAY;
+#endif //GM_GC_DEBUG
+
+  //Insert at the end of gray list
+  a_obj->SetPrev(m_scan->GetPrev());
+  a_obj->SetNext(m_scan);
+  m_scan->GetPrev()->SetNext(a_obj);
+  m_scan->SetPrev(a_obj);
+}
+
+
 void gmGCColorSet::DestructAll()
 {
   int count = 0;
@@ -549,6 +576,120 @@ void gmGCColorSet::DestructAll()
   Init(m_gc);
 }
 
+//////////////////////////////////////////////////
+// gmGCNursery
+//////////////////////////////////////////////////
+
+gmGCNursery::gmGCNursery()
+{
+  Init(NULL);
+}
+
+
+void gmGCNursery::Init(gmGarbageCollector* a_gc)
+{
+  m_gc = a_gc;
+
+  m_youngList.SetNext(&m_youngList);
+  m_youngList.SetPrev(&m_youngList);
+  m_reachedList.SetNext(&m_reachedList);
+  m_reachedList.SetPrev(&m_reachedList);
+  m_remembered.Reset();
+  m_numObjects = 0;
+}
+
+
+void gmGCNursery::Allocate(gmGCObjBase* a_obj)
+{
+  a_obj->SetPersist(false);
+  a_obj->SetAge(GM_GC_AGE_YOUNG);
+  a_obj->SetRemembered(false);
+  a_obj->SetColor(m_gc->GetCurShadeColor());
+
+  LinkLast(&m_youngList, a_obj);
+  ++m_numObjects;
+}
+
+
+void gmGCNursery::Release(gmGCObjBase* a_obj)
+{
+  GM_ASSERT(a_obj->GetAge() == GM_GC_AGE_YOUNG);
+  a_obj->SetAge(GM_GC_AGE_OLD);
+  --m_numObjects;
+}
+
+
+void gmGCNursery::Remember(gmGCObjBase* a_obj)
+{
+  a_obj->SetRemembered(true);
+  m_remembered.InsertLast(a_obj);
+}
+
+
+void gmGCNursery::TraceAndPromote(gmGCColorSet& a_colorSet, bool a_gray)
+{
+  gmMachine * machine = m_gc->GetVM();
+  int workDone = 0;
+
+  // Remembered objects are old, trace them for their young references only
+  gmuint i;
+  for(i = 0; i < m_remembered.Count(); ++i)
+  {
+    gmGCObjBase* obj = m_remembered[i];
+    obj->SetRemembered(false);
+    obj->Trace(machine, m_gc, GM_MAX_INT32, workDone);
+  }
+  m_remembered.Reset();
+
+  // Trace reached objects, which may reach more, then move them to the color set
+  while(m_reachedList.GetNext() != &m_reachedList)
+  {
+    gmGCObjBase* obj = m_reachedList.GetNext();
+    obj->Trace(machine, m_gc, GM_MAX_INT32, workDone);
+
+    obj->GetNext()->SetPrev(&m_reachedList);
+    m_reachedList.SetNext(obj->GetNext());
+    if(a_gray)
+    {
+      a_colorSet.AllocateGray(obj); // May reference old objects that are white to the new cycle
+    }
+    else
+    {
+      a_colorSet.Allocate(obj); // Black, like any other object allocated during a major cycle
+    }
+  }
+}
+
+
+int gmGCNursery::DestructUnreached()
+{
+  int numDestructed = 0;
+
+  gmGCObjBase* curObj = m_youngList.GetNext();
+  while(curObj != &m_youngList)
+  {
+    gmGCObjBase* objToDestruct = curObj;
+    curObj = curObj->GetNext();
+
+    objToDestruct->Destruct(m_gc->GetVM());
+    ++numDestructed;
+  }
+
+  m_youngList.SetNext(&m_youngList);
+  m_youngList.SetPrev(&m_youngList);
+  m_numObjects = 0;
+
+  return numDestructed;
+}
+
+
+void gmGCNursery::DestructAll()
+{
+  GM_ASSERT(m_reachedList.GetNext() == &m_reachedList);
+  DestructUnreached();
+  Init(m_gc);
+}
+
 //////////////////////////////////////////////////
 // gmGarbageCollector
 //////////////////////////////////////////////////
@@ -570,11 +711,15 @@ void gmGarbageCollector::Init(gmGCScanRootsCallBack a_scanRootsCallback, gmMachi
   m_workPerIncrement = GM_GC_DEFAULT_WORK_INCREMENT;
   m_maxObjsToDestructPerIncrement = GM_GC_DEFAULT_DESTRUCT_INCREMENT;
   m_workLeftToGo = 0;
+  m_statsWorkDone = 0;
   m_fullThrottle = false;
   m_gcTurnedOff = true; // Start in OFF state, machine will turn on when needed.
   m_firstCollectionIncrement = true;
   m_doneTracing = false;
   m_colorSet.Init(this);
+  m_nursery.Init(this);
+  m_nurseryLimit = GM_GC_DEFAULT_NURSERY_LIMIT;
+  m_minorCollecting = false;
   m_traceState.Reset();
   m_flipCallback = NULL;
   m_scanRootsCallback = a_scanRootsCallback;
@@ -595,6 +740,7 @@ bool gmGarbageCollector::BlackenGrays()
 
     while(m_colorSet.BlackenNextGray(workDone, m_workLeftToGo))
     {
+      m_statsWorkDone += workDone;
       m_workLeftToGo -= workDone;
       if (m_workLeftToGo <= 0)
       {
@@ -623,6 +769,10 @@ bool gmGarbageCollector::Collect()
 
   if(m_firstCollectionIncrement)
   {
+    // Empty the nursery so every object the roots reach is in the color set.
+    // Objects allocated from here on are newer than the root snapshot.
+    MinorCollect(true);
+
     // Scan each root object and gray it
     GM_ASSERT(m_scanRootsCallback);
     m_scanRootsCallback(m_gmMachine, this);
@@ -661,6 +811,38 @@ bool gmGarbageCollector::Collect()
 }
 
 
+bool gmGarbageCollector::MarkSome(int a_maxWork)
+{
+  if(!IsTracing())
+  {
+    return false;
+  }
+
+  m_workLeftToGo = a_maxWork;
+  BlackenGrays();
+
+  return m_colorSet.AnyGrays();
+}
+
+
+int gmGarbageCollector::MinorCollect(bool a_startingCycle)
+{
+  if(m_nursery.GetNumObjects() == 0)
+  {
+    return 0;
+  }
+
+  GM_ASSERT(m_scanRootsCallback);
+
+  m_minorCollecting = true;
+  m_scanRootsCallback(m_gmMachine, this);
+  m_nursery.TraceAndPromote(m_colorSet, a_startingCycle);
+  m_minorCollecting = false;
+
+  return m_nursery.DestructUnreached();
+}
+
+
 void gmGarbageCollector::Flip()
 {
   m_firstCollectionIncrement = true;
@@ -704,6 +886,7 @@ void gmGarbageCollector::ReclaimObjectsAndRestartCollection()
 /// \brief Destruct all objects.
 void gmGarbageCollector::DestructAll()
 {
+  m_nursery.DestructAll();
   m_colorSet.DestructAll();
 
   //Reset some of our members
@@ -849,3 +1032,45 @@ gmObject* gmGCColorSet::CheckReference(gmptr a_ref)
 
   return NULL;
 }
+
+
+const void* gmGCNursery::GetInstructionAtBreakPoint(gmuint32 a_sourceId, int a_line)
+{
+  gmGCObjBase* cur = m_youngList.GetNext();
+  while(cur != &m_youngList)
+  {
+    gmObject* object = (gmObject*)cur;
+    if(object->GetType() == GM_FUNCTION)
+    {
+      gmFunctionObject * function = (gmFunctionObject *) object;
+      if(function->GetSourceId() == a_sourceId)
+      {
+        const void * instr = function->GetInstructionAtLine(a_line);
+        if(instr)
+        {
+          return instr;
+        }
+      }
+    }
+    cur = cur->GetNext();
+  }
+
+  return NULL;
+}
+
+
+gmObject* gmGCNursery::CheckReference(gmptr a_ref)
+{
+  gmGCObjBase* cur = m_youngList.GetNext();
+  while(cur != &m_youngList)
+  {
+    gmObject* object = (gmObject*)cur;
+    if((gmptr)object == a_ref)
+    {
+      return object;
+    }
+    cur = cur->GetNext();
+  }
+
+  return NULL;
+}
@@ -13,6 +13,7 @@
 #define _GMINCGC_H_
 
 #include "gmConfig.h"
+#include "gmArraySimple.h"
 
 // Configuration options
 #define GM_GC_TURN_OFF_ABLE 1                     // Let GC turn off after completion, can be turned back on when memory low
@@ -62,6 +63,14 @@ typedef void (GM_CDECL *gmGCScanRootsCallBack)(gmMachine* a_machine, gmGarbageCo
 // FREE:  Free  (inclusive)  to White (exclusive)
 // WHITE: White (exclusive)  to Tail  (exclusive)
 //
+// Concurrent marking:
+//
+// Blackening grays only reads the objects being traced and updates the color set,
+// so MarkSome() may run on another thread while the machine is idle, eg. while the
+// host renders.  The host must stop it before using the machine again, after which
+// the write barriers keep the marking valid as for any other increment.  The root
+// scan, minor collections and reclaiming garbage stay on the machine's thread.
+//
 
 //////////////////////////////////////////////////
 // gmgmGCObjBase
@@ -78,6 +87,13 @@ enum
 };
 #endif //GM_GC_DEBUG
 
+enum
+{
+  GM_GC_AGE_OLD,      // in the color set
+  GM_GC_AGE_YOUNG,    // in the nursery
+  GM_GC_AGE_REACHED,  // in the nursery and reached by the current minor collection
+};
+
 /// \brief All GC objects are dervied from this class
 class gmGCObjBase
 {
@@ -101,6 +117,12 @@ public:
    inline char GetPersist()                        {return m_persist;}
   inline void SetPersist(bool a_flag)             {m_persist = a_flag;}
 
+  inline int GetAge()                             {return (int)m_age;}
+  inline void SetAge(int a_age)                   {m_age = (char)a_age;}
+  inline bool IsYoung()                           {return m_age != GM_GC_AGE_OLD;}
+  inline bool GetRemembered()                     {return m_remembered != 0;}
+  inline void SetRemembered(bool a_flag)          {m_remembered = a_flag;}
+
   /// \brief Called when GC wants to free this memory
   virtual void Destruct(gmMachine * a_machine)    {}
 
@@ -123,7 +145,8 @@ private:
   gmGCObjBase* m_next;                            ///< Point to next object in color set
   char m_color;                                   ///< Is gray or black flag, really only need by 1 bit
   char m_persist;                                 ///< This object is persistant
-  char m_pad[2];                                  ///< Pad to dword
+  char m_age;                                     ///< GM_GC_AGE_OLD, GM_GC_AGE_YOUNG or GM_GC_AGE_REACHED
+  char m_remembered;                              ///< Old object is in the nursery remembered set
 };
 
 //////////////////////////////////////////////////
@@ -165,6 +188,9 @@ public:
   /// \brief Called on a new object being allocated.
   void Allocate(gmGCObjBase* a_obj);
 
+  /// \brief Called on an object promoted from the nursery at the start of a cycle, it joins the root snapshot as gray.
+  void AllocateGray(gmGCObjBase* a_obj);
+
   /// \brief This routine reclaims the garbage memory for the system.
   void ReclaimGarbage();
 
@@ -238,6 +264,84 @@ protected:
 };
 
 
+//////////////////////////////////////////////////
+// gmGCNursery
+//////////////////////////////////////////////////
+
+// Generational nursery:
+//
+// New objects are linked into the nursery rather than the color set.  A minor
+// collection scans the roots and the remembered set (old objects that were given a
+// young reference, see WriteBarrierStore()), traces only young objects, moves the
+// survivors into the color set and destructs the rest.  Each major cycle starts with
+// a minor collection, so the root snapshot only holds old objects.
+
+/// \brief Young generation
+class gmGCNursery
+{
+public:
+
+  /// \brief Constructor
+  gmGCNursery();
+
+  /// \brief Initialize members
+  void Init(gmGarbageCollector* a_gc);
+
+  /// \brief Called on a new object being allocated.
+  void Allocate(gmGCObjBase* a_obj);
+
+  /// \brief Called by GCGetNextObject() during a minor collection.  Moves a young object to the reached list.
+  inline void Reach(gmGCObjBase* a_obj);
+
+  /// \brief Forget a young object the caller is about to unlink, used when a young object is made persistant.
+  void Release(gmGCObjBase* a_obj);
+
+  /// \brief Add an old object that was given a young reference to the remembered set.
+  void Remember(gmGCObjBase* a_obj);
+
+  /// \brief Trace the remembered set, then trace and promote reached objects until none are left.
+  /// \param a_gray promotes to gray rather than black, so the major cycle that is starting traces them
+  void TraceAndPromote(gmGCColorSet& a_colorSet, bool a_gray);
+
+  /// \brief Destruct the young objects that were not reached.
+  /// \return The number of objects destructed
+  int DestructUnreached();
+
+  /// \brief Destruct all objects.
+  void DestructAll();
+
+  /// \brief Number of objects allocated since the last minor collection.
+  inline int GetNumObjects()                      {return m_numObjects;}
+
+  /// \brief Number of old objects in the remembered set.
+  inline int GetNumRemembered()                   {return (int) m_remembered.Count();}
+
+  /// \brief Check if reference is valid for VM
+  gmObject* CheckReference(gmptr a_ref);
+  
+  /// \brief Get instruction at point for VM Debugger.
+  const void * GetInstructionAtBreakPoint(gmuint32 a_sourceId, int a_line);
+
+protected:
+
+  /// \brief Link a_obj at the end of the circular list a_list.
+  static inline void LinkLast(gmGCObjBase* a_list, gmGCObjBase* a_obj)
+  {
+    a_obj->SetNext(a_list);
+    a_obj->SetPrev(a_list->GetPrev());
+    a_list->GetPrev()->SetNext(a_obj);
+    a_list->SetPrev(a_obj);
+  }
+
+  gmGCObjBase m_youngList;                        ///< Circular list of objects not yet reached
+  gmGCObjBase m_reachedList;                      ///< Circular list of reached objects waiting to be traced
+  gmArraySimple<gmGCObjBase*> m_remembered;       ///< Old objects that may reference young objects
+  int m_numObjects;
+
+  gmGarbageCollector* m_gc;
+};
+
+
 //////////////////////////////////////////////////
 // gmGarbageCollector
 //////////////////////////////////////////////////
@@ -280,6 +384,10 @@ public:
   /// \brief Perform write barrier operation on Left and/or Right side objects.
   inline void WriteBarrier(gmGCObjBase* a_lObj /*, gmGCObjBase* a_rObj*/);
 
+  /// \brief Generational write barrier, call when a_obj is stored into a_container.
+  /// Old containers given a young object are traced by the next minor collection.
+  inline void WriteBarrierStore(gmGCObjBase* a_container, gmGCObjBase* a_obj);
+
   /// \brief Call to start collection
   /// \return true if collection completed, false if more work to do.
   bool Collect();
@@ -287,12 +395,54 @@ public:
   /// \brief Do a full collect and don't return until done.
   void FullCollect();
 
+  /// \brief Blacken grays until a_maxWork is done or none are left.  May be called from a thread other than
+  /// the machine's, but the machine must not be used until it returns.
+  /// \return true if grays are left.
+  bool MarkSome(int a_maxWork);
+
+  /// \brief Are there grays to blacken, after the roots are scanned and before the cycle completes?
+  inline bool IsTracing()                         {return !m_gcTurnedOff && !m_firstCollectionIncrement && m_colorSet.AnyGrays();}
+
+  /// \brief Collect the nursery, promoting survivors to the old generation.
+  /// \param a_startingCycle survivors are promoted gray as they are part of the root snapshot
+  /// \return The number of young objects destructed.
+  int MinorCollect(bool a_startingCycle = false);
+
   /// \brief Called during trace by client code, and by scan roots callback.  
-  /// This grays a white object.
-  inline void GetNextObject(gmGCObjBase* a_obj)   {m_colorSet.GrayAWhite(a_obj);}
+  /// This grays a white object, or during a minor collection, reaches a young object.
+  inline void GetNextObject(gmGCObjBase* a_obj)
+  {
+    if(m_minorCollecting) 
+    {
+      m_nursery.Reach(a_obj);
+    }
+    else
+    {
+      m_colorSet.GrayAWhite(a_obj);
+    }
+  }
 
   /// \brief Called on a new object being allocated
-  inline void AllocateObject(gmGCObjBase* a_obj)  {m_colorSet.Allocate(a_obj);}
+  inline void AllocateObject(gmGCObjBase* a_obj)
+  {
+    if(m_nurseryLimit > 0)
+    {
+      m_nursery.Allocate(a_obj);
+    }
+    else
+    {
+      m_colorSet.Allocate(a_obj);
+    }
+  }
+
+  /// \brief Set the number of young objects that fill the nursery, 0 allocates straight into the old generation
+  inline void SetNurseryLimit(int a_nurseryLimit)  {m_nurseryLimit = a_nurseryLimit;}
+  /// \brief Get the number of young objects that fill the nursery
+  inline int GetNurseryLimit()                     {return m_nurseryLimit;}
+  /// \brief Get the number of objects allocated since the last minor collection
+  inline int GetNurseryCount()                     {return m_nursery.GetNumObjects();}
+  /// \brief Is it time for a minor collection?
+  inline bool IsNurseryFull()                      {return m_nurseryLimit > 0 && m_nursery.GetNumObjects() >= m_nurseryLimit;}
 
   /// \brief Get the current shade color since it is flipped each cycle.
   inline int GetCurShadeColor()                   {return (m_curShadeColor);}
@@ -316,6 +466,9 @@ public:
   /// \brief Get the amount of objects to destruct per increment of collecting
   inline int GetDestructPerIncrement()            {return m_maxObjsToDestructPerIncrement;}
 
+  /// \brief Get the total work done tracing and objects destructed, the difference over a call measures its work
+  inline gmuint32 GetStatsWorkDone()              {return m_statsWorkDone;}
+
   /// \brief Set function to be called before flip when dead objects are reclaimed. 
   /// Optional, so pass NULL to disable.
   inline void SetFlipCallback(GCFlipCallBack a_flipCallback)  {m_flipCallback = a_flipCallback;}
@@ -327,24 +480,44 @@ public:
   void DestructAll();
 
   /// \brief Reclaim some free objects.
-  int ReclaimSomeFreeObjects()                    {return m_colorSet.DestructSomeFreeObjects(m_maxObjsToDestructPerIncrement);}
+  int ReclaimSomeFreeObjects()
+  {
+    int numDestructed = m_colorSet.DestructSomeFreeObjects(m_maxObjsToDestructPerIncrement);
+    m_statsWorkDone += numDestructed;
+    return numDestructed;
+  }
 
   /// \brief Make an object persistant by moving it into the persistant list.
-  void MakeObjectPersistant(gmGCObjBase* a_obj)   {m_colorSet.MakePersistant(a_obj);}
+  void MakeObjectPersistant(gmGCObjBase* a_obj)
+  {
+    if(a_obj->IsYoung())
+    {
+      m_nursery.Release(a_obj); // MakePersistant() unlinks it from the young list
+    }
+    m_colorSet.MakePersistant(a_obj);
+  }
 
   /// \brief Get the virtual machine for language
   inline gmMachine* GetVM()                       {return m_gmMachine;}
 
   /// \brief Check if reference is valid for VM
-  gmObject* CheckReference(gmptr a_ref)           {return m_colorSet.CheckReference(a_ref);}
+  gmObject* CheckReference(gmptr a_ref)
+  {
+    gmObject* object = m_nursery.CheckReference(a_ref);
+    return (object) ? object : m_colorSet.CheckReference(a_ref);
+  }
   
   /// \brief Get instruction at point for VM Debugger.
-  const void * GetInstructionAtBreakPoint(gmuint32 a_sourceId, int a_line) {return m_colorSet.GetInstructionAtBreakPoint(a_sourceId, a_line);}
+  const void * GetInstructionAtBreakPoint(gmuint32 a_sourceId, int a_line)
+  {
+    const void * instr = m_nursery.GetInstructionAtBreakPoint(a_sourceId, a_line);
+    return (instr) ? instr : m_colorSet.GetInstructionAtBreakPoint(a_sourceId, a_line);
+  }
 
   /// \brief Revive a dead object (only used to re-live a shared string before it is finalized)
   void Revive(gmGCObjBase* a_obj)                 
   { 
-    if( !a_obj->GetPersist() ) 
+    if( !a_obj->GetPersist() && !a_obj->IsYoung() ) // young objects are never waiting to be finalized
     {
       m_colorSet.Revive(a_obj); 
     } 
@@ -365,10 +538,14 @@ protected:
   inline void ToggleCurShadeColor()               {m_curShadeColor = !m_curShadeColor;}
 
   gmGCColorSet m_colorSet;                        ///< Tri color helper class
+  gmGCNursery m_nursery;                          ///< Young generation
+  int m_nurseryLimit;                             ///< Young objects allocated before a minor collection
+  bool m_minorCollecting;                         ///< GetNextObject() reaches young objects instead of graying
   int m_curShadeColor;                            ///< Cur color used to shade this generation
   int m_workPerIncrement;                         ///< How much work to do per increment
   int m_workLeftToGo;                             ///< How much work left in this increment
   int m_maxObjsToDestructPerIncrement;            ///< How much destructing work to do this frame?
+  gmuint32 m_statsWorkDone;                       ///< Total work done tracing and objects destructed
   bool m_gcTurnedOff;                             ///< Is the GC currently turned off?
   bool m_firstCollectionIncrement;                ///< Using snapshot method, scan roots atomically first
   bool m_fullThrottle;                            ///< Set to true when forcing a full collection
@@ -393,6 +570,12 @@ void gmGCColorSet::GrayAWhite(gmGCObjBase* a_obj)
   }
 #endif //GM_GC_KEEP_PERSISTANT_SEPARATE
 
+  // Young objects are newer than the root snapshot, so they are already black to this collection
+  if(a_obj->IsYoung())
+  {
+    return;
+  }
+
   // If right object is not shaded, shade it
   if(!m_gc->IsShaded(a_obj))
   {
@@ -427,10 +610,38 @@ void gmGarbageCollector::WriteBarrier(gmGCObjBase* a_lObj/*, gmGCObjBase* a_rObj
   }
 #endif //GM_GC_KEEP_PERSISTANT_SEPARATE
 
+  if(a_lObj->IsYoung()) // Not in the color set
+  {
+    return;
+  }
+
   if(!IsShaded(a_lObj)) 
   { 
     m_colorSet.GrayThisObject(a_lObj);
   }
 }
 
+
+void gmGarbageCollector::WriteBarrierStore(gmGCObjBase* a_container, gmGCObjBase* a_obj)
+{
+  // A young container is traced anyway if it survives, so only old to young references need remembering
+  if(a_obj->IsYoung() && !a_container->IsYoung() && !a_container->GetRemembered())
+  {
+    m_nursery.Remember(a_container);
+  }
+}
+
+
+void gmGCNursery::Reach(gmGCObjBase* a_obj)
+{
+  // Old objects are not traced by a minor collection
+  if(a_obj->GetAge() == GM_GC_AGE_YOUNG)
+  {
+    a_obj->GetNext()->SetPrev(a_obj->GetPrev());
+    a_obj->GetPrev()->SetNext(a_obj->GetNext());
+    a_obj->SetAge(GM_GC_AGE_REACHED);
+    LinkLast(&m_reachedList, a_obj);
+  }
+}
+
 #endif //_GMINCGC_H_
@@ -56,21 +56,24 @@ bool gmLibHooks::AddFunction(gmFunctionInfo &a_info)
   m_functionStream << (gmuint32) a_info.m_byteCodeLength;
   m_functionStream.Write(a_info.m_byteCode, a_info.m_byteCodeLength);
 
+  int numSymbols = a_info.m_numLocals + a_info.m_numParams, i;
+
+  // debug name
   if(m_debug)
   {
-    int numSymbols = a_info.m_numLocals + a_info.m_numParams, i;
-
-    // debug name
     m_functionStream << (gmuint32) GetSymbolId(a_info.m_debugName);
+  }
 
-    // line info
-    m_functionStream << (gmuint32) a_info.m_lineInfoCount;
-    for(i = 0; i < a_info.m_lineInfoCount; ++i)
-    {
-      m_functionStream << (gmuint32) a_info.m_lineInfo[i].m_address;
-      m_functionStream << (gmuint32) a_info.m_lineInfo[i].m_lineNumber;
-    }
+  // line info, release libs have it too
+  m_functionStream << (gmuint32) a_info.m_lineInfoCount;
+  for(i = 0; i < a_info.m_lineInfoCount; ++i)
+  {
+    m_functionStream << (gmuint32) a_info.m_lineInfo[i].m_address;
+    m_functionStream << (gmuint32) a_info.m_lineInfo[i].m_lineNumber;
+  }
 
+  if(m_debug)
+  {
     // symbol info
     for(i = 0; i < numSymbols; ++i)
     {
@@ -96,7 +99,7 @@ bool gmLibHooks::End(int a_errors)
     
     gmuint32 t = ID_gml0, t1 = 0;
     *m_stream << t;
-    t = (m_debug) ? 1 : 0;
+    t = ((m_debug) ? 1 : 0) | 2; // 1 debug, 2 line info for every function
     *m_stream << t;
 
     offsetPos = m_stream->Tell();
@@ -228,21 +231,62 @@ struct gmlFunction
 };
 
 
+/// \brief gmLibString() returns the string object for a string table offset, allocating it on first reference.
+///        a_interned caches one object per offset, the low bit marks it as permanant.
+static gmptr gmLibString(gmMachine &a_machine, gmptr * a_interned, const char * a_stringTable, gmptr a_offset, bool a_permanant)
+{
+  gmptr entry = a_interned[a_offset];
+  if(entry && (entry & 1 || !a_permanant))
+  {
+    return entry & ~(gmptr) 1;
+  }
+
+  gmStringObject * stringObject = (a_permanant) ? a_machine.AllocPermanantStringObject(&a_stringTable[a_offset]) 
+                                                : a_machine.AllocStringObject(&a_stringTable[a_offset]);
+  a_interned[a_offset] = stringObject->GetRef() | ((a_permanant) ? 1 : 0);
+  return stringObject->GetRef();
+}
+
+
 gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream, const char * a_filename)
 {
+  // memory backed streams are bound in place
+  const void * image = a_stream.GetImage();
+  if(image)
+  {
+    return BindLib(a_machine, image, a_stream.GetSize(), a_filename);
+  }
+
+  // read anything else into memory first
+  gmStreamBufferDynamic buffer;
+  char chunk[1024];
+  unsigned int read;
+  a_stream.Seek(0);
+  while((read = a_stream.Read(chunk, sizeof(chunk))) > 0)
+  {
+    buffer.Write(chunk, read);
+  }
+  return BindLib(a_machine, buffer.GetData(), buffer.GetSize(), a_filename);
+}
+
+
+gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, const void * a_image, unsigned int a_size, const char * a_filename)
+{
+  gmStreamBufferStatic stream(a_image, a_size);
   gmlHeader header;
   gmlStrings strings;
   gmlSource source;
   gmlFunction function;
   gmFunctionObject * functionObject = NULL;
   gmFunctionObject ** functionObjects = NULL;
-  bool error = true, debug = false;
-  char * stringTable = NULL;
-  char * sourceCode = NULL;
+  bool error = true, debug = false, lines = false;
+  const char * stringTable = NULL;
+  gmptr * interned = NULL;
   char * byteCode = NULL;
   unsigned int i, j;
   gmuint32 numFunctions = 0;
   gmuint32 sourceCodeId = 0;
+  gmuint32 byteCodeSize = 0;
   gmuint32 scratchSize = 2048;
   gmuint8 * scratch = GM_NEW( gmuint8[scratchSize] );
 
@@ -250,34 +294,31 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
   bool gc = a_machine.IsGCEnabled();
   a_machine.EnableGC(false);
 
-  // Ensure stream is read from the start
-  a_stream.Seek( 0 );
-
   // Load the gmlib header
-  if((a_stream.Read(&header, sizeof(header)) != sizeof(header)) || header.m_id != ID_gml0) { goto done; }
+  if((stream.Read(&header, sizeof(header)) != sizeof(header)) || header.m_id != ID_gml0) { goto done; }
   debug = (header.m_flags & 1);
+  lines = debug || (header.m_flags & 2);
 
-  // Load the string table
-  a_stream.Seek(header.m_stOffset);
-  if(a_stream.Read(&strings, sizeof(strings)) != sizeof(strings)) { goto done; }
-  stringTable = GM_NEW( char[strings.m_size] );
-  if(a_stream.Read(stringTable, strings.m_size) != strings.m_size) { goto done; }
+  // Reference the string table in place, strings are allocated as the byte code references them
+  stream.Seek(header.m_stOffset);
+  if(stream.Read(&strings, sizeof(strings)) != sizeof(strings)) { goto done; }
+  if(strings.m_size > a_size - stream.Tell()) { goto done; }
+  stringTable = stream.GetData() + stream.Tell();
+  interned = GM_NEW( gmptr[strings.m_size] );
+  memset(interned, 0, sizeof(gmptr) * strings.m_size);
 
-  // Read the source code 
+  // Reference the source code in place
   if(header.m_scOffset && a_machine.GetDebugMode())
   {
-    a_stream.Seek(header.m_scOffset);
-    if(a_stream.Read(&source, sizeof(source)) != sizeof(source)) { goto done; }
-    sourceCode = GM_NEW( char[source.m_size] );
-    if(a_stream.Read(sourceCode, source.m_size) != source.m_size) { goto done; }
-    sourceCodeId = a_machine.AddSourceCode(sourceCode, a_filename);
-    delete[] sourceCode;
-    sourceCode = NULL;
+    stream.Seek(header.m_scOffset);
+    if(stream.Read(&source, sizeof(source)) != sizeof(source)) { goto done; }
+    if(source.m_size > a_size - stream.Tell()) { goto done; }
+    sourceCodeId = a_machine.AddSourceCode(stream.GetData() + stream.Tell(), a_filename);
   }
 
   // Read in the functions
-  a_stream.Seek(header.m_fnOffset);
-  if(a_stream.Read(&numFunctions, sizeof(numFunctions)) != sizeof(numFunctions)) { goto done; }
+  stream.Seek(header.m_fnOffset);
+  if(stream.Read(&numFunctions, sizeof(numFunctions)) != sizeof(numFunctions)) { goto done; }
 
   // Allocate n function objects.
   functionObjects = GM_NEW( gmFunctionObject *[numFunctions] );
@@ -289,12 +330,15 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
   // Load each function
   for(i = 0; i < numFunctions; ++i)
   {
-    if((a_stream.Read(&function, sizeof(function)) != sizeof(function)) || function.m_func != ID_func) { goto done; }
-    // Read in the byte code
-    if(byteCode) { delete[] byteCode; }
-    // use the byte code allocation for the debug params and locals symbol array
-    byteCode = GM_NEW( char[function.m_byteCodeLen] );
-    if(a_stream.Read(byteCode, function.m_byteCodeLen) != function.m_byteCodeLen) { goto done; }
+    if((stream.Read(&function, sizeof(function)) != sizeof(function)) || function.m_func != ID_func) { goto done; }
+    // Copy the byte code out for fixing up, the buffer is reused across functions
+    if(byteCodeSize < function.m_byteCodeLen)
+    {
+      if(byteCode) { delete[] byteCode; }
+      byteCodeSize = function.m_byteCodeLen;
+      byteCode = GM_NEW( char[byteCodeSize] );
+    }
+    if(stream.Read(byteCode, function.m_byteCodeLen) != function.m_byteCodeLen) { goto done; }
 
     // Load all symbols
     union
@@ -309,29 +353,40 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
     {
       switch(*(instruction32++))
       {
+#if GM_USE_FORK
+        case BC_FORK :
+#endif //GM_USE_FORK
         case BC_BRA :
         case BC_BRZ :
         case BC_BRNZ :
         case BC_BRZK :
-        case BC_BRNZK :
-        case BC_FOREACH : instruction += sizeof(gmptr); break;
+        case BC_BRNZK : instruction += sizeof(gmptr); break;
         case BC_PUSHINT : instruction += sizeof(gmint); break;
         case BC_PUSHFP : instruction += sizeof(gmfloat); break;
 
         case BC_CALL :
+        case BC_FOREACH :
         case BC_GETLOCAL :
-        case BC_SETLOCAL : instruction += sizeof(gmuint32); break;
+        case BC_SETLOCAL :
+        case BC_GETLOCAL2 :
+        case BC_GETLOCAL_GETDOT :
+        case BC_INCLOCAL :
+        case BC_LOCAL_LT_BRZ :
+        case BC_LOCAL_LTE_BRZ :
+        case BC_LOCAL_GT_BRZ :
+        case BC_LOCAL_GTE_BRZ : instruction += sizeof(gmuint32); break;
 
         case BC_GETDOT :
         case BC_SETDOT :
         case BC_GETTHIS :
         case BC_SETTHIS :
+        case BC_GETTHIS_GETDOT :
         case BC_GETGLOBAL :
         case BC_SETGLOBAL :
         {
           gmptr * reference = (gmptr *) instruction; 
           GM_ASSERT(*reference >= 0 && *reference < (gmptr) strings.m_size);
-          *reference = a_machine.AllocPermanantStringObject(&stringTable[*reference])->GetRef();
+          *reference = gmLibString(a_machine, interned, stringTable, *reference, true);
           instruction += sizeof(gmptr);
           break;
         }
@@ -339,7 +394,7 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
         {
           gmptr * reference = (gmptr *) instruction; 
           GM_ASSERT(*reference >= 0 && *reference < (gmptr) strings.m_size);
-          *reference = a_machine.AllocStringObject(&stringTable[*reference])->GetRef();
+          *reference = gmLibString(a_machine, interned, stringTable, *reference, false);
           instruction += sizeof(gmptr);
           break;
         }
@@ -369,19 +424,23 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
     functionInfo.m_maxStackSize = function.m_maxStackSize;
     functionInfo.m_symbols = NULL;
     functionInfo.m_lineInfo = NULL;
+    functionInfo.m_lineInfoCount = 0;
 
-    // We have now loaded all objects into the byte code....  Load the debug info
-    if(debug)
+    // We have now loaded all objects into the byte code....  Load the debug and line info
+    if(lines)
     {
-      gmuint32 stringOffset, lineInfoCount, numSymbols = function.m_numLocals + function.m_numParams;
+      gmuint32 stringOffset, lineInfoCount, numSymbols = (debug) ? function.m_numLocals + function.m_numParams : 0;
 
       // debug name
-      if(a_stream.Read(&stringOffset, sizeof(stringOffset)) != sizeof(stringOffset)) { goto done; }
-      GM_ASSERT(stringOffset < strings.m_size);
-      functionInfo.m_debugName = &stringTable[stringOffset];
+      if(debug)
+      {
+        if(stream.Read(&stringOffset, sizeof(stringOffset)) != sizeof(stringOffset)) { goto done; }
+        GM_ASSERT(stringOffset < strings.m_size);
+        functionInfo.m_debugName = &stringTable[stringOffset];
+      }
 
       // Make sure our scratch memory is large enough
-      if(a_stream.Read(&lineInfoCount, sizeof(lineInfoCount)) != sizeof(lineInfoCount)) { goto done; }
+      if(stream.Read(&lineInfoCount, sizeof(lineInfoCount)) != sizeof(lineInfoCount)) { goto done; }
       gmuint32 reqdScratchSize = (lineInfoCount * sizeof(gmLineInfo)) + (sizeof(const char *) * numSymbols);
       if(scratchSize < reqdScratchSize)
       {
@@ -391,22 +450,27 @@ gmFunctionObject * gmLibHooks::BindLib(gmMachine &a_machine, gmStream &a_stream,
       }
       gmLineInfo * lineInfo = (gmLineInfo *) scratch;
       functionInfo.m_lineInfo = lineInfo;
-      functionInfo.m_symbols = (const char **) (scratch + (lineInfoCount * sizeof(gmLineInfo)));
       functionInfo.m_lineInfoCount = lineInfoCount;
 
-      // Debug line info
+      // Line info
       for(j = 0; j < lineInfoCount; ++j)
       {
         gmlLineInfo libLineInfo;
-        if(a_stream.Read(&libLineInfo, sizeof(libLineInfo)) != sizeof(libLineInfo)) { goto done; }
+        if(stream.Read(&libLineInfo, sizeof(libLineInfo)) != sizeof(libLineInfo)) { goto done; }
         lineInfo[j].m_address = libLineInfo.m_byteCodeAddress;
         lineInfo[j].m_lineNumber = libLineInfo.m_lineNumber;
       }
+    }
+
+    if(debug)
+    {
+      gmuint32 stringOffset, numSymbols = function.m_numLocals + function.m_numParams;
+      functionInfo.m_symbols = (const char **) (scratch + (functionInfo.m_lineInfoCount * sizeof(gmLineInfo)));
 
       // Debug symbols
       for(j = 0; j < numSymbols; ++j)
       {
-        if(a_stream.Read(&stringOffset, sizeof(stringOffset)) != sizeof(stringOffset)) { goto done; }
+        if(stream.Read(&stringOffset, sizeof(stringOffset)) != sizeof(stringOffset)) { goto done; }
         GM_ASSERT(stringOffset < strings.m_size);
         functionInfo.m_symbols[j] = &stringTable[stringOffset];
       }
@@ -427,8 +491,7 @@ done:
 
   // turn gc off.
   a_machine.EnableGC(gc);
-  if(stringTable) { delete[] stringTable; }
-  if(sourceCode) { delete[] sourceCode; }
+  if(interned) { delete[] interned; }
   if(functionObjects) { delete[] functionObjects; }
   if(byteCode) { delete[] byteCode; }
   if(scratch) { delete[] scratch; }
@@ -40,6 +40,10 @@ public:
   /// \brief BindLib will bind the lib to the machine, and return the root function for executing.
   static gmFunctionObject * BindLib(gmMachine &a_machine, gmStream &a_stream, const char * a_filename);
 
+  /// \brief BindLib will bind a lib image in memory (eg. a memory mapped lib file), reading the string table and
+  ///        source in place.  a_image only needs to stay valid for the duration of the call.
+  static gmFunctionObject * BindLib(gmMachine &a_machine, const void * a_image, unsigned int a_size, const char * a_filename);
+
 private:
 
   class USymbol : public gmListDoubleNode<USymbol>
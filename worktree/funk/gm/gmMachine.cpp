@@ -25,6 +25,7 @@
 #include "gmCrc.h"
 #include "gmStream.h"
 #include "gmLibHooks.h"
+#include "gmAllocProfiler.h"
 
 
 #if GM_USE_INCGC
@@ -163,8 +164,8 @@ void GM_CDECL gmMachine::ScanRootsCallBack(gmMachine* a_machine, gmGarbageCollec
   // iterate over all threads and mark the stacks.
   for(tit = a_machine->m_runningThreads.GetFirst(); a_machine->m_runningThreads.IsValid(tit); tit = a_machine->m_runningThreads.GetNext(tit)) tit->GCScanRoots(a_machine, a_gc);
   for(tit = a_machine->m_blockedThreads.GetFirst(); a_machine->m_blockedThreads.IsValid(tit); tit = a_machine->m_blockedThreads.GetNext(tit)) tit->GCScanRoots(a_machine, a_gc);
-  for(tit = a_machine->m_sleepingThreads.GetFirst(); a_machine->m_sleepingThreads.IsValid(tit); tit = a_machine->m_sleepingThreads.GetNext(tit)) tit->GCScanRoots(a_machine, a_gc);
-  for(tit = a_machine->m_exceptionThreads.GetFirst(); a_machine->m_exceptionThreads.IsValid(tit); tit = a_machine->m_sleepingThreads.GetNext(tit)) tit->GCScanRoots(a_machine, a_gc);
+  for(gmuint sit = 0; sit < a_machine->m_sleepingThreads.Count(); ++sit) a_machine->m_sleepingThreads[sit].m_thread->GCScanRoots(a_machine, a_gc);
+  for(tit = a_machine->m_exceptionThreads.GetFirst(); a_machine->m_exceptionThreads.IsValid(tit); tit = a_machine->m_exceptionThreads.GetNext(tit)) tit->GCScanRoots(a_machine, a_gc);
 
   // iterate over global variables and mark
   if(a_machine->m_global)
@@ -196,6 +197,9 @@ gmMachine::gmMachine()
     m_memTableObj(sizeof(gmTableObject), GMMACHINE_TBLCHUNKSIZE),
     m_memFunctionObj(sizeof(gmFunctionObject), GMMACHINE_OBJECTCHUNKSIZE),
     m_memUserObj(sizeof(gmUserObject), GMMACHINE_OBJECTCHUNKSIZE),
+#if GM_COMPACT_VARIABLE
+    m_memVecObj(sizeof(gmVecObject), GMMACHINE_VECCHUNKSIZE),
+#endif //GM_COMPACT_VARIABLE
     m_memStackFrames(sizeof(gmStackFrame), GMMACHINE_STACKFCHUNKSIZE),
 
     m_strings(GMMACHINE_STRINGHASHSIZE),
@@ -219,6 +223,7 @@ gmMachine::gmMachine()
 
   m_objects = NULL;
   m_threadId = 0;
+  m_sleepOrder = 0;
   m_nextThread = NULL;
   m_nextThreadValid = false;
   m_autoMem = GMMACHINE_AUTOMEM;
@@ -231,14 +236,42 @@ gmMachine::gmMachine()
   m_gcPhaseCount = 0;
   m_statsGCFullCollect = 0;
   m_statsGCIncCollect = 0;
+  m_statsGCMinorCollect = 0;
   m_statsGCWarnings = 0;
+  m_statsDotCacheHits = 0;
+  m_statsDotCacheMisses = 0;
+  m_statsThreadsCreated = 0;
+  m_statsThreadsReused = 0;
+  m_statsThreadStackGrows = 0;
+  m_numKilledThreads = 0;
+  m_threadPoolSize = GMMACHINE_MAXKILLEDTHREADS;
+  m_threadStackBytes = GMTHREAD_INITIALBYTESIZE;
+#if GMMACHINE_DOTCACHESIZE
+  memset(m_dotCache, 0, sizeof(m_dotCache));
+#endif //GMMACHINE_DOTCACHESIZE
+#if GMTHREAD_BYTECODEHISTOGRAM
+  m_byteCodeHistogram = NULL;
+#endif //GMTHREAD_BYTECODEHISTOGRAM
+#if GMMACHINE_ALLOCPROFILER
+  m_allocProfiler = NULL;
+#endif //GMMACHINE_ALLOCPROFILER
+#if GMTHREAD_SAMPLING
+  m_sampleDue = false;
+  m_sampleCallback = NULL;
+  m_sampleUser = NULL;
+#endif //GMTHREAD_SAMPLING
 
   m_currentThread = 0;
 
   m_debug = false;
   m_debugUser = NULL;
 
+  m_optimise = (GMCODEGEN_OPTIMISE != 0);
+  m_lineOps = (GMCODEGEN_LINEOPS != 0);
+  memset(&m_compileStats, 0, sizeof(m_compileStats));
+
   m_gcEnabled = true;
+  m_concurrentMark = false;
 
   m_global = AllocTableObject(); // Alloc global table
 
@@ -258,12 +291,85 @@ gmMachine::~gmMachine()
 #if GM_USE_INCGC
   delete m_gc;
 #endif //GM_USE_INCGC
+#if GMTHREAD_BYTECODEHISTOGRAM
+  EnableByteCodeHistogram(false);
+#endif //GMTHREAD_BYTECODEHISTOGRAM
+#if GMMACHINE_ALLOCPROFILER
+  EnableAllocProfiler(false);
+#endif //GMMACHINE_ALLOCPROFILER
+}
+
+
+
+#if GMTHREAD_BYTECODEHISTOGRAM
+
+void gmMachine::EnableByteCodeHistogram(bool a_enable)
+{
+  if(!a_enable)
+  {
+    delete m_byteCodeHistogram;
+    m_byteCodeHistogram = NULL;
+  }
+  else if(m_byteCodeHistogram)
+  {
+    m_byteCodeHistogram->Reset();
+  }
+  else
+  {
+    m_byteCodeHistogram = GM_NEW( gmByteCodeHistogram );
+  }
+}
+
+#endif //GMTHREAD_BYTECODEHISTOGRAM
+
+
+#if GMMACHINE_ALLOCPROFILER
+
+void gmMachine::EnableAllocProfiler(bool a_enable)
+{
+  if(!a_enable)
+  {
+    delete m_allocProfiler;
+    m_allocProfiler = NULL;
+  }
+  else if(m_allocProfiler)
+  {
+    m_allocProfiler->Reset();
+  }
+  else
+  {
+    m_allocProfiler = GM_NEW( gmAllocProfiler );
+  }
 }
 
+#endif //GMMACHINE_ALLOCPROFILER
+
+
+#if GMTHREAD_SAMPLING
+
+void gmMachine::SetSampleCallback(gmSampleCallback a_callback, void * a_user)
+{
+  m_sampleDue = false;
+  m_sampleCallback = a_callback;
+  m_sampleUser = a_user;
+}
+
+
+void gmMachine::Sys_Sample(gmThread * a_thread)
+{
+  m_sampleDue = false;
+  if(m_sampleCallback) m_sampleCallback(a_thread, m_sampleUser);
+}
+
+#endif //GMTHREAD_SAMPLING
 
 
 void gmMachine::ResetAndFreeMemory()
 {
+#if GMMACHINE_ALLOCPROFILER
+  // everything is freed, the records would only be of the reset
+  if(m_allocProfiler) m_allocProfiler->Reset();
+#endif //GMMACHINE_ALLOCPROFILER
 
 #if GM_USE_INCGC
 
@@ -310,9 +416,11 @@ void gmMachine::ResetAndFreeMemory()
   // threads
   m_runningThreads.RemoveAll();
   m_blockedThreads.RemoveAll();
-  m_sleepingThreads.RemoveAll();
+  m_sleepingThreads.ResetAndFreeMemory();
+  m_sleepOrder = 0;
   m_exceptionThreads.RemoveAll();
   m_killedThreads.RemoveAndDeleteAll();
+  m_numKilledThreads = 0;
   m_threads.RemoveAndDeleteAll();
   m_threadId = 0;
   m_time = 0;
@@ -338,6 +446,11 @@ void gmMachine::ResetAndFreeMemory()
   GM_ASSERT(m_memUserObj.GetMemUsed() == 0);
   m_memUserObj.ResetAndFreeMemory();
 
+#if GM_COMPACT_VARIABLE
+  GM_ASSERT(m_memVecObj.GetMemUsed() == 0);
+  m_memVecObj.ResetAndFreeMemory();
+#endif //GM_COMPACT_VARIABLE
+
   GM_ASSERT(m_memStackFrames.GetMemUsed() == 0);
   m_memStackFrames.ResetAndFreeMemory();
 
@@ -602,7 +715,8 @@ int gmMachine::ExecuteString(const char * a_string, int * a_threadId, bool a_now
 
   // compile
   gmHooks hooks(this, a_string, a_filename);
-  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log);
+  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log, m_optimise, m_lineOps);
+  m_compileStats = gmCodeGen::Get().GetStats();
   if(errors > 0)
   {
     gmCodeTree::Get().Unlock();
@@ -707,7 +821,8 @@ int gmMachine::CompileStringToLib(const char * a_string, gmStream &a_stream)
   
   // compile
   gmLibHooks hooks(a_stream, a_string);
-  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log);
+  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log, m_optimise, m_lineOps);
+  m_compileStats = gmCodeGen::Get().GetStats();
 
   gmCodeTree::Get().Unlock();
   gmCodeGen::Get().Unlock();
@@ -717,6 +832,39 @@ int gmMachine::CompileStringToLib(const char * a_string, gmStream &a_stream)
 }
 
 
+int gmMachine::CompileStringToLib(const char * a_string, gmStream &a_stream, gmLog &a_log, bool a_debug, bool a_optimise, bool a_lineOps, gmCodeGenStats * a_stats)
+{
+#if GMMACHINE_REMOVECOMPILER
+  a_log.LogEntry("No compiler in build");
+  return 1;
+#else // GMMACHINE_REMOVECOMPILER
+  // parse, the scanner and parser state is per thread
+  gmCodeTree codeTree;
+  int errors = codeTree.Lock(a_string, &a_log);
+  if(errors > 0) 
+  {
+    codeTree.Unlock();
+    return errors;
+  }
+
+  // compile
+  gmCodeGen * codeGen = gmCodeGen::Create();
+  gmLibHooks hooks(a_stream, a_string);
+  errors = codeGen->Lock(codeTree.GetCodeTree(), &hooks, a_debug, &a_log, a_optimise, a_lineOps);
+  if(a_stats)
+  {
+    *a_stats = codeGen->GetStats();
+  }
+
+  codeTree.Unlock();
+  codeGen->Unlock();
+  gmCodeGen::Destroy(codeGen);
+
+  return errors;
+#endif // GMMACHINE_REMOVECOMPILER
+}
+
+
 gmFunctionObject * gmMachine::CompileStringToFunction(const char * a_string, int *a_errorCount, const char * a_filename)
 {
 #if GMMACHINE_REMOVECOMPILER
@@ -739,7 +887,8 @@ gmFunctionObject * gmMachine::CompileStringToFunction(const char * a_string, int
 
   // compile
   gmHooks hooks(this, a_string, a_filename);
-  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log);
+  errors = gmCodeGen::Get().Lock(gmCodeTree::Get().GetCodeTree(), &hooks, m_debug, &m_log, m_optimise, m_lineOps);
+  m_compileStats = gmCodeGen::Get().GetStats();
   if(errors > 0)
   {
     gmCodeTree::Get().Unlock();
@@ -789,14 +938,24 @@ void gmMachine::Sys_SignalCreateThread(gmThread * a_thread)
 
 gmThread * gmMachine::CreateThread(int * a_threadId)
 {
+  ++m_statsThreadsCreated;
   gmThread * thread = m_killedThreads.RemoveFirst();
-  if(thread == NULL)
+  if(thread)
   {
-    thread = GM_NEW( gmThread(this) );
+    --m_numKilledThreads;
+    ++m_statsThreadsReused;
+  }
+  else
+  {
+    thread = GM_NEW( gmThread(this, m_threadStackBytes) );
   }
   thread->Sys_Reset(GetThreadId());
   if(a_threadId) *a_threadId = thread->GetId();
   m_threads.Insert(thread);
+  if(m_threads.Count() > m_threads.GetTableSize())
+  {
+    m_threads.Resize(m_threads.GetTableSize() << 1);
+  }
   thread->Sys_SetState(gmThread::RUNNING);
   thread->Sys_SetStartTime(m_time);
   m_runningThreads.InsertLast(thread); // insert last to maintain propper execution order.
@@ -812,6 +971,18 @@ gmThread * gmMachine::CreateThread(int * a_threadId)
 
 
 
+void gmMachine::SetThreadPoolSize(int a_size)
+{
+  m_threadPoolSize = (a_size > 0) ? a_size : 0;
+  while(m_numKilledThreads > m_threadPoolSize)
+  {
+    delete m_killedThreads.RemoveFirst();
+    --m_numKilledThreads;
+  }
+}
+
+
+
 gmThread * gmMachine::GetThread(int a_threadId)
 {
   return m_threads.Find(a_threadId);
@@ -821,6 +992,26 @@ gmThread * gmMachine::GetThread(int a_threadId)
 
 bool gmMachine::Signal(const gmVariable &a_signal, int a_dstThreadId, int a_srcThreadId)
 {
+  if(a_dstThreadId != GM_INVALID_THREAD)
+  {
+    // directed signal, search the blocks on the destination thread rather than every thread waiting on the signal.
+    gmThread * thread = GetThread(a_dstThreadId);
+    if(thread)
+    {
+      gmBlock * block = thread->Sys_GetBlocks();
+      while(block)
+      {
+        if(gmVariable::Compare(block->m_block, a_signal) == 0)
+        {
+          Sys_SignalBlock(block, a_signal, a_dstThreadId, a_srcThreadId);
+          return true;
+        }
+        block = block->m_nextBlock;
+      }
+    }
+    return false;
+  }
+
   gmBlockList * blockList = m_blocks.Find(a_signal);
   bool used = false;
 
@@ -830,50 +1021,51 @@ bool gmMachine::Signal(const gmVariable &a_signal, int a_dstThreadId, int a_srcT
     gmBlock * block = blockList->m_blocks.GetFirst();
     while(blockList->m_blocks.IsValid(block))
     {
-      gmThread * thread = block->m_thread;
-      if(a_dstThreadId == GM_INVALID_THREAD || a_dstThreadId == thread->GetId())
-      {
-        gmSignal * signal = NULL;
-        used = true;
+      // an endon kill removes the block from the list, so step first
+      gmBlock * next = blockList->m_blocks.GetNext(block);
+      used = true;
+      Sys_SignalBlock(block, a_signal, a_dstThreadId, a_srcThreadId);
+      block = next;
+    }
+  }
+  return used;
+}
+
+
+
+void gmMachine::Sys_SignalBlock(gmBlock * a_block, const gmVariable &a_signal, int a_dstThreadId, int a_srcThreadId)
+{
+  gmThread * thread = a_block->m_thread;
 
 #if GM_USE_ENDON
-        if(block->m_endOn == true)
-        {
-          block->m_signalled = true;
-          block->m_srcThreadId = a_srcThreadId;
+  if(a_block->m_endOn == true)
+  {
+    a_block->m_signalled = true;
+    a_block->m_srcThreadId = a_srcThreadId;
 
-          Sys_SwitchState(thread, gmThread::KILLED);
-        }
-        else
+    Sys_SwitchState(thread, gmThread::KILLED);
+  }
+  else
 #endif //GM_USE_ENDON
-        {
-          // allocate a signal
-          if(thread->GetState() == gmThread::SYS_PENDING)
-          {
-            signal = (gmSignal *) Sys_Alloc(sizeof(gmSignal));
-            signal->m_signal = a_signal;
-            signal->m_srcThreadId = a_srcThreadId;
-            signal->m_dstThreadId = a_dstThreadId;
-            signal->m_nextSignal = thread->Sys_GetSignals();
-            thread->Sys_SetSignals(signal);
-          }
-          else
-          {
-            block->m_signalled = true;
-            block->m_srcThreadId = a_srcThreadId;
+  {
+    // allocate a signal
+    if(thread->GetState() == gmThread::SYS_PENDING)
+    {
+      gmSignal * signal = (gmSignal *) Sys_Alloc(sizeof(gmSignal));
+      signal->m_signal = a_signal;
+      signal->m_srcThreadId = a_srcThreadId;
+      signal->m_dstThreadId = a_dstThreadId;
+      signal->m_nextSignal = thread->Sys_GetSignals();
+      thread->Sys_SetSignals(signal);
+    }
+    else
+    {
+      a_block->m_signalled = true;
+      a_block->m_srcThreadId = a_srcThreadId;
 
-            thread->Sys_SetState(gmThread::SYS_PENDING);
-          }
-        }
-        if(a_dstThreadId != GM_INVALID_THREAD)
-        {
-          break;
-        }
-      }
-      block = blockList->m_blocks.GetNext(block);
+      thread->Sys_SetState(gmThread::SYS_PENDING);
     }
   }
-  return used;
 }
 
 
@@ -956,6 +1148,11 @@ int gmMachine::Sys_Block(gmThread * a_thread, int m_numBlocks, const gmVariable
       blockList = gmConstructElement<gmBlockList>(blockList);
       blockList->m_block = a_blocks[i];
       m_blocks.Insert(blockList);
+      if(m_blocks.Count() > m_blocks.GetTableSize())
+      {
+        // grow with the number of distinct signals so Signal() stays O(waiters on the signal)
+        m_blocks.Resize(m_blocks.GetTableSize() << 1);
+      }
     }
 
     block = (gmBlock *) Sys_Alloc(sizeof(gmBlock));
@@ -1003,11 +1200,17 @@ void gmMachine::ForEachThread(gmThreadIteratorCallback a_callback, void * a_cont
     if(!a_callback(thread, a_context)) return;
   }
 
-  for(it = m_sleepingThreads.First(); it;)
+  // the callback may wake or kill the thread, reordering the heap
+  gmArraySimple<gmThread *> sleeping;
+  gmuint i;
+  sleeping.SetCount(m_sleepingThreads.Count());
+  for(i = 0; i < m_sleepingThreads.Count(); ++i)
   {
-    gmThread * thread = it.Resolve();
-    ++it;
-    if(!a_callback(thread, a_context)) return;
+    sleeping[i] = m_sleepingThreads[i].m_thread;
+  }
+  for(i = 0; i < sleeping.Count(); ++i)
+  {
+    if(!a_callback(sleeping[i], a_context)) return;
   }
 
   for(it = m_exceptionThreads.First(); it;)
@@ -1044,8 +1247,8 @@ void gmMachine::Sys_SwitchState(gmThread * a_thread, int a_to)
       m_blockedThreads.Remove(a_thread);
       break;
     } 
-    case gmThread::SLEEPING : m_sleepingThreads.Remove(a_thread); break;
-    case gmThread::KILLED : m_killedThreads.Remove(a_thread); break;
+    case gmThread::SLEEPING : Sys_SleepRemove(a_thread); break;
+    case gmThread::KILLED : m_killedThreads.Remove(a_thread); --m_numKilledThreads; break;
     case gmThread::EXCEPTION : m_exceptionThreads.Remove(a_thread); break;
     default : GM_ASSERT(0); break;
   }
@@ -1054,24 +1257,7 @@ void gmMachine::Sys_SwitchState(gmThread * a_thread, int a_to)
     case gmThread::RUNNING : m_runningThreads.InsertLast(a_thread); break;
     case gmThread::BLOCKED : m_blockedThreads.InsertFirst(a_thread); break;
     case gmThread::EXCEPTION : m_exceptionThreads.InsertFirst(a_thread); break;
-    case gmThread::SLEEPING :
-    {
-      // insert ordered by thread time stamp (GetTimeStamp)
-      gmListDouble<gmThread>::Iterator it = m_sleepingThreads.First();
-      bool inserted = false;
-      while(it)
-      {
-        if(it->GetTimeStamp() > a_thread->GetTimeStamp())
-        {
-          m_sleepingThreads.InsertBefore(it.Resolve(), a_thread);
-          inserted = true;
-          break;
-        }
-        ++it;
-      }
-      if(!inserted) m_sleepingThreads.InsertLast(a_thread);
-      break;
-    }
+    case gmThread::SLEEPING : Sys_SleepInsert(a_thread); break;
     case gmThread::KILLED :
     {
       // Change the thread state before resetting the thread for consistency.
@@ -1087,9 +1273,18 @@ void gmMachine::Sys_SwitchState(gmThread * a_thread, int a_to)
       m_threads.Remove(a_thread);
       a_thread->Sys_Reset(0);
 
-      if(m_killedThreads.Count() < GMMACHINE_MAXKILLEDTHREADS)
+      // new threads start with the stack threads have been growing to. it decays over the kills, and rises at most
+      // twofold a kill, so a one off deep thread doesn't size every thread after it
+      const int stackBytes = a_thread->GetStackBytes();
+      m_threadStackBytes -= m_threadStackBytes >> 5;
+      if(m_threadStackBytes < stackBytes) m_threadStackBytes = (stackBytes < 2 * m_threadStackBytes) ? stackBytes : 2 * m_threadStackBytes;
+      if(m_threadStackBytes < GMTHREAD_INITIALBYTESIZE) m_threadStackBytes = GMTHREAD_INITIALBYTESIZE;
+
+      if(m_numKilledThreads < m_threadPoolSize)
       {
+        if(stackBytes > 2 * m_threadStackBytes) a_thread->Sys_ResizeStack(m_threadStackBytes);
         m_killedThreads.InsertFirst(a_thread);
+        ++m_numKilledThreads;
         // Thread is dead and we don't want to set it's state (already set).
         // Besides it's ID is now invalid.
         return;
@@ -1105,6 +1300,100 @@ void gmMachine::Sys_SwitchState(gmThread * a_thread, int a_to)
 }
 
 
+//
+// Sleep heap, a binary min heap of gmSleeper.  each thread holds its heap index so it can be removed when woken by
+// a signal or killed.
+//
+
+static inline bool gmSleepsBefore(gmuint32 a_timeStamp, gmuint32 a_order, gmuint32 b_timeStamp, gmuint32 b_order)
+{
+  if(a_timeStamp != b_timeStamp) return a_timeStamp < b_timeStamp;
+  return (gmint32) (a_order - b_order) < 0;
+}
+
+
+
+void gmMachine::Sys_SleepInsert(gmThread * a_thread)
+{
+  gmSleeper & sleeper = m_sleepingThreads.InsertLast();
+  sleeper.m_timeStamp = a_thread->GetTimeStamp();
+  sleeper.m_order = m_sleepOrder++;
+  sleeper.m_thread = a_thread;
+  Sys_SleepSiftUp(m_sleepingThreads.Count() - 1);
+}
+
+
+
+void gmMachine::Sys_SleepRemove(gmThread * a_thread)
+{
+  int index = a_thread->Sys_GetSleepIndex();
+  int last = m_sleepingThreads.Count() - 1;
+  GM_ASSERT(index >= 0 && index <= last && m_sleepingThreads[index].m_thread == a_thread);
+  a_thread->Sys_SetSleepIndex(-1);
+
+  if(index != last)
+  {
+    // move the last sleeper into the hole, then up or down to its place
+    m_sleepingThreads[index] = m_sleepingThreads[last];
+    m_sleepingThreads.RemoveLast();
+    if(Sys_SleepSiftUp(index) == index)
+    {
+      Sys_SleepSiftDown(index);
+    }
+  }
+  else
+  {
+    m_sleepingThreads.RemoveLast();
+  }
+}
+
+
+
+int gmMachine::Sys_SleepSiftUp(int a_index)
+{
+  gmSleeper sleeper = m_sleepingThreads[a_index];
+  while(a_index > 0)
+  {
+    int parent = (a_index - 1) >> 1;
+    const gmSleeper & p = m_sleepingThreads[parent];
+    if(!gmSleepsBefore(sleeper.m_timeStamp, sleeper.m_order, p.m_timeStamp, p.m_order)) break;
+    m_sleepingThreads[a_index] = p;
+    p.m_thread->Sys_SetSleepIndex(a_index);
+    a_index = parent;
+  }
+  m_sleepingThreads[a_index] = sleeper;
+  sleeper.m_thread->Sys_SetSleepIndex(a_index);
+  return a_index;
+}
+
+
+
+void gmMachine::Sys_SleepSiftDown(int a_index)
+{
+  const int count = m_sleepingThreads.Count();
+  gmSleeper sleeper = m_sleepingThreads[a_index];
+  for(;;)
+  {
+    int child = (a_index << 1) + 1;
+    if(child >= count) break;
+    if(child + 1 < count && 
+       gmSleepsBefore(m_sleepingThreads[child + 1].m_timeStamp, m_sleepingThreads[child + 1].m_order, 
+                      m_sleepingThreads[child].m_timeStamp, m_sleepingThreads[child].m_order))
+    {
+      ++child;
+    }
+    const gmSleeper & c = m_sleepingThreads[child];
+    if(!gmSleepsBefore(c.m_timeStamp, c.m_order, sleeper.m_timeStamp, sleeper.m_order)) break;
+    m_sleepingThreads[a_index] = c;
+    c.m_thread->Sys_SetSleepIndex(a_index);
+    a_index = child;
+  }
+  m_sleepingThreads[a_index] = sleeper;
+  sleeper.m_thread->Sys_SetSleepIndex(a_index);
+}
+
+
+
 void gmMachine::KillExceptionThreads()
 {
   gmThread * thread = m_exceptionThreads.GetLast();
@@ -1117,7 +1406,7 @@ void gmMachine::KillExceptionThreads()
 
 
 
-int gmMachine::Execute(gmuint32 a_delta)
+int gmMachine::Execute(gmuint32 a_delta, bool a_collectGarbage)
 {
   m_time += a_delta;
 
@@ -1130,15 +1419,9 @@ int gmMachine::Execute(gmuint32 a_delta)
   //
   // Wake up any sleeping threads at their timestamp
   //
-  for(;;)
+  while(m_sleepingThreads.Count() > 0 && m_sleepingThreads[0].m_timeStamp <= m_time)
   {
-    gmThread * thread = m_sleepingThreads.GetFirst();
-    if(m_sleepingThreads.IsValid(thread) && (thread->GetTimeStamp() <= m_time))
-    {
-      Sys_SwitchState(thread, gmThread::RUNNING);
-      continue;
-    }
-    break;
+    Sys_SwitchState(m_sleepingThreads[0].m_thread, gmThread::RUNNING);
   }
 
   //
@@ -1179,7 +1462,10 @@ int gmMachine::Execute(gmuint32 a_delta)
   }
   m_nextThreadValid = false;
 
-  CollectGarbage();
+  if(a_collectGarbage)
+  {
+    CollectGarbage();
+  }
 
   return m_threads.Count();
 }
@@ -1244,15 +1530,22 @@ bool gmMachine::CollectGarbage(bool a_forceFullCollect)
 
     ++m_framesSinceLastIncCollect;
 
+    // Free this frame's temporaries before deciding if the old generation needs collecting
+    if(!a_forceFullCollect && m_gc->IsNurseryFull())
+    {
+      m_gc->MinorCollect();
+      ++m_statsGCMinorCollect;
+    }
+
     // Have we exceeded the hard limit?
     if(a_forceFullCollect || (GetCurrentMemoryUsage() > GetDesiredByteMemoryUsageHard()))
     {
       //int beforeMemUsage = GetCurrentMemoryUsage();
-      ++m_statsGCFullCollect;
       result = true;
 
       // Perform full collection & reclaimation now
       m_gc->FullCollect(); 
+      ++m_statsGCFullCollect;
       
       if(m_autoMem)
       {
@@ -1336,8 +1629,8 @@ bool gmMachine::CollectGarbage(bool a_forceFullCollect)
           }
         }
       }
-      // If we are collecting, then collect some more this opportunity
-      if(!m_gc->IsOff())
+      // If we are collecting, then collect some more this opportunity, unless the grays are left to the host
+      if(!m_gc->IsOff() && !(m_concurrentMark && m_gc->IsTracing()))
       {
         if(m_gc->Collect())
         {
@@ -1403,7 +1696,7 @@ bool gmMachine::CollectGarbage(bool a_forceFullCollect)
     // iterate over all threads and mark the stacks.
     for(tit = m_runningThreads.GetFirst(); m_runningThreads.IsValid(tit); tit = m_runningThreads.GetNext(tit)) tit->Mark(m_mark);
     for(tit = m_blockedThreads.GetFirst(); m_blockedThreads.IsValid(tit); tit = m_blockedThreads.GetNext(tit)) tit->Mark(m_mark);
-    for(tit = m_sleepingThreads.GetFirst(); m_sleepingThreads.IsValid(tit); tit = m_sleepingThreads.GetNext(tit)) tit->Mark(m_mark);
+    for(gmuint sit = 0; sit < m_sleepingThreads.Count(); ++sit) m_sleepingThreads[sit].m_thread->Mark(m_mark);
     for(tit = m_exceptionThreads.GetFirst(); m_exceptionThreads.IsValid(tit); tit = m_exceptionThreads.GetNext(tit)) tit->Mark(m_mark);
 
     // iterate over global variables and mark
@@ -1472,6 +1765,9 @@ unsigned int gmMachine::GetSystemMemUsed() const
   total += m_memTableObj.GetSystemMemUsed();
   total += m_memFunctionObj.GetSystemMemUsed();
   total += m_memUserObj.GetSystemMemUsed();
+#if GM_COMPACT_VARIABLE
+  total += m_memVecObj.GetSystemMemUsed();
+#endif //GM_COMPACT_VARIABLE
   total += m_memStackFrames.GetSystemMemUsed();
   total += m_fixedSet.GetSystemMemUsed();
 
@@ -1479,7 +1775,7 @@ unsigned int gmMachine::GetSystemMemUsed() const
   gmThread * tit;
   for(tit = m_runningThreads.GetFirst(); m_runningThreads.IsValid(tit); tit = m_runningThreads.GetNext(tit)) total += tit->GetSystemMemUsed();
   for(tit = m_blockedThreads.GetFirst(); m_blockedThreads.IsValid(tit); tit = m_blockedThreads.GetNext(tit)) total += tit->GetSystemMemUsed();
-  for(tit = m_sleepingThreads.GetFirst(); m_sleepingThreads.IsValid(tit); tit = m_sleepingThreads.GetNext(tit)) total += tit->GetSystemMemUsed();
+  for(gmuint i = 0; i < m_sleepingThreads.Count(); ++i) total += m_sleepingThreads[i].m_thread->GetSystemMemUsed();
   for(tit = m_killedThreads.GetFirst(); m_killedThreads.IsValid(tit); tit = m_killedThreads.GetNext(tit)) total += tit->GetSystemMemUsed();
   for(tit = m_exceptionThreads.GetFirst(); m_exceptionThreads.IsValid(tit); tit = m_exceptionThreads.GetNext(tit)) total += tit->GetSystemMemUsed();
 
@@ -1490,26 +1786,31 @@ unsigned int gmMachine::GetSystemMemUsed() const
 
 gmStringObject * gmMachine::AllocStringObject(const char * a_string, int a_length)
 {
-  gmStringObject * newStringObj = m_strings.Find(a_string);
+  return AllocStringObject(gmStringKey(a_string, a_length));
+}
+
+
+
+gmStringObject * gmMachine::AllocStringObject(const gmStringKey &a_key)
+{
+  gmStringObject * newStringObj = m_strings.Find(a_key);
   if(newStringObj)
   {
     m_gc->Revive(newStringObj); // If string was in free list waiting to be finalized, revive it.
     return newStringObj;
   }
   
-  if(a_length < 0)
-  {
-    a_length = (int)strlen(a_string);
-  }
+  const int a_length = a_key.m_length;
   char * string = (char *) Sys_Alloc(a_length + 1);
-  memcpy(string, a_string, a_length + 1);
+  memcpy(string, a_key.m_string, a_length);
+  string[a_length] = '\0';
 
 #if GMMACHINE_GCEVERYALLOC
   CollectGarbage();
 #endif
   newStringObj = (gmStringObject *) m_memStringObj.Alloc();
 
-  GM_PLACEMENT_NEW( gmStringObject(string, a_length), newStringObj );
+  GM_PLACEMENT_NEW( gmStringObject(string, a_key), newStringObj );
 
 #if GM_USE_INCGC
   m_gc->AllocateObject(newStringObj);
@@ -1518,10 +1819,17 @@ gmStringObject * gmMachine::AllocStringObject(const char * a_string, int a_lengt
   GM_ADDOBJECT(newStringObj);
 #endif //GM_USE_INCGC
 
-  // insert into hash
+  // insert into hash, growing it so the chains stay short
   m_strings.Insert(newStringObj);
+  if(m_strings.Count() > m_strings.GetTableSize())
+  {
+    m_strings.Resize(m_strings.GetTableSize() << 1);
+  }
 
   m_currentMemoryUsage += sizeof(gmStringObject);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Allocated(this, newStringObj, sizeof(gmStringObject) + a_length + 1);
+#endif //GMMACHINE_ALLOCPROFILER
   return newStringObj;
 }
 
@@ -1562,6 +1870,9 @@ gmTableObject * gmMachine::AllocTableObject()
 #endif //GM_USE_INCGC
 
   m_currentMemoryUsage += sizeof(gmTableObject);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Allocated(this, newTableObj, sizeof(gmTableObject));
+#endif //GMMACHINE_ALLOCPROFILER
   return newTableObj;
 }
 
@@ -1585,6 +1896,9 @@ gmFunctionObject * gmMachine::AllocFunctionObject(gmCFunction a_function)
   newFunctionObj->m_cFunction = a_function;
 
   m_currentMemoryUsage += sizeof(gmFunctionObject);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Allocated(this, newFunctionObj, sizeof(gmFunctionObject));
+#endif //GMMACHINE_ALLOCPROFILER
   return newFunctionObj;
 }
 
@@ -1608,16 +1922,45 @@ gmUserObject * gmMachine::AllocUserObject(void * a_user, int a_userType)
   newUserObj->m_userType = a_userType;
   newUserObj->m_user = a_user;
   m_currentMemoryUsage += sizeof(gmUserObject);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Allocated(this, newUserObj, sizeof(gmUserObject));
+#endif //GMMACHINE_ALLOCPROFILER
   return newUserObj;
 }
 
 
 
-void gmMachine::Sys_FreeUniqueString(const char * a_string)
+#if GM_COMPACT_VARIABLE
+gmVecObject * gmMachine::AllocVecObject(gmType a_type, const gmVec3 &a_vec)
+{
+#if GMMACHINE_GCEVERYALLOC
+  CollectGarbage();
+#endif
+  gmVecObject * newVecObj = (gmVecObject *) m_memVecObj.Alloc();
+  GM_PLACEMENT_NEW(gmVecObject(a_type, a_vec), newVecObj);
+
+#if GM_USE_INCGC
+  m_gc->AllocateObject(newVecObj);
+  AddCountObj(newVecObj);
+#else //GM_USE_INCGC
+  GM_ADDOBJECT(newVecObj);
+#endif //GM_USE_INCGC
+
+  m_currentMemoryUsage += sizeof(gmVecObject);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Allocated(this, newVecObj, sizeof(gmVecObject));
+#endif //GMMACHINE_ALLOCPROFILER
+  return newVecObj;
+}
+#endif //GM_COMPACT_VARIABLE
+
+
+
+void gmMachine::Sys_FreeUniqueString(gmStringObject * a_string)
 {
-  if(m_strings.RemoveKey(a_string))
+  if(m_strings.Remove(a_string))
   {
-    Sys_Free(const_cast<char *>(a_string));
+    Sys_Free(const_cast<char *>(a_string->GetString()));
   }
 }
 
@@ -1634,6 +1977,9 @@ int gmMachine::GetThreadId()
 void gmMachine::FreeObject(gmObject * a_obj)
 {
   //RemoveCountObj(a_obj);
+#if GMMACHINE_ALLOCPROFILER
+  if(m_allocProfiler) m_allocProfiler->Freed(this, a_obj);
+#endif //GMMACHINE_ALLOCPROFILER
 
   switch(a_obj->GetType())
   {
@@ -1655,6 +2001,15 @@ void gmMachine::FreeObject(gmObject * a_obj)
       m_currentMemoryUsage -= sizeof(gmFunctionObject);
       break;
     }
+#if GM_COMPACT_VARIABLE
+    case GM_VEC2:
+    case GM_VEC3:
+    {
+      m_memVecObj.Free(a_obj);
+      m_currentMemoryUsage -= sizeof(gmVecObject);
+      break;
+    }
+#endif //GM_COMPACT_VARIABLE
     default: // >= GM_USER types
     {
       m_memUserObj.Free(a_obj);
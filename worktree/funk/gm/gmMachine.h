@@ -52,11 +52,14 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "gmLog.h"
 #include "gmVariable.h"
 #include "gmTableObject.h"
+#include "gmStringObject.h"
 #include "gmOperators.h"
 #include "gmFunctionObject.h"
 #include "gmHash.h"
 #include "gmArraySimple.h"
 #include "gmIncGC.h"
+#include "gmCodeGen.h"
+#include "gmByteCode.h"
 
 #if GMMACHINE_TRACK_THREAD_ALLOC_COUNTS
 #include <map>
@@ -77,6 +80,7 @@ struct gmSignal;
 class gmSourceEntry;
 class gmStream;
 class gmBlockList;
+class gmAllocProfiler;
 
 enum gmMachineCommand
 {
@@ -104,6 +108,7 @@ typedef void (GM_CDECL *gmAsStringCallback)(gmUserObject * a_userObj, char * a_b
 typedef void (GM_CDECL *gmPrintCallback)(gmMachine * a_machine, const char * a_string);
 typedef bool (GM_CDECL *gmThreadIteratorCallback)(gmThread * a_thread, void * a_context);
 typedef bool (GM_CDECL *gmUserBreakCallback)(gmThread * a_thread);
+typedef void (GM_CDECL *gmSampleCallback)(gmThread * a_thread, void * a_user);
 
 // the following callbacks return true if the thread is to yield after completion of the callback.
 typedef bool (GM_CDECL *gmDebugLineCallback)(gmThread * a_thread);
@@ -299,6 +304,14 @@ public:
   /// \sa GetCompileLog()
   int CompileStringToLib(const char * a_string, gmStream &a_stream);
 
+  /// \brief CompileStringToLib() will compile a_string to a lib without touching any machine.  The compile uses its own
+  ///        code tree and code generator, so independent scripts may be compiled on worker threads and the libs bound
+  ///        on the machine's thread with ExecuteLib() or BindLibToFunction().
+  /// \param a_log receives compile errors, one log per compiling thread.
+  /// \param a_stats may be NULL, else receives the instruction counts.
+  /// \return the number of errors from compiling the script.
+  static int CompileStringToLib(const char * a_string, gmStream &a_stream, gmLog &a_log, bool a_debug, bool a_optimise, bool a_lineOps, gmCodeGenStats * a_stats = NULL);
+
   /// \brief CompileStringToFunction()
   gmFunctionObject * CompileStringToFunction(const char * a_string, int *a_errorCount = NULL, const char * a_filename = NULL);
 
@@ -320,6 +333,15 @@ public:
   gmThread * CreateThread(const gmVariable &a_this, const gmVariable &a_function, int * a_threadId = NULL);
   gmThread * CreateThread(int * a_threadId = NULL);
 
+  /// \brief SetThreadPoolSize() sets how many killed threads are kept, stack and all, for CreateThread() to reuse.
+  ///        0 frees every thread as it is killed.
+  void SetThreadPoolSize(int a_size);
+  inline int GetThreadPoolSize() const            { return m_threadPoolSize; }
+  inline int GetNumPooledThreads() const          { return m_numKilledThreads; }
+  /// \brief GetThreadStackBytes() returns the stack a new thread starts with, the high-water mark of the threads
+  ///        killed lately.  A pooled thread whose stack grew past twice that is shrunk back to it.
+  inline int GetThreadStackBytes() const          { return m_threadStackBytes; }
+
   /// \brief GetThread() will return the thread given a thread id.
   /// \return NULL on error.
   gmThread * GetThread(int a_threadId);
@@ -357,8 +379,9 @@ public:
 
   /// \brief Execute() will execute all running threads
   /// \param m_deltaTime is the time in milliseconds since the machine was last updated.
+  /// \param a_collectGarbage is false if the caller calls CollectGarbage() itself, eg. to time it.
   /// \return number of running sleeping and blocked threads.
-  int Execute(gmuint32 a_delta);
+  int Execute(gmuint32 a_delta, bool a_collectGarbage = true);
 
   /// \brief GetTime() will return the machine time in milliseconds.
   inline gmuint32 GetTime() const { return m_time; }
@@ -419,6 +442,12 @@ public:
   /// \brief Is automatic memory limit calculation enabled?
   inline bool GetAutoMemoryUsage() const          { return m_autoMem; }
 
+  /// \brief SetConcurrentMark() leaves blackening grays to gmGarbageCollector::MarkSome(), called by the host on another
+  ///        thread while the machine is idle.  CollectGarbage() still scans the roots and reclaims garbage.  The host
+  ///        must stop marking before calling into the machine again.
+  inline void SetConcurrentMark(bool a_concurrentMark) { m_concurrentMark = a_concurrentMark; }
+  inline bool GetConcurrentMark() const           { return m_concurrentMark; }
+
   /// \brief GetSystemMemUsed will return the number of bytes allocated by the system.  This is slow, call for debug only
   unsigned int GetSystemMemUsed() const;
 
@@ -476,6 +505,14 @@ public:
   /// \brief AllocStringObject() will create a constant string object from the unique string pool.
   /// \param a_length is the string length not including '\0' terminator, (-1) if unknown
   gmStringObject * AllocStringObject(const char * a_string, int a_length = -1);
+  gmStringObject * AllocStringObject(const gmStringKey &a_key);
+
+  /// \brief FindStringObject() will find a string in the unique string pool without allocating.  a table can only
+  ///        hold a string key that is in the pool, so NULL means no table has the key.  the string may be garbage
+  ///        waiting to be freed, use it for lookups only and AllocStringObject() to keep it.
+  /// \param a_length is the string length not including '\0' terminator, (-1) if unknown
+  inline gmStringObject * FindStringObject(const char * a_string, int a_length = -1) { return m_strings.Find(gmStringKey(a_string, a_length)); }
+  inline gmStringObject * FindStringObject(const gmStringKey &a_key) { return m_strings.Find(a_key); }
 
   /// \brief AllocPermanantStringObject() will create a constant string object from the unique string pool.  this
   ///        string will not be garbage collected. (m_mark == GM_PERSIST)
@@ -494,6 +531,12 @@ public:
   /// \sa CreateUserType()
   gmUserObject * AllocUserObject(void * a_user, int a_userType);
 
+#if GM_COMPACT_VARIABLE
+  /// \brief AllocVecObject() will create the boxed value of a vec variable, use gmVariable::SetVec2() and SetVec3().
+  /// \param a_type is GM_VEC2 or GM_VEC3
+  gmVecObject * AllocVecObject(gmType a_type, const gmVec3 &a_vec);
+#endif //GM_COMPACT_VARIABLE
+
   //
   //
   // Debug Interface
@@ -510,6 +553,24 @@ public:
   /// \brief GetDebugMode()
   inline bool GetDebugMode() const { return m_debug; }
 
+  /// \brief SetOptimiseMode() will run compiled byte code through the gmByteCodeOpt pass (constant folding, dead
+  ///        branch and unreachable code removal, jump threading, push pop removal).  Defaults to GMCODEGEN_OPTIMISE.
+  inline void SetOptimiseMode(bool a_optimise) { m_optimise = a_optimise; }
+
+  /// \brief GetOptimiseMode()
+  inline bool GetOptimiseMode() const { return m_optimise; }
+
+  /// \brief SetLineOpsMode() will emit a BC_LINE instruction per source line in debug mode compiles, which the debugger
+  ///        needs to break and step.  Without, errors, profilers and the debugger still find lines through each function's
+  ///        line table, and the byte code runs without a dispatch per line.  Defaults to GMCODEGEN_LINEOPS.
+  inline void SetLineOpsMode(bool a_lineOps) { m_lineOps = a_lineOps; }
+
+  /// \brief GetLineOpsMode()
+  inline bool GetLineOpsMode() const { return m_lineOps; }
+
+  /// \brief GetCompileStats() will return the instruction counts for the last script compiled by this machine.
+  inline const gmCodeGenStats &GetCompileStats() const { return m_compileStats; }
+
   /// \brief AddSourceCode() will add source code to the machine, and return a unique id.
   ///        This is used when debug mode is set so the remote debugger can retrieve source as needed
   ///        for debugging.
@@ -539,12 +600,13 @@ public:
 
   inline gmStackFrame * Sys_AllocStackFrame() { return (gmStackFrame *) m_memStackFrames.Alloc(); }
   inline void Sys_FreeStackFrame(gmStackFrame * a_frame) { m_memStackFrames.Free(a_frame); }
-  void Sys_FreeUniqueString(const char * a_string);
+  void Sys_FreeUniqueString(gmStringObject * a_string);
   inline void * Sys_Alloc(int a_size);
   inline void Sys_Free(void * a_mem) { m_fixedSet.Free(a_mem); }
 
   void Sys_RemoveBlocks(gmThread * a_thread);
   void Sys_RemoveSignals(gmThread * a_thread);
+  void Sys_SignalBlock(gmBlock * a_block, const gmVariable &a_signal, int a_dstThreadId, int a_srcThreadId);
 
   void Sys_SignalCreateThread(gmThread * a_thread);
 
@@ -556,9 +618,52 @@ public:
   gmGarbageCollector* m_gc;
 #endif //GM_USE_INCGC
 
+#if GMMACHINE_DOTCACHESIZE
+  /// \brief Sys_DotCacheLookup() finds the node for a_key in a_table, using the node slot remembered for the
+  ///        member access at a_instruction. Returns NULL if a_key is not in a_table.
+  inline gmTableNode * Sys_DotCacheLookup(const void * a_instruction, const gmTableObject * a_table, const gmVariable &a_key);
+#endif //GMMACHINE_DOTCACHESIZE
+  inline void ResetStatsDotCache()                { m_statsDotCacheHits = m_statsDotCacheMisses = 0; }
+  inline int GetStatsDotCacheHits()               { return m_statsDotCacheHits; }
+  inline int GetStatsDotCacheMisses()             { return m_statsDotCacheMisses; }
+
+#if GMTHREAD_BYTECODEHISTOGRAM
+  /// \brief EnableByteCodeHistogram() will start or stop counting executed byte codes, pairs and triples.
+  ///        Enabling an enabled histogram resets the counts.
+  void EnableByteCodeHistogram(bool a_enable);
+  /// \brief GetByteCodeHistogram() returns the histogram, or NULL if it is not enabled.
+  inline gmByteCodeHistogram * GetByteCodeHistogram() const { return m_byteCodeHistogram; }
+#endif //GMTHREAD_BYTECODEHISTOGRAM
+
+#if GMMACHINE_ALLOCPROFILER
+  /// \brief EnableAllocProfiler() will start or stop recording allocations by site and type.  Enabling an enabled
+  ///        profiler resets it.
+  void EnableAllocProfiler(bool a_enable);
+  /// \brief GetAllocProfiler() returns the profiler, or NULL if it is not enabled.
+  inline gmAllocProfiler * GetAllocProfiler() const { return m_allocProfiler; }
+#endif //GMMACHINE_ALLOCPROFILER
+
+#if GMTHREAD_SAMPLING
+  /// \brief SetSampleCallback() sets the function a running thread calls after RequestSample(), with its call stack and
+  ///        GetInstruction() current.  NULL stops sampling.
+  void SetSampleCallback(gmSampleCallback a_callback, void * a_user);
+  /// \brief RequestSample() may be called from any thread.  The sample is taken at the next call or loop back edge a
+  ///        script thread runs, so a request made while no script runs must be cancelled with CancelSample().
+  inline void RequestSample()                     { m_sampleDue = (m_sampleCallback != NULL); }
+  inline void CancelSample()                      { m_sampleDue = false; }
+  inline bool Sys_IsSampleDue() const             { return m_sampleDue; }
+  void Sys_Sample(gmThread * a_thread);
+#endif //GMTHREAD_SAMPLING
+
   inline int GetStatsGCNumFullCollects()          { return m_statsGCFullCollect; }
   inline int GetStatsGCNumIncCollects()           { return m_statsGCIncCollect; }
   inline int GetStatsGCNumWarnings()              { return m_statsGCWarnings; }
+  inline int GetStatsGCNumMinorCollects()         { return m_statsGCMinorCollect; }
+  inline void ResetStatsThreads()                 { m_statsThreadsCreated = m_statsThreadsReused = m_statsThreadStackGrows = 0; }
+  inline int GetStatsThreadsCreated()             { return m_statsThreadsCreated; }
+  inline int GetStatsThreadsReused()              { return m_statsThreadsReused; }
+  inline int GetStatsThreadStackGrows()           { return m_statsThreadStackGrows; }
+  inline void Sys_StatsThreadStackGrow()          { ++m_statsThreadStackGrows; }
   /// \brief Is GC actually running a cycle
   bool IsGCRunning();
 
@@ -583,8 +688,23 @@ protected:
   int m_threadId;                                 ///< cycling thread number
   gmListDouble<gmThread> m_runningThreads;
   gmListDouble<gmThread> m_blockedThreads;
-  gmListDouble<gmThread> m_sleepingThreads;       ///< sorted by timez
-  gmListDouble<gmThread> m_killedThreads;
+  /// \struct gmSleeper is a thread in the sleep heap, keyed on wake time, then the order it went to sleep in.
+  struct gmSleeper
+  {
+    gmuint32 m_timeStamp;
+    gmuint32 m_order;
+    gmThread * m_thread;
+  };
+  gmArraySimple<gmSleeper> m_sleepingThreads;     ///< binary min heap, O(log n) sleep and wake
+  gmuint32 m_sleepOrder;                          ///< sleep count, threads with equal time stamps wake in the order they slept
+  void Sys_SleepInsert(gmThread * a_thread);
+  void Sys_SleepRemove(gmThread * a_thread);
+  int Sys_SleepSiftUp(int a_index);
+  void Sys_SleepSiftDown(int a_index);
+  gmListDouble<gmThread> m_killedThreads;         ///< the thread pool, reset threads with their stacks
+  int m_numKilledThreads;                         ///< threads in m_killedThreads, Count() walks the list
+  int m_threadPoolSize;                           ///< most threads kept in m_killedThreads
+  int m_threadStackBytes;                         ///< stack bytes a new thread starts with, decaying high-water mark
   gmListDouble<gmThread> m_exceptionThreads;      ///< dead threads, hanging around for debugging
   gmHash<int, gmThread> m_threads;
   int GetThreadId();
@@ -604,6 +724,9 @@ protected:
   gmMemFixed m_memTableObj;                       ///< memory for Table objects
   gmMemFixed m_memFunctionObj;                    ///< memory for Function objects
   gmMemFixed m_memUserObj;                        ///< memory for User objects
+#if GM_COMPACT_VARIABLE
+  gmMemFixed m_memVecObj;                         ///< memory for boxed vec2 and vec3 values
+#endif //GM_COMPACT_VARIABLE
   gmMemFixed m_memStackFrames;                    ///< memory for stack frame structures
   gmMemFixedSet m_fixedSet;                       ///< string and small variable sized stuff allocator.
 
@@ -614,14 +737,42 @@ protected:
   bool m_autoMem;                                 ///< Automatically adjust memory limit(s)
   gmuint32 m_mark;                                ///< The mark phase Id for atomic GC
   bool m_gcEnabled;                               ///< GC enabled/disabled
+  bool m_concurrentMark;                          ///< Grays are blackened by the host, see SetConcurrentMark()
   int m_framesSinceLastIncCollect;                ///< number of frames or oportunities since last inc GC end
   int m_gcPhaseCount;                             ///< GC phase, 2 phases required for full GC
   int m_statsGCFullCollect;                       ///< How many times a full collect has occured
   int m_statsGCIncCollect;                        ///< How many times incremental collect has started
+  int m_statsGCMinorCollect;                      ///< How many times the nursery has been collected
+  int m_statsThreadsCreated;                      ///< CreateThread() calls
+  int m_statsThreadsReused;                       ///< CreateThread() calls that took a thread from the pool
+  int m_statsThreadStackGrows;                    ///< times a thread stack was reallocated larger
   int m_statsGCWarnings;                          ///< The incGC thinks it is being used inefficiently.  It this number is large and growing rapidly the hard and soft limits may need calibrating.
 
+  // Member access cache
+#if GMMACHINE_DOTCACHESIZE
+  struct DotCacheEntry
+  {
+    const void * m_instruction;                   ///< BC_GETDOT / BC_SETDOT instruction that owns the entry
+    int m_slot;                                   ///< node slot of the member in the table last looked up
+  };
+  DotCacheEntry m_dotCache[GMMACHINE_DOTCACHESIZE];
+#endif //GMMACHINE_DOTCACHESIZE
+  int m_statsDotCacheHits;                        ///< member lookups satisfied by the cached slot
+  int m_statsDotCacheMisses;                      ///< member lookups that probed the table
+#if GMTHREAD_BYTECODEHISTOGRAM
+  gmByteCodeHistogram * m_byteCodeHistogram;      ///< executed byte code counts, NULL unless enabled
+#endif //GMTHREAD_BYTECODEHISTOGRAM
+#if GMMACHINE_ALLOCPROFILER
+  gmAllocProfiler * m_allocProfiler;              ///< allocation records, NULL unless enabled
+#endif //GMMACHINE_ALLOCPROFILER
+#if GMTHREAD_SAMPLING
+  volatile bool m_sampleDue;                      ///< set by RequestSample(), cleared when the sample is taken
+  gmSampleCallback m_sampleCallback;
+  void * m_sampleUser;
+#endif //GMTHREAD_SAMPLING
+
   // String Table
-  gmHash<const char *, gmStringObject> m_strings;
+  gmHash<gmStringKey, gmStringObject, gmStringHasher> m_strings;
 
   // Types
   class Type
@@ -670,6 +821,11 @@ protected:
   // Debugging
   bool m_debug;
   gmListDouble<gmSourceEntry> m_source;
+
+  // Compiling
+  bool m_optimise;
+  bool m_lineOps;
+  gmCodeGenStats m_compileStats;
   gmLog m_log;
 };
 
@@ -709,6 +865,35 @@ inline gmObject * gmMachine::GetObject(gmptr a_ref)
 
 
 
+#if GMMACHINE_DOTCACHESIZE
+
+inline gmTableNode * gmMachine::Sys_DotCacheLookup(const void * a_instruction, const gmTableObject * a_table, const gmVariable &a_key)
+{
+  // Entries are validated by the key found at the slot, so they never need invalidating.
+  DotCacheEntry * entry = &m_dotCache[((gmuptr) a_instruction >> 2) & (GMMACHINE_DOTCACHESIZE - 1)];
+  if(entry->m_instruction == a_instruction)
+  {
+    gmTableNode * node = a_table->GetNodeAtSlot(entry->m_slot, a_key);
+    if(node)
+    {
+      ++m_statsDotCacheHits;
+      return node;
+    }
+  }
+  ++m_statsDotCacheMisses;
+  int slot = a_table->GetSlot(a_key);
+  if(slot < 0)
+  {
+    return NULL;
+  }
+  entry->m_instruction = a_instruction;
+  entry->m_slot = slot;
+  return a_table->GetNodeAtSlot(slot, a_key);
+}
+
+#endif //GMMACHINE_DOTCACHESIZE
+
+
 inline gmVariable gmMachine::GetTypeVariable(gmType a_type, const gmVariable &a_key) const
 {
   return m_types[a_type].m_variables->Get(a_key);
@@ -14,6 +14,9 @@
 #include "gmThread.h"
 #include "gmMachine.h"
 #include "gmUtil.h"
+#include "gmAllocProfiler.h"
+
+#include <time.h> // clock
 
 //
 // machine
@@ -163,6 +166,90 @@ static int GM_CDECL gmSysGetStatsGCNumWarnings(gmThread * a_thread)
 }
 
 
+static int GM_CDECL gmSysGetStatsGCNumMinorCollects(gmThread * a_thread)
+{
+  a_thread->PushInt(a_thread->GetMachine()->GetStatsGCNumMinorCollects());
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysGetStatsDotCacheHits(gmThread * a_thread)
+{
+  a_thread->PushInt(a_thread->GetMachine()->GetStatsDotCacheHits());
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysGetStatsDotCacheMisses(gmThread * a_thread)
+{
+  a_thread->PushInt(a_thread->GetMachine()->GetStatsDotCacheMisses());
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysByteCodeHistogram(gmThread * a_thread)
+{
+  GM_INT_PARAM(enable, 0, 1);
+#if GMTHREAD_BYTECODEHISTOGRAM
+  a_thread->GetMachine()->EnableByteCodeHistogram(enable != 0);
+  a_thread->PushInt(1);
+#else // !GMTHREAD_BYTECODEHISTOGRAM
+  a_thread->PushInt(0);
+#endif // !GMTHREAD_BYTECODEHISTOGRAM
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysByteCodeHistogramPrint(gmThread * a_thread)
+{
+  GM_INT_PARAM(top, 0, 20);
+#if GMTHREAD_BYTECODEHISTOGRAM
+  const gmByteCodeHistogram * histogram = a_thread->GetMachine()->GetByteCodeHistogram();
+  if(histogram && top > 0)
+  {
+    histogram->Print(stdout, top);
+  }
+#endif // GMTHREAD_BYTECODEHISTOGRAM
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysAllocProfiler(gmThread * a_thread)
+{
+  GM_INT_PARAM(enable, 0, 1);
+#if GMMACHINE_ALLOCPROFILER
+  a_thread->GetMachine()->EnableAllocProfiler(enable != 0);
+  a_thread->PushInt(1);
+#else // !GMMACHINE_ALLOCPROFILER
+  a_thread->PushInt(0);
+#endif // !GMMACHINE_ALLOCPROFILER
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmSysAllocProfilerReport(gmThread * a_thread)
+{
+  GM_STRING_PARAM(file, 0, NULL);
+  GM_INT_PARAM(top, 1, 20);
+#if GMMACHINE_ALLOCPROFILER
+  const gmAllocProfiler * profiler = a_thread->GetMachine()->GetAllocProfiler();
+  if(profiler)
+  {
+    FILE * fp = (file) ? fopen(file, "w") : stdout;
+    if(fp)
+    {
+      profiler->Print(fp, a_thread->GetMachine(), top);
+      if(fp != stdout) fclose(fp);
+      a_thread->PushInt(1);
+      return GM_OK;
+    }
+  }
+#endif // GMMACHINE_ALLOCPROFILER
+  a_thread->PushInt(0);
+  return GM_OK;
+}
+
+
 static int GM_CDECL gmSysIsGCRunning(gmThread * a_thread)
 {
   a_thread->PushInt(a_thread->GetMachine()->IsGCRunning());
@@ -208,6 +295,14 @@ static int GM_CDECL gmMachineTime(gmThread * a_thread) // return machine time
 
 
 
+static int GM_CDECL gmMachineClock(gmThread * a_thread) // return processor clock in ms
+{
+  a_thread->PushFloat((gmfloat) clock() * (1000.0f / (gmfloat) CLOCKS_PER_SEC));
+  return GM_OK;
+}
+
+
+
 //
 // thread
 //
@@ -506,6 +601,9 @@ static int GM_CDECL gmSetState(gmThread * a_thread) // fp, params
     currentState->m_setExitState = NULL;
     currentState->m_lastState = currentState->m_currentState;
     currentState->m_currentState = function;
+#if GM_USE_INCGC
+    a_thread->GetMachine()->GetGC()->WriteBarrierStore(userObj, function);
+#endif //GM_USE_INCGC
     newStateVariable = *currentStateVariable;
   }
   else
@@ -581,6 +679,9 @@ static int GM_CDECL gmSetStateOnThread(gmThread * a_thread) // (threadid, fp, pa
     currentState->m_setExitState = NULL;
     currentState->m_lastState = currentState->m_currentState;
     currentState->m_currentState = function;
+#if GM_USE_INCGC
+    a_thread->GetMachine()->GetGC()->WriteBarrierStore(userObj, function);
+#endif //GM_USE_INCGC
     newStateVariable = *currentStateVariable;
   }
   else
@@ -695,6 +796,9 @@ static int GM_CDECL gmSetExitState(gmThread * a_thread) // function
     gmUserObject * userObj = (gmUserObject *) GM_OBJECT(currentStateVariable->m_value.m_ref);
     gmStateUserType * currentState = (gmStateUserType *) userObj->m_user;
     currentState->m_setExitState = function;
+#if GM_USE_INCGC
+    a_thread->GetMachine()->GetGC()->WriteBarrierStore(userObj, function);
+#endif //GM_USE_INCGC
   }
   return GM_OK;
 }
@@ -1187,6 +1291,13 @@ static gmFunctionEntry s_binding[] =
   */
   {"sysGetStatsGCNumIncCollects", gmSysGetStatsGCNumIncCollects},
 
+  /*gm
+    \function sysGetStatsGCNumMinorCollects
+    \brief sysGetStatsGCNumMinorCollects Return the number of times the nursery of young objects has been collected.
+    \return int Number of times minor collect has occured.
+  */
+  {"sysGetStatsGCNumMinorCollects", gmSysGetStatsGCNumMinorCollects},
+
   /*gm
     \function sysGetStatsGCNumWarnings
     \brief sysGetStatsGCNumWarnings Return the number of warnings because the GC or VM thought the GC was poorly configured.
@@ -1196,6 +1307,54 @@ static gmFunctionEntry s_binding[] =
   */
   {"sysGetStatsGCNumWarnings", gmSysGetStatsGCNumWarnings},
 
+  /*gm
+    \function sysGetStatsDotCacheHits
+    \brief sysGetStatsDotCacheHits Return the number of member accesses (a.b) resolved from the inline cache.
+    \return int Number of cache hits since the host last reset the stats, the funk VirtualMachine resets them every frame.
+  */
+  {"sysGetStatsDotCacheHits", gmSysGetStatsDotCacheHits},
+
+  /*gm
+    \function sysGetStatsDotCacheMisses
+    \brief sysGetStatsDotCacheMisses Return the number of member accesses (a.b) that had to search the table.
+    \return int Number of cache misses since the host last reset the stats, the funk VirtualMachine resets them every frame.
+  */
+  {"sysGetStatsDotCacheMisses", gmSysGetStatsDotCacheMisses},
+
+  /*gm
+    \function sysByteCodeHistogram
+    \brief sysByteCodeHistogram Start or stop counting executed byte codes, pairs and triples. Starting resets the counts.
+    \param int enable optional (1)
+    \return int 0 if the machine was built without GMTHREAD_BYTECODEHISTOGRAM.
+  */
+  {"sysByteCodeHistogram", gmSysByteCodeHistogram},
+
+  /*gm
+    \function sysByteCodeHistogramPrint
+    \brief sysByteCodeHistogramPrint Print the most frequent byte codes, pairs and triples to stdout.
+    \param int top optional (20) number of entries in each list
+  */
+  {"sysByteCodeHistogramPrint", gmSysByteCodeHistogramPrint},
+
+  /*gm
+    \function sysAllocProfiler
+    \brief sysAllocProfiler Start or stop recording object allocations by site and type, with bytes and lifetimes.
+           Starting resets the records.  Sites need scripts compiled in debug mode.
+    \param int enable optional (1)
+    \return int 0 if the machine was built without GMMACHINE_ALLOCPROFILER.
+  */
+  {"sysAllocProfiler", gmSysAllocProfiler},
+
+  /*gm
+    \function sysAllocProfilerReport
+    \brief sysAllocProfilerReport Write the allocation sites by bytes allocated, the types, and the gc cycles their
+           objects survived.
+    \param string file optional (null) file to write, null prints to stdout
+    \param int top optional (20) number of sites
+    \return int 1 if the report was written.
+  */
+  {"sysAllocProfilerReport", gmSysAllocProfilerReport},
+
   /*gm
     \function sysIsGCRunning
     \brief Returns true if GC is running a cycle.
@@ -1208,6 +1367,13 @@ static gmFunctionEntry s_binding[] =
     \return int
   */
   {"sysTime", gmMachineTime},
+
+  /*gm
+    \function sysClock
+    \brief sysClock will return the processor clock in milli seconds, use for timing script code (benchmarks)
+    \return float
+  */
+  {"sysClock", gmMachineClock},
     
   /*gm
     \function doString
@@ -49,14 +49,14 @@ int GM_CDECL gmfToString(gmThread * a_thread)
   else if (GM_VEC2 == var->m_type)
   {
 	  char numberAsStringBuffer[64];
-	  sprintf(numberAsStringBuffer, "v2(%f, %f)", var->m_value.m_v2.x, var->m_value.m_v2.y ); // this won't be > 64 chars
+	  sprintf(numberAsStringBuffer, "v2(%f, %f)", var->GetVec2().x, var->GetVec2().y ); // this won't be > 64 chars
 	  a_thread->PushNewString(numberAsStringBuffer);
   }
 
   else if (GM_VEC3 == var->m_type)
   {
 	  char numberAsStringBuffer[64];
-	  sprintf(numberAsStringBuffer, "v3(%f, %f, %f)", var->m_value.m_v3.x, var->m_value.m_v3.y, var->m_value.m_v3.z ); // this won't be > 64 chars
+	  sprintf(numberAsStringBuffer, "v3(%f, %f, %f)", var->GetVec3().x, var->GetVec3().y, var->GetVec3().z ); // this won't be > 64 chars
 	  a_thread->PushNewString(numberAsStringBuffer);
   }
 
@@ -297,14 +297,14 @@ static int GM_CDECL gmfFloor(gmThread * a_thread)
   }
   else if(a_thread->ParamType(0) == GM_VEC2)
   {
-	  v2 vec2Val = a_thread->Param(0).m_value.m_v2;
+	  v2 vec2Val = a_thread->Param(0).GetVec2();
 	  a_thread->PushVec2(v2(floorf(vec2Val.x), floorf(vec2Val.y)));
 
 	  return GM_OK;
   }
   else if(a_thread->ParamType(0) == GM_VEC3)
   {
-	  v3 vec2Val = a_thread->Param(0).m_value.m_v3;
+	  v3 vec2Val = a_thread->Param(0).GetVec3();
 	  a_thread->PushVec3(v3(floorf(vec2Val.x), floorf(vec2Val.y), floorf(vec2Val.z)));
 
 	  return GM_OK;
@@ -333,14 +333,14 @@ void GM_CDECL gmVec2OpAdd(gmThread * a_thread, gmVariable * a_operands)
 	GM_OP_VEC2(v0,0);
 	GM_OP_VEC2(v1,1);
 	gmVec2 res = {v0.x+v1.x, v0.y+v1.y};
-	a_operands[0].SetVec2(res);
+	a_operands[0].SetVec2(a_thread->GetMachine(), res);
 }
 void GM_CDECL gmVec2OpSub(gmThread * a_thread, gmVariable * a_operands)
 {
 	GM_OP_VEC2(v0,0);
 	GM_OP_VEC2(v1,1);
 	gmVec2 res = {v0.x-v1.x, v0.y-v1.y};
-	a_operands[0].SetVec2(res);
+	a_operands[0].SetVec2(a_thread->GetMachine(), res);
 }
 void GM_CDECL gmVec2OpMul(gmThread * a_thread, gmVariable * a_operands)
 {
@@ -354,11 +354,11 @@ void GM_CDECL gmVec2OpMul(gmThread * a_thread, gmVariable * a_operands)
 		float coeff = 1.0f;
 		if ( type == GM_INT ) coeff = (float)a_operands[1].GetInt();
 		else coeff = (float)a_operands[1].GetFloat();
-		a_operands[0].SetVec2( thisVal * coeff );
+		a_operands[0].SetVec2( a_thread->GetMachine(), thisVal * coeff );
 	}
 	else if ( type == GM_VEC2 )
 	{
-		a_operands[0].SetVec2( thisVal * a_operands[1].GetVec2() );
+		a_operands[0].SetVec2( a_thread->GetMachine(), thisVal * a_operands[1].GetVec2() );
 	}
 	else
 	{
@@ -377,11 +377,11 @@ void GM_CDECL gmVec2OpDiv(gmThread * a_thread, gmVariable * a_operands)
 		float coeff = 1.0f;
 		if ( type == GM_INT ) coeff = (float)a_operands[1].GetInt();
 		else coeff = (float)a_operands[1].GetFloat();
-		a_operands[0].SetVec2( thisVal / coeff );
+		a_operands[0].SetVec2( a_thread->GetMachine(), thisVal / coeff );
 	}
 	else if ( type == GM_VEC2 )
 	{
-		a_operands[0].SetVec2( thisVal / a_operands[1].GetVec2() );
+		a_operands[0].SetVec2( a_thread->GetMachine(), thisVal / a_operands[1].GetVec2() );
 	}
 	else
 	{
@@ -404,7 +404,7 @@ void GM_CDECL gmVec2OpNEQ(gmThread * a_thread, gmVariable * a_operands)
 }
 void GM_CDECL gmVec2OpNEG(gmThread * a_thread, gmVariable * a_operands)
 {
-	a_operands[0].SetVec2( -v2(a_operands[0].m_value.m_v2 ) );
+	a_operands[0].SetVec2( a_thread->GetMachine(), -a_operands[0].GetVec2() );
 }
 
 void GM_CDECL gmVec2OpPOS(gmThread * a_thread, gmVariable * a_operands)
@@ -425,7 +425,7 @@ void GM_CDECL gmVec2GetDot(gmThread * a_thread, gmVariable * a_operands)
 		else if ( stricmp( memberStr, "yy") == 0 ) result =  v2(thisVal.y, thisVal.y);		
 		else a_operands[0].Nullify();
 
-		a_operands[0].SetVec2(result);
+		a_operands[0].SetVec2(a_thread->GetMachine(), result);
 	}
 
 	else if( strlen(memberStr) == 1 )
@@ -466,14 +466,14 @@ void GM_CDECL gmVec3OpAdd(gmThread * a_thread, gmVariable * a_operands)
 	GM_OP_VEC3(v0,0);
 	GM_OP_VEC3(v1,1);
 	gmVec3 res = {v0.x+v1.x, v0.y+v1.y, v0.z+v1.z};
-	a_operands[0].SetVec3(res);
+	a_operands[0].SetVec3(a_thread->GetMachine(), res);
 }
 void GM_CDECL gmVec3OpSub(gmThread * a_thread, gmVariable * a_operands)
 {
 	GM_OP_VEC3(v0,0);
 	GM_OP_VEC3(v1,1);
 	gmVec3 res = {v0.x-v1.x, v0.y-v1.y, v0.z-v1.z};
-	a_operands[0].SetVec3(res);
+	a_operands[0].SetVec3(a_thread->GetMachine(), res);
 }
 void GM_CDECL gmVec3OpMul(gmThread * a_thread, gmVariable * a_operands)
 {
@@ -487,11 +487,11 @@ void GM_CDECL gmVec3OpMul(gmThread * a_thread, gmVariable * a_operands)
 		float coeff = 1.0f;
 		if ( type == GM_INT ) coeff = (float)a_operands[1].GetInt();
 		else coeff = (float)a_operands[1].GetFloat();
-		a_operands[0].SetVec3( thisVal * coeff );
+		a_operands[0].SetVec3( a_thread->GetMachine(), thisVal * coeff );
 	}
 	else if ( type == GM_VEC3 )
 	{
-		a_operands[0].SetVec3( thisVal * a_operands[1].GetVec3() );
+		a_operands[0].SetVec3( a_thread->GetMachine(), thisVal * a_operands[1].GetVec3() );
 	}
 	else
 	{
@@ -510,11 +510,11 @@ void GM_CDECL gmVec3OpDiv(gmThread * a_thread, gmVariable * a_operands)
 		float coeff = 1.0f;
 		if ( type == GM_INT ) coeff = (float)a_operands[1].GetInt();
 		else coeff = (float)a_operands[1].GetFloat();
-		a_operands[0].SetVec3( thisVal / coeff );
+		a_operands[0].SetVec3( a_thread->GetMachine(), thisVal / coeff );
 	}
 	else if ( type == GM_VEC3 )
 	{
-		a_operands[0].SetVec3( thisVal / a_operands[1].GetVec3() );
+		a_operands[0].SetVec3( a_thread->GetMachine(), thisVal / a_operands[1].GetVec3() );
 	}
 	else
 	{
@@ -537,7 +537,7 @@ void GM_CDECL gmVec3OpNEQ(gmThread * a_thread, gmVariable * a_operands)
 }
 void GM_CDECL gmVec3OpNEG(gmThread * a_thread, gmVariable * a_operands)
 {
-	a_operands[0].SetVec3( -v3(a_operands[0].m_value.m_v3 ) );
+	a_operands[0].SetVec3( a_thread->GetMachine(), -a_operands[0].GetVec3() );
 }
 
 void GM_CDECL gmVec3OpPOS(gmThread * a_thread, gmVariable * a_operands)
@@ -581,7 +581,7 @@ void GM_CDECL gmVec3GetDot(gmThread * a_thread, gmVariable * a_operands)
 		else if ( stricmp( memberStr, "zzz") == 0 ) result = v3(thisVal.z, thisVal.z, thisVal.z);
 		else a_operands[0].Nullify();
 
-		a_operands[0].SetVec3(result);
+		a_operands[0].SetVec3(a_thread->GetMachine(), result);
 	}
 
 	else if( strlen(memberStr) == 2 )
@@ -599,7 +599,7 @@ void GM_CDECL gmVec3GetDot(gmThread * a_thread, gmVariable * a_operands)
 		else if ( stricmp( memberStr, "zz") == 0 ) result =  v2(thisVal.z, thisVal.z);
 		else a_operands[0].Nullify();
 
-		a_operands[0].SetVec2(result);
+		a_operands[0].SetVec2(a_thread->GetMachine(), result);
 	}
 
 	else if( strlen(memberStr) == 1 )
@@ -658,11 +658,11 @@ inline const char * gmUnknownToString(gmMachine * a_machine, gmVariable * a_unkn
   }
   else if (a_unknown->m_type == GM_VEC2)
   {
-	  sprintf(a_buffer, "v2(%f, %f)", a_unknown->m_value.m_v2.x, a_unknown->m_value.m_v2.y); // this won't be > 64 chars
+	  sprintf(a_buffer, "v2(%f, %f)", a_unknown->GetVec2().x, a_unknown->GetVec2().y); // this won't be > 64 chars
   }
   else if (a_unknown->m_type == GM_VEC3)
   {
-	  sprintf(a_buffer, "v3(%f, %f, %f)", a_unknown->m_value.m_v3.x, a_unknown->m_value.m_v3.y, a_unknown->m_value.m_v3.z); // this won't be > 64 chars
+	  sprintf(a_buffer, "v3(%f, %f, %f)", a_unknown->GetVec3().x, a_unknown->GetVec3().y, a_unknown->GetVec3().z); // this won't be > 64 chars
   }
 
   else
@@ -687,6 +687,15 @@ void GM_CDECL gmStringOpAdd(gmThread * a_thread, gmVariable * a_operands)
   a_operands->m_type = GM_STRING;
   a_operands->m_value.m_ref = (gmptr) machine->AllocStringObject(buffer, len1 + len2);
 }
+void gmAppendAsString(gmMachine * a_machine, const gmVariable &a_var, gmArraySimple<char> &a_buffer)
+{
+  char buffer[GMSTRING_BUFFERSIZE];
+  int len = 0;
+  const char * str = gmUnknownToString(a_machine, (gmVariable *) &a_var, buffer, &len);
+  const gmuint count = a_buffer.Count();
+  a_buffer.SetCount(count + len);
+  memcpy(a_buffer.GetData() + count, str, len);
+}
 void GM_CDECL gmStringOpLT(gmThread * a_thread, gmVariable * a_operands)
 {
   gmMachine * machine = a_thread->GetMachine();
@@ -15,6 +15,7 @@
 #include "gmConfig.h"
 #include "gmVariable.h"
 #include "gmByteCode.h"
+#include "gmArraySimple.h"
 
 struct gmVariable;
 class gmThread;
@@ -76,4 +77,11 @@ typedef void (GM_CDECL *gmOperatorFunction)(gmThread * a_thread, gmVariable * a_
 
 void gmInitBasicType(gmType a_type, gmOperatorFunction * a_operators);
 
+/// \brief gmStringOpAdd() is the string add operator, gmThread builds a chain of adds itself while it is in place.
+void GM_CDECL gmStringOpAdd(gmThread * a_thread, gmVariable * a_operands);
+
+/// \brief gmAppendAsString() appends the characters of a_var, as gmStringOpAdd converts it, to a_buffer without a
+///        terminator.  a_var must be a type <= GM_STRING.
+void gmAppendAsString(gmMachine * a_machine, const gmVariable &a_var, gmArraySimple<char> &a_buffer);
+
 #endif // _GMOPERATORS_H_
@@ -4,6 +4,8 @@
 
 #define YYBISON 1  /* Identify Bison output.  */
 
+#define YYPURE 1
+
 #define yyparse gmparse
 #define yylex gmlex
 #define yyerror gmerror
@@ -65,7 +67,11 @@
 #include "gmCodeTree.h"
 #define YYSTYPE gmCodeTreeNode *
 
-extern gmCodeTreeNode * g_codeTree;
+extern GM_THREAD_LOCAL gmCodeTreeNode * g_codeTree;
+
+// pure parser, the look ahead and semantic value live on the gmparse() stack.  the scanner does not set a
+// semantic value, rules build nodes from gmtext.
+inline int gmlex(YYSTYPE * a_lval) { return gmlex(); }
 
 #define GM_BISON_DEBUG
 #ifdef GM_BISON_DEBUG
@@ -1794,7 +1800,7 @@ case 119:
 case 120:
 {
       yyval = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_IDENTIFIER, gmlineno);
-      yyval->m_data.m_string = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      yyval->m_data.m_string = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy(yyval->m_data.m_string, gmtext);
     ;
     break;}
@@ -1832,7 +1838,7 @@ case 126:
 {
       yyval = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_CONSTANT, gmlineno, CTNCT_INT);
 
-      char * c = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      char * c = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy(c, gmtext);
       int result = 0;
       int shr = 0;
@@ -1870,7 +1876,7 @@ case 126:
         ++shr;
       }
 
-      if(shr > 4 && gmCodeTree::Get().GetLog()) gmCodeTree::Get().GetLog()->LogEntry("truncated char, line %d", gmlineno);
+      if(shr > 4 && gmCodeTree::Current().GetLog()) gmCodeTree::Current().GetLog()->LogEntry("truncated char, line %d", gmlineno);
 
       yyval->m_data.m_iValue = result;
     ;
@@ -1895,7 +1901,7 @@ case 129:
 case 130:
 {
       yyval = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_CONSTANT, gmlineno, CTNCT_STRING);
-      yyval->m_data.m_string = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      yyval->m_data.m_string = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy(yyval->m_data.m_string, gmtext);
       if(gmtext[0] == '"')
       {
@@ -1912,7 +1918,7 @@ case 131:
       yyval = yyvsp[-1];
       int alen = (int)strlen(yyval->m_data.m_string);
       int blen = (int)strlen(gmtext);
-      char * str = (char *) gmCodeTree::Get().Alloc(alen + blen + 1);
+      char * str = (char *) gmCodeTree::Current().Alloc(alen + blen + 1);
       if(str)
       {
         memcpy(str, yyvsp[-1]->m_data.m_string, alen);
@@ -48,5 +48,3 @@
 #define	SYMBOL_NEQ	302
 #define	TOKEN_ERROR	303
 
-
-extern YYSTYPE gmlval;
@@ -16,7 +16,11 @@
 #include "gmCodeTree.h"
 #define YYSTYPE gmCodeTreeNode *
 
-extern gmCodeTreeNode * g_codeTree;
+extern GM_THREAD_LOCAL gmCodeTreeNode * g_codeTree;
+
+// pure parser, the look ahead and semantic value live on the gmparse() stack.  the scanner does not set a
+// semantic value, rules build nodes from gmtext.
+inline int gmlex(YYSTYPE * a_lval) { return gmlex(); }
 
 #define GM_BISON_DEBUG
 #ifdef GM_BISON_DEBUG
@@ -116,6 +120,7 @@ gmCodeTreeNode * CreateAsignExpression(int a_subTypeType, gmCodeTreeNode * a_lef
 %token SYMBOL_NEQ
 %token TOKEN_ERROR
 
+%pure_parser
 %start program
 %%
 
@@ -799,7 +804,7 @@ identifier
   : IDENTIFIER
     {
       $$ = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_IDENTIFIER, gmlineno);
-      $$->m_data.m_string = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      $$->m_data.m_string = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy($$->m_data.m_string, gmtext);
     }
   ;
@@ -834,7 +839,7 @@ constant
     {
       $$ = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_CONSTANT, gmlineno, CTNCT_INT);
 
-      char * c = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      char * c = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy(c, gmtext);
       int result = 0;
       int shr = 0;
@@ -872,7 +877,7 @@ constant
         ++shr;
       }
 
-      if(shr > 4 && gmCodeTree::Get().GetLog()) gmCodeTree::Get().GetLog()->LogEntry("truncated char, line %d", gmlineno);
+      if(shr > 4 && gmCodeTree::Current().GetLog()) gmCodeTree::Current().GetLog()->LogEntry("truncated char, line %d", gmlineno);
 
       $$->m_data.m_iValue = result;
     }
@@ -896,7 +901,7 @@ constant_string_list
   : CONSTANT_STRING
     {
       $$ = gmCodeTreeNode::Create(CTNT_EXPRESSION, CTNET_CONSTANT, gmlineno, CTNCT_STRING);
-      $$->m_data.m_string = (char *) gmCodeTree::Get().Alloc((int)strlen(gmtext) + 1);
+      $$->m_data.m_string = (char *) gmCodeTree::Current().Alloc((int)strlen(gmtext) + 1);
       strcpy($$->m_data.m_string, gmtext);
       if(gmtext[0] == '"')
       {
@@ -912,7 +917,7 @@ constant_string_list
       $$ = $1;
       int alen = (int)strlen($$->m_data.m_string);
       int blen = (int)strlen(gmtext);
-      char * str = (char *) gmCodeTree::Get().Alloc(alen + blen + 1);
+      char * str = (char *) gmCodeTree::Current().Alloc(alen + blen + 1);
       if(str)
       {
         memcpy(str, $1->m_data.m_string, alen);
@@ -0,0 +1,217 @@
+#include "gmSampleProfiler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "gmMachine.h"
+#include "gmThread.h"
+#include "gmFunctionObject.h"
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <SDL_timer.h>
+
+gmSampleProfiler::gmSampleProfiler( gmMachine *vm, int periodMs )
+	: m_vm(vm), m_periodMs(periodMs > 0 ? periodMs : 1), m_executing(false), m_quit(false),
+	m_frameSamples(0), m_lastFrameSamples(0), m_totalSamples(0)
+{
+#if GMTHREAD_SAMPLING
+	m_vm->SetSampleCallback( Sample, this );
+#endif //GMTHREAD_SAMPLING
+	m_mutex = SDL_CreateMutex();
+	m_thread = SDL_CreateThread( Worker, this );
+}
+
+gmSampleProfiler::~gmSampleProfiler()
+{
+	SDL_LockMutex( m_mutex );
+	m_quit = true;
+	m_executing = false;
+	SDL_UnlockMutex( m_mutex );
+
+	SDL_WaitThread( m_thread, NULL );
+	SDL_DestroyMutex( m_mutex );
+
+#if GMTHREAD_SAMPLING
+	m_vm->SetSampleCallback( NULL, NULL );
+#endif //GMTHREAD_SAMPLING
+}
+
+void gmSampleProfiler::BeginExecute()
+{
+	SDL_LockMutex( m_mutex );
+	m_executing = true;
+	SDL_UnlockMutex( m_mutex );
+}
+
+void gmSampleProfiler::EndExecute()
+{
+	// a request left over would be answered by the next call into the machine, charging it with the time in between
+	SDL_LockMutex( m_mutex );
+	m_executing = false;
+#if GMTHREAD_SAMPLING
+	m_vm->CancelSample();
+#endif //GMTHREAD_SAMPLING
+	SDL_UnlockMutex( m_mutex );
+}
+
+void gmSampleProfiler::EndFrame()
+{
+	for( StackMap::const_iterator it = m_frameStacks.begin(); it != m_frameStacks.end(); ++it )
+	{
+		m_totalStacks[it->first] += it->second;
+	}
+
+	for( FunctionMap::const_iterator it = m_frameFunctions.begin(); it != m_frameFunctions.end(); ++it )
+	{
+		Counts & counts = m_totalFunctions[it->first];
+		counts.self += it->second.self;
+		counts.total += it->second.total;
+	}
+
+	m_lastFrameFunctions.swap( m_frameFunctions );
+	m_lastFrameSamples = m_frameSamples;
+	m_totalSamples += m_frameSamples;
+
+	m_frameStacks.clear();
+	m_frameFunctions.clear();
+	m_frameSamples = 0;
+}
+
+void gmSampleProfiler::Clear()
+{
+	m_frameStacks.clear();
+	m_totalStacks.clear();
+	m_frameFunctions.clear();
+	m_lastFrameFunctions.clear();
+	m_totalFunctions.clear();
+	m_frameSamples = 0;
+	m_lastFrameSamples = 0;
+	m_totalSamples = 0;
+}
+
+bool gmSampleProfiler::WriteFolded( const char * file ) const
+{
+	FILE * fp = fopen( file, "w" );
+	if ( !fp ) return false;
+
+	for( StackMap::const_iterator it = m_totalStacks.begin(); it != m_totalStacks.end(); ++it )
+	{
+		fprintf( fp, "%s %d\n", it->first.c_str(), it->second );
+	}
+
+	fclose( fp );
+	return true;
+}
+
+static bool CompareSelf( const gmSampleProfiler::Function & a, const gmSampleProfiler::Function & b )
+{
+	return a.self != b.self ? a.self > b.self : a.total > b.total;
+}
+
+void gmSampleProfiler::GetFunctions( std::vector<Function> & functions, bool lastFrame ) const
+{
+	const FunctionMap & counts = lastFrame ? m_lastFrameFunctions : m_totalFunctions;
+
+	functions.clear();
+	functions.reserve( counts.size() );
+	for( FunctionMap::const_iterator it = counts.begin(); it != counts.end(); ++it )
+	{
+		Function function;
+		function.name = it->first;
+		function.self = it->second.self;
+		function.total = it->second.total;
+		functions.push_back( function );
+	}
+
+	std::sort( functions.begin(), functions.end(), CompareSelf );
+}
+
+void gmSampleProfiler::Sample( gmThread * thread, void * user )
+{
+	((gmSampleProfiler *)user)->Record( thread );
+}
+
+void gmSampleProfiler::Record( gmThread * thread )
+{
+	// walk from the running function out to the thread's root, as in gmThread::LogCallStack
+	std::string frames[64];
+	std::string functions[64];
+	int depth = 0;
+
+	const gmVariable * base = thread->GetBase();
+	const gmuint8 * ip = thread->GetInstruction();
+	const gmStackFrame * frame = thread->GetFrame();
+
+	while( frame && depth < 64 )
+	{
+		const gmVariable * fnVar = base - 1;
+		if ( fnVar->m_type == GM_FUNCTION )
+		{
+			const gmFunctionObject * fn = (const gmFunctionObject *) GM_MOBJECT( m_vm, fnVar->m_value.m_ref );
+
+			const char * source = NULL;
+			const char * file = NULL;
+			if ( !m_vm->GetSourceCode( fn->GetSourceId(), source, file ) || !file ) file = "?";
+			const char * slash = strrchr( file, '/' );
+			if ( slash ) file = slash + 1;
+
+			char buffer[256];
+			sprintf( buffer, "%.160s (%.64s", fn->GetDebugName(), file );
+			functions[depth] = buffer;
+			sprintf( buffer + strlen(buffer), ":%d)", ip ? fn->GetLine( ip ) : 0 );
+			frames[depth] = buffer;
+			++depth;
+		}
+
+		base = thread->GetBottom() + frame->m_returnBase;
+		ip = frame->m_returnAddress;
+		frame = frame->m_prev;
+	}
+
+	if ( depth == 0 ) return;
+
+	// folded stacks go from the root to the leaf
+	std::string stack = frames[depth - 1];
+	for( int i = depth - 2; i >= 0; --i )
+	{
+		stack += ';';
+		stack += frames[i];
+	}
+	m_frameStacks[stack] += 1;
+
+	m_frameFunctions[functions[0] + ")"].self += 1;
+	for( int i = 0; i < depth; ++i )
+	{
+		// recursion counts once toward the total
+		bool seen = false;
+		for( int j = 0; j < i && !seen; ++j ) seen = functions[j] == functions[i];
+		if ( !seen ) m_frameFunctions[functions[i] + ")"].total += 1;
+	}
+
+	++m_frameSamples;
+}
+
+int gmSampleProfiler::Worker( void * data )
+{
+	((gmSampleProfiler *)data)->Run();
+	return 0;
+}
+
+void gmSampleProfiler::Run()
+{
+	while ( true )
+	{
+		SDL_Delay( m_periodMs );
+
+		SDL_LockMutex( m_mutex );
+		const bool quit = m_quit;
+#if GMTHREAD_SAMPLING
+		if ( m_executing ) m_vm->RequestSample();
+#endif //GMTHREAD_SAMPLING
+		SDL_UnlockMutex( m_mutex );
+
+		if ( quit ) break;
+	}
+}
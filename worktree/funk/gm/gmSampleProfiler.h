@@ -0,0 +1,83 @@
+#ifndef _INCLUDE_GM_SAMPLE_PROFILER_H
+#define _INCLUDE_GM_SAMPLE_PROFILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gmConfig.h"
+
+class gmMachine;
+class gmThread;
+struct SDL_Thread;
+struct SDL_mutex;
+
+// records the call stack of the running script thread every period, see gmMachine::RequestSample.
+// costs nothing while it does not exist, names and lines need the scripts compiled in debug mode.
+// it needs a machine built with GMTHREAD_SAMPLING (GM_PROFILE_BUILD), elsewhere it records nothing
+class gmSampleProfiler
+{
+public:
+	static bool IsSupported() { return GMTHREAD_SAMPLING != 0; }
+
+	gmSampleProfiler( gmMachine *vm, int periodMs = 1 );
+	~gmSampleProfiler();
+
+	// samples are only taken between these, around calls into the machine
+	void BeginExecute();
+	void EndExecute();
+
+	// folds this frame's samples into the totals
+	void EndFrame();
+	void Clear();
+
+	// writes the totals as folded stacks, a "caller;callee samples" line per stack, for flamegraph.pl or speedscope
+	bool WriteFolded( const char * file ) const;
+
+	struct Function
+	{
+		std::string name;	// "function (file)"
+		int self;			// samples in the function itself
+		int total;			// samples in the function and its callees
+	};
+
+	// functions by self samples, most first, over the last frame or all frames since Clear
+	void GetFunctions( std::vector<Function> & functions, bool lastFrame ) const;
+
+	int GetLastFrameSamples() const { return m_lastFrameSamples; }
+	int GetTotalSamples() const { return m_totalSamples; }
+	int GetPeriodMs() const { return m_periodMs; }
+
+private:
+	struct Counts
+	{
+		int self;
+		int total;
+	};
+	typedef std::map<std::string, Counts> FunctionMap;
+	typedef std::map<std::string, int> StackMap;
+
+	static void Sample( gmThread * thread, void * user );
+	void Record( gmThread * thread );
+	static int Worker( void * data );
+	void Run();
+
+	gmMachine * m_vm;
+	SDL_Thread * m_thread;
+	SDL_mutex * m_mutex;
+	int m_periodMs;
+	bool m_executing;	// a sample request is answered before the machine returns
+	bool m_quit;
+
+	// touched by the machine's thread only
+	StackMap m_frameStacks;
+	StackMap m_totalStacks;
+	FunctionMap m_frameFunctions;
+	FunctionMap m_lastFrameFunctions;
+	FunctionMap m_totalFunctions;
+	int m_frameSamples;
+	int m_lastFrameSamples;
+	int m_totalSamples;
+};
+
+#endif
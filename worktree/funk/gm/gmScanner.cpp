@@ -31,6 +31,7 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include "gmScanner.h" // gmScanState, scanner state is per compile so scripts may be compiled concurrently
 
 
 #ifdef __cplusplus
@@ -111,8 +112,24 @@
 
 typedef struct yy_buffer_state *YY_BUFFER_STATE;
 
-extern int yyleng;
-extern FILE *yyin, *yyout;
+/* The scanner's globals are fields of the calling thread's gmScanState, see
+ * gmScanner.h.  flex defines yyin, yyout, yylineno, yytext and the REJECT
+ * state itself as well, gmfrontend.bat removes those definitions.
+ */
+#undef yyleng
+#define yyleng (g_scanState->m_leng)
+#undef yyin
+#define yyin (g_scanState->m_in)
+#undef yyout
+#define yyout (g_scanState->m_out)
+#undef yytext
+#define yytext (g_scanState->m_text)
+#undef yylineno
+#define yylineno (g_scanState->m_lineno)
+#define yy_state_buf (g_scanState->m_states)
+#define yy_state_ptr (g_scanState->m_statePos)
+#define yy_full_match (g_scanState->m_fullMatch)
+#define yy_lp (g_scanState->m_lp)
 
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
@@ -168,7 +185,7 @@ struct yy_buffer_state
    /* Number of characters read into yy_ch_buf, not including EOB
     * characters.
     */
-   int yy_n_chars;
+   int yy_buf_n_chars;
 
    /* Whether we "own" the buffer - i.e., we know we created it,
     * and can realloc() it to grow it, and should free() it to
@@ -210,7 +227,7 @@ struct yy_buffer_state
 #define YY_BUFFER_EOF_PENDING 2
    };
 
-static YY_BUFFER_STATE yy_current_buffer = 0;
+#define yy_current_buffer (g_scanState->m_buffer)
 
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
@@ -220,22 +237,20 @@ static YY_BUFFER_STATE yy_current_buffer = 0;
 
 
 /* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
-
-static int yy_n_chars;     /* number of characters read into yy_ch_buf */
+#define yy_hold_char (g_scanState->m_holdChar)
 
+#define yy_n_chars (g_scanState->m_numChars)     /* number of characters read into yy_ch_buf */
 
-int yyleng;
 
 /* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 1;    /* whether we need to initialize */
-static int yy_start = 0;   /* start state number */
+#define yy_c_buf_p (g_scanState->m_bufPos)
+#define yy_init (g_scanState->m_init)    /* whether we need to initialize */
+#define yy_start (g_scanState->m_start)   /* start state number */
 
 /* Flag which is used to allow yywrap()'s to do buffer switches
  * instead of setting up a fresh yyin.  A bit of a hack ...
  */
-static int yy_did_buffer_switch_on_eof;
+#define yy_did_buffer_switch_on_eof (g_scanState->m_didBufferSwitchOnEof)
 
 void yyrestart YY_PROTO(( FILE *input_file ));
 
@@ -276,11 +291,7 @@ static void yy_flex_free YY_PROTO(( void * ));
 
 #define YY_USES_REJECT
 typedef unsigned char YY_CHAR;
-FILE *yyin = (FILE *) 0, *yyout = (FILE *) 0;
 typedef int yy_state_type;
-extern int yylineno;
-int yylineno = 1;
-extern char *yytext;
 #define yytext_ptr yytext
 
 static yy_state_type yy_get_previous_state YY_PROTO(( void ));
@@ -539,9 +550,6 @@ static yyconst short int yy_chk[355] =
       185,  185,  185,  185
     } ;
 
-static yy_state_type yy_state_buf[YY_BUF_SIZE + 2], *yy_state_ptr;
-static char *yy_full_match;
-static int yy_lp;
 #define REJECT \
 { \
 *yy_cp = yy_hold_char; /* undo effects of setting up yytext */ \
@@ -551,7 +559,6 @@ goto find_rule; \
 }
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
-char *yytext;
 #line 1 "gmScanner.l"
 #define INITIAL 0
 /*
@@ -567,10 +574,11 @@ char *yytext;
 #line 22 "gmScanner.l"
 
 #include <stdio.h>
+#include <string.h>
 #include "gmConfig.h"
 #include "gmParser.cpp.h"
 
-#line 574 "gmScanner.cpp"
+#line 582 "gmScanner.cpp"
 
 /* Macros after this point can all be overridden by user definitions in
  * section 1.
@@ -601,9 +609,9 @@ static int input YY_PROTO(( void ));
 #endif
 
 #if YY_STACK_USED
-static int yy_start_stack_ptr = 0;
-static int yy_start_stack_depth = 0;
-static int *yy_start_stack = 0;
+#define yy_start_stack_ptr (g_scanState->m_startStackPtr)
+#define yy_start_stack_depth (g_scanState->m_startStackDepth)
+#define yy_start_stack (g_scanState->m_startStack)
 #ifndef YY_NO_PUSH_STATE
 static void yy_push_state YY_PROTO(( int new_state ));
 #endif
@@ -739,10 +747,10 @@ YY_DECL
    register char *yy_cp, *yy_bp;
    register int yy_act;
 
-#line 29 "gmScanner.l"
+#line 30 "gmScanner.l"
 
 
-#line 746 "gmScanner.cpp"
+#line 754 "gmScanner.cpp"
 
    if ( yy_init )
       {
@@ -835,7 +843,7 @@ do_action:  /* This label is used only to access EOF actions. */
    { /* beginning of action switch */
 case 1:
 YY_RULE_SETUP
-#line 31 "gmScanner.l"
+#line 32 "gmScanner.l"
 {
             int c;
 
@@ -853,400 +861,400 @@ YY_RULE_SETUP
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 46 "gmScanner.l"
+#line 47 "gmScanner.l"
 { /* eat up comments */       }
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 48 "gmScanner.l"
+#line 49 "gmScanner.l"
 { return(KEYWORD_LOCAL);      }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 49 "gmScanner.l"
+#line 50 "gmScanner.l"
 { return(KEYWORD_GLOBAL);     }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 50 "gmScanner.l"
+#line 51 "gmScanner.l"
 { return(KEYWORD_MEMBER);     }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 51 "gmScanner.l"
+#line 52 "gmScanner.l"
 { return(KEYWORD_AND);        }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 52 "gmScanner.l"
+#line 53 "gmScanner.l"
 { return(KEYWORD_OR);         }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 53 "gmScanner.l"
+#line 54 "gmScanner.l"
 { return(KEYWORD_IF);         }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 54 "gmScanner.l"
+#line 55 "gmScanner.l"
 { return(KEYWORD_ELSE);       }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 55 "gmScanner.l"
+#line 56 "gmScanner.l"
 { return(KEYWORD_WHILE);      }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 56 "gmScanner.l"
+#line 57 "gmScanner.l"
 { return(KEYWORD_FOR);        }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 57 "gmScanner.l"
+#line 58 "gmScanner.l"
 { return(KEYWORD_FOREACH);    }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 58 "gmScanner.l"
+#line 59 "gmScanner.l"
 { return(KEYWORD_IN);         }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 59 "gmScanner.l"
+#line 60 "gmScanner.l"
 { return(KEYWORD_DOWHILE);    }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 60 "gmScanner.l"
+#line 61 "gmScanner.l"
 { return(KEYWORD_BREAK);      }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 61 "gmScanner.l"
+#line 62 "gmScanner.l"
 { return(KEYWORD_CONTINUE);   }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 62 "gmScanner.l"
+#line 63 "gmScanner.l"
 { return(KEYWORD_NULL);       }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 63 "gmScanner.l"
+#line 64 "gmScanner.l"
 { return(KEYWORD_RETURN);     }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 64 "gmScanner.l"
+#line 65 "gmScanner.l"
 { return(KEYWORD_FUNCTION);   }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 65 "gmScanner.l"
+#line 66 "gmScanner.l"
 { return(KEYWORD_TABLE);      }
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 66 "gmScanner.l"
+#line 67 "gmScanner.l"
 { return(KEYWORD_THIS);       }
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 67 "gmScanner.l"
+#line 68 "gmScanner.l"
 { return(KEYWORD_TRUE);       }
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 68 "gmScanner.l"
+#line 69 "gmScanner.l"
 { return(KEYWORD_FALSE);      }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 69 "gmScanner.l"
+#line 70 "gmScanner.l"
 { return(KEYWORD_FORK);       }
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 71 "gmScanner.l"
+#line 72 "gmScanner.l"
 { return(IDENTIFIER);         }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 73 "gmScanner.l"
+#line 74 "gmScanner.l"
 { return(CONSTANT_HEX);       }
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 74 "gmScanner.l"
+#line 75 "gmScanner.l"
 { return(CONSTANT_BINARY);    }
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 75 "gmScanner.l"
+#line 76 "gmScanner.l"
 { return(CONSTANT_INT);       }
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 76 "gmScanner.l"
+#line 77 "gmScanner.l"
 { return(CONSTANT_CHAR);      }
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 77 "gmScanner.l"
+#line 78 "gmScanner.l"
 { return(CONSTANT_FLOAT);     }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 78 "gmScanner.l"
+#line 79 "gmScanner.l"
 { return(CONSTANT_FLOAT);     }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 79 "gmScanner.l"
+#line 80 "gmScanner.l"
 { return(CONSTANT_FLOAT);     }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 80 "gmScanner.l"
+#line 81 "gmScanner.l"
 { return(CONSTANT_STRING);    }
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 81 "gmScanner.l"
+#line 82 "gmScanner.l"
 { return(CONSTANT_STRING);    }
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 83 "gmScanner.l"
+#line 84 "gmScanner.l"
 { return(KEYWORD_AND);        }
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 84 "gmScanner.l"
+#line 85 "gmScanner.l"
 { return(KEYWORD_OR);         }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 85 "gmScanner.l"
+#line 86 "gmScanner.l"
 { return(SYMBOL_ASGN_BSR);    }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 86 "gmScanner.l"
+#line 87 "gmScanner.l"
 { return(SYMBOL_ASGN_BSL);    }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 87 "gmScanner.l"
+#line 88 "gmScanner.l"
 { return(SYMBOL_ASGN_ADD);    }
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 88 "gmScanner.l"
+#line 89 "gmScanner.l"
 { return(SYMBOL_ASGN_MINUS);  }
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 89 "gmScanner.l"
+#line 90 "gmScanner.l"
 { return(SYMBOL_ASGN_TIMES);  }
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 90 "gmScanner.l"
+#line 91 "gmScanner.l"
 { return(SYMBOL_ASGN_DIVIDE); }
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 91 "gmScanner.l"
+#line 92 "gmScanner.l"
 { return(SYMBOL_ASGN_REM);    }
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 92 "gmScanner.l"
+#line 93 "gmScanner.l"
 { return(SYMBOL_ASGN_BAND);   }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 93 "gmScanner.l"
+#line 94 "gmScanner.l"
 { return(SYMBOL_ASGN_BOR);    }
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 94 "gmScanner.l"
+#line 95 "gmScanner.l"
 { return(SYMBOL_ASGN_BXOR);   }
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 95 "gmScanner.l"
+#line 96 "gmScanner.l"
 { return(SYMBOL_RIGHT_SHIFT); }
 	YY_BREAK
 case 48:
 YY_RULE_SETUP
-#line 96 "gmScanner.l"
+#line 97 "gmScanner.l"
 { return(SYMBOL_LEFT_SHIFT);  }
 	YY_BREAK
 case 49:
 YY_RULE_SETUP
-#line 97 "gmScanner.l"
+#line 98 "gmScanner.l"
 { return(SYMBOL_LTE);         }
 	YY_BREAK
 case 50:
 YY_RULE_SETUP
-#line 98 "gmScanner.l"
+#line 99 "gmScanner.l"
 { return(SYMBOL_GTE);         }
 	YY_BREAK
 case 51:
 YY_RULE_SETUP
-#line 99 "gmScanner.l"
+#line 100 "gmScanner.l"
 { return(SYMBOL_EQ);          }
 	YY_BREAK
 case 52:
 YY_RULE_SETUP
-#line 100 "gmScanner.l"
+#line 101 "gmScanner.l"
 { return(SYMBOL_NEQ);         }
 	YY_BREAK
 case 53:
 YY_RULE_SETUP
-#line 101 "gmScanner.l"
+#line 102 "gmScanner.l"
 { return('?');				}
 	YY_BREAK
 case 54:
 YY_RULE_SETUP
-#line 102 "gmScanner.l"
+#line 103 "gmScanner.l"
 { return(';');                }
 	YY_BREAK
 case 55:
 YY_RULE_SETUP
-#line 103 "gmScanner.l"
+#line 104 "gmScanner.l"
 { return('{');                }
 	YY_BREAK
 case 56:
 YY_RULE_SETUP
-#line 104 "gmScanner.l"
+#line 105 "gmScanner.l"
 { return('}');                }
 	YY_BREAK
 case 57:
 YY_RULE_SETUP
-#line 105 "gmScanner.l"
+#line 106 "gmScanner.l"
 { return(',');                }
 	YY_BREAK
 case 58:
 YY_RULE_SETUP
-#line 106 "gmScanner.l"
+#line 107 "gmScanner.l"
 { return('=');                }
 	YY_BREAK
 case 59:
 YY_RULE_SETUP
-#line 107 "gmScanner.l"
+#line 108 "gmScanner.l"
 { return('(');                }
 	YY_BREAK
 case 60:
 YY_RULE_SETUP
-#line 108 "gmScanner.l"
+#line 109 "gmScanner.l"
 { return(')');                }
 	YY_BREAK
 case 61:
 YY_RULE_SETUP
-#line 109 "gmScanner.l"
+#line 110 "gmScanner.l"
 { return('[');                }
 	YY_BREAK
 case 62:
 YY_RULE_SETUP
-#line 110 "gmScanner.l"
+#line 111 "gmScanner.l"
 { return(']');                }
 	YY_BREAK
 case 63:
 YY_RULE_SETUP
-#line 111 "gmScanner.l"
+#line 112 "gmScanner.l"
 { return('.');                }
 	YY_BREAK
 case 64:
 YY_RULE_SETUP
-#line 112 "gmScanner.l"
+#line 113 "gmScanner.l"
 { return('!');                }
 	YY_BREAK
 case 65:
 YY_RULE_SETUP
-#line 113 "gmScanner.l"
+#line 114 "gmScanner.l"
 { return('-');                }
 	YY_BREAK
 case 66:
 YY_RULE_SETUP
-#line 114 "gmScanner.l"
+#line 115 "gmScanner.l"
 { return('+');                }
 	YY_BREAK
 case 67:
 YY_RULE_SETUP
-#line 115 "gmScanner.l"
+#line 116 "gmScanner.l"
 { return('*');                }
 	YY_BREAK
 case 68:
 YY_RULE_SETUP
-#line 116 "gmScanner.l"
+#line 117 "gmScanner.l"
 { return('/');                }
 	YY_BREAK
 case 69:
 YY_RULE_SETUP
-#line 117 "gmScanner.l"
+#line 118 "gmScanner.l"
 { return('%');                }
 	YY_BREAK
 case 70:
 YY_RULE_SETUP
-#line 118 "gmScanner.l"
+#line 119 "gmScanner.l"
 { return('<');                }
 	YY_BREAK
 case 71:
 YY_RULE_SETUP
-#line 119 "gmScanner.l"
+#line 120 "gmScanner.l"
 { return('>');                }
 	YY_BREAK
 case 72:
 YY_RULE_SETUP
-#line 120 "gmScanner.l"
+#line 121 "gmScanner.l"
 { return('&');                }
 	YY_BREAK
 case 73:
 YY_RULE_SETUP
-#line 121 "gmScanner.l"
+#line 122 "gmScanner.l"
 { return('|');                }
 	YY_BREAK
 case 74:
 YY_RULE_SETUP
-#line 122 "gmScanner.l"
+#line 123 "gmScanner.l"
 { return('^');                }
 	YY_BREAK
 case 75:
 YY_RULE_SETUP
-#line 123 "gmScanner.l"
+#line 124 "gmScanner.l"
 { return('~');                }
 	YY_BREAK
 case 76:
 YY_RULE_SETUP
-#line 124 "gmScanner.l"
+#line 125 "gmScanner.l"
 { return(':');                }
 	YY_BREAK
 case 77:
 YY_RULE_SETUP
-#line 125 "gmScanner.l"
+#line 126 "gmScanner.l"
 { return(':');                }
 	YY_BREAK
 case 78:
 YY_RULE_SETUP
-#line 127 "gmScanner.l"
+#line 128 "gmScanner.l"
 {                             }
 	YY_BREAK
 case 79:
 YY_RULE_SETUP
-#line 128 "gmScanner.l"
+#line 129 "gmScanner.l"
 { return(TOKEN_ERROR);        }
 	YY_BREAK
 case 80:
 YY_RULE_SETUP
-#line 130 "gmScanner.l"
+#line 131 "gmScanner.l"
 ECHO;
 	YY_BREAK
-#line 1250 "gmScanner.cpp"
+#line 1258 "gmScanner.cpp"
 			case YY_STATE_EOF(INITIAL):
 				yyterminate();
 
@@ -1269,7 +1277,7 @@ ECHO;
           * this is the first action (other than possibly a
           * back-up) that will match for the new input source.
           */
-         yy_n_chars = yy_current_buffer->yy_n_chars;
+         yy_n_chars = yy_current_buffer->yy_buf_n_chars;
          yy_current_buffer->yy_input_file = yyin;
          yy_current_buffer->yy_buffer_status = YY_BUFFER_NORMAL;
          }
@@ -1729,7 +1737,7 @@ YY_BUFFER_STATE new_buffer;
       /* Flush out information for old buffer. */
       *yy_c_buf_p = yy_hold_char;
       yy_current_buffer->yy_buf_pos = yy_c_buf_p;
-      yy_current_buffer->yy_n_chars = yy_n_chars;
+      yy_current_buffer->yy_buf_n_chars = yy_n_chars;
       }
 
    yy_current_buffer = new_buffer;
@@ -1750,7 +1758,7 @@ void yy_load_buffer_state( void )
 void yy_load_buffer_state()
 #endif
    {
-   yy_n_chars = yy_current_buffer->yy_n_chars;
+   yy_n_chars = yy_current_buffer->yy_buf_n_chars;
    yytext_ptr = yy_c_buf_p = yy_current_buffer->yy_buf_pos;
    yyin = yy_current_buffer->yy_input_file;
    yy_hold_char = *yy_c_buf_p;
@@ -1849,7 +1857,7 @@ YY_BUFFER_STATE b;
 #endif
 
    {
-   b->yy_n_chars = 0;
+   b->yy_buf_n_chars = 0;
 
    /* We always need two end-of-buffer characters.  The first causes
     * a transition to the end-of-buffer state.  The second causes
@@ -1893,7 +1901,7 @@ yy_size_t size;
    b->yy_buf_pos = b->yy_ch_buf = base;
    b->yy_is_our_buffer = 0;
    b->yy_input_file = 0;
-   b->yy_n_chars = b->yy_buf_size;
+   b->yy_buf_n_chars = b->yy_buf_size;
    b->yy_is_interactive = 0;
    b->yy_at_bol = 1;
    b->yy_fill_buffer = 0;
@@ -2113,7 +2121,7 @@ int main()
    return 0;
    }
 #endif
-#line 130 "gmScanner.l"
+#line 131 "gmScanner.l"
 
 
 // yywrap
@@ -2124,3 +2132,31 @@ int gmwrap()
 
 
 
+GM_THREAD_LOCAL gmScanState * g_scanState = NULL;
+
+bool gmScanBegin(gmScanState * a_state, const char * a_script)
+{
+  int len = (int) strlen(a_script);
+
+  memset(a_state, 0, sizeof(gmScanState));
+  a_state->m_init = 1;
+  a_state->m_lineno = 1;
+  a_state->m_previous = g_scanState;
+  g_scanState = a_state;
+
+  // a match can run to the end of the script, the scan buffer holds the script and two end of buffer chars
+  yy_state_buf = (yy_state_type *) yy_flex_alloc((len + 2) * sizeof(yy_state_type));
+  if(!yy_state_buf) return false;
+
+  return yy_scan_bytes(a_script, len) != NULL;
+}
+
+void gmScanEnd(gmScanState * a_state)
+{
+  if(yy_current_buffer) yy_delete_buffer(yy_current_buffer);
+  if(yy_state_buf) yy_flex_free(yy_state_buf);
+  g_scanState = a_state->m_previous;
+}
+
+
+
@@ -12,6 +12,7 @@
 #ifndef _GMSCANNER_H_
 #define _GMSCANNER_H_
 
+#include <stdio.h>
 #include "gmConfig.h"
 
 //
@@ -25,8 +26,45 @@ YY_BUFFER_STATE gm_scan_string(const char * str);
 YY_BUFFER_STATE gm_scan_bytes(const char *bytes, int len);
 void gm_delete_buffer(YY_BUFFER_STATE b);
 int gmlex();
-extern char * gmtext;
-extern int gmlineno;
+
+/// \struct gmScanState
+/// \brief gmScanState holds what flex keeps in globals, for one compile.  flex.skl maps the globals on to the
+///        calling thread's state, so several threads may compile at once.
+struct gmScanState
+{
+  YY_BUFFER_STATE m_buffer;
+  char m_holdChar;
+  int m_numChars;
+  char * m_bufPos;
+  int m_init;
+  int m_start;
+  int m_didBufferSwitchOnEof;
+  int * m_startStack;
+  int m_startStackPtr;
+  int m_startStackDepth;
+  FILE * m_in, * m_out;
+  char * m_text;
+  int m_leng;
+  int m_lineno;
+
+  // REJECT, used by yylineno, keeps the state at each character of the match
+  int * m_states, * m_statePos;
+  char * m_fullMatch;
+  int m_lp;
+
+  gmScanState * m_previous;
+};
+
+extern GM_THREAD_LOCAL gmScanState * g_scanState;
+
+/// \brief gmScanBegin() makes a_state the calling thread's scanner, reading a_script.
+/// \return false if the script could not be buffered
+bool gmScanBegin(gmScanState * a_state, const char * a_script);
+/// \brief gmScanEnd() frees a_state's buffers and restores the previous scanner.
+void gmScanEnd(gmScanState * a_state);
+
+#define gmtext (g_scanState->m_text)
+#define gmlineno (g_scanState->m_lineno)
 
 #endif // _GMSCANNER_H_
 
@@ -61,6 +61,11 @@ public:
   /// \return the number of bytes successfully written
   virtual unsigned int Write(const void * p_buffer, unsigned int p_n) = 0;
 
+  /// \brief GetImage() will return the whole stream as contiguous memory if the stream is memory backed, so readers
+  ///        can reference data in place rather than Read() it.
+  /// \return NULL if the stream is not memory backed
+  virtual const void * GetImage() const { return NULL; }
+
   /// \brief GetFlags() will return the current stream flags
   inline Flags GetFlags() const { return (Flags) m_flags; }
 
@@ -14,6 +14,7 @@
 #include "gmThread.h"
 #include "gmMachine.h"
 #include "gmHelpers.h"
+#include "gmOperators.h"
 
 
 //
@@ -946,6 +947,143 @@ static int GM_CDECL gmStringGetPath(gmThread * a_thread)
   return GM_OK;
 }
 
+//
+// StringBuilder
+//
+
+// Statics and globals
+gmType GM_STRINGBUILDER = GM_NULL;
+
+/// \brief gmUserStringBuilder holds the characters appended, not interned until String() is called.  The buffer grows
+///        by powers of 2, so appending is amortised constant time per character.
+struct gmUserStringBuilder
+{
+  gmArraySimple<char> m_chars;
+};
+
+
+static gmUserStringBuilder * gmGetThisStringBuilder(gmThread * a_thread)
+{
+  gmUserObject * builderObject = a_thread->ThisUserObject();
+  GM_ASSERT(builderObject->m_userType == GM_STRINGBUILDER);
+  return (gmUserStringBuilder *) builderObject->m_user;
+}
+
+
+static int GM_CDECL gmfStringBuilder(gmThread * a_thread) // capacity
+{
+  GM_INT_PARAM(capacity, 0, 0);
+  gmUserStringBuilder * builder = (gmUserStringBuilder *) a_thread->GetMachine()->Sys_Alloc(sizeof(gmUserStringBuilder));
+  GM_PLACEMENT_NEW( gmUserStringBuilder(), builder );
+  if(capacity > 0)
+  {
+    builder->m_chars.SetCount(capacity);
+    builder->m_chars.Reset();
+  }
+  a_thread->PushNewUser(builder, GM_STRINGBUILDER);
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmfStringBuilderAppend(gmThread * a_thread) // ...
+{
+  gmMachine * machine = a_thread->GetMachine();
+  gmUserStringBuilder * builder = gmGetThisStringBuilder(a_thread);
+  if(builder)
+  {
+    int i;
+    for(i = 0; i < a_thread->GetNumParams(); ++i)
+    {
+      const gmVariable &var = a_thread->Param(i);
+      if(var.m_type <= GM_STRING)
+      {
+        // as the string add operator converts it
+        gmAppendAsString(machine, var, builder->m_chars);
+      }
+      else
+      {
+        char buffer[256];
+        const char * str = var.AsString(machine, buffer, sizeof(buffer));
+        const int len = (int) strlen(str);
+        const gmuint count = builder->m_chars.Count();
+        builder->m_chars.SetCount(count + len);
+        memcpy(builder->m_chars.GetData() + count, str, len);
+      }
+    }
+  }
+  a_thread->Push(*a_thread->GetThis());
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmfStringBuilderLength(gmThread * a_thread)
+{
+  gmUserStringBuilder * builder = gmGetThisStringBuilder(a_thread);
+  a_thread->PushInt((builder) ? (int) builder->m_chars.Count() : 0);
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmfStringBuilderClear(gmThread * a_thread)
+{
+  gmUserStringBuilder * builder = gmGetThisStringBuilder(a_thread);
+  if(builder) builder->m_chars.Reset();
+  a_thread->Push(*a_thread->GetThis());
+  return GM_OK;
+}
+
+
+static int GM_CDECL gmfStringBuilderString(gmThread * a_thread)
+{
+  gmUserStringBuilder * builder = gmGetThisStringBuilder(a_thread);
+  if(builder && builder->m_chars.Count())
+  {
+    a_thread->PushNewString(builder->m_chars.GetData(), builder->m_chars.Count());
+  }
+  else
+  {
+    a_thread->PushNewString("", 0);
+  }
+  return GM_OK;
+}
+
+
+static void gmDestructStringBuilder(gmMachine * a_machine, gmUserObject * a_object)
+{
+  if(a_object->m_user)
+  {
+    gmUserStringBuilder * builder = (gmUserStringBuilder *) a_object->m_user;
+    builder->~gmUserStringBuilder();
+    a_machine->Sys_Free(builder);
+  }
+  a_object->m_user = NULL;
+}
+
+#if GM_USE_INCGC
+static void GM_CDECL gmGCDestructStringBuilderUserType(gmMachine * a_machine, gmUserObject* a_object)
+{
+  gmDestructStringBuilder(a_machine, a_object);
+}
+
+static bool GM_CDECL gmGCTraceStringBuilderUserType(gmMachine * a_machine, gmUserObject* a_object, gmGarbageCollector* a_gc, const int a_workLeftToGo, int& a_workDone)
+{
+  // holds no references
+  ++a_workDone;
+  return true;
+}
+
+#else //GM_USE_INCGC
+static void GM_CDECL gmMarkStringBuilderUserType(gmMachine * a_machine, gmUserObject * a_object, gmuint32 a_mark)
+{
+}
+
+static void GM_CDECL gmGCStringBuilderUserType(gmMachine * a_machine, gmUserObject * a_object, gmuint32 a_mark)
+{
+  gmDestructStringBuilder(a_machine, a_object);
+}
+#endif //GM_USE_INCGC
+
+
 extern int GM_CDECL gmfToInt(gmThread * a_thread);
 extern int GM_CDECL gmfToFloat(gmThread * a_thread);
 extern int GM_CDECL gmfToString(gmThread * a_thread);
@@ -1161,10 +1299,65 @@ static gmFunctionEntry s_stringLib[] =
 */
 };
 
+static gmFunctionEntry s_stringBuilderLib[] = 
+{ 
+  /*gm
+    \lib gm
+  */
+  /*gm
+    \function StringBuilder
+    \brief StringBuilder will create a string builder, appending to it does not intern each intermediate string
+    \param int capacity optional (0) characters to reserve
+    \return stringbuilder
+  */
+  {"StringBuilder", gmfStringBuilder},
+};
+
+static gmFunctionEntry s_stringBuilderTypeLib[] = 
+{ 
+  /*gm
+    \lib stringbuilder
+  */
+  /*gm
+    \function Append
+    \brief Append will append each parameter, converted as the string add operator does, or as print does for other types
+    \param ... values to append
+    \return this stringbuilder
+  */
+  {"Append", gmfStringBuilderAppend},
+  /*gm
+    \function Length
+    \brief Length will return the number of characters appended
+    \return int length
+  */
+  {"Length", gmfStringBuilderLength},
+  /*gm
+    \function Clear
+    \brief Clear will empty the builder, keeping its memory for reuse
+    \return this stringbuilder
+  */
+  {"Clear", gmfStringBuilderClear},
+  /*gm
+    \function String
+    \brief String will return the characters appended as a string
+    \return string
+  */
+  {"String", gmfStringBuilderString},
+};
+
 void gmBindStringLib(gmMachine * a_machine)
 {
   a_machine->RegisterTypeOperator(GM_STRING, O_BIT_XOR, NULL, gmStringOpAppendPath);
   a_machine->RegisterTypeOperator(GM_STRING, O_GETIND, NULL, gmStringOpGetInd);
   a_machine->RegisterTypeLibrary(GM_STRING, s_stringLib, sizeof(s_stringLib) / sizeof(s_stringLib[0]));
+
+  a_machine->RegisterLibrary(s_stringBuilderLib, sizeof(s_stringBuilderLib) / sizeof(s_stringBuilderLib[0]));
+  GM_STRINGBUILDER = a_machine->CreateUserType("stringbuilder");
+  a_machine->RegisterTypeLibrary(GM_STRINGBUILDER, s_stringBuilderTypeLib, sizeof(s_stringBuilderTypeLib) / sizeof(s_stringBuilderTypeLib[0]));
+#if GM_USE_INCGC
+  a_machine->RegisterUserCallbacks(GM_STRINGBUILDER, gmGCTraceStringBuilderUserType, gmGCDestructStringBuilderUserType);
+#else //GM_USE_INCGC
+  a_machine->RegisterUserCallbacks(GM_STRINGBUILDER, gmMarkStringBuilderUserType, gmGCStringBuilderUserType);
+#endif //GM_USE_INCGC
 }
 
@@ -13,9 +13,12 @@
 #define _GMSTRINGLIB_H_
 
 #include "gmConfig.h"
+#include "gmVariable.h"
 
 class gmMachine;
 
+extern gmType GM_STRINGBUILDER;
+
 void gmBindStringLib(gmMachine * a_machine);
 
 #endif // _GMSTRINGLIB_H_
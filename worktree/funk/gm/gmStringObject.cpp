@@ -15,7 +15,7 @@
 
 void gmStringObject::Destruct(gmMachine * a_machine) 
 {
-  a_machine->Sys_FreeUniqueString(m_string);
+  a_machine->Sys_FreeUniqueString(this);
 #if GM_USE_INCGC
   a_machine->DestructDeleteObject(this);
 #endif //GM_USE_INCGC
@@ -18,13 +18,76 @@
 
 class gmMachine;
 
+/// \class gmStringKey
+/// \brief gmStringKey is the key of the unique string pool.  The hash and length are computed once, so a native can
+///        keep a gmStringKey for a name it looks up often, and the pool never rehashes a string it holds.
+struct gmStringKey
+{
+  gmStringKey() {}
+  gmStringKey(const char * a_string, int a_length = -1)
+  {
+    m_string = a_string;
+    m_hash = 0;
+    if(a_length < 0)
+    {
+      // hash and measure in one pass
+      const char * cp = a_string;
+      while(*cp != '\0')
+      {
+        m_hash = (m_hash + ((m_hash << 5) + *cp));
+        ++cp;
+      }
+      m_length = (int) (cp - a_string);
+    }
+    else
+    {
+      m_length = a_length;
+      int i;
+      for(i = 0; i < a_length; ++i)
+      {
+        m_hash = (m_hash + ((m_hash << 5) + a_string[i]));
+      }
+    }
+  }
+
+  const char * m_string;
+  int m_length;
+  gmuint m_hash;
+};
+
+/// \class gmStringHasher
+/// \brief gmStringHasher is the HASHER of the unique string pool, comparing the hash and length before the characters
+class gmStringHasher
+{
+public:
+
+  static inline gmuint Hash(const gmStringKey &a_key)
+  {
+    return a_key.m_hash;
+  }
+
+  static inline int Compare(const gmStringKey &a_keyA, const gmStringKey &a_keyB)
+  {
+    if(a_keyA.m_hash != a_keyB.m_hash) return (a_keyA.m_hash < a_keyB.m_hash) ? -1 : 1;
+    if(a_keyA.m_length != a_keyB.m_length) return a_keyA.m_length - a_keyB.m_length;
+    return memcmp(a_keyA.m_string, a_keyB.m_string, a_keyA.m_length);
+  }
+};
+
 /// \class gmStringObject
 /// \brief
-class gmStringObject : public gmObject, public gmHashNode<const char *, gmStringObject>
+class gmStringObject : public gmObject, public gmHashNode<gmStringKey, gmStringObject, gmStringHasher>
 {
 public:
 
-  inline const char * GetKey() const { return m_string; }
+  inline gmStringKey GetKey() const
+  {
+    gmStringKey key;
+    key.m_string = m_string;
+    key.m_length = m_length;
+    key.m_hash = m_hash;
+    return key;
+  }
 
   virtual int GetType() const { return GM_STRING; }
   virtual void Destruct(gmMachine * a_machine);
@@ -32,17 +95,19 @@ public:
   inline operator const char *() const { return m_string; }
   inline const char * GetString() const { return m_string; }
   inline int GetLength() const { return m_length; }
+  inline gmuint GetHash() const { return m_hash; }
 
 protected:
 
   /// \brief Non-public constructor.  Create via gmMachine.
-  gmStringObject(const char * a_string, int a_length) { m_string = a_string; m_length = a_length; }
+  gmStringObject(const char * a_string, const gmStringKey &a_key) { m_string = a_string; m_length = a_key.m_length; m_hash = a_key.m_hash; }
   friend class gmMachine;
 
 private:
 
   const char * m_string;
   int m_length;
+  gmuint m_hash;
 };
 
 #endif // _GMSTRINGOBJECT_H_
@@ -73,6 +73,19 @@ static int GM_CDECL gmfSystem(gmThread * a_thread)
   return GM_OK;
 }
 
+// string values of a table in key order
+static void gmTableFileNames(gmTableObject * a_table, std::vector<const char*> & a_files)
+{
+	std::vector<gmVariable> keys;
+	gmSortTableKeys( a_table, keys );
+
+	for( size_t i = 0; i < keys.size(); ++i )
+	{
+		gmVariable file = a_table->Get(keys[i]);
+		if ( file.IsString() ) a_files.push_back( file.GetCStringSafe() );
+	}
+}
+
 static int GM_CDECL gmfDoFile(gmThread * a_thread) // filename, now (1), return thread id, null on error, exception on compile error.
 {
   GM_CHECK_NUM_PARAMS(1);
@@ -124,6 +137,22 @@ static int GM_CDECL gmfDoFile(gmThread * a_thread) // filename, now (1), return
   return GM_OK;
 }
 
+static int GM_CDECL gmfDoFiles(gmThread * a_thread) // table of filenames, threads (4), return number of files that failed
+{
+	GM_CHECK_NUM_PARAMS(1);
+	GM_CHECK_TABLE_PARAM(table, 0);
+	GM_INT_PARAM(threads, 1, 4);
+
+	std::vector<const char*> files;
+	gmTableFileNames( table, files );
+
+	int failed = 0;
+	if ( !files.empty() ) failed = gmCompileFiles( a_thread->GetMachine(), &files[0], (int)files.size(), threads );
+	a_thread->PushInt(failed);
+
+	return GM_OK;
+}
+
 //
 //
 // Implementation of ansi file binding
@@ -811,6 +840,14 @@ static gmFunctionEntry s_systemLib[] =
     \return thread id of new thread created to execute file
   */
   {"DoFile", gmfDoFile},
+  /*gm
+    \function DoFiles
+    \brief DoFiles will compile the gm scripts in the named files on worker threads, then execute them in order
+    \param table of filenames
+    \param int optional (4) number of compile threads, including the calling thread
+    \return number of files that failed to load
+  */
+  {"DoFiles", gmfDoFiles},
   /*gm
   \function SaveTableToFile
   \brief Save gm table to a file
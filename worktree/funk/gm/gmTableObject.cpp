@@ -21,6 +21,9 @@ gmTableObject::gmTableObject()
   m_firstFree = NULL;
   m_tableSize = 0;
   m_slotsUsed = 0;
+  m_array = NULL;
+  m_arraySize = 0;
+  m_arrayUsed = 0;
 }
 
 
@@ -31,6 +34,15 @@ bool gmTableObject::Trace(gmMachine * a_machine, gmGarbageCollector* a_gc, const
 {
   gmTableNode * curNode;
   int index;
+  for(index = 0; index < m_arraySize; ++index)
+  {
+    if(m_array[index].IsReference())
+    {
+      gmObject* object = GM_MOBJECT(a_machine, m_array[index].m_value.m_ref);
+      a_gc->GetNextObject(object);
+      ++a_workDone;
+    }
+  }
   for(index = 0; index < m_tableSize; ++index)
   {
     if(m_nodes[index].m_key.m_type != GM_NULL)
@@ -63,6 +75,14 @@ void gmTableObject::Mark(gmMachine * a_machine, gmuint32 a_mark)
 
   gmTableNode * curNode;
   int index;
+  for(index = 0; index < m_arraySize; ++index)
+  {
+    if(m_array[index].IsReference())
+    {
+      gmObject* object = GM_MOBJECT(a_machine, m_array[index].m_value.m_ref);
+      if(object->NeedsMark(a_mark)) object->Mark(a_machine, a_mark);
+    }
+  }
   for(index = 0; index < m_tableSize; ++index)
   {
     if(m_nodes[index].m_key.m_type != GM_NULL)
@@ -91,10 +111,17 @@ void gmTableObject::Destruct(gmMachine * a_machine)
     a_machine->Sys_Free(m_nodes);
     m_nodes = NULL;
   }
+  if(m_array)
+  {
+    a_machine->Sys_Free(m_array);
+    m_array = NULL;
+  }
 
   m_firstFree = NULL;
   m_tableSize = 0;
   m_slotsUsed = 0;
+  m_arraySize = 0;
+  m_arrayUsed = 0;
 
 #if GM_USE_INCGC
   a_machine->DestructDeleteObject(this);
@@ -132,6 +159,13 @@ inline int VarKeysEqual(const gmVariable& a_varA, const gmVariable& a_varB)
     }
   }
 #endif  
+#if GM_COMPACT_VARIABLE
+  // boxed vec keys are equal by value, as they were unboxed
+  if( (a_varA.m_type == GM_VEC2 || a_varA.m_type == GM_VEC3) && a_varA.m_type == a_varB.m_type )
+  {
+    return gmVariable::CompareVec(a_varA, a_varB) == 0;
+  }
+#endif //GM_COMPACT_VARIABLE
   return false;
 }
 
@@ -140,6 +174,11 @@ gmVariable gmTableObject::Get(const gmVariable &a_key) const
 {
   gmTableNode* foundNode = NULL;
 
+  if(a_key.m_type == GM_INT && (unsigned int) a_key.m_value.m_int < (unsigned int) m_arraySize)
+  {
+    return m_array[a_key.m_value.m_int];
+  }
+
   if(m_nodes && a_key.m_type != GM_NULL)
   {
     foundNode = GetAtHashPos(&a_key);
@@ -158,9 +197,42 @@ gmVariable gmTableObject::Get(const gmVariable &a_key) const
 }
 
 
+int gmTableObject::GetSlot(const gmVariable &a_key) const
+{
+  if(m_nodes && a_key.m_type != GM_NULL)
+  {
+    gmTableNode* foundNode = GetAtHashPos(&a_key);
+
+    do
+    {
+      if( VarKeysEqual(a_key, foundNode->m_key) )
+      {
+        return (int) (foundNode - m_nodes);
+      }
+      foundNode = foundNode->m_nextInHashTable;
+    } while (foundNode);
+  }
+
+  return -1;
+}
+
+
 gmVariable gmTableObject::Get(gmMachine * a_machine, const char * a_key) const
 {
-  return Get(gmVariable(GM_STRING, a_machine->AllocStringObject(a_key)->GetRef()));
+  return Get(a_machine, gmStringKey(a_key));
+}
+
+
+
+gmVariable gmTableObject::Get(gmMachine * a_machine, const gmStringKey &a_key) const
+{
+  // a string that is not in the pool can't be a key, so don't allocate one to find out
+  gmStringObject * key = a_machine->FindStringObject(a_key);
+  if(key == NULL)
+  {
+    return gmVariable::s_null;
+  }
+  return Get(gmVariable(GM_STRING, key->GetRef()));
 }
 
 
@@ -170,18 +242,91 @@ void gmTableObject::Set(gmMachine * a_machine, const gmVariable &a_key, const gm
 void gmTableObject::Set(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value)
 #endif //GM_USE_INCGC
 {
-  GM_ASSERT(m_firstFree >= &m_nodes[0] && m_firstFree <= &m_nodes[m_tableSize-1]);
+  if(a_key.m_type == GM_NULL)
+  {
+    return;
+  }
 
-  if(!m_tableSize)
+#if GM_USE_INCGC
+  // An old table given a young key or value is remembered for the next minor collection
+  if(a_key.IsReference())
   {
-    Construct(a_machine);
+    a_machine->GetGC()->WriteBarrierStore(this, (gmObject*)a_key.m_value.m_ref);
   }
+  if(a_value.IsReference())
+  {
+    a_machine->GetGC()->WriteBarrierStore(this, (gmObject*)a_value.m_value.m_ref);
+  }
+#endif //GM_USE_INCGC
 
-  if(a_key.m_type == GM_NULL)
+  if(a_key.m_type == GM_INT)
   {
-    return;
+    const unsigned int index = (unsigned int) a_key.m_value.m_int;
+
+    // appending to an array part at least half full doubles it, or more if the nodes hold the keys that follow
+    if(index == (unsigned int) m_arraySize && a_value.m_type != GM_NULL && m_arrayUsed >= (m_arraySize / 2))
+    {
+      int size = (m_arraySize) ? m_arraySize * 2 : MIN_TABLE_SIZE;
+      const int bestSize = (m_slotsUsed) ? GetBestArraySize() : 0;
+      ResizeArray(a_machine, (bestSize > size) ? bestSize : size);
+    }
+
+    if(index < (unsigned int) m_arraySize)
+    {
+      gmVariable * slot = &m_array[index];
+      if(slot->m_type != GM_NULL)
+      {
+#if GM_USE_INCGC
+        if( !a_disableWriteBarrier )
+        {
+          // Value is going, write barrier value only
+          if(slot->IsReference())
+          {
+            a_machine->GetGC()->WriteBarrier((gmObject*)slot->m_value.m_ref);
+          }
+        }
+#endif //GM_USE_INCGC
+        if(a_value.m_type == GM_NULL)
+        {
+          --m_arrayUsed;
+        }
+      }
+      else if(a_value.m_type != GM_NULL)
+      {
+        ++m_arrayUsed;
+      }
+      *slot = a_value;
+      return;
+    }
+  }
+
+#if GM_USE_INCGC
+  SetNode(a_machine, a_key, a_value, a_disableWriteBarrier);
+#else //GM_USE_INCGC
+  SetNode(a_machine, a_key, a_value);
+#endif //GM_USE_INCGC
+}
+
+
+
+#if GM_USE_INCGC
+void gmTableObject::SetNode(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value, bool a_disableWriteBarrier)
+#else //GM_USE_INCGC
+void gmTableObject::SetNode(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value)
+#endif //GM_USE_INCGC
+{
+  if(!m_tableSize)
+  {
+    //If not found, but value is null, don't add it
+    if(GM_NULL == a_value.m_type)
+    {
+      return;
+    }
+    Construct(a_machine);
   }
 
+  GM_ASSERT(m_firstFree >= &m_nodes[0] && m_firstFree <= &m_nodes[m_tableSize-1]);
+
   gmTableNode* origHashNode = GetAtHashPos(&a_key);
   gmTableNode* foundNode = origHashNode;
   gmTableNode* lastNode = NULL;
@@ -324,6 +469,20 @@ gmTableObject * gmTableObject::Duplicate(gmMachine * a_machine)
 {
   gmTableObject * object = a_machine->AllocTableObject();
 
+  if(m_arraySize)
+  {
+    object->ResizeArray(a_machine, m_arraySize);
+
+    int index;
+    for(index = 0; index < m_arraySize; ++index)
+    {
+      if(m_array[index].m_type != GM_NULL)
+      {
+        object->Set(a_machine, gmVariable(GM_INT, (gmptr) index), m_array[index]);
+      }
+    }
+  }
+
   if(m_tableSize)
   {
     object->AllocSize(a_machine, m_tableSize);
@@ -350,28 +509,43 @@ void gmTableObject::Construct(gmMachine * a_machine)
 
 
 
-gmTableNode* gmTableObject::GetNext(gmTableIterator& a_it) const
+bool gmTableObject::GetNext(gmTableIterator& a_it, gmVariable& a_key, gmVariable& a_value) const
 {
   int index = a_it;
   if(index == IT_NULL)
   {
-    return NULL;
+    return false;
   }
   if(index == IT_FIRST)
   {
     index = 0;
   }
-  while(index<m_tableSize)
+  // the array part is iterated by key, then the nodes follow it
+  while(index<m_arraySize)
   {
-    if(m_nodes[index].m_key.m_type != GM_NULL)
+    if(m_array[index].m_type != GM_NULL)
     {
       a_it = index + 1;
-      return &m_nodes[index];
+      a_key = gmVariable(GM_INT, (gmptr) index);
+      a_value = m_array[index];
+      return true;
+    }
+    ++index;
+  }
+  while(index - m_arraySize < m_tableSize)
+  {
+    const gmTableNode * node = &m_nodes[index - m_arraySize];
+    if(node->m_key.m_type != GM_NULL)
+    {
+      a_it = index + 1;
+      a_key = node->m_key;
+      a_value = node->m_value;
+      return true;
     }
     ++index;
   }
   a_it = IT_NULL;
-  return NULL;
+  return false;
 }
 
 // ported from hidef
@@ -388,6 +562,11 @@ void gmTableObject::ClearTable(gmMachine * a_machine, bool a_disableWriteBarrier
 			if(node->m_value.IsReference())
 				a_machine->GetGC()->WriteBarrier((gmObject*)node->m_value.m_value.m_ref);
 		}
+		for ( int index = m_arraySize - 1; index >= 0; --index )
+		{
+			if(m_array[index].IsReference())
+				a_machine->GetGC()->WriteBarrier((gmObject*)m_array[index].m_value.m_ref);
+		}
 	}
 #endif
 
@@ -396,10 +575,17 @@ void gmTableObject::ClearTable(gmMachine * a_machine, bool a_disableWriteBarrier
 		a_machine->Sys_Free(m_nodes);
 		m_nodes = NULL;
 	}
+	if(m_array)
+	{
+		a_machine->Sys_Free(m_array);
+		m_array = NULL;
+	}
 
 	m_firstFree = NULL;
 	m_tableSize = 0;
 	m_slotsUsed = 0;
+	m_arraySize = 0;
+	m_arrayUsed = 0;
 }
 
 /* original attempt for FunkEngine -- doesnt handle marking children for gc
@@ -418,6 +604,17 @@ void gmTableObject::ClearTable(gmMachine * a_machine)
 
 void gmTableObject::Resize(gmMachine * a_machine)
 {
+  // integer keys that would fill most of a larger array part move there rather than grow the nodes
+  const int arraySize = GetBestArraySize();
+  if(arraySize > m_arraySize)
+  {
+    ResizeArray(a_machine, arraySize);
+    if(m_tableSize == 0)
+    {
+      return;
+    }
+  }
+
   int newSize = m_tableSize;
 
   if(m_slotsUsed >= m_tableSize - ( m_tableSize / 4 ))
@@ -442,21 +639,46 @@ void gmTableObject::Resize(gmMachine * a_machine)
     }
     GM_ASSERT(0); //Shouldn't ever get here
   }
-  
+
+  Rehash(a_machine, newSize);
+}
+
+
+
+void gmTableObject::Rehash(gmMachine * a_machine, int a_size)
+{
   gmTableNode* oldNodes = m_nodes;
   int oldTableSize = m_tableSize;
 
-  AllocSize(a_machine, newSize);
+  if(a_size)
+  {
+    AllocSize(a_machine, a_size);
+  }
+  else
+  {
+    // every key is in the array part
+    m_nodes = NULL;
+    m_firstFree = NULL;
+    m_tableSize = 0;
+    m_slotsUsed = 0;
+  }
 
   int index;
   for(index = 0; index < oldTableSize; ++index)
   {
-    if(oldNodes[index].m_key.m_type != GM_NULL)
+    const gmTableNode * node = &oldNodes[index];
+    if(node->m_key.m_type == GM_INT && (unsigned int) node->m_key.m_value.m_int < (unsigned int) m_arraySize)
+    {
+      // the array part has grown over the key
+      m_array[node->m_key.m_value.m_int] = node->m_value;
+      ++m_arrayUsed;
+    }
+    else if(node->m_key.m_type != GM_NULL)
     {
 #if GM_USE_INCGC
-      Set(a_machine, oldNodes[index].m_key, oldNodes[index].m_value, true);
+      SetNode(a_machine, node->m_key, node->m_value, true);
 #else //GM_USE_INCGC
-      Set(a_machine, oldNodes[index].m_key, oldNodes[index].m_value);
+      SetNode(a_machine, node->m_key, node->m_value);
 #endif //GM_USE_INCGC
     }
   }
@@ -482,13 +704,103 @@ void gmTableObject::AllocSize(gmMachine * a_machine, int a_size)
 
 
 
+void gmTableObject::ResizeArray(gmMachine * a_machine, int a_size)
+{
+  GM_ASSERT((a_size & (a_size-1)) == 0 && a_size > m_arraySize);
+
+  gmVariable * array = (gmVariable *) a_machine->Sys_Alloc(sizeof(gmVariable) * a_size);
+  if(m_array)
+  {
+    memcpy(array, m_array, sizeof(gmVariable) * m_arraySize);
+    a_machine->Sys_Free(m_array);
+  }
+  memset(array + m_arraySize, 0, sizeof(gmVariable) * (a_size - m_arraySize));
+
+  const int oldSize = m_arraySize;
+  m_array = array;
+  m_arraySize = a_size;
+
+  // integer keys now in range of the array part move out of the nodes
+  int moved = 0;
+  int index;
+  for(index = 0; index < m_tableSize; ++index)
+  {
+    const gmVariable &key = m_nodes[index].m_key;
+    if(key.m_type == GM_INT && key.m_value.m_int >= oldSize && key.m_value.m_int < a_size)
+    {
+      ++moved;
+    }
+  }
+  if(moved)
+  {
+    // the nodes shrink to what is left, or go when nothing is
+    const int left = m_slotsUsed - moved;
+    int size = 0;
+    if(left)
+    {
+      size = MIN_TABLE_SIZE;
+      while(left >= size - (size / 4)) size *= 2;
+    }
+    Rehash(a_machine, size);
+  }
+}
+
+
+
+int gmTableObject::GetBestArraySize() const
+{
+  // integer keys counted by the power of 2 array size that first holds them, key 0 by size 1, keys 2^(n-1)..2^n-1 by 2^n
+  int counts[32];
+  memset(counts, 0, sizeof(counts));
+
+  int bits, index;
+  for(bits = 0, index = 0; index < m_arraySize; ++bits)
+  {
+    const int end = 1 << bits;
+    for(; index < end && index < m_arraySize; ++index)
+    {
+      if(m_array[index].m_type != GM_NULL) ++counts[bits];
+    }
+  }
+  for(index = 0; index < m_tableSize; ++index)
+  {
+    const gmVariable &key = m_nodes[index].m_key;
+    if(key.m_type == GM_INT && key.m_value.m_int >= 0)
+    {
+      int bits = 0;
+      while(bits < 31 && (1 << bits) <= key.m_value.m_int) ++bits;
+      if(bits < 31) ++counts[bits];
+    }
+  }
+
+  // the largest size more than half used
+  int best = 0;
+  int used = 0;
+  for(bits = 0; bits < 31; ++bits)
+  {
+    used += counts[bits];
+    if(used > (1 << bits) / 2)
+    {
+      best = 1 << bits;
+    }
+  }
+
+  if(best && best < MIN_TABLE_SIZE)
+  {
+    best = MIN_TABLE_SIZE;
+  }
+  return best;
+}
+
+
+
 gmVariable gmTableObject::GetLinearSearch(const char * a_key) const
 {
-  gmTableIterator it;
-  for( gmTableNode * node = GetFirst(it);
-       !IsNull(it);
-       node = GetNext(it) )
+  // string keys are only in the nodes
+  int index;
+  for(index = 0; index < m_tableSize; ++index)
   {
+    const gmTableNode * node = &m_nodes[index];
     if( GM_STRING == node->m_key.m_type )
     {
       if( strcmp(((gmStringObject*)node->m_key.m_value.m_ref)->GetString(), a_key) == 0 )
@@ -16,6 +16,8 @@
 #include "gmVariable.h"
 //#include "gmMem.h"
 
+struct gmStringKey;
+
 typedef int gmTableIterator; ///< Table iterator, is actually the array index, or a reserved value
 
 
@@ -31,7 +33,9 @@ struct gmTableNode
 
 
 /// \class gmTable
-/// \brief
+/// \brief Integer keys 0..n-1 of a table used as an array are kept in a dense array part of values, all other keys in
+///        the hashed nodes.  The array part doubles when appended to while at least half full, and integer keys
+///        already in the nodes move to it when the nodes are resized and most of a larger array part would be used.
 class gmTableObject : public gmObject
 {
 public:
@@ -54,13 +58,38 @@ public:
   
   // Get by variable
   gmVariable Get(const gmVariable &a_key) const;
-  // Get by c string (uses table search)
+  // Get by c string (uses table search, never allocates)
   gmVariable Get(gmMachine * a_machine, const char * a_key) const;
-  // Get by array index (uses table search)
-  gmVariable Get(int a_indexKey) const { return Get(gmVariable(a_indexKey)); }
+  // Get by string key with its hash computed once, keep one for a name looked up often
+  gmVariable Get(gmMachine * a_machine, const gmStringKey &a_key) const;
+  // Get by array index (uses the array part, or table search)
+  gmVariable Get(int a_indexKey) const
+  {
+    if((unsigned int) a_indexKey < (unsigned int) m_arraySize)
+    {
+      return m_array[a_indexKey];
+    }
+    return Get(gmVariable(GM_INT, (gmptr) a_indexKey));
+  }
   // Get by c string (uses linear search)
   gmVariable GetLinearSearch(const char * a_key) const;
 
+  // Get node slot for key, or -1, keys in the array part have none. Slots are stable until the table resizes.
+  int GetSlot(const gmVariable &a_key) const;
+  // Get node at slot if it still holds the string key, else NULL. Used by member access caches.
+  inline gmTableNode * GetNodeAtSlot(int a_slot, const gmVariable &a_key) const
+  {
+    if((unsigned int) a_slot < (unsigned int) m_tableSize)
+    {
+      gmTableNode * node = &m_nodes[a_slot];
+      if(node->m_key.m_type == a_key.m_type && node->m_key.m_value.m_ref == a_key.m_value.m_ref)
+      {
+        return node;
+      }
+    }
+    return NULL;
+  }
+
 #if GM_USE_INCGC  
   void Set(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value, bool a_disableWriteBarrier = false);  
 #else //GM_USE_INCGC
@@ -72,19 +101,19 @@ public:
     Set(a_machine, gmVariable(GM_INT, (gmptr)a_index), a_value);
   }
 
-  inline int Count() const { return m_slotsUsed; }
+  inline int Count() const { return m_slotsUsed + m_arrayUsed; }
   gmTableObject * Duplicate(gmMachine * a_machine);
 
 
   //
-  // iterator
+  // iterator, visits the array part in key order then the nodes
   //
 
-  inline gmTableNode * GetFirst(gmTableIterator& a_it) const
+  inline bool GetFirst(gmTableIterator& a_it, gmVariable& a_key, gmVariable& a_value) const
   {
     a_it = IT_FIRST;
 
-    return GetNext(a_it);
+    return GetNext(a_it, a_key, a_value);
   }
 
   inline bool IsNull(gmTableIterator a_it) const
@@ -96,7 +125,9 @@ public:
     return false;
   }
 
-  gmTableNode * GetNext(gmTableIterator& a_it) const;
+  /// \brief GetNext() will copy the next key and value, leaving them untouched at the end.
+  /// \return false at the end
+  bool GetNext(gmTableIterator& a_it, gmVariable& a_key, gmVariable& a_value) const;
 
   void ClearTable(gmMachine * a_machine, bool a_disableWriteBarrier);
 
@@ -124,6 +155,13 @@ private:
   {
     unsigned int hash = (unsigned int)a_key->m_value.m_ref; // Use lower 32 bits for now (NOTE: Alternate hashing method may improve performance)
 
+#if GM_COMPACT_VARIABLE
+    if(a_key->m_type == GM_VEC2 || a_key->m_type == GM_VEC3)
+    {
+      hash = gmVariable::HashVec(*a_key); // boxed vec keys are equal by value
+    }
+    else
+#endif //GM_COMPACT_VARIABLE
     if(a_key->IsReference())
     {
       hash >>= 2; // Remove 4 byte pointer alignment (may not be optimal)
@@ -135,13 +173,25 @@ private:
   }
 
 
+#if GM_USE_INCGC
+  void SetNode(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value, bool a_disableWriteBarrier);
+#else //GM_USE_INCGC
+  void SetNode(gmMachine * a_machine, const gmVariable &a_key, const gmVariable &a_value);
+#endif //GM_USE_INCGC
   void Resize(gmMachine * a_machine);
+  void Rehash(gmMachine * a_machine, int a_size);
   void AllocSize(gmMachine * a_machine, int a_size);
+  void ResizeArray(gmMachine * a_machine, int a_size);
+  int GetBestArraySize() const;
 
   gmTableNode * m_nodes;
   gmTableNode * m_firstFree;
   int m_tableSize;
   int m_slotsUsed;
+
+  gmVariable * m_array;                           ///< values of keys 0..m_arraySize-1, null where unset
+  int m_arraySize;                                ///< 0 or a power of 2
+  int m_arrayUsed;                                ///< values set in the array part
 };
 
 #endif // _GMTABLEOBJECT_H_
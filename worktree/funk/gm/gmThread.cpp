@@ -29,6 +29,288 @@
 #define GMTHREAD_LOG m_machine->GetLog().LogEntry
 #define PUSHNULL top->m_type = GM_NULL; top->m_value.m_int = 0; ++top;
 
+//
+// Opcode dispatch. With GMTHREAD_THREADED_DISPATCH each handler jumps straight to the next handler through
+// a label table (one indirect branch per opcode rather than a shared switch branch), else a plain switch is used.
+//
+#if GMTHREAD_BYTECODEHISTOGRAM
+#define GM_RECORD_BYTECODE if(histogram) histogram->Record(*instruction32);
+#else // !GMTHREAD_BYTECODEHISTOGRAM
+#define GM_RECORD_BYTECODE
+#endif // !GMTHREAD_BYTECODEHISTOGRAM
+
+#if GMTHREAD_THREADED_DISPATCH && defined(GM_HAS_COMPUTED_GOTO)
+#define GM_THREADED_DISPATCH
+#define GM_CASE(OP) Label_##OP:
+#define GM_DEFAULT
+#define GM_NEXT { GM_RECORD_BYTECODE goto *s_dispatch[*(instruction32++)]; }
+#define GM_DISPATCH GM_NEXT;
+#else // !GM_THREADED_DISPATCH
+#define GM_CASE(OP) case OP:
+#define GM_DEFAULT default:
+#define GM_NEXT break
+#define GM_DISPATCH GM_RECORD_BYTECODE switch(*(instruction32++))
+#endif // !GM_THREADED_DISPATCH
+
+//
+// User break. Only tested on calls and backward branches as any endless loop must pass through one of these.
+//
+#ifdef GM_CHECK_USER_BREAK_CALLBACK // This may be defined in gmConfig_p.h
+#define GM_CHECK_USER_BREAK \
+  if( gmMachine::s_userBreakCallback && gmMachine::s_userBreakCallback(this) ) \
+  { \
+    GMTHREAD_LOG("User break. Execution halted."); \
+    goto LabelException; \
+  }
+#else // !GM_CHECK_USER_BREAK_CALLBACK
+#define GM_CHECK_USER_BREAK
+#endif // !GM_CHECK_USER_BREAK_CALLBACK
+
+//
+// Sampling. Tested at the same places as the user break, a sample request is answered within a loop iteration or call.
+//
+#if GMTHREAD_SAMPLING
+#define GM_CHECK_SAMPLE \
+  if(m_machine->Sys_IsSampleDue()) \
+  { \
+    m_instruction = instruction; \
+    m_machine->Sys_Sample(this); \
+  }
+#else // !GMTHREAD_SAMPLING
+#define GM_CHECK_SAMPLE
+#endif // !GMTHREAD_SAMPLING
+
+//
+// Allocation sites. Byte codes that may allocate without a call save their instruction, see gmAllocProfiler.
+//
+#if GMMACHINE_ALLOCPROFILER
+#define GM_ALLOC_SITE m_instruction = instruction;
+#else // !GMMACHINE_ALLOCPROFILER
+#define GM_ALLOC_SITE
+#endif // !GMMACHINE_ALLOCPROFILER
+
+//
+// Quickening. The generic operator byte code is rewritten to a typed byte code for the operand types it sees,
+// the typed byte code rewrites itself back to the generic one (and re-dispatches) when the types no longer match.
+//
+#define GM_IS_NUMBER(T) ((gmuint) ((T) - GM_INT) <= (gmuint) (GM_FLOAT - GM_INT))
+#define GM_TOFLOAT(V) (((V)->m_type == GM_FLOAT) ? (V)->m_value.m_float : (gmfloat) (V)->m_value.m_int)
+
+#if GMTHREAD_QUICKEN
+
+#define GM_QUICKEN(BYTECODE) \
+  { \
+    const_cast<gmuint32 *>(--instruction32)[0] = (BYTECODE); \
+    GM_NEXT; \
+  }
+
+#define GM_QUICK_INT_OP(GENERIC, OP) \
+  { \
+    operand = top - 2; \
+    if(operand[0].m_type == GM_INT && operand[1].m_type == GM_INT) \
+    { \
+      operand->m_value.m_int = operand[0].m_value.m_int OP operand[1].m_value.m_int; \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#define GM_QUICK_FP_OP(GENERIC, OP) \
+  { \
+    operand = top - 2; \
+    if(GM_IS_NUMBER(operand[0].m_type) && GM_IS_NUMBER(operand[1].m_type) && (operand[0].m_type | operand[1].m_type) & GM_FLOAT) \
+    { \
+      operand->m_value.m_float = GM_TOFLOAT(operand) OP GM_TOFLOAT(operand + 1); \
+      operand->m_type = GM_FLOAT; \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#define GM_QUICK_FP_CMP(GENERIC, OP) \
+  { \
+    operand = top - 2; \
+    if(GM_IS_NUMBER(operand[0].m_type) && GM_IS_NUMBER(operand[1].m_type) && (operand[0].m_type | operand[1].m_type) & GM_FLOAT) \
+    { \
+      operand->m_value.m_int = GM_TOFLOAT(operand) OP GM_TOFLOAT(operand + 1); \
+      operand->m_type = GM_INT; \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#if GM_COMPACT_VARIABLE
+
+// boxed vecs are shared, the result is a new box
+#define GM_QUICK_VEC_OP(GENERIC, TYPE, MEMBER, OP) \
+  { \
+    operand = top - 2; \
+    if(operand[0].m_type == TYPE && operand[1].m_type == TYPE) \
+    { \
+      const gmVec3 &v0 = ((gmVecObject *) operand[0].m_value.m_ref)->GetVec(); \
+      const gmVec3 &v1 = ((gmVecObject *) operand[1].m_value.m_ref)->GetVec(); \
+      gmVec3 res = { v0.x OP v1.x, v0.y OP v1.y, v0.z OP v1.z }; \
+      GM_ALLOC_SITE \
+      operand->m_value.m_ref = m_machine->AllocVecObject(TYPE, res)->GetRef(); \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#define GM_QUICK_VEC_SCALE(GENERIC, TYPE, MEMBER) \
+  { \
+    operand = top - 2; \
+    if(operand[0].m_type == TYPE && GM_IS_NUMBER(operand[1].m_type)) \
+    { \
+      const gmfloat coeff = GM_TOFLOAT(operand + 1); \
+      const gmVec3 &v0 = ((gmVecObject *) operand[0].m_value.m_ref)->GetVec(); \
+      gmVec3 res = { v0.x * coeff, v0.y * coeff, v0.z * coeff }; \
+      GM_ALLOC_SITE \
+      operand->m_value.m_ref = m_machine->AllocVecObject(TYPE, res)->GetRef(); \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#else //GM_COMPACT_VARIABLE
+
+#define GM_QUICK_VEC_OP(GENERIC, TYPE, MEMBER, OP) \
+  { \
+    operand = top - 2; \
+    if(operand[0].m_type == TYPE && operand[1].m_type == TYPE) \
+    { \
+      operand->m_value.MEMBER.x OP##= operand[1].m_value.MEMBER.x; \
+      operand->m_value.MEMBER.y OP##= operand[1].m_value.MEMBER.y; \
+      if(TYPE == GM_VEC3) operand->m_value.m_v3.z OP##= operand[1].m_value.m_v3.z; \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#define GM_QUICK_VEC_SCALE(GENERIC, TYPE, MEMBER) \
+  { \
+    operand = top - 2; \
+    if(operand[0].m_type == TYPE && GM_IS_NUMBER(operand[1].m_type)) \
+    { \
+      const gmfloat coeff = GM_TOFLOAT(operand + 1); \
+      operand->m_value.MEMBER.x *= coeff; \
+      operand->m_value.MEMBER.y *= coeff; \
+      if(TYPE == GM_VEC3) operand->m_value.m_v3.z *= coeff; \
+      --top; \
+      GM_NEXT; \
+    } \
+    GM_QUICKEN(GENERIC) \
+  }
+
+#endif //GM_COMPACT_VARIABLE
+
+/// \brief gmQuickenOperator() returns the typed byte code for a generic operator byte code and its operand types,
+///        or BC_NOP if there is none. Result must match what the native type operator would produce.
+static GM_FORCEINLINE gmuint32 gmQuickenOperator(gmuint32 a_byteCode, gmType a_left, gmType a_right)
+{
+  if(a_left == GM_INT && a_right == GM_INT)
+  {
+    switch(a_byteCode)
+    {
+      case BC_OP_ADD : return BC_OP_ADD_INT;
+      case BC_OP_SUB : return BC_OP_SUB_INT;
+      case BC_OP_MUL : return BC_OP_MUL_INT;
+      case BC_OP_LT : return BC_OP_LT_INT;
+      case BC_OP_GT : return BC_OP_GT_INT;
+      case BC_OP_LTE : return BC_OP_LTE_INT;
+      case BC_OP_GTE : return BC_OP_GTE_INT;
+      case BC_OP_EQ : return BC_OP_EQ_INT;
+      case BC_OP_NEQ : return BC_OP_NEQ_INT;
+      default : break;
+    }
+  }
+  else if(GM_IS_NUMBER(a_left) && GM_IS_NUMBER(a_right))
+  {
+    switch(a_byteCode)
+    {
+      case BC_OP_ADD : return BC_OP_ADD_FP;
+      case BC_OP_SUB : return BC_OP_SUB_FP;
+      case BC_OP_MUL : return BC_OP_MUL_FP;
+#if !GMMACHINE_GMCHECKDIVBYZERO
+      case BC_OP_DIV : return BC_OP_DIV_FP;
+#endif // !GMMACHINE_GMCHECKDIVBYZERO
+      case BC_OP_LT : return BC_OP_LT_FP;
+      case BC_OP_GT : return BC_OP_GT_FP;
+      case BC_OP_LTE : return BC_OP_LTE_FP;
+      case BC_OP_GTE : return BC_OP_GTE_FP;
+      default : break;
+    }
+  }
+  else if(a_left == GM_VEC2)
+  {
+    if(a_right == GM_VEC2 && a_byteCode == BC_OP_ADD) return BC_OP_ADD_V2;
+    if(a_right == GM_VEC2 && a_byteCode == BC_OP_SUB) return BC_OP_SUB_V2;
+    if(GM_IS_NUMBER(a_right) && a_byteCode == BC_OP_MUL) return BC_OP_MUL_V2F;
+  }
+  else if(a_left == GM_VEC3)
+  {
+    if(a_right == GM_VEC3 && a_byteCode == BC_OP_ADD) return BC_OP_ADD_V3;
+    if(a_right == GM_VEC3 && a_byteCode == BC_OP_SUB) return BC_OP_SUB_V3;
+    if(GM_IS_NUMBER(a_right) && a_byteCode == BC_OP_MUL) return BC_OP_MUL_V3F;
+  }
+  return BC_NOP;
+}
+
+#endif // GMTHREAD_QUICKEN
+
+//
+// Superinstructions. Each handler runs its whole sequence when the operand types allow, else it falls back to the
+// generic handler of the sequence's first byte code, which then runs the original byte codes left in place.
+//
+
+// table member node for the member access at INSTRUCTION
+#if GMMACHINE_DOTCACHESIZE
+#define GM_DOT_NODE(INSTRUCTION, TABLE, KEY) m_machine->Sys_DotCacheLookup((INSTRUCTION), (TABLE), (KEY))
+#else // !GMMACHINE_DOTCACHESIZE
+static GM_FORCEINLINE gmTableNode * gmDotNode(const gmTableObject * a_table, const gmVariable &a_key)
+{
+  int slot = a_table->GetSlot(a_key);
+  return (slot < 0) ? NULL : a_table->GetNodeAtSlot(slot, a_key);
+}
+#define GM_DOT_NODE(INSTRUCTION, TABLE, KEY) gmDotNode((TABLE), (KEY))
+#endif // !GMMACHINE_DOTCACHESIZE
+
+// get local, get local or push int or push fp, compare, brz
+#define GM_LOCAL_CMP_BRZ(OP) \
+  { \
+    const gmVariable * a = base + instruction32[0]; \
+    const gmVariable * b = base + instruction32[2]; \
+    gmVariable constant; \
+    if(instruction32[1] != BC_GETLOCAL) \
+    { \
+      constant.m_type = (instruction32[1] == BC_PUSHINT) ? GM_INT : GM_FLOAT; \
+      constant.m_value.m_int = (gmint) instruction32[2]; \
+      b = &constant; \
+    } \
+    int result; \
+    if(a->m_type == GM_INT && b->m_type == GM_INT) result = (a->m_value.m_int OP b->m_value.m_int); \
+    else if(GM_IS_NUMBER(a->m_type) && GM_IS_NUMBER(b->m_type)) result = (GM_TOFLOAT(a) OP GM_TOFLOAT(b)); \
+    else goto LabelGetLocal; \
+    instruction += 5 * sizeof(gmuint32); \
+    if(result == 0) GM_BRANCH() \
+    else instruction += sizeof(gmptr); \
+    GM_NEXT; \
+  }
+
+// branch to the opptr at instruction, user break and sample checked on loop back edges
+#define GM_BRANCH() \
+  { \
+    const gmuint8 * target = code + *((gmptr *) instruction); \
+    if(target < instruction) { GM_CHECK_USER_BREAK GM_CHECK_SAMPLE } \
+    instruction = target; \
+  }
+
 // helper functions
 void gmGetLineFromString(const char * a_string, int a_line, char * a_buffer, int a_len)
 {
@@ -72,11 +354,13 @@ gmThread::gmThread(gmMachine * a_machine, int a_initialByteSize)
 
   m_timeStamp = 0;
   m_startTime = 0;
+  m_sleepIndex = -1;
   m_instruction = NULL;
   m_state = KILLED;
   m_id = GM_INVALID_THREAD;
   m_blocks = NULL;
   m_signals = NULL;
+  m_concatSlot = -1;
 
   // copy current thread's group
   gmThread * currThread = m_machine->GetCurrentThread();
@@ -197,7 +481,42 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
   register gmVariable * top;
   gmVariable * base;
   gmVariable * operand;
+  gmOperator binaryOperator;
   const gmuint8 * code;
+#if GMTHREAD_BYTECODEHISTOGRAM
+  gmByteCodeHistogram * histogram = m_machine->GetByteCodeHistogram();
+#endif // GMTHREAD_BYTECODEHISTOGRAM
+
+#ifdef GM_THREADED_DISPATCH
+  // must match enum gmByteCode order
+  static const void * const s_dispatch[] =
+  {
+    &&Label_BC_GETDOT, &&Label_BC_SETDOT, &&Label_BC_GETIND, &&Label_BC_SETIND,
+    &&Label_BC_OP_ADD, &&Label_BC_OP_SUB, &&Label_BC_OP_MUL, &&Label_BC_OP_DIV, &&Label_BC_OP_REM,
+    &&Label_BC_BIT_OR, &&Label_BC_BIT_XOR, &&Label_BC_BIT_AND, &&Label_BC_BIT_SHL, &&Label_BC_BIT_SHR, &&Label_BC_BIT_INV,
+    &&Label_BC_OP_LT, &&Label_BC_OP_GT, &&Label_BC_OP_LTE, &&Label_BC_OP_GTE, &&Label_BC_OP_EQ, &&Label_BC_OP_NEQ,
+    &&Label_BC_OP_NEG, &&Label_BC_OP_POS, &&Label_BC_OP_NOT,
+    &&Label_BC_NOP, &&Label_BC_LINE,
+    &&Label_BC_BRA, &&Label_BC_BRZ, &&Label_BC_BRNZ, &&Label_BC_BRZK, &&Label_BC_BRNZK, &&Label_BC_CALL, &&Label_BC_RET, &&Label_BC_RETV, &&Label_BC_FOREACH,
+    &&Label_BC_POP, &&Label_BC_POP2, &&Label_BC_DUP, &&Label_BC_DUP2, &&Label_BC_SWAP, &&Label_BC_PUSHNULL,
+    &&Label_BC_PUSHINT, &&Label_BC_PUSHINT0, &&Label_BC_PUSHINT1, &&Label_BC_PUSHFP, &&Label_BC_PUSHSTR, &&Label_BC_PUSHTBL, &&Label_BC_PUSHFN, &&Label_BC_PUSHTHIS,
+    &&Label_BC_GETLOCAL, &&Label_BC_SETLOCAL, &&Label_BC_GETGLOBAL, &&Label_BC_SETGLOBAL, &&Label_BC_GETTHIS, &&Label_BC_SETTHIS,
+    &&Label_BC_PUSHLASTIND, &&Label_BC_ISNOTNULL,
+#if GM_USE_FORK
+    &&Label_BC_FORK,
+#endif //GM_USE_FORK
+    &&Label_BC_CONCAT, &&Label_BC_CONCATEND,
+    &&Label_BC_OP_ADD_INT, &&Label_BC_OP_SUB_INT, &&Label_BC_OP_MUL_INT, &&Label_BC_OP_LT_INT, &&Label_BC_OP_GT_INT,
+    &&Label_BC_OP_LTE_INT, &&Label_BC_OP_GTE_INT, &&Label_BC_OP_EQ_INT, &&Label_BC_OP_NEQ_INT,
+    &&Label_BC_OP_ADD_FP, &&Label_BC_OP_SUB_FP, &&Label_BC_OP_MUL_FP, &&Label_BC_OP_DIV_FP,
+    &&Label_BC_OP_LT_FP, &&Label_BC_OP_GT_FP, &&Label_BC_OP_LTE_FP, &&Label_BC_OP_GTE_FP,
+    &&Label_BC_OP_ADD_V2, &&Label_BC_OP_SUB_V2, &&Label_BC_OP_MUL_V2F, &&Label_BC_OP_ADD_V3, &&Label_BC_OP_SUB_V3, &&Label_BC_OP_MUL_V3F,
+    &&Label_BC_GETLOCAL2, &&Label_BC_GETLOCAL_GETDOT, &&Label_BC_GETTHIS_GETDOT, &&Label_BC_INCLOCAL,
+    &&Label_BC_LOCAL_LT_BRZ, &&Label_BC_LOCAL_LTE_BRZ, &&Label_BC_LOCAL_GT_BRZ, &&Label_BC_LOCAL_GTE_BRZ,
+  };
+  // compile time check the table covers every byte code
+  typedef char gmDispatchTableSizeCheck[(sizeof(s_dispatch) / sizeof(s_dispatch[0]) == BC_MAX) ? 1 : -1];
+#endif // GM_THREADED_DISPATCH
 
   if(m_state != RUNNING) return m_state;
 
@@ -228,38 +547,28 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
   //
   for(;;)
   {
-
-#ifdef GM_CHECK_USER_BREAK_CALLBACK // This may be defined in gmConfig_p.h
-    // Check external source to break execution with exception eg. Check for CTRL-BREAK
-    // Endless loop protection could be implemented with this, or in a similar manner.
-    if( gmMachine::s_userBreakCallback && gmMachine::s_userBreakCallback(this) )
-    {
-      GMTHREAD_LOG("User break. Execution halted.");
-      goto LabelException;
-    }
-#endif //GM_CHECK_USER_BREAK_CALLBACK 
-
-    switch(*(instruction32++))
+    GM_DISPATCH
     {
       //
       // unary operator
       //
 
-	  case BC_ISNOTNULL:
+	  GM_CASE(BC_ISNOTNULL)
 	    operand = top - 1;
 	    operand[0].m_value.m_int = !( operand[0].m_type == GM_NULL );
 	    operand[0].m_type = GM_INT;
-	    break;
+	    GM_NEXT;
 
-      case BC_BIT_INV :
-      case BC_OP_NEG :
-      case BC_OP_POS :
-      case BC_OP_NOT :
+      GM_CASE(BC_BIT_INV)
+      GM_CASE(BC_OP_NEG)
+      GM_CASE(BC_OP_POS)
+      GM_CASE(BC_OP_NOT)
       {
         operand = top - 1; 
         gmOperatorFunction op = OPERATOR(operand->m_type, (gmOperator) instruction32[-1]); 
         if(op) 
         { 
+          GM_ALLOC_SITE
           op(this, operand); 
         } 
         else if((fn = CALLOPERATOR(operand->m_type, (gmOperator) instruction32[-1]))) 
@@ -271,7 +580,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           State res = PushStackFrame(1, &instruction, &code); 
           top = GetTop();
           base = GetBase();
-          if(res == RUNNING) break;
+          if(res == RUNNING) GM_NEXT;
           if(res == SYS_YIELD) return RUNNING;
           if(res == SYS_EXCEPTION) goto LabelException;
           if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -282,43 +591,56 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           GMTHREAD_LOG("unary operator %s undefined for type %s", gmGetOperatorName((gmOperator) instruction32[-1]), m_machine->GetTypeName(operand->m_type)); 
           goto LabelException; 
         } 
-        break;
+        GM_NEXT;
       }
 
       //
       // operator
       //
 
-      case BC_OP_ADD :
-      case BC_OP_SUB :
-      case BC_OP_MUL :
-      case BC_OP_DIV :
-      case BC_OP_REM :
-      case BC_BIT_OR :
-      case BC_BIT_XOR :
-      case BC_BIT_AND :
-      case BC_BIT_SHL :
-      case BC_BIT_SHR :
-      case BC_OP_LT :
-      case BC_OP_GT :
-      case BC_OP_LTE :
-      case BC_OP_GTE :
-      case BC_OP_EQ :
-      case BC_OP_NEQ :
+      GM_CASE(BC_OP_ADD)
+      GM_CASE(BC_OP_SUB)
+      GM_CASE(BC_OP_MUL)
+      GM_CASE(BC_OP_DIV)
+      GM_CASE(BC_OP_REM)
+      GM_CASE(BC_BIT_OR)
+      GM_CASE(BC_BIT_XOR)
+      GM_CASE(BC_BIT_AND)
+      GM_CASE(BC_BIT_SHL)
+      GM_CASE(BC_BIT_SHR)
+      GM_CASE(BC_OP_LT)
+      GM_CASE(BC_OP_GT)
+      GM_CASE(BC_OP_LTE)
+      GM_CASE(BC_OP_GTE)
+      GM_CASE(BC_OP_EQ)
+      GM_CASE(BC_OP_NEQ)
       {
         operand = top - 2; 
+
+#if GMTHREAD_QUICKEN
+        {
+          const gmuint32 quick = gmQuickenOperator(instruction32[-1], operand[0].m_type, operand[1].m_type);
+          if(quick != BC_NOP) GM_QUICKEN(quick)
+        }
+#endif // GMTHREAD_QUICKEN
+
+        binaryOperator = (gmOperator) instruction32[-1];
+
+LabelBinaryOperator:
+
         --top; 
         
         // NOTE: Classic logic for operators.  Higher type processes the operation.
         register gmType t1 = operand[1].m_type; 
         if(operand->m_type > t1) t1 = operand->m_type; 
         
-        gmOperatorFunction op = OPERATOR(t1, (gmOperator) instruction32[-1]); 
+        gmOperatorFunction op = OPERATOR(t1, binaryOperator); 
         if(op) 
         { 
+          GM_ALLOC_SITE
           op(this, operand); 
         } 
-        else if((fn = CALLOPERATOR(t1, (gmOperator) instruction32[-1]))) 
+        else if((fn = CALLOPERATOR(t1, binaryOperator))) 
         { 
           operand[2] = operand[0]; 
           operand[3] = operand[1]; 
@@ -328,7 +650,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           State res = PushStackFrame(2, &instruction, &code); 
           top = GetTop(); 
           base = GetBase();
-          if(res == RUNNING) break;
+          if(res == RUNNING) GM_NEXT;
           if(res == SYS_YIELD) return RUNNING;
           if(res == SYS_EXCEPTION) goto LabelException;
           if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -336,19 +658,79 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         } 
         else 
         { 
-          GMTHREAD_LOG("operator %s undefined for type %s and %s", gmGetOperatorName((gmOperator) instruction32[-1]), m_machine->GetTypeName(operand->m_type), m_machine->GetTypeName((operand + 1)->m_type)); 
+          GMTHREAD_LOG("operator %s undefined for type %s and %s", gmGetOperatorName(binaryOperator), m_machine->GetTypeName(operand->m_type), m_machine->GetTypeName((operand + 1)->m_type)); 
           goto LabelException; 
         } 
 
-        break;
+        GM_NEXT;
       }
-      case BC_GETIND :
+
+      //
+      // string building, the generic add (never quickened) when the operands are not strings
+      //
+
+      GM_CASE(BC_CONCAT)
+      GM_CASE(BC_CONCATEND)
+      {
+        operand = top - 2;
+        GM_ALLOC_SITE
+        if(Concat(operand, (instruction32[-1] == BC_CONCATEND)))
+        {
+          --top;
+          GM_NEXT;
+        }
+        binaryOperator = O_ADD;
+        goto LabelBinaryOperator;
+      }
+
+      //
+      // typed operators
+      //
+
+#if GMTHREAD_QUICKEN
+      GM_CASE(BC_OP_ADD_INT) GM_QUICK_INT_OP(BC_OP_ADD, +)
+      GM_CASE(BC_OP_SUB_INT) GM_QUICK_INT_OP(BC_OP_SUB, -)
+      GM_CASE(BC_OP_MUL_INT) GM_QUICK_INT_OP(BC_OP_MUL, *)
+      GM_CASE(BC_OP_LT_INT) GM_QUICK_INT_OP(BC_OP_LT, <)
+      GM_CASE(BC_OP_GT_INT) GM_QUICK_INT_OP(BC_OP_GT, >)
+      GM_CASE(BC_OP_LTE_INT) GM_QUICK_INT_OP(BC_OP_LTE, <=)
+      GM_CASE(BC_OP_GTE_INT) GM_QUICK_INT_OP(BC_OP_GTE, >=)
+      GM_CASE(BC_OP_EQ_INT) GM_QUICK_INT_OP(BC_OP_EQ, ==)
+      GM_CASE(BC_OP_NEQ_INT) GM_QUICK_INT_OP(BC_OP_NEQ, !=)
+      GM_CASE(BC_OP_ADD_FP) GM_QUICK_FP_OP(BC_OP_ADD, +)
+      GM_CASE(BC_OP_SUB_FP) GM_QUICK_FP_OP(BC_OP_SUB, -)
+      GM_CASE(BC_OP_MUL_FP) GM_QUICK_FP_OP(BC_OP_MUL, *)
+      GM_CASE(BC_OP_DIV_FP) GM_QUICK_FP_OP(BC_OP_DIV, /)
+      GM_CASE(BC_OP_LT_FP) GM_QUICK_FP_CMP(BC_OP_LT, <)
+      GM_CASE(BC_OP_GT_FP) GM_QUICK_FP_CMP(BC_OP_GT, >)
+      GM_CASE(BC_OP_LTE_FP) GM_QUICK_FP_CMP(BC_OP_LTE, <=)
+      GM_CASE(BC_OP_GTE_FP) GM_QUICK_FP_CMP(BC_OP_GTE, >=)
+      GM_CASE(BC_OP_ADD_V2) GM_QUICK_VEC_OP(BC_OP_ADD, GM_VEC2, m_v2, +)
+      GM_CASE(BC_OP_SUB_V2) GM_QUICK_VEC_OP(BC_OP_SUB, GM_VEC2, m_v2, -)
+      GM_CASE(BC_OP_MUL_V2F) GM_QUICK_VEC_SCALE(BC_OP_MUL, GM_VEC2, m_v2)
+      GM_CASE(BC_OP_ADD_V3) GM_QUICK_VEC_OP(BC_OP_ADD, GM_VEC3, m_v3, +)
+      GM_CASE(BC_OP_SUB_V3) GM_QUICK_VEC_OP(BC_OP_SUB, GM_VEC3, m_v3, -)
+      GM_CASE(BC_OP_MUL_V3F) GM_QUICK_VEC_SCALE(BC_OP_MUL, GM_VEC3, m_v3)
+#else // !GMTHREAD_QUICKEN
+      GM_CASE(BC_OP_ADD_INT) GM_CASE(BC_OP_SUB_INT) GM_CASE(BC_OP_MUL_INT) GM_CASE(BC_OP_LT_INT) GM_CASE(BC_OP_GT_INT)
+      GM_CASE(BC_OP_LTE_INT) GM_CASE(BC_OP_GTE_INT) GM_CASE(BC_OP_EQ_INT) GM_CASE(BC_OP_NEQ_INT)
+      GM_CASE(BC_OP_ADD_FP) GM_CASE(BC_OP_SUB_FP) GM_CASE(BC_OP_MUL_FP) GM_CASE(BC_OP_DIV_FP)
+      GM_CASE(BC_OP_LT_FP) GM_CASE(BC_OP_GT_FP) GM_CASE(BC_OP_LTE_FP) GM_CASE(BC_OP_GTE_FP)
+      GM_CASE(BC_OP_ADD_V2) GM_CASE(BC_OP_SUB_V2) GM_CASE(BC_OP_MUL_V2F) GM_CASE(BC_OP_ADD_V3) GM_CASE(BC_OP_SUB_V3) GM_CASE(BC_OP_MUL_V3F)
+      {
+        // never quickened
+        GM_NEXT;
+      }
+#endif // !GMTHREAD_QUICKEN
+
+      GM_CASE(BC_GETIND)
       {
         operand = top - 2; 
         --top; 
         gmOperatorFunction op = OPERATOR(operand->m_type, (gmOperator) instruction32[-1]); 
         if(op) 
         { 
+          GM_ALLOC_SITE
           op(this, operand); 
         } 
         else if((fn = CALLOPERATOR(operand->m_type, (gmOperator) instruction32[-1]))) 
@@ -361,7 +743,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           State res = PushStackFrame(2, &instruction, &code); 
           top = GetTop(); 
           base = GetBase();
-          if(res == RUNNING) break;
+          if(res == RUNNING) GM_NEXT;
           if(res == SYS_YIELD) return RUNNING;
           if(res == SYS_EXCEPTION) goto LabelException;
           if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -373,15 +755,16 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           goto LabelException; 
         } 
 
-        break;
+        GM_NEXT;
       }
-      case BC_SETIND : 
+      GM_CASE(BC_SETIND)
       { 
         operand = top - 3; 
         top -= 3; 
         gmOperatorFunction op = OPERATOR(operand->m_type, O_SETIND); 
         if(op) 
         { 
+          GM_ALLOC_SITE
           op(this, operand); 
         } 
         else if((fn = CALLOPERATOR(operand->m_type, O_SETIND))) 
@@ -395,7 +778,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           State res = PushStackFrame(3, &instruction, &code); 
           top = GetTop(); 
           base = GetBase(); 
-          if(res == RUNNING) break; 
+          if(res == RUNNING) GM_NEXT; 
           if(res == SYS_YIELD) return RUNNING; 
           if(res == SYS_EXCEPTION) goto LabelException; 
           if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread 
@@ -406,13 +789,13 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           GMTHREAD_LOG("setind failed."); 
           goto LabelException; 
         } 
-        break; 
+        GM_NEXT; 
       } 
-      case BC_NOP :
+      GM_CASE(BC_NOP)
       {
-        break;
+        GM_NEXT;
       }
-      case BC_LINE :
+      GM_CASE(BC_LINE)
       {
 
 #if GMDEBUG_SUPPORT
@@ -426,20 +809,53 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
 #endif // GMDEBUG_SUPPORT
 
-        break;
+        GM_NEXT;
       }
-      case BC_GETDOT :
+      GM_CASE(BC_GETDOT)
       {
         operand = top - 1;
         gmptr member = OPCODE_PTR(instruction);
         top->m_type = GM_STRING;
         top->m_value.m_ref = member;
         gmType t1 = operand->m_type;
+#if GMMACHINE_DOTCACHESIZE
+        const gmTableNode * node;
+        if(t1 == GM_TABLE)
+        {
+          // table members, same result as gmTableGetDot
+          gmTableObject * table = (gmTableObject *) GM_MOBJECT(m_machine, operand->m_value.m_ref);
+          node = m_machine->Sys_DotCacheLookup(instruction, table, *top);
+          if(node)
+          {
+            *operand = node->m_value;
+            GM_NEXT;
+          }
+        }
+        else
+        {
+          gmOperatorFunction op = OPERATOR(t1, O_GETDOT);
+          if(op)
+          {
+            GM_ALLOC_SITE
+            op(this, operand);
+            if(operand->m_type) GM_NEXT;
+          }
+          if(t1 == GM_NULL)
+          {
+            GMTHREAD_LOG("getdot failed.");
+            goto LabelException;
+          }
+        }
+        // type variables
+        node = m_machine->Sys_DotCacheLookup(instruction, m_machine->GetTypeTable(t1), *top);
+        *operand = (node) ? node->m_value : gmVariable::s_null;
+#else // !GMMACHINE_DOTCACHESIZE
         gmOperatorFunction op = OPERATOR(t1, O_GETDOT);
         if(op)
         {
+          GM_ALLOC_SITE
           op(this, operand);
-          if(operand->m_type) break;
+          if(operand->m_type) GM_NEXT;
         }
         if(t1 == GM_NULL)
         {
@@ -447,18 +863,43 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           goto LabelException;
         }
         *operand = m_machine->GetTypeVariable(t1, gmVariable(GM_STRING, member));
-        break;
+#endif // !GMMACHINE_DOTCACHESIZE
+        GM_NEXT;
       }
-      case BC_SETDOT :
+      GM_CASE(BC_SETDOT)
       {
         operand = top - 2;
         gmptr member = OPCODE_PTR(instruction);
         top->m_type = GM_STRING;
         top->m_value.m_ref = member;
         top -= 2;
+#if GMMACHINE_DOTCACHESIZE
+        if(operand->m_type == GM_TABLE && operand[1].m_type != GM_NULL)
+        {
+          // replace existing table members in place, inserts and removes go through gmTableSetDot
+          gmTableObject * table = (gmTableObject *) GM_MOBJECT(m_machine, operand->m_value.m_ref);
+          gmTableNode * node = m_machine->Sys_DotCacheLookup(instruction, table, operand[2]);
+          if(node)
+          {
+#if GM_USE_INCGC
+            if(node->m_value.IsReference())
+            {
+              m_machine->GetGC()->WriteBarrier((gmObject *) node->m_value.m_value.m_ref);
+            }
+            if(operand[1].IsReference())
+            {
+              m_machine->GetGC()->WriteBarrierStore(table, GM_MOBJECT(m_machine, operand[1].m_value.m_ref));
+            }
+#endif //GM_USE_INCGC
+            node->m_value = operand[1];
+            GM_NEXT;
+          }
+        }
+#endif // GMMACHINE_DOTCACHESIZE
         gmOperatorFunction op = OPERATOR(operand->m_type, O_SETDOT);
         if(op)
         {
+          GM_ALLOC_SITE
           op(this, operand);
         }
         else
@@ -466,14 +907,14 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           GMTHREAD_LOG("setdot failed.");
           goto LabelException;
         }
-        break;
+        GM_NEXT;
       }
-      case BC_BRA :
+      GM_CASE(BC_BRA)
       {
-        instruction = code + OPCODE_PTR_NI(instruction);
-        break;
+        GM_BRANCH()
+        GM_NEXT;
       }
-      case BC_BRZ :
+      GM_CASE(BC_BRZ)
       {
 #if GM_BOOL_OP
         operand = top - 1;
@@ -498,7 +939,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
             State res = PushStackFrame(1, &instruction, &code);
             top = GetTop();
             base = GetBase();
-            if(res == RUNNING) break;
+            if(res == RUNNING) GM_NEXT;
             if(res == SYS_YIELD) return RUNNING;
             if(res == SYS_EXCEPTION) goto LabelException;
             if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -508,20 +949,20 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
         if(operand->m_value.m_int == 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #else // !GM_BOOL_OP
         --top;
         if(top->m_value.m_int == 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #endif // !GM_BOOL_OP
-        break;
+        GM_NEXT;
       }
-      case BC_BRNZ :
+      GM_CASE(BC_BRNZ)
       {
 #if GM_BOOL_OP
         operand = top - 1;
@@ -546,7 +987,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
             State res = PushStackFrame(1, &instruction, &code);
             top = GetTop();
             base = GetBase();
-            if(res == RUNNING) break;
+            if(res == RUNNING) GM_NEXT;
             if(res == SYS_YIELD) return RUNNING;
             if(res == SYS_EXCEPTION) goto LabelException;
             if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -556,20 +997,20 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
         if(operand->m_value.m_int != 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #else // !GM_BOOL_OP
         --top;
         if(top->m_value.m_int != 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #endif // !GM_BOOL_OP
-        break;
+        GM_NEXT;
       }
-      case BC_BRZK :
+      GM_CASE(BC_BRZK)
       {
 #if GM_BOOL_OP
         operand = top - 1;
@@ -593,7 +1034,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
             State res = PushStackFrame(1, &instruction, &code);
             top = GetTop();
             base = GetBase();
-            if(res == RUNNING) break;
+            if(res == RUNNING) GM_NEXT;
             if(res == SYS_YIELD) return RUNNING;
             if(res == SYS_EXCEPTION) goto LabelException;
             if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -603,19 +1044,19 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
         if(operand->m_value.m_int == 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #else // !GM_BOOL_OP
         if(top[-1].m_value.m_int == 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #endif // !GM_BOOL_OP
-        break;
+        GM_NEXT;
       }
-      case BC_BRNZK :
+      GM_CASE(BC_BRNZK)
       {
 #if GM_BOOL_OP
         operand = top - 1;
@@ -639,7 +1080,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
             State res = PushStackFrame(1, &instruction, &code);
             top = GetTop();
             base = GetBase();
-            if(res == RUNNING) break;
+            if(res == RUNNING) GM_NEXT;
             if(res == SYS_YIELD) return RUNNING;
             if(res == SYS_EXCEPTION) goto LabelException;
             if(res == KILLED) { m_machine->Sys_SwitchState(this, KILLED); GM_ASSERT(0); } // operator should not kill a thread
@@ -649,20 +1090,22 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
         if(operand->m_value.m_int != 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #else // !GM_BOOL_OP
         if(top[-1].m_value.m_int != 0)
         {
-          instruction = code + OPCODE_PTR_NI(instruction);
+          GM_BRANCH()
         }
         else instruction += sizeof(gmptr);
 #endif // !GM_BOOL_OP
-        break;
+        GM_NEXT;
       }
-      case BC_CALL :
+      GM_CASE(BC_CALL)
       {
+        GM_CHECK_USER_BREAK
+        GM_CHECK_SAMPLE
         SetTop(top);
         
         int numParams = (int) OPCODE_INT(instruction);
@@ -684,7 +1127,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
 #endif // GMDEBUG_SUPPORT
 
-          break;
+          GM_NEXT;
         }
         if(res == SYS_YIELD) return RUNNING;
         if(res == SYS_EXCEPTION) goto LabelException;
@@ -695,11 +1138,11 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         }
         return res;
       }
-      case BC_RET :
+      GM_CASE(BC_RET)
       {
         PUSHNULL;
       }
-      case BC_RETV :
+      GM_CASE(BC_RETV)
       {
         SetTop(top);
         int res = Sys_PopStackFrame(instruction, code);
@@ -719,7 +1162,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 
 #endif // GMDEBUG_SUPPORT
 
-          break;
+          GM_NEXT;
         }
         if(res == KILLED)
         {
@@ -728,10 +1171,10 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           return KILLED;
         }
         if(res == SYS_EXCEPTION) goto LabelException;
-        break;
+        GM_NEXT;
       }
 
-	  case BC_PUSHLASTIND:
+	  GM_CASE(BC_PUSHLASTIND)
 	  {
 		  operand = top - 1;
 		  if ( operand->m_type == GM_TABLE )
@@ -753,13 +1196,13 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
 			  GMTHREAD_LOG( "'[]' used on object that isn't a table or darray" );
 			  goto LabelException;
 		  }
-		  break;
+		  GM_NEXT;
 	  }
 
 #if GM_USE_FORK
     // duplicates the current thread and just the local stack frame
     // and branches around the forked section of code
-     case BC_FORK :
+     GM_CASE(BC_FORK)
      {
         int id;
         gmThread* newthr = GetMachine()->CreateThread(&id);
@@ -785,10 +1228,10 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         top->m_type = GM_INT;
         top->m_value.m_int = newthr->GetId();
         ++top;
-        break;
+        GM_NEXT;
      }
 #endif //GM_USE_FORK
-      case BC_FOREACH :
+      GM_CASE(BC_FOREACH)
       {
         gmuint32 localvalue = OPCODE_INT(instruction);
         gmuint32 localkey = localvalue >> 16;
@@ -833,12 +1276,10 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           GM_ASSERT(top[-1].m_type == GM_INT);
           gmTableIterator it = (gmTableIterator) top[-1].m_value.m_int;
           gmTableObject * table = (gmTableObject *) GM_MOBJECT(m_machine, top[-2].m_value.m_ref);
-          gmTableNode * node = table->GetNext(it);
+          const bool found = table->GetNext(it, base[localkey], base[localvalue]);
           top[-1].m_value.m_int = it;
-          if(node)
+          if(found)
           {
-            base[localkey] = node->m_key;
-            base[localvalue] = node->m_value;
             top->m_type = GM_INT; top->m_value.m_int = 1;
           }
           else
@@ -847,106 +1288,108 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           }
           ++top;
         }
-        break;
+        GM_NEXT;
       }
-      case BC_POP :
+      GM_CASE(BC_POP)
       {
         --top;
-        break;
+        GM_NEXT;
       }
-      case BC_POP2 :
+      GM_CASE(BC_POP2)
       {
         top -= 2;
-        break;
+        GM_NEXT;
       }
-      case BC_DUP :
+      GM_CASE(BC_DUP)
       {
         top[0] = top[-1]; 
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_DUP2 :
+      GM_CASE(BC_DUP2)
       {
         top[0] = top[-2];
         top[1] = top[-1];
         top += 2;
-        break;
+        GM_NEXT;
       }
-      case BC_SWAP :
+      GM_CASE(BC_SWAP)
       {
         top[0] = top[-1];
         top[-1] = top[-2];
         top[-2] = top[0];
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHNULL :
+      GM_CASE(BC_PUSHNULL)
       {
         PUSHNULL;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHINT :
+      GM_CASE(BC_PUSHINT)
       {
         top->m_type = GM_INT;
         top->m_value.m_int = OPCODE_INT(instruction);
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHINT0 :
+      GM_CASE(BC_PUSHINT0)
       {
         top->m_type = GM_INT;
         top->m_value.m_int = 0;
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHINT1 :
+      GM_CASE(BC_PUSHINT1)
       {
         top->m_type = GM_INT;
         top->m_value.m_int = 1;
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHFP :
+      GM_CASE(BC_PUSHFP)
       {
         top->m_type = GM_FLOAT;
         top->m_value.m_float = OPCODE_FLOAT(instruction);
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHSTR :
+      GM_CASE(BC_PUSHSTR)
       {
         top->m_type = GM_STRING;
         top->m_value.m_ref = OPCODE_PTR(instruction);
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHTBL :
+      GM_CASE(BC_PUSHTBL)
       {
         SetTop(top);
+        GM_ALLOC_SITE
         top->m_type = GM_TABLE;
         top->m_value.m_ref = m_machine->AllocTableObject()->GetRef();
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHFN :
+      GM_CASE(BC_PUSHFN)
       {
         top->m_type = GM_FUNCTION;
         top->m_value.m_ref = OPCODE_PTR(instruction);
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_PUSHTHIS :
+      GM_CASE(BC_PUSHTHIS)
       {
         *top = *GetThis();
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_GETLOCAL :
+      GM_CASE(BC_GETLOCAL)
+      LabelGetLocal:
       {
         gmuint32 offset = OPCODE_INT(instruction);
         *(top++) = base[offset];
-        break;
+        GM_NEXT;
       }
-      case BC_SETLOCAL :
+      GM_CASE(BC_SETLOCAL)
       {
         gmuint32 offset = OPCODE_INT(instruction);
 
@@ -961,23 +1404,24 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         }
 
         base[offset] = *(--top);
-        break;
+        GM_NEXT;
       }
-      case BC_GETGLOBAL :
+      GM_CASE(BC_GETGLOBAL)
       {
         top->m_type = GM_STRING;
         top->m_value.m_ref = OPCODE_PTR(instruction);
         *top = m_machine->GetGlobals()->Get(*top); ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_SETGLOBAL :
+      GM_CASE(BC_SETGLOBAL)
       {
         top->m_type = GM_STRING;
         top->m_value.m_ref = OPCODE_PTR(instruction);
         m_machine->GetGlobals()->Set(m_machine, *top, *(top-1)); --top;
-        break;
+        GM_NEXT;
       }
-      case BC_GETTHIS :
+      GM_CASE(BC_GETTHIS)
+      LabelGetThis:
       {
         gmptr member = OPCODE_PTR(instruction);
         const gmVariable * thisVar = GetThis();
@@ -987,8 +1431,9 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         gmOperatorFunction op = OPERATOR(thisVar->m_type, O_GETDOT);
         if(op)
         {
+          GM_ALLOC_SITE
           op(this, top);
-          if(top->m_type) { ++top; break; }
+          if(top->m_type) { ++top; GM_NEXT; }
         }
         if(thisVar->m_type == GM_NULL)
         {
@@ -997,9 +1442,9 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         }
         *top = m_machine->GetTypeVariable(thisVar->m_type, top[1]);
         ++top;
-        break;
+        GM_NEXT;
       }
-      case BC_SETTHIS :
+      GM_CASE(BC_SETTHIS)
       {
         gmptr member = OPCODE_PTR(instruction);
         const gmVariable * thisVar = GetThis();
@@ -1012,6 +1457,7 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
         gmOperatorFunction op = OPERATOR(thisVar->m_type, O_SETDOT);
         if(op)
         {
+          GM_ALLOC_SITE
           op(this, operand);
         }
         else
@@ -1019,11 +1465,106 @@ gmThread::State gmThread::Sys_ExecuteMainLoop(gmVariable * a_return)
           GMTHREAD_LOG("setthis failed.");
           goto LabelException;
         }
-        break;
+        GM_NEXT;
       }
-      default :
+
+      //
+      // superinstructions
+      //
+
+      GM_CASE(BC_GETLOCAL2)
       {
-        break;
+        top[0] = base[instruction32[0]];
+        top[1] = base[instruction32[2]];
+        top += 2;
+        instruction32 += 3;
+        GM_NEXT;
+      }
+      GM_CASE(BC_GETLOCAL_GETDOT)
+      {
+        operand = base + instruction32[0];
+        if(operand->m_type == GM_TABLE)
+        {
+          const gmuint8 * next = instruction + 2 * sizeof(gmuint32) + sizeof(gmptr);
+          top->m_type = GM_STRING;
+          top->m_value.m_ref = *((gmptr *) (instruction + 2 * sizeof(gmuint32)));
+          gmTableObject * table = (gmTableObject *) GM_MOBJECT(m_machine, operand->m_value.m_ref);
+          const gmTableNode * node = GM_DOT_NODE(next, table, *top);
+          if(node)
+          {
+            *(top++) = node->m_value;
+            instruction = next;
+            GM_NEXT;
+          }
+        }
+        goto LabelGetLocal;
+      }
+      GM_CASE(BC_GETTHIS_GETDOT)
+      {
+        const gmVariable * thisVar = GetThis();
+        if(thisVar->m_type == GM_TABLE)
+        {
+          const gmuint8 * dot = instruction + sizeof(gmptr);
+          const gmuint8 * next = dot + sizeof(gmuint32) + sizeof(gmptr);
+          top->m_type = GM_STRING;
+          top->m_value.m_ref = *((gmptr *) instruction);
+          gmTableObject * table = (gmTableObject *) GM_MOBJECT(m_machine, thisVar->m_value.m_ref);
+          const gmTableNode * node = GM_DOT_NODE(dot, table, *top);
+          if(node && node->m_value.m_type == GM_TABLE)
+          {
+            top->m_value.m_ref = *((gmptr *) (dot + sizeof(gmuint32)));
+            table = (gmTableObject *) GM_MOBJECT(m_machine, node->m_value.m_value.m_ref);
+            node = GM_DOT_NODE(next, table, *top);
+            if(node)
+            {
+              *(top++) = node->m_value;
+              instruction = next;
+              GM_NEXT;
+            }
+          }
+        }
+        goto LabelGetThis;
+      }
+      GM_CASE(BC_INCLOCAL)
+      {
+        operand = base + instruction32[0];
+        if(operand->m_type == GM_INT)
+        {
+          gmint increment = 1; // push int 1 has no operand
+          const gmuint32 * add = instruction32 + 2;
+          if(instruction32[1] == BC_PUSHINT)
+          {
+            increment = (gmint) instruction32[2];
+            ++add;
+          }
+          const gmint value = operand->m_value.m_int + increment;
+          gmVariable * local = base + add[2];
+
+          // Write barrier old local objects
+          if(local->IsReference())
+          {
+            gmGarbageCollector* gc = m_machine->GetGC();
+            if(!gc->IsOff())
+            {
+              gc->WriteBarrier(GM_MOBJECT(m_machine, local->m_value.m_ref));
+            }
+          }
+
+          local->m_type = GM_INT;
+          local->m_value.m_int = value;
+          instruction32 = add + 3;
+          GM_NEXT;
+        }
+        goto LabelGetLocal;
+      }
+      GM_CASE(BC_LOCAL_LT_BRZ) GM_LOCAL_CMP_BRZ(<)
+      GM_CASE(BC_LOCAL_LTE_BRZ) GM_LOCAL_CMP_BRZ(<=)
+      GM_CASE(BC_LOCAL_GT_BRZ) GM_LOCAL_CMP_BRZ(>)
+      GM_CASE(BC_LOCAL_GTE_BRZ) GM_LOCAL_CMP_BRZ(>=)
+
+      GM_DEFAULT
+      {
+        GM_NEXT;
       }
     }
   }
@@ -1082,6 +1623,8 @@ void gmThread::Sys_Reset(int a_id)
   m_id = a_id;
   m_numParameters = 0;
   m_user = 0;
+  m_concat.ResetAndFreeMemory();
+  m_concatSlot = -1;
 
   // set group
   gmThread * currThread = m_machine->GetCurrentThread();
@@ -1326,6 +1869,58 @@ void gmThread::LogLineFile()
 
 
 
+bool gmThread::Concat(gmVariable * a_operands, bool a_end)
+{
+  const int slot = (int) (a_operands - m_stack);
+
+  // types <= GM_STRING add as strings once either side is a string, unless the string add has been replaced
+  const bool appendable = (a_operands[1].m_type <= GM_STRING) && (OPERATOR(GM_STRING, O_ADD) == gmStringOpAdd);
+
+  if(slot != m_concatSlot)
+  {
+    if(a_end || !appendable || a_operands[0].m_type > GM_STRING) return false;
+    if(a_operands[0].m_type != GM_STRING && a_operands[1].m_type != GM_STRING) return false;
+
+    // start a string, behind the slot of the one being built
+    const int start = m_concat.Count();
+    m_concat.SetCount(start + sizeof(int));
+    memcpy(m_concat.GetData() + start, &m_concatSlot, sizeof(int));
+    gmAppendAsString(m_machine, a_operands[0], m_concat);
+    gmAppendAsString(m_machine, a_operands[1], m_concat);
+    a_operands[0] = gmVariable(GM_NULL, (gmptr) start);
+    m_concatSlot = slot;
+    return true;
+  }
+
+  if(appendable)
+  {
+    gmAppendAsString(m_machine, a_operands[1], m_concat);
+    if(!a_end) return true;
+  }
+
+  // intern the string built, the slot holds null until then so the garbage collector may run
+  const int start = (int) a_operands[0].m_value.m_ref;
+  const int begin = start + sizeof(int);
+  memcpy(&m_concatSlot, m_concat.GetData() + start, sizeof(int));
+  SetTop(a_operands + 2);
+  gmStringObject * str = m_machine->AllocStringObject(m_concat.GetData() + begin, m_concat.Count() - begin);
+  m_concat.SetCount(start);
+  a_operands[0] = gmVariable(GM_STRING, str->GetRef());
+  return appendable;
+}
+
+
+
+void gmThread::Sys_ResizeStack(int a_byteSize)
+{
+  GM_ASSERT(m_top == 0);
+  delete [] m_stack;
+  m_size = a_byteSize / sizeof(gmVariable);
+  m_stack = GM_NEW( gmVariable[m_size] );
+}
+
+
+
 bool gmThread::Touch(int a_extra)
 {
   // Grow stack if necessary.  NOTE: Use better growth metric if needed.
@@ -1349,6 +1944,7 @@ bool gmThread::Touch(int a_extra)
    if(m_stack) 
      delete[] m_stack; 
    m_stack = stack; 
+   m_machine->Sys_StatsThreadStackGrow();
   }
   return true;
 }
@@ -84,6 +84,9 @@ public:
   /// \brief Sys_Reset() will reset the thread.
   void Sys_Reset(int a_id);
 
+  /// \brief Sys_ResizeStack() will reallocate the stack of a reset thread to a_byteSize.
+  void Sys_ResizeStack(int a_byteSize);
+
   /// \brief Sys_SetState() will set the thread state.
   inline void Sys_SetState(State a_state) { m_state = a_state; }
 
@@ -209,8 +212,13 @@ public:
   inline void Sys_SetTimeStamp(gmuint32 a_timeStamp) { m_timeStamp = a_timeStamp; }
   inline void Sys_SetStartTime(gmuint32 a_startTime) { m_startTime = a_startTime; }
 
+  /// \brief Sys_GetSleepIndex() will return the thread's slot in the machine's sleep heap, -1 if not sleeping.
+  inline int Sys_GetSleepIndex() const { return m_sleepIndex; }
+  inline void Sys_SetSleepIndex(int a_index) { m_sleepIndex = a_index; }
+
   /// \brief GetSystemMemUsed will return the number of bytes allocated by the system.
   inline unsigned int GetSystemMemUsed() const { return (m_size * sizeof(gmVariable)) + sizeof(this); }
+  inline int GetStackBytes() const { return m_size * sizeof(gmVariable); }
 
   // Eddie: thread groups
   inline int  GetGroup() { return m_groupId; }
@@ -250,6 +258,11 @@ private:
 
   void LogLineFile();
 
+  /// \brief Concat() adds the operands of BC_CONCAT or BC_CONCATEND.  A chain of string adds is built in m_concat, the
+  ///        left operand's slot holding the start of its characters, and is interned only at the end of the chain.
+  /// \return false if the add is not a string add, or its string could not be built, the generic add must follow.
+  bool Concat(gmVariable * a_operands, bool a_end);
+
   // stack members
   gmMachine * m_machine;
   gmVariable * m_stack;
@@ -262,12 +275,15 @@ private:
   State m_state;
   gmuint32 m_timeStamp; // wake up at this time stamp.
   gmuint32 m_startTime; // time this thread was started.
+  int m_sleepIndex; // slot in the machine sleep heap when SLEEPING, else -1
   const gmuint8 * m_instruction;
   int m_id;
   int m_groupId;
   gmSignal * m_signals; // list of potentially active signals on this thread.
   gmBlock * m_blocks; // list of active blocks when thread is in BLOCKED state.
   short m_numParameters;
+  gmArraySimple<char> m_concat; // strings being built by Concat(), each behind the slot of the one it is nested in
+  int m_concatSlot; // stack index of the innermost string being built, -1 if none
 };
 
 
@@ -311,14 +327,12 @@ inline void gmThread::PushFloat(gmfloat a_value)
 
 inline void gmThread::PushVec2(funk::v2 a_value)
 {
-	m_stack[m_top].m_type = GM_VEC2;
-	m_stack[m_top++].m_value.m_v2 = a_value.gmv2;
+	m_stack[m_top++].SetVec2(m_machine, a_value);
 }
 
 inline void gmThread::PushVec3(funk::v3 a_value)
 {
-	m_stack[m_top].m_type = GM_VEC3;
-	m_stack[m_top++].m_value.m_v3 = a_value.gmv3;
+	m_stack[m_top++].SetVec3(m_machine, a_value);
 }
 
 inline void gmThread::PushString(gmStringObject * a_string)
@@ -408,7 +422,7 @@ inline gmVec2 gmThread::ParamVec2(int a_param) const
 
 	if(a_param >= m_numParameters) return default_val;
 	gmVariable * var = m_stack + m_base + a_param;
-	if(var->m_type == GM_VEC2) return var->m_value.m_v2;
+	if(var->m_type == GM_VEC2) return var->GetVec2().gmv2;
 	return default_val;
 }
 
@@ -426,7 +440,7 @@ inline bool gmThread::ParamVec2(int a_param, funk::v2& a_value) const
 	gmVariable * var = m_stack + m_base + a_param;
 	if( var->m_type == GM_VEC2 )
 	{
-		a_value = var->m_value.m_v2;
+		a_value = var->GetVec2();
 		return true;
 	}
 	// Invalid
@@ -440,7 +454,7 @@ inline gmVec3 gmThread::ParamVec3(int a_param) const
 
 	if(a_param >= m_numParameters) return default_val;
 	gmVariable * var = m_stack + m_base + a_param;
-	if(var->m_type == GM_VEC3) return var->m_value.m_v3;
+	if(var->m_type == GM_VEC3) return var->GetVec3().gmv3;
 	return default_val;
 }
 inline bool gmThread::ParamVec3(int a_param, funk::v3& a_value) const
@@ -457,7 +471,7 @@ inline bool gmThread::ParamVec3(int a_param, funk::v3& a_value) const
 	gmVariable * var = m_stack + m_base + a_param;
 	if( var->m_type == GM_VEC3 )
 	{
-		a_value = var->m_value.m_v3;
+		a_value = var->GetVec3();
 		return true;
 	}
 	// Invalid
@@ -813,7 +827,7 @@ inline gmVec2 gmThread::ThisVec2()
 	const gmVec2 default_val = {0,0};
 
 	const gmVariable * var = GetThis();
-	if(var->m_type == GM_VEC2) return var->m_value.m_v2;
+	if(var->m_type == GM_VEC2) return var->GetVec2().gmv2;
 	return default_val;
 }
 
@@ -822,7 +836,7 @@ inline gmVec3 gmThread::ThisVec3()
 	const gmVec3 default_val = {0,0,0};
 
 	const gmVariable * var = GetThis();
-	if(var->m_type == GM_VEC3) return var->m_value.m_v3;
+	if(var->m_type == GM_VEC3) return var->GetVec3().gmv3;
 	return default_val;
 }
 
@@ -952,8 +966,14 @@ inline gmUserObject * gmThread::ThisUserObject()
 
 #define GM_OP_USER_PTR( TYPE, INDEX, PTR ) assert( a_operands[INDEX].m_type == GM_TYPEID(TYPE) ); TYPE* PTR = static_cast<TYPE*>(static_cast< gmUserObject*>(GM_OBJECT(a_operands[INDEX].m_value.m_ref))->m_user);
 #define GM_OP_STR_PTR( CHAR_PTR, INDEX) assert( a_operands[INDEX].m_type == GM_STRING ); const char* CHAR_PTR = (static_cast< gmStringObject*>(GM_OBJECT(a_operands[INDEX].m_value.m_ref)))->GetString();
+#if GM_COMPACT_VARIABLE
+// boxed vecs are shared, the operand is a copy
+#define GM_OP_VEC2( VAL, INDEX ) assert( a_operands[INDEX].m_type == GM_VEC2 ); gmVec2 VAL = a_operands[INDEX].GetVec2().gmv2;
+#define GM_OP_VEC3( VAL, INDEX ) assert( a_operands[INDEX].m_type == GM_VEC3 ); gmVec3 VAL = a_operands[INDEX].GetVec3().gmv3;
+#else //GM_COMPACT_VARIABLE
 #define GM_OP_VEC2( VAL, INDEX ) assert( a_operands[INDEX].m_type == GM_VEC2 ); gmVec2 &VAL = a_operands[INDEX].m_value.m_v2;
 #define GM_OP_VEC3( VAL, INDEX ) assert( a_operands[INDEX].m_type == GM_VEC3 ); gmVec3 &VAL = a_operands[INDEX].m_value.m_v3;
+#endif //GM_COMPACT_VARIABLE
 #define GM_OP_FLOAT( VAL, INDEX) assert( a_operands[INDEX].m_type == GM_FLOAT ); float VAL = a_operands[INDEX].m_value.m_float;
 #define GM_OP_INT( VAL, INDEX) assert( a_operands[INDEX].m_type == GM_INT ); int VAL = a_operands[INDEX].m_value.m_int;
 #define GM_OP_FLOAT_OR_INT( VAL, INDEX ) assert( a_operands[INDEX].m_type == GM_FLOAT || a_operands[INDEX].m_type == GM_INT ); float VAL = (float)(a_operands[INDEX].m_type == GM_INT )?a_operands[INDEX].m_value.m_int:a_operands[INDEX].m_value.m_float;
@@ -980,11 +1000,11 @@ inline gmUserObject * gmThread::ThisUserObject()
 
 #define GM_CHECK_VEC2_PARAM(VAR, PARAM) \
 	if(GM_THREAD_ARG->ParamType((PARAM)) != GM_VEC2) { GM_EXCEPTION_MSG("expecting param %d as vec2", (PARAM)); return GM_EXCEPTION; } \
-	funk::v2 VAR = GM_THREAD_ARG->Param((PARAM)).m_value.m_v2;
+	funk::v2 VAR = GM_THREAD_ARG->Param((PARAM)).GetVec2();
 
 #define GM_CHECK_VEC3_PARAM(VAR, PARAM) \
 	if(GM_THREAD_ARG->ParamType((PARAM)) != GM_VEC3) { GM_EXCEPTION_MSG("expecting param %d as vec3", (PARAM)); return GM_EXCEPTION; } \
-	funk::v3 VAR = GM_THREAD_ARG->Param((PARAM)).m_value.m_v3;
+	funk::v3 VAR = GM_THREAD_ARG->Param((PARAM)).GetVec3();
 
 #define GM_CHECK_STRING_PARAM(VAR, PARAM) \
   if(GM_THREAD_ARG->ParamType((PARAM)) != GM_STRING) { GM_EXCEPTION_MSG("expecting param %d as string", (PARAM)); return GM_EXCEPTION; } \
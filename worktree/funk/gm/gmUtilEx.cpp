@@ -2,6 +2,7 @@
 
 #include <time.h>
 #include <fstream>
+#include <string>
 #include <time.h>
 
 #include <common/Util.h>
@@ -11,48 +12,230 @@
 #include "gmMachine.h"
 #include "gmTableObject.h"
 #include "gmStreamBuffer.h"
+#include "gmByteCode.h"
+#include "gmByteCodeOpt.h"
+#include "gmCrc.h"
+#include "gmLibHooks.h"
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #include <math/v2.h>
 #include <math/v3.h>
 
 using namespace funk;
 
-int gmCompileStr( gmMachine *vm, const char* file )
+#define ID_gmc0 GM_MAKE_ID32('g','m','c','0')
+
+// header in front of each cached lib
+struct gmcHeader
 {
-	// If using bytecode
-	if ( VirtualMachine::Get()->IsUsingByteCode() )
+	gmuint32 m_id;
+	gmuint32 m_compilerKey;	// see CacheCompilerKey
+	gmuint32 m_sourceCrc;
+	gmuint32 m_sourceSize;
+	gmuint32 m_libSize;
+};
+
+static char s_byteCodeCacheDir[256] = { 0 };
+static bool s_printCompileStats = false;
+
+void gmSetByteCodeCacheDir( const char * dir )
+{
+	if ( !dir || !*dir ) 
 	{
-		int threadId;
+		s_byteCodeCacheDir[0] = '\0';
+		return;
+	}
 
-		int numBytes;
-		char * code = TextFileRead(file, &numBytes);
+	// room for a separator, CachePath puts the file name straight after the directory
+	assert( strlen(dir) + 1 < sizeof(s_byteCodeCacheDir) );
+	strncpy( s_byteCodeCacheDir, dir, sizeof(s_byteCodeCacheDir)-2 );
+	s_byteCodeCacheDir[sizeof(s_byteCodeCacheDir)-2] = '\0';
+
+	const size_t len = strlen( s_byteCodeCacheDir );
+	if ( s_byteCodeCacheDir[len-1] != '/' && s_byteCodeCacheDir[len-1] != '\\' )
+	{
+		s_byteCodeCacheDir[len] = '/';
+		s_byteCodeCacheDir[len+1] = '\0';
+	}
 
-		gmStreamBufferStatic readBuffer;
-		readBuffer.Open(code, numBytes );
-		vm->ExecuteLib(readBuffer, &threadId, true );
+#ifdef _WIN32
+	_mkdir( s_byteCodeCacheDir );
+#else
+	mkdir( s_byteCodeCacheDir, 0755 );
+#endif
+}
 
-		delete [] code;
-		return threadId;
+// anything that changes the compiled output must be part of the key
+static gmuint32 CacheCompilerKey( gmMachine * vm )
+{
+	char key[128];
+	sprintf( key, "%s %d %d %d %d %d %d %d", GM_VERSION, GM_BYTECODE_VERSION, (int)BC_MAX, (int)sizeof(gmptr), 
+		GMCODEGEN_SUPERINSTRUCTIONS, (int)vm->GetOptimiseMode(), (int)vm->GetDebugMode(), (int)vm->GetLineOpsMode() );
+	return gmCrc32String(key);
+}
+
+static void CachePath( const char * file, char * path )
+{
+	// one cache file per script path, a changed source simply overwrites it
+	sprintf( path, "%s%08x.gmc", s_byteCodeCacheDir, gmCrc32String(file) );
+}
+
+static bool CacheValid( const MappedFile & cache, const gmcHeader & key )
+{
+	if ( !cache.IsOpen() || cache.GetSize() < (int)sizeof(gmcHeader) ) return false;
+
+	gmcHeader header;
+	memcpy( &header, cache.GetData(), sizeof(header) );
+
+	return header.m_id == key.m_id
+		&& header.m_compilerKey == key.m_compilerKey
+		&& header.m_sourceCrc == key.m_sourceCrc
+		&& header.m_sourceSize == key.m_sourceSize
+		&& header.m_libSize == cache.GetSize() - sizeof(header);
+}
+
+static bool CacheExecuteLib( gmMachine * vm, const char * file, const gmcHeader & key, int * threadId )
+{
+	char path[512];
+	CachePath( file, path );
+
+	MappedFile cache( path );
+	if ( !CacheValid(cache, key) ) return false;
+
+	// bound in place from the mapping
+	gmStreamBufferStatic readBuffer( cache.GetData() + sizeof(gmcHeader), cache.GetSize() - sizeof(gmcHeader) );
+	return vm->ExecuteLib( readBuffer, threadId, true, file );
+}
+
+static void CacheWriteLib( const char * file, const gmcHeader & key, const gmStreamBufferDynamic & lib )
+{
+	char path[512];
+	CachePath( file, path );
+
+	FILE * fp = fopen( path, "wb" );
+	if ( !fp ) 
+	{
+		printf("Unable to write byte code cache '%s'\n", path );
+		return;
+	}
+
+	gmcHeader header = key;
+	header.m_libSize = lib.GetSize();
+
+	// id is written last so a partially written file never validates
+	header.m_id = 0;
+	fwrite( &header, sizeof(header), 1, fp );
+	fwrite( lib.GetData(), 1, header.m_libSize, fp );
+	fflush( fp );
+
+	header.m_id = key.m_id;
+	fseek( fp, 0, SEEK_SET );
+	fwrite( &header, sizeof(header), 1, fp );
+	fclose( fp );
+}
+
+void gmSetPrintCompileStats( bool print )
+{
+	s_printCompileStats = print;
+}
+
+static void PrintCompileStats( const gmCodeGenStats & stats, const char * file )
+{
+	if ( !s_printCompileStats ) return;
+
+	// report instruction count reduction per file
+	const int removed = stats.m_instructions - stats.m_optimisedInstructions;
+	printf("Compiled '%s' (%d instructions, %d optimised out, %.1f%%, %d superinstructions, %d line)\n", file, stats.m_optimisedInstructions, removed, 
+		stats.m_instructions ? 100.0f * removed / stats.m_instructions : 0.0f, stats.m_superInstructions, stats.m_lineInstructions );
+}
+
+int gmExecuteLibFile( gmMachine *vm, const char* file )
+{
+	MappedFile lib(file);
+	if ( !lib.IsOpen() )
+	{
+		CHECK( false, "Cannot open lib '%s'\n", file );
+		return 0;
+	}
+
+	// bind straight out of the mapped file, the string table and source are never copied
+	int threadId = 0;
+	gmStreamBufferStatic readBuffer( lib.GetData(), lib.GetSize() );
+	vm->ExecuteLib( readBuffer, &threadId, true, file );
+	return threadId;
+}
+
+int gmCompileStr( gmMachine *vm, const char* file )
+{
+	// If using bytecode
+	if ( VirtualMachine::Get()->IsUsingByteCode() )
+	{
+		return gmExecuteLibFile( vm, file );
 	}
 
 	// Not using bytecode, compiling
 	while(true)
 	{
 		int threadId;
-		char * code = TextFileRead(file);
+		int numBytes;
+		char * code = TextFileRead(file, &numBytes);
 
 		// failed
 		if ( !code ) return 0;
 
-		if ( vm->GetDebugMode() ) vm->AddSourceCode( code, file );
-		int err = vm->CheckSyntax( code );
-		
-		if ( !err ) 
+		int err = 0;
+
+		if ( s_byteCodeCacheDir[0] )
 		{
-			printf("Compiled '%s'\n", file );
-			vm->ExecuteString(code, &threadId);
-			delete [] code;
-			return threadId;
+			gmcHeader key;
+			key.m_id = ID_gmc0;
+			key.m_compilerKey = CacheCompilerKey(vm);
+			key.m_sourceCrc = gmCrc32Buffer(code, numBytes);
+			key.m_sourceSize = numBytes;
+			key.m_libSize = 0;
+
+			// warm start, source unchanged since last compile
+			if ( CacheExecuteLib(vm, file, key, &threadId) )
+			{
+				delete [] code;
+				return threadId;
+			}
+
+			// compile to a lib (source and line info are kept in debug mode) and cache it
+			gmStreamBufferDynamic lib;
+			err = vm->CompileStringToLib( code, lib );
+
+			if ( !err )
+			{
+				PrintCompileStats( vm->GetCompileStats(), file );
+				CacheWriteLib( file, key, lib );
+				vm->ExecuteLib( lib, &threadId, true, file );
+
+				delete [] code;
+				return threadId;
+			}
+		}
+		else
+		{
+			if ( vm->GetDebugMode() ) vm->AddSourceCode( code, file );
+			err = vm->CheckSyntax( code );
+		
+			if ( !err ) 
+			{
+				vm->ExecuteString(code, &threadId);
+				PrintCompileStats( vm->GetCompileStats(), file );
+
+				delete [] code;
+				return threadId;
+			}
 		}
 
 		delete [] code;
@@ -74,6 +257,202 @@ int gmCompileStr( gmMachine *vm, const char* file )
 	}
 }
 
+// one script compiled to a lib by a compile worker
+struct gmCompileJob
+{
+	gmCompileJob() : m_file(0), m_cached(false), m_errors(0) {}
+
+	const char * m_file;
+	gmcHeader m_key;
+	bool m_cached;	// cache holds a lib for this source, nothing was compiled
+	int m_errors;	// -1 if the file could not be read
+	gmStreamBufferDynamic m_lib;
+	gmCodeGenStats m_stats;
+};
+
+// jobs shared by the compile workers, nothing here refers to the machine
+struct gmCompileQueue
+{
+	gmCompileJob * m_jobs;
+	int m_numJobs;
+	int m_next;
+	SDL_mutex * m_mutex;
+	bool m_debug;
+	bool m_optimise;
+	bool m_lineOps;
+	bool m_cache;
+};
+
+static void CompileJob( const gmCompileQueue & queue, gmCompileJob & job, gmLog & log )
+{
+	int numBytes;
+	char * code = TextFileRead( job.m_file, &numBytes );
+	if ( !code ) 
+	{
+		job.m_errors = -1;
+		return;
+	}
+
+	if ( queue.m_cache )
+	{
+		job.m_key.m_sourceCrc = gmCrc32Buffer(code, numBytes);
+		job.m_key.m_sourceSize = numBytes;
+
+		char path[512];
+		CachePath( job.m_file, path );
+		MappedFile cache( path );
+		job.m_cached = CacheValid( cache, job.m_key );
+	}
+
+	if ( !job.m_cached )
+	{
+		job.m_errors = gmMachine::CompileStringToLib( code, job.m_lib, log, queue.m_debug, queue.m_optimise, queue.m_lineOps, &job.m_stats );
+
+		if ( !job.m_errors && queue.m_cache ) CacheWriteLib( job.m_file, job.m_key, job.m_lib );
+	}
+
+	delete [] code;
+}
+
+static int SDLCALL CompileWorker( void * data )
+{
+	gmCompileQueue * queue = (gmCompileQueue *)data;
+
+	// errors are reported when the file is compiled again on the main thread
+	gmLog log;
+
+	while ( true )
+	{
+		if ( queue->m_mutex ) SDL_LockMutex( queue->m_mutex );
+		int job = queue->m_next++;
+		if ( queue->m_mutex ) SDL_UnlockMutex( queue->m_mutex );
+
+		if ( job >= queue->m_numJobs ) break;
+
+		CompileJob( *queue, queue->m_jobs[job], log );
+		log.Reset();
+	}
+
+	return 0;
+}
+
+// compiles files into jobs on numThreads threads, the calling thread being one of them
+static void CompileJobs( gmMachine * vm, const char ** files, gmCompileJob * jobs, int numJobs, int numThreads, bool useCache )
+{
+	gmcHeader key;
+	key.m_id = ID_gmc0;
+	key.m_compilerKey = CacheCompilerKey(vm);
+	key.m_sourceCrc = 0;
+	key.m_sourceSize = 0;
+	key.m_libSize = 0;
+
+	for( int i = 0; i < numJobs; ++i )
+	{
+		jobs[i].m_file = files[i];
+		jobs[i].m_key = key;
+	}
+
+	gmCompileQueue queue;
+	queue.m_jobs = jobs;
+	queue.m_numJobs = numJobs;
+	queue.m_next = 0;
+	queue.m_mutex = NULL;
+	queue.m_debug = vm->GetDebugMode();
+	queue.m_optimise = vm->GetOptimiseMode();
+	queue.m_lineOps = vm->GetLineOpsMode();
+	queue.m_cache = useCache && s_byteCodeCacheDir[0];
+
+	if ( numThreads > numJobs ) numThreads = numJobs;
+
+	if ( numThreads <= 1 )
+	{
+		CompileWorker( &queue );
+		return;
+	}
+
+	queue.m_mutex = SDL_CreateMutex();
+
+	std::vector<SDL_Thread*> threads;
+	for( int i = 1; i < numThreads; ++i )
+	{
+		threads.push_back( SDL_CreateThread( CompileWorker, &queue ) );
+	}
+
+	CompileWorker( &queue );
+
+	for( size_t i = 0; i < threads.size(); ++i )
+	{
+		SDL_WaitThread( threads[i], NULL );
+	}
+
+	SDL_DestroyMutex( queue.m_mutex );
+}
+
+int gmCompileFiles( gmMachine *vm, const char ** files, int numFiles, int numThreads )
+{
+	int failed = 0;
+
+	// libs are already compiled
+	if ( VirtualMachine::Get()->IsUsingByteCode() || numFiles <= 0 )
+	{
+		for( int i = 0; i < numFiles; ++i )
+		{
+			if ( !gmExecuteLibFile( vm, files[i] ) ) ++failed;
+		}
+		return failed;
+	}
+
+	gmCompileJob * jobs = new gmCompileJob[numFiles];
+	CompileJobs( vm, files, jobs, numFiles, numThreads, true );
+
+	// bind and execute on this thread, in the order given
+	for( int i = 0; i < numFiles; ++i )
+	{
+		gmCompileJob & job = jobs[i];
+		int threadId = 0;
+
+		if ( job.m_cached )
+		{
+			if ( CacheExecuteLib(vm, job.m_file, job.m_key, &threadId) ) continue;
+		}
+		else if ( job.m_errors == 0 )
+		{
+			PrintCompileStats( job.m_stats, job.m_file );
+			if ( vm->ExecuteLib(job.m_lib, &threadId, true, job.m_file) ) continue;
+		}
+
+		// unreadable or failed to compile, gmCompileStr reports the error and waits for a fix
+		if ( !gmCompileStr(vm, job.m_file) ) ++failed;
+	}
+
+	delete [] jobs;
+	return failed;
+}
+
+int gmCompileBindFiles( gmMachine *vm, const char ** files, int numFiles, int numThreads )
+{
+	if ( numFiles <= 0 ) return 0;
+
+	gmCompileJob * jobs = new gmCompileJob[numFiles];
+	CompileJobs( vm, files, jobs, numFiles, numThreads, false );
+
+	int failed = 0;
+	for( int i = 0; i < numFiles; ++i )
+	{
+		if ( jobs[i].m_errors )
+		{
+			++failed;
+			continue;
+		}
+
+		gmLibHooks::BindLib( *vm, jobs[i].m_lib.GetData(), jobs[i].m_lib.GetSize(), jobs[i].m_file );
+	}
+
+	delete [] jobs;
+	return failed;
+}
+
+
 void OutputTableNode( std::ofstream &fh, gmTableObject * table, gmVariable & key, int level )
 {
 	// check not infinite loop
@@ -123,12 +502,12 @@ void OutputTableNode( std::ofstream &fh, gmTableObject * table, gmVariable & key
 			fh << "{" << std::endl;
 
 			gmTableObject * childTable = var.GetTableObjectSafe();
-			std::vector<gmVariable*> tableKeys;
+			std::vector<gmVariable> tableKeys;
 
 			gmSortTableKeys( childTable, tableKeys );
 			for( size_t i = 0; i < tableKeys.size(); ++i )
 			{
-				OutputTableNode( fh, childTable, *tableKeys[i], level+1 );
+				OutputTableNode( fh, childTable, tableKeys[i], level+1 );
 			}
 
 			break;
@@ -172,11 +551,11 @@ int gmSaveTableToFile( gmTableObject * table, const char * file )
 
 	fh << "global g_fileData =" << std::endl << "{" << std::endl;
 
-	std::vector<gmVariable*> tableKeys;
+	std::vector<gmVariable> tableKeys;
 	gmSortTableKeys( table, tableKeys );
 	for( size_t i = 0; i < tableKeys.size(); ++i )
 	{
-		OutputTableNode( fh, table, *tableKeys[i], 1 );
+		OutputTableNode( fh, table, tableKeys[i], 1 );
 	}
 
 	fh << "};";
@@ -210,19 +589,19 @@ bool gmVariableCmp( const gmVariable & v0, const gmVariable & v1 )
 	return false;
 }
 
-void gmSortTableKeys( gmTableObject * table, std::vector<gmVariable*> & result )
+void gmSortTableKeys( gmTableObject * table, std::vector<gmVariable> & result )
 {
 	int tableSize = table->Count();
 
 	result.clear();
 	result.reserve(tableSize);
 
+	// keys in the array part have no node, so they are copied
 	gmTableIterator it;
-	gmTableNode * node = table->GetFirst( it );
-	while ( !table->IsNull(it) )
+	gmVariable key, value;
+	for( bool more = table->GetFirst( it, key, value ); more; more = table->GetNext( it, key, value ) )
 	{
-		result.push_back( &(node->m_key) );
-		node = table->GetNext(it);
+		result.push_back( key );
 	}
 
 	// sort keys
@@ -230,9 +609,9 @@ void gmSortTableKeys( gmTableObject * table, std::vector<gmVariable*> & result )
 	{
 		for( int j = i+1; j < tableSize; ++j )
 		{
-			if ( !gmVariableCmp( *result[i], *result[j] ) )
+			if ( !gmVariableCmp( result[i], result[j] ) )
 			{
-				gmVariable * temp = result[i];
+				gmVariable temp = result[i];
 				result[i] = result[j];
 				result[j] = temp;
 			}
@@ -8,9 +8,27 @@ class gmTableObject;
 struct gmVariable;
 
 int gmCompileStr( gmMachine *vm, const char* file );
+
+// executes a lib compiled with gmMachine::CompileStringToLib, memory mapped and bound in place. returns thread id
+int gmExecuteLibFile( gmMachine *vm, const char* file );
+
+// compiles the files to libs on numThreads threads (the caller included), then executes them in order on the calling thread.
+// files that fail to compile go through gmCompileStr. returns the number of files that failed
+int gmCompileFiles( gmMachine *vm, const char ** files, int numFiles, int numThreads );
+
+// compiles the files to libs on numThreads threads (the caller included) and binds them without executing them, the
+// byte code cache is not used. returns the number of files that failed
+int gmCompileBindFiles( gmMachine *vm, const char ** files, int numFiles, int numThreads );
+
+// compiled byte code cache used by gmCompileStr, keyed by source crc and compiler version, NULL dir disables
+void gmSetByteCodeCacheDir( const char * dir );
+
+// prints the optimiser's instruction counts for every file compiled, off by default
+void gmSetPrintCompileStats( bool print );
+
 int gmSaveTableToFile( gmTableObject * table, const char * file );
 
 // sorts table's children and outputs
-void gmSortTableKeys( gmTableObject * table, std::vector<gmVariable*> & result );
+void gmSortTableKeys( gmTableObject * table, std::vector<gmVariable> & result );
 
 #endif
\ No newline at end of file
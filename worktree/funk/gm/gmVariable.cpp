@@ -30,10 +30,10 @@ const char * gmVariable::AsString(gmMachine * a_machine, char * a_buffer, int a_
       _gmsnprintf(a_buffer, a_len, "%d", m_value.m_int);
       break;
 	case GM_VEC2 :
-		_gmsnprintf(a_buffer, a_len, "v2(%f, %f)", m_value.m_v2.x, m_value.m_v2.y );
+		_gmsnprintf(a_buffer, a_len, "v2(%f, %f)", GetVec2().x, GetVec2().y );
 		break;
 	case GM_VEC3 :
-		_gmsnprintf(a_buffer, a_len, "v3(%f, %f, %f)", m_value.m_v3.x, m_value.m_v3.y, m_value.m_v3.z );
+		_gmsnprintf(a_buffer, a_len, "v3(%f, %f, %f)", GetVec3().x, GetVec3().y, GetVec3().z );
 		break;
     case GM_FLOAT :
       _gmsnprintf(a_buffer, a_len, "%g", m_value.m_float);
@@ -100,6 +100,33 @@ void gmVariable::SetString(gmMachine * a_machine, const char * a_cString)
 }
 
 
+#if GM_COMPACT_VARIABLE
+
+void gmVariable::SetVec2(gmMachine * a_machine, funk::v2 a_val)
+{
+  gmVec3 vec = { a_val.x, a_val.y, 0.0f };
+  m_type = GM_VEC2;
+  m_value.m_ref = a_machine->AllocVecObject(GM_VEC2, vec)->GetRef();
+}
+
+
+void gmVariable::SetVec3(gmMachine * a_machine, funk::v3 a_val)
+{
+  m_type = GM_VEC3;
+  m_value.m_ref = a_machine->AllocVecObject(GM_VEC3, a_val.gmv3)->GetRef();
+}
+
+
+void gmVecObject::Destruct(gmMachine * a_machine)
+{
+#if GM_USE_INCGC
+  a_machine->DestructDeleteObject(this);
+#endif //GM_USE_INCGC
+}
+
+#endif //GM_COMPACT_VARIABLE
+
+
 const char * gmVariable::GetCStringSafe() const
 {
   if( m_type == GM_STRING )
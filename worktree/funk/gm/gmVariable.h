@@ -30,6 +30,9 @@ class gmStringObject;
 class gmTableObject;
 class gmFunctionObject;
 class gmUserObject;
+#if GM_COMPACT_VARIABLE
+class gmVecObject;
+#endif //GM_COMPACT_VARIABLE
 
 /// \enum gmType
 /// \brief gmType is an enum of the possible scripting types.
@@ -60,6 +63,7 @@ enum
 /// \brief a variable is the basic type passed around on the stack, and used as storage in the symbol tables.
 ///        A variable is either a reference to a gmObject type, or it is a direct value such as null, int or float.
 ///        The gm runtime stack operates on gmVariable types.
+///        With GM_COMPACT_VARIABLE, vec2 and vec3 are references to a gmVecObject and must be created with a machine.
 struct gmVariable
 {
   static gmVariable s_null;
@@ -68,8 +72,10 @@ struct gmVariable
 
   union
   {
+#if !GM_COMPACT_VARIABLE
 	gmVec3 m_v3;
 	gmVec2 m_v2;
+#endif //!GM_COMPACT_VARIABLE
     gmint m_int;
     gmfloat m_float;
     gmptr m_ref;
@@ -85,8 +91,10 @@ struct gmVariable
 
   explicit inline gmVariable(int a_val) : m_type(GM_INT) { m_value.m_int = a_val; }
   explicit inline gmVariable(float a_val) : m_type(GM_FLOAT) { m_value.m_float = a_val; }
+#if !GM_COMPACT_VARIABLE
   explicit inline gmVariable(funk::v2 a_val) : m_type(GM_VEC2) { m_value.m_v2 = a_val.gmv2; }
   explicit inline gmVariable(funk::v3 a_val) : m_type(GM_VEC3) { m_value.m_v3 = a_val.gmv3; }
+#endif //!GM_COMPACT_VARIABLE
   explicit inline gmVariable(gmStringObject * a_string) { SetString(a_string); }
   explicit inline gmVariable(gmTableObject * a_table) { SetTable(a_table); }
   explicit inline gmVariable(gmFunctionObject * a_func) { SetFunction(a_func); }
@@ -94,8 +102,15 @@ struct gmVariable
 
   inline void SetInt(int a_value) { m_type = GM_INT; m_value.m_int = a_value; }
   inline void SetFloat(float a_value) { m_type = GM_FLOAT; m_value.m_float = a_value; }
+#if GM_COMPACT_VARIABLE
+  void SetVec2(gmMachine * a_machine, funk::v2 a_val);
+  void SetVec3(gmMachine * a_machine, funk::v3 a_val);
+#else //GM_COMPACT_VARIABLE
   inline void SetVec2(funk::v2 a_val) { m_type = GM_VEC2; m_value.m_v2 = a_val.gmv2; }
   inline void SetVec3(funk::v3 a_val) { m_type = GM_VEC3; m_value.m_v3 = a_val.gmv3; }
+  inline void SetVec2(gmMachine * a_machine, funk::v2 a_val) { SetVec2(a_val); }
+  inline void SetVec3(gmMachine * a_machine, funk::v3 a_val) { SetVec3(a_val); }
+#endif //GM_COMPACT_VARIABLE
   inline void SetString(gmStringObject * a_string);
   void SetString(gmMachine * a_machine, const char * a_cString);
   inline void SetTable(gmTableObject * a_table);
@@ -106,7 +121,11 @@ struct gmVariable
 
   inline void Nullify() { m_type = GM_NULL; m_value.m_int = 0; }
   inline bool IsNull() const { return m_type == GM_NULL; }
+#if GM_COMPACT_VARIABLE
+  inline bool IsReference() const { return m_type > GM_FLOAT; }
+#else //GM_COMPACT_VARIABLE
   inline bool IsReference() const { return m_type > GM_VEC3; }
+#endif //GM_COMPACT_VARIABLE
   inline bool IsString() const { return m_type == GM_STRING; }
   inline bool IsInt() const { return m_type == GM_INT; }
   inline bool IsFloat() const { return m_type == GM_FLOAT; }
@@ -120,8 +139,13 @@ struct gmVariable
   // GetInt and GetFloat are not protected. User should verify the type before calling this.
   inline int GetInt() const  { return m_value.m_int; }
   inline float GetFloat() const { return m_value.m_float; }
+#if GM_COMPACT_VARIABLE
+  inline funk::v2 GetVec2() const;
+  inline funk::v3 GetVec3() const;
+#else //GM_COMPACT_VARIABLE
   inline funk::v2 GetVec2() const { return m_value.m_v2; }
   inline funk::v3 GetVec3() const { return m_value.m_v3; }
+#endif //GM_COMPACT_VARIABLE
 
 
   /// \brief AsString will get this gm variable as a string if possible.  AsString is used for the gm "print" and system.Exec function bindings.
@@ -154,6 +178,9 @@ struct gmVariable
 
   static inline gmuint Hash(const gmVariable &a_key)
   {
+#if GM_COMPACT_VARIABLE
+    if(a_key.IsVec2() || a_key.IsVec3()) return HashVec(a_key);
+#endif //GM_COMPACT_VARIABLE
     gmuint hash = (gmuint) a_key.m_value.m_ref;
     if(a_key.IsReference())
     {
@@ -166,11 +193,19 @@ struct gmVariable
   {
     if(a_keyA.m_type < a_keyB.m_type) return -1;
     if(a_keyA.m_type > a_keyB.m_type) return 1;
+#if GM_COMPACT_VARIABLE
+    if(a_keyA.IsVec2() || a_keyA.IsVec3()) return CompareVec(a_keyA, a_keyB);
+#endif //GM_COMPACT_VARIABLE
     if(a_keyA.m_value.m_int < a_keyB.m_value.m_int) return -1;
     if(a_keyA.m_value.m_int > a_keyB.m_value.m_int) return 1;
     return 0;
   }
 
+#if GM_COMPACT_VARIABLE
+  // vec keys are equal by value, as they were before boxing
+  static inline gmuint HashVec(const gmVariable &a_key);
+  static inline int CompareVec(const gmVariable &a_keyA, const gmVariable &a_keyB);
+#endif //GM_COMPACT_VARIABLE
 };
 
 
@@ -214,10 +249,73 @@ protected:
 };
 
 
+#if GM_COMPACT_VARIABLE
+
+/// \class gmVecObject
+/// \brief gmVecObject holds the value of a GM_VEC2 or GM_VEC3 variable when GM_COMPACT_VARIABLE is on.  It is never
+///        modified after allocation, an operation producing a vec allocates a new one, so variables may share it.
+class gmVecObject : public gmObject
+{
+public:
+
+  virtual int GetType() const { return m_type; }
+  virtual void Destruct(gmMachine * a_machine);
+
+  inline const gmVec3 &GetVec() const { return m_vec; }
+
+protected:
+
+  /// \brief Non-public constructor.  Create via gmMachine.
+  inline gmVecObject(gmType a_type, const gmVec3 &a_vec) : m_type(a_type), m_vec(a_vec) {}
+  friend class gmMachine;
+
+private:
+
+  gmType m_type;
+  gmVec3 m_vec; //!< z is 0 for GM_VEC2
+};
+
+#endif //GM_COMPACT_VARIABLE
+
+
 //
 // INLINE IMPLEMENTATION
 //
 
+#if GM_COMPACT_VARIABLE
+
+inline funk::v2 gmVariable::GetVec2() const
+{
+  const gmVec3 &vec = ((const gmVecObject *) m_value.m_ref)->GetVec();
+  return funk::v2(vec.x, vec.y);
+}
+
+inline funk::v3 gmVariable::GetVec3() const
+{
+  const gmVec3 &vec = ((const gmVecObject *) m_value.m_ref)->GetVec();
+  return funk::v3(vec.x, vec.y, vec.z);
+}
+
+inline gmuint gmVariable::HashVec(const gmVariable &a_key)
+{
+  // the x bits, as the unboxed key hashed
+  const gmVec3 &vec = ((const gmVecObject *) a_key.m_value.m_ref)->GetVec();
+  union { gmfloat m_float; gmuint32 m_bits; } x;
+  x.m_float = vec.x;
+  return (gmuint) x.m_bits;
+}
+
+inline int gmVariable::CompareVec(const gmVariable &a_keyA, const gmVariable &a_keyB)
+{
+  if(a_keyA.m_value.m_ref == a_keyB.m_value.m_ref) return 0;
+  const gmVec3 &vecA = ((const gmVecObject *) a_keyA.m_value.m_ref)->GetVec();
+  const gmVec3 &vecB = ((const gmVecObject *) a_keyB.m_value.m_ref)->GetVec();
+  const int count = (a_keyA.m_type == GM_VEC3) ? 3 : 2;
+  return memcmp(&vecA, &vecB, count * sizeof(gmfloat));
+}
+
+#endif //GM_COMPACT_VARIABLE
+
 
 inline void gmVariable::SetString(gmStringObject * a_string)
 {
@@ -8,6 +8,10 @@ rem generate compiler
 bin\bison -o gmParser.cpp -d -l -p gm gmParser.y  
 bin\flex -ogmScanner.cpp -Pgm -Sflex.skl gmScanner.l
 
+rem flex defines yyin, yyout, yylineno, yytext and the REJECT state itself, outside the skeleton.  flex.skl maps
+rem those names on to the compile's gmScanState, so drop flex's definitions.
+powershell -NoProfile -Command "(Get-Content gmScanner.cpp) | Where-Object { $_ -notmatch '^(extern )?(FILE \*yyin|int yylineno|char \*yytext)\b|^static (yy_state_type yy_state_buf|char \*yy_full_match|int yy_lp)\b' } | Set-Content gmScanner.cpp"
+
 rem Strip CR generated files
 bin\StripCR gmParser.cpp /nobak
 bin\StripCR gmScanner.cpp /nobak
@@ -23,7 +23,7 @@ void OutputGmTable( gmTableObject* table, gmUserArray* selectArr, int level, boo
 {
 	if( level >= selectArr->Size() ) return;
 
-	std::vector<gmVariable*> keys;
+	std::vector<gmVariable> keys;
 	gmSortTableKeys(table, keys);
 
 	const int charsPerTab = 2;
@@ -31,7 +31,7 @@ void OutputGmTable( gmTableObject* table, gmUserArray* selectArr, int level, boo
 
 	for( size_t i = 0; i < keys.size(); ++i )
 	{
-		gmVariable & key = *keys[i];
+		gmVariable & key = keys[i];
 		gmVariable val = table->Get(key);
 		int getLevelVal = selectArr->GetAt(level).GetInt();
 		bool selected = getLevelVal == i;
@@ -208,13 +208,12 @@ struct gmfImguiLib
 
 		// gather all strings
 		gmTableIterator it;
-		gmTableNode * childNode = table->GetFirst( it );
+		gmVariable key, value;
 		int i = 0;
-		while ( !table->IsNull(it) )
+		for( bool more = table->GetFirst( it, key, value ); more; more = table->GetNext( it, key, value ) )
 		{
-			selections[i] = childNode->m_value.GetCStringSafe();	
+			selections[i] = value.GetCStringSafe();	
 			++i;
-			childNode = table->GetNext(it);
 		}
 
 		a_thread->PushInt( Imgui::Select(selections, choice, numChoices) );
@@ -236,17 +235,16 @@ struct gmfImguiLib
 
 		// gather all strings
 		gmTableIterator it;
-		gmTableNode * childNode = table->GetFirst( it );
+		gmVariable key, value;
 		int i = 0;
-		while ( !table->IsNull(it) )
+		for( bool more = table->GetFirst( it, key, value ); more; more = table->GetNext( it, key, value ) )
 		{
-			selections[i] = childNode->m_key.GetCStringSafe();	
-			values[i] = childNode->m_value.GetIntSafe();	
+			selections[i] = key.GetCStringSafe();	
+			values[i] = value.GetIntSafe();	
 
 			if ( values[i] == choice ) index = i;
 
 			++i;
-			childNode = table->GetNext(it);
 		}
 
 		
@@ -0,0 +1,503 @@
+#include "FloatBuffer.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <xmmintrin.h>
+
+#include <gm/gmBind.h>
+
+namespace funk
+{
+// four samples at a time, unaligned loads so views of any memory work; they cost
+// the same as aligned ones on aligned storage
+
+static void AddSamples( float * dst, const float * src, int n )
+{
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) _mm_storeu_ps( dst + i, _mm_add_ps( _mm_loadu_ps( dst + i ), _mm_loadu_ps( src + i ) ) );
+	for( ; i < n; ++i ) dst[i] += src[i];
+}
+
+static void MulSamples( float * dst, const float * src, int n )
+{
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) _mm_storeu_ps( dst + i, _mm_mul_ps( _mm_loadu_ps( dst + i ), _mm_loadu_ps( src + i ) ) );
+	for( ; i < n; ++i ) dst[i] *= src[i];
+}
+
+static void ScaleSamples( float * dst, float scale, float offset, int n )
+{
+	const __m128 s = _mm_set1_ps( scale );
+	const __m128 o = _mm_set1_ps( offset );
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) _mm_storeu_ps( dst + i, _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( dst + i ), s ), o ) );
+	for( ; i < n; ++i ) dst[i] = dst[i] * scale + offset;
+}
+
+static void ClampSamples( float * dst, float lo, float hi, int n )
+{
+	const __m128 l = _mm_set1_ps( lo );
+	const __m128 h = _mm_set1_ps( hi );
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) _mm_storeu_ps( dst + i, _mm_min_ps( _mm_max_ps( _mm_loadu_ps( dst + i ), l ), h ) );
+	for( ; i < n; ++i ) dst[i] = dst[i] < lo ? lo : ( dst[i] > hi ? hi : dst[i] );
+}
+
+static float HorizontalSum( __m128 v )
+{
+	float lanes[4];
+	_mm_storeu_ps( lanes, v );
+	return ( lanes[0] + lanes[1] ) + ( lanes[2] + lanes[3] );
+}
+
+static float SumSamples( const float * src, int n )
+{
+	__m128 acc = _mm_setzero_ps();
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) acc = _mm_add_ps( acc, _mm_loadu_ps( src + i ) );
+	float result = HorizontalSum( acc );
+	for( ; i < n; ++i ) result += src[i];
+	return result;
+}
+
+static float DotSamples( const float * a, const float * b, int n )
+{
+	__m128 acc = _mm_setzero_ps();
+	int i = 0;
+	for( ; i + 4 <= n; i += 4 ) acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+	float result = HorizontalSum( acc );
+	for( ; i < n; ++i ) result += a[i] * b[i];
+	return result;
+}
+
+static float MinSamples( const float * src, int n )
+{
+	if ( n == 0 ) return 0.0f;
+
+	float result = src[0];
+	int i = 0;
+	if ( n >= 4 )
+	{
+		__m128 m = _mm_loadu_ps( src );
+		for( i = 4; i + 4 <= n; i += 4 ) m = _mm_min_ps( m, _mm_loadu_ps( src + i ) );
+		float lanes[4];
+		_mm_storeu_ps( lanes, m );
+		for( int j = 0; j < 4; ++j ) result = lanes[j] < result ? lanes[j] : result;
+	}
+	for( ; i < n; ++i ) result = src[i] < result ? src[i] : result;
+	return result;
+}
+
+static float MaxSamples( const float * src, int n )
+{
+	if ( n == 0 ) return 0.0f;
+
+	float result = src[0];
+	int i = 0;
+	if ( n >= 4 )
+	{
+		__m128 m = _mm_loadu_ps( src );
+		for( i = 4; i + 4 <= n; i += 4 ) m = _mm_max_ps( m, _mm_loadu_ps( src + i ) );
+		float lanes[4];
+		_mm_storeu_ps( lanes, m );
+		for( int j = 0; j < 4; ++j ) result = lanes[j] > result ? lanes[j] : result;
+	}
+	for( ; i < n; ++i ) result = src[i] > result ? src[i] : result;
+	return result;
+}
+
+FloatBuffer::FloatBuffer( int size ) : m_data(0), m_size(0), m_source(0)
+{
+	Resize( size );
+}
+
+FloatBuffer::FloatBuffer( Source * source ) : m_data(0), m_size(0), m_source(source)
+{;}
+
+FloatBuffer::~FloatBuffer()
+{
+	if ( m_source ) delete m_source;
+	else if ( m_data ) _aligned_free( m_data );
+}
+
+float * FloatBuffer::Data()
+{
+	if ( m_source ) m_data = m_source->GetData( m_size );
+	return m_data;
+}
+
+int FloatBuffer::Size()
+{
+	if ( m_source ) m_data = m_source->GetData( m_size );
+	return m_size;
+}
+
+bool FloatBuffer::Resize( int size )
+{
+	if ( m_source ) return false;
+	if ( size < 0 ) size = 0;
+	if ( size == m_size ) return true;
+
+	// keeps the samples that fit, zeroes the rest
+	float * data = size ? (float*)_aligned_malloc( size * sizeof(float), 16 ) : 0;
+	const int kept = size < m_size ? size : m_size;
+	if ( kept ) memcpy( data, m_data, kept * sizeof(float) );
+	if ( size > kept ) memset( data + kept, 0, ( size - kept ) * sizeof(float) );
+
+	if ( m_data ) _aligned_free( m_data );
+	m_data = data;
+	m_size = size;
+
+	return true;
+}
+
+float * FloatBuffer::Release( int & size )
+{
+	if ( m_source )
+	{
+		const float * src = Data();
+		float * copy = m_size ? (float*)_aligned_malloc( m_size * sizeof(float), 16 ) : 0;
+		if ( copy ) memcpy( copy, src, m_size * sizeof(float) );
+		size = m_size;
+		return copy;
+	}
+
+	float * data = m_data;
+	size = m_size;
+	m_data = 0;
+	m_size = 0;
+	return data;
+}
+
+void FloatBuffer::Adopt( float * data, int size )
+{
+	if ( m_source )
+	{
+		delete m_source;
+		m_source = 0;
+	}
+	else if ( m_data ) _aligned_free( m_data );
+
+	m_data = data;
+	m_size = data ? size : 0;
+}
+
+void FloatBuffer::Fill( float value )
+{
+	float * data = Data();
+	for( int i = 0; i < m_size; ++i ) data[i] = value;
+}
+
+void FloatBuffer::Scale( float scale, float offset )
+{
+	float * data = Data();
+	ScaleSamples( data, scale, offset, m_size );
+}
+
+void FloatBuffer::Clamp( float lo, float hi )
+{
+	float * data = Data();
+	ClampSamples( data, lo, hi, m_size );
+}
+
+float FloatBuffer::Sum()
+{
+	const float * data = Data();
+	return SumSamples( data, m_size );
+}
+
+float FloatBuffer::Min()
+{
+	const float * data = Data();
+	return MinSamples( data, m_size );
+}
+
+float FloatBuffer::Max()
+{
+	const float * data = Data();
+	return MaxSamples( data, m_size );
+}
+
+bool FloatBuffer::Add( FloatBuffer & src )
+{
+	if ( src.Size() != Size() ) return false;
+	AddSamples( Data(), src.Data(), m_size );
+	return true;
+}
+
+bool FloatBuffer::Mul( FloatBuffer & src )
+{
+	if ( src.Size() != Size() ) return false;
+	MulSamples( Data(), src.Data(), m_size );
+	return true;
+}
+
+bool FloatBuffer::Dot( FloatBuffer & src, float & result )
+{
+	if ( src.Size() != Size() ) return false;
+	result = DotSamples( Data(), src.Data(), m_size );
+	return true;
+}
+
+void FloatBuffer::CopyRange( FloatBuffer & src, int srcStart, int dstStart, int count )
+{
+	const int srcSize = src.Size();
+	const float * srcData = src.Data();
+	float * data = Data();
+
+	if ( srcStart < 0 ) { count += srcStart; dstStart -= srcStart; srcStart = 0; }
+	if ( dstStart < 0 ) { count += dstStart; srcStart -= dstStart; dstStart = 0; }
+	if ( count > srcSize - srcStart ) count = srcSize - srcStart;
+	if ( count > m_size - dstStart ) count = m_size - dstStart;
+	if ( count <= 0 ) return;
+
+	memmove( data + dstStart, srcData + srcStart, count * sizeof(float) );
+}
+
+void FloatBuffer::Resample( FloatBuffer & src )
+{
+	const int srcSize = src.Size();
+	const float * srcData = src.Data();
+	float * data = Data();
+
+	if ( m_size == 0 ) return;
+	if ( srcSize == 0 ) { Fill( 0.0f ); return; }
+	if ( srcSize == 1 || m_size == 1 ) { Fill( srcData[0] ); return; }
+
+	// a resampled copy of itself needs the source kept
+	FloatBuffer copy;
+	if ( srcData == data )
+	{
+		copy.Resize( srcSize );
+		memcpy( copy.m_data, srcData, srcSize * sizeof(float) );
+		srcData = copy.m_data;
+	}
+
+	// the ends map onto the ends
+	const float step = float( srcSize - 1 ) / float( m_size - 1 );
+	for( int i = 0; i < m_size - 1; ++i )
+	{
+		const float x = i * step;
+		const int x0 = (int)x;
+		const int x1 = x0 + 1 < srcSize ? x0 + 1 : x0;
+		const float t = x - x0;
+		data[i] = srcData[x0] + ( srcData[x1] - srcData[x0] ) * t;
+	}
+	data[m_size - 1] = srcData[srcSize - 1];
+}
+
+GM_REG_NAMESPACE(FloatBuffer)
+{
+	GM_MEMFUNC_CONSTRUCTOR(FloatBuffer)
+	{
+		GM_INT_PARAM( size, 0, 0 );
+		GM_PUSH_USER_HANDLED( FloatBuffer, new FloatBuffer(size) );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Size)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		a_thread->PushInt( ptr->Size() );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Resize)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_INT_PARAM( size, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		if ( !ptr->Resize(size) )
+		{
+			GM_EXCEPTION_MSG("can't resize a view of memory owned elsewhere");
+			return GM_EXCEPTION;
+		}
+
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(IsView)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		a_thread->PushInt( ptr->IsView() ? 1 : 0 );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Get)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_INT_PARAM( index, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		if ( index < 0 || index >= ptr->Size() )
+		{
+			GM_EXCEPTION_MSG("index %d out of range 0..%d", index, ptr->Size() - 1);
+			return GM_EXCEPTION;
+		}
+
+		a_thread->PushFloat( ptr->Data()[index] );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Set)
+	{
+		GM_CHECK_NUM_PARAMS(2);
+		GM_CHECK_INT_PARAM( index, 0 );
+		GM_CHECK_FLOAT_OR_INT_PARAM( value, 1 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		if ( index < 0 || index >= ptr->Size() )
+		{
+			GM_EXCEPTION_MSG("index %d out of range 0..%d", index, ptr->Size() - 1);
+			return GM_EXCEPTION;
+		}
+
+		ptr->Data()[index] = value;
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Fill)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_FLOAT_OR_INT_PARAM( value, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		ptr->Fill( value );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Scale)
+	{
+		GM_CHECK_FLOAT_OR_INT_PARAM( scale, 0 );
+		GM_FLOAT_OR_INT_PARAM( offset, 1, 0.0f );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		ptr->Scale( scale, offset );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Clamp)
+	{
+		GM_CHECK_NUM_PARAMS(2);
+		GM_CHECK_FLOAT_OR_INT_PARAM( lo, 0 );
+		GM_CHECK_FLOAT_OR_INT_PARAM( hi, 1 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		ptr->Clamp( lo, hi );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Sum)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		a_thread->PushFloat( ptr->Sum() );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Min)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		a_thread->PushFloat( ptr->Min() );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Max)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		a_thread->PushFloat( ptr->Max() );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Add)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_USER_PARAM_PTR( FloatBuffer, src, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		if ( !ptr->Add(*src) )
+		{
+			GM_EXCEPTION_MSG("sizes differ, %d and %d", ptr->Size(), src->Size());
+			return GM_EXCEPTION;
+		}
+
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Mul)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_USER_PARAM_PTR( FloatBuffer, src, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		if ( !ptr->Mul(*src) )
+		{
+			GM_EXCEPTION_MSG("sizes differ, %d and %d", ptr->Size(), src->Size());
+			return GM_EXCEPTION;
+		}
+
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Dot)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_USER_PARAM_PTR( FloatBuffer, src, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+
+		float result = 0.0f;
+		if ( !ptr->Dot(*src, result) )
+		{
+			GM_EXCEPTION_MSG("sizes differ, %d and %d", ptr->Size(), src->Size());
+			return GM_EXCEPTION;
+		}
+
+		a_thread->PushFloat( result );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Copy)
+	{
+		GM_CHECK_USER_PARAM_PTR( FloatBuffer, src, 0 );
+		GM_INT_PARAM( srcStart, 1, 0 );
+		GM_INT_PARAM( dstStart, 2, 0 );
+		GM_INT_PARAM( count, 3, src->Size() );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		ptr->CopyRange( *src, srcStart, dstStart, count );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Resample)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_CHECK_USER_PARAM_PTR( FloatBuffer, src, 0 );
+		GM_GET_THIS_PTR(FloatBuffer, ptr);
+		ptr->Resample( *src );
+		return GM_OK;
+	}
+}
+
+GM_REG_MEM_BEGIN(FloatBuffer)
+GM_REG_MEMFUNC( FloatBuffer, Size )
+GM_REG_MEMFUNC( FloatBuffer, Resize )
+GM_REG_MEMFUNC( FloatBuffer, IsView )
+GM_REG_MEMFUNC( FloatBuffer, Get )
+GM_REG_MEMFUNC( FloatBuffer, Set )
+GM_REG_MEMFUNC( FloatBuffer, Fill )
+GM_REG_MEMFUNC( FloatBuffer, Scale )
+GM_REG_MEMFUNC( FloatBuffer, Clamp )
+GM_REG_MEMFUNC( FloatBuffer, Sum )
+GM_REG_MEMFUNC( FloatBuffer, Min )
+GM_REG_MEMFUNC( FloatBuffer, Max )
+GM_REG_MEMFUNC( FloatBuffer, Add )
+GM_REG_MEMFUNC( FloatBuffer, Mul )
+GM_REG_MEMFUNC( FloatBuffer, Dot )
+GM_REG_MEMFUNC( FloatBuffer, Copy )
+GM_REG_MEMFUNC( FloatBuffer, Resample )
+GM_REG_HANDLED_DESTRUCTORS(FloatBuffer)
+GM_REG_MEM_END()
+GM_BIND_DEFINE(FloatBuffer)
+
+}
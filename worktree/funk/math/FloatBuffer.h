@@ -0,0 +1,71 @@
+#ifndef _INCLUDE_FLOAT_BUFFER_H_
+#define _INCLUDE_FLOAT_BUFFER_H_
+
+#include <gm/gmBindHeader.h>
+#include <common/HandledObj.h>
+
+namespace funk
+{
+	// contiguous float32 samples for scripts, the bulk ops run natively so the
+	// interpreter never touches each sample. owns 16-byte aligned storage, or
+	// views memory owned elsewhere (audio channels, image planes) without copying
+	class FloatBuffer : public HandledObj<FloatBuffer>
+	{
+	public:
+
+		// memory owned elsewhere, looked up on every use since the owner may resize or move it
+		class Source
+		{
+		public:
+			virtual ~Source() {;}
+			virtual float * GetData( int & size ) = 0;
+		};
+
+		FloatBuffer( int size = 0 );
+		FloatBuffer( Source * source );	// takes ownership of source
+		~FloatBuffer();
+
+		GM_BIND_TYPEID(FloatBuffer);
+
+		float *	Data();
+		int		Size();
+		bool	IsView() const { return m_source != 0; }
+
+		// views can't be resized, returns false
+		bool	Resize( int size );
+
+		// hands the samples to the caller, who frees them with _aligned_free, and leaves
+		// this buffer empty. a view hands over a copy and keeps viewing
+		float *	Release( int & size );
+		// takes ownership of samples from Release, replacing the current ones
+		void	Adopt( float * data, int size );
+
+		void	Fill( float value );
+		void	Scale( float scale, float offset = 0.0f );
+		void	Clamp( float lo, float hi );
+		float	Sum();
+		float	Min();
+		float	Max();
+
+		// the sizes must match, returns false otherwise
+		bool	Add( FloatBuffer & src );
+		bool	Mul( FloatBuffer & src );
+		bool	Dot( FloatBuffer & src, float & result );
+
+		// copies count samples, the ranges are clipped to both buffers, src may be this buffer
+		void	CopyRange( FloatBuffer & src, int srcStart, int dstStart, int count );
+
+		// linear interpolation of src over the whole of this buffer
+		void	Resample( FloatBuffer & src );
+
+	private:
+
+		float *		m_data;
+		int			m_size;
+		Source *	m_source;
+	};
+
+	GM_BIND_DECL(FloatBuffer);
+}
+
+#endif
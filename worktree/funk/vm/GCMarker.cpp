@@ -0,0 +1,87 @@
+#include "GCMarker.h"
+
+#include <common/Timer.h>
+
+#include <gm/gmMachine.h>
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+namespace funk
+{
+GCMarker::GCMarker( gmMachine * vm )
+	: m_vm(vm), m_workPerChunk(0), m_markMs(0.0f), m_marking(false), m_busy(false), m_quit(false)
+{
+	m_mutex = SDL_CreateMutex();
+	m_cond = SDL_CreateCond();
+	m_thread = SDL_CreateThread( Worker, this );
+	m_vm->SetConcurrentMark( true );
+}
+
+GCMarker::~GCMarker()
+{
+	SDL_LockMutex( m_mutex );
+	m_quit = true;
+	m_marking = false;
+	SDL_CondBroadcast( m_cond );
+	SDL_UnlockMutex( m_mutex );
+
+	SDL_WaitThread( m_thread, NULL );
+	SDL_DestroyCond( m_cond );
+	SDL_DestroyMutex( m_mutex );
+
+	m_vm->SetConcurrentMark( false );
+}
+
+void GCMarker::Begin()
+{
+	SDL_LockMutex( m_mutex );
+	m_markMs = 0.0f;
+	m_workPerChunk = m_vm->GetGC()->GetWorkPerIncrement();
+	m_marking = m_vm->GetGC()->IsTracing();
+	if ( m_marking ) SDL_CondBroadcast( m_cond );
+	SDL_UnlockMutex( m_mutex );
+}
+
+void GCMarker::Sync()
+{
+	SDL_LockMutex( m_mutex );
+	m_marking = false;
+	while ( m_busy ) SDL_CondWait( m_cond, m_mutex );
+	SDL_UnlockMutex( m_mutex );
+}
+
+int GCMarker::Worker( void * data )
+{
+	((GCMarker *)data)->Run();
+	return 0;
+}
+
+void GCMarker::Run()
+{
+	SDL_LockMutex( m_mutex );
+
+	while ( true )
+	{
+		while ( !m_marking && !m_quit ) SDL_CondWait( m_cond, m_mutex );
+		if ( m_quit ) break;
+
+		// work a chunk at a time so Sync never waits long
+		m_busy = true;
+		SDL_UnlockMutex( m_mutex );
+
+		Timer timer;
+		bool graysLeft = m_vm->GetGC()->MarkSome( m_workPerChunk );
+		float ms = timer.GetTimeMs();
+
+		SDL_LockMutex( m_mutex );
+		m_busy = false;
+		m_markMs += ms;
+		if ( !graysLeft ) m_marking = false;
+		SDL_CondBroadcast( m_cond );
+	}
+
+	SDL_UnlockMutex( m_mutex );
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef _INCLUDE_GC_MARKER_H
+#define _INCLUDE_GC_MARKER_H
+
+class gmMachine;
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace funk
+{
+	// Blackens the garbage collector's grays on a thread of its own while the machine is
+	// idle, see gmMachine::SetConcurrentMark. Marks a chunk of work at a time so Sync
+	// never waits long for the machine back.
+	class GCMarker
+	{
+	public:
+		GCMarker( gmMachine * vm );
+		~GCMarker();
+
+		// the machine is not used until Sync, mark meanwhile
+		void Begin();
+
+		// stops marking, returns once the marking thread no longer touches the machine
+		void Sync();
+
+		// time spent marking between the last Begin and Sync
+		float GetMarkMs() const { return m_markMs; }
+
+	private:
+		static int Worker( void * data );
+		void Run();
+
+		gmMachine * m_vm;
+		SDL_Thread * m_thread;
+		SDL_mutex * m_mutex;
+		SDL_cond * m_cond;
+		int m_workPerChunk;
+		float m_markMs;
+		bool m_marking;	// grays are left and the machine is idle
+		bool m_busy;	// the marking thread is in the garbage collector
+		bool m_quit;
+	};
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "GCPacer.h"
+
+#include <common/Timer.h>
+#include <math/Util.h>
+
+#include <gm/gmMachine.h>
+
+namespace funk
+{
+const float kSmoothing = 0.1f;		// weight of a new sample in the running averages
+const float kBudgetPlanned = 0.5f;	// cycles are planned on this much of the budget, the rest is for catching up
+const float kStartMargin = 1.25f;	// start collecting this much earlier than the estimate
+const int kMinWorkPerIncrement = 50;
+
+GCPacer::GCPacer()
+{
+	m_vm = NULL;
+	m_budgetMs = 1.0f;
+	m_memTarget = 0;
+	m_destructRatio = 1.0f;
+	m_allocRate = 0.0f;
+	m_msPerWork = 0.0f;
+	m_cycleWork = 0.0f;
+	m_curCycleWork = 0.0f;
+	m_memAfter = 0;
+	m_workPerIncrement = 0;
+	m_budgetWork = 0;
+	m_memStart = 0;
+}
+
+void GCPacer::Init( gmMachine * vm, float budgetMs, int memTarget )
+{
+	m_vm = vm;
+	m_budgetMs = budgetMs;
+	m_memTarget = memTarget;
+
+	// the static settings are the first guess
+	m_workPerIncrement = vm->GetGC()->GetWorkPerIncrement();
+	m_budgetWork = m_workPerIncrement;
+	m_destructRatio = (float)vm->GetGC()->GetDestructPerIncrement() / (float)max( m_workPerIncrement, 1 );
+
+	m_allocRate = 0.0f;
+	m_msPerWork = 0.0f;
+	m_cycleWork = 0.0f;
+	m_curCycleWork = 0.0f;
+	m_memAfter = vm->GetCurrentMemoryUsage();
+	m_memStart = memTarget;
+}
+
+float GCPacer::Collect()
+{
+	gmGarbageCollector * gc = m_vm->GetGC();
+
+	// only collecting frees memory, so growth since the last collect is what the scripts allocated
+	const int allocated = max( m_vm->GetCurrentMemoryUsage() - m_memAfter, 0 );
+	m_allocRate += ( allocated - m_allocRate ) * kSmoothing;
+
+	const gmuint32 workBefore = gc->GetStatsWorkDone();
+	const int incBefore = m_vm->GetStatsGCNumIncCollects();
+	const int fullBefore = m_vm->GetStatsGCNumFullCollects();
+	const int minorBefore = m_vm->GetStatsGCNumMinorCollects();
+
+	Timer timer;
+	m_vm->CollectGarbage();
+	const float ms = timer.GetTimeMs();
+
+	const int work = (int)( gc->GetStatsWorkDone() - workBefore );
+	const bool fullCollect = m_vm->GetStatsGCNumFullCollects() != fullBefore;
+	const bool minorCollect = m_vm->GetStatsGCNumMinorCollects() != minorBefore;
+
+	// root scans and minor collects are not counted as work, so leave their frames out of the cost
+	if ( work > 0 && !fullCollect && !minorCollect )
+	{
+		const float msPerWork = ms / work;
+		m_msPerWork = m_msPerWork > 0.0f ? m_msPerWork + ( msPerWork - m_msPerWork ) * kSmoothing : msPerWork;
+	}
+
+	m_curCycleWork += work;
+	if ( fullCollect )
+	{
+		m_curCycleWork = 0.0f;
+	}
+	else if ( m_vm->GetStatsGCNumIncCollects() != incBefore )
+	{
+		m_cycleWork = m_cycleWork > 0.0f ? ( m_cycleWork + m_curCycleWork ) * 0.5f : m_curCycleWork;
+		m_curCycleWork = 0.0f;
+	}
+
+	m_memAfter = m_vm->GetCurrentMemoryUsage();
+
+	Pace( !gc->IsOff() );
+
+	return ms;
+}
+
+void GCPacer::Pace( bool collecting )
+{
+	gmGarbageCollector * gc = m_vm->GetGC();
+
+	// most work a frame can afford
+	if ( m_msPerWork > 0.0f ) m_budgetWork = (int)( m_budgetMs / m_msPerWork );
+	m_budgetWork = max( m_budgetWork, kMinWorkPerIncrement );
+
+	const int plannedWork = max( (int)( m_budgetWork * kBudgetPlanned ), kMinWorkPerIncrement );
+	const float allocRate = max( m_allocRate, 1.0f );
+
+	if ( collecting )
+	{
+		if ( m_memAfter >= m_memTarget )
+		{
+			// over the target, catch up as fast as the budget allows
+			m_workPerIncrement = m_budgetWork;
+		}
+		else if ( m_cycleWork > 0.0f )
+		{
+			// finish the rest of the cycle before the heap grows to the target, it may take longer than last time
+			const float framesLeft = max( ( m_memTarget - m_memAfter ) / allocRate, 1.0f );
+			const float workLeft = max( m_cycleWork - m_curCycleWork, m_cycleWork * 0.1f );
+			m_workPerIncrement = clamp( (int)( workLeft / framesLeft ), kMinWorkPerIncrement, m_budgetWork );
+		}
+		else
+		{
+			m_workPerIncrement = plannedWork;
+		}
+	}
+	else
+	{
+		// start the next cycle early enough to finish it at the target
+		const float cycleFrames = m_cycleWork / plannedWork;
+		m_memStart = (int)( m_memTarget - allocRate * cycleFrames * kStartMargin );
+		m_memStart = clamp( m_memStart, m_memTarget / 4, m_memTarget );
+		m_workPerIncrement = plannedWork;
+	}
+
+	gc->SetWorkPerIncrement( m_workPerIncrement );
+	gc->SetDestructPerIncrement( max( (int)( m_workPerIncrement * m_destructRatio ), 1 ) );
+	m_vm->SetDesiredByteMemoryUsageSoft( min( m_memStart, m_vm->GetDesiredByteMemoryUsageHard() ) );
+}
+
+}
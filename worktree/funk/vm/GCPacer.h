@@ -0,0 +1,54 @@
+#ifndef _INCLUDE_GC_PACER_H
+#define _INCLUDE_GC_PACER_H
+
+class gmMachine;
+
+namespace funk
+{
+	// Runs the garbage collector each frame and sets its work per increment from measured
+	// allocation rate and collection cost, to stay inside a frame budget while the heap
+	// stays under a memory target. Starts collection early enough for the cycle to end
+	// at the target, by lowering the machine's soft limit.
+	class GCPacer
+	{
+	public:
+		GCPacer();
+
+		void Init( gmMachine * vm, float budgetMs, int memTarget );
+
+		// collects garbage for this frame and paces the next, returns ms spent collecting
+		float Collect();
+
+		void SetBudgetMs( float budgetMs ) { m_budgetMs = budgetMs; }
+		float GetBudgetMs() const { return m_budgetMs; }
+
+		void SetMemTarget( int memTarget ) { m_memTarget = memTarget; }
+		int GetMemTarget() const { return m_memTarget; }
+
+		float GetAllocRate() const { return m_allocRate; }		// bytes allocated per frame
+		float GetMsPerWork() const { return m_msPerWork; }		// collection cost per unit of work
+		int GetCycleWork() const { return (int)m_cycleWork; }	// work a full cycle took last time
+		int GetWorkPerIncrement() const { return m_workPerIncrement; }
+		int GetBudgetWork() const { return m_budgetWork; }		// most work per increment the budget allows
+		int GetMemStart() const { return m_memStart; }		// soft limit collection starts at
+
+	private:
+		void Pace( bool collecting );
+
+		gmMachine * m_vm;
+		float m_budgetMs;
+		int m_memTarget;
+		float m_destructRatio;	// destructs per unit of work, from the initial settings
+
+		float m_allocRate;
+		float m_msPerWork;
+		float m_cycleWork;
+		float m_curCycleWork;	// work done so far this cycle
+		int m_memAfter;			// memory after the last collect
+		int m_workPerIncrement;
+		int m_budgetWork;
+		int m_memStart;
+	};
+}
+
+#endif
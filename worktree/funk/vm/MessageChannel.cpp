@@ -0,0 +1,471 @@
+#include "MessageChannel.h"
+
+#include <string.h>
+#include <malloc.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gm/gmBind.h>
+#include <gm/gmMachine.h>
+#include <gm/gmThread.h>
+#include <gm/gmStreamBuffer.h>
+#include <math/v2.h>
+#include <math/v3.h>
+#include <math/FloatBuffer.h>
+
+#include <SDL_mutex.h>
+
+namespace funk
+{
+// tables nested deeper are refused
+static const int kMaxDepth = 32;
+
+enum MessageTag
+{
+	TAG_NULL,
+	TAG_INT,
+	TAG_FLOAT,
+	TAG_VEC2,
+	TAG_VEC3,
+	TAG_STRING,
+	TAG_TABLE,
+	TAG_TABLEREF,	// a table sent earlier in the same message
+	TAG_FLOATBUFFER,
+};
+
+// the tables of one value being encoded, each is sent once and referred to after
+struct EncodeTables
+{
+	std::vector<const gmTableObject*> sent;
+	std::vector<const gmTableObject*> path;	// the table being encoded and those it is in
+};
+
+struct MessageSamples
+{
+	float * data;	// _aligned_malloc'd, NULL once adopted by a FloatBuffer
+	int size;
+	gmUserObject * received;	// the buffer rebuilt from them, for a buffer sent more than once
+};
+
+// a value encoded by the sending machine, the samples of its FloatBuffers ride
+// alongside so moving them is a pointer hand-over
+struct Message
+{
+	gmStreamBufferDynamic data;
+	std::vector<MessageSamples> samples;
+
+	~Message()
+	{
+		for( size_t i = 0; i < samples.size(); ++i )
+		{
+			if ( samples[i].data ) _aligned_free( samples[i].data );
+		}
+	}
+};
+
+struct MessageQueue
+{
+	std::string name;
+	int capacity;
+	std::deque<Message*> messages;
+	SDL_mutex * mutex;
+};
+
+// queues by name, they outlive the channels so a message can be sent before the
+// receiver opens its end
+static SDL_mutex * s_queuesMutex = SDL_CreateMutex();
+static std::map<std::string, MessageQueue*> s_queues;
+
+static MessageChannel::SendResult Encode( Message & msg, std::vector<FloatBuffer*> & buffers, EncodeTables & tables, const gmVariable & value )
+{
+	gmStream & stream = msg.data;
+
+	switch( value.m_type )
+	{
+	case GM_NULL:
+		stream << (gmuint8)TAG_NULL;
+		return MessageChannel::SENT;
+
+	case GM_INT:
+		stream << (gmuint8)TAG_INT << value.m_value.m_int;
+		return MessageChannel::SENT;
+
+	case GM_FLOAT:
+		stream << (gmuint8)TAG_FLOAT << value.m_value.m_float;
+		return MessageChannel::SENT;
+
+	case GM_VEC2:
+		{
+			const v2 vec = value.GetVec2();
+			stream << (gmuint8)TAG_VEC2 << vec.x << vec.y;
+			return MessageChannel::SENT;
+		}
+
+	case GM_VEC3:
+		{
+			const v3 vec = value.GetVec3();
+			stream << (gmuint8)TAG_VEC3 << vec.x << vec.y << vec.z;
+			return MessageChannel::SENT;
+		}
+
+	case GM_STRING:
+		{
+			const gmStringObject * str = value.GetStringObjectSafe();
+			const int length = str->GetLength();
+			stream << (gmuint8)TAG_STRING << length;
+			stream.Write( str->GetString(), length );
+			return MessageChannel::SENT;
+		}
+
+	case GM_TABLE:
+		{
+			const gmTableObject * table = value.GetTableObjectSafe();
+
+			// a table holding itself, directly or through others, has no end to send
+			if ( std::find( tables.path.begin(), tables.path.end(), table ) != tables.path.end() ) return MessageChannel::CYCLE;
+			if ( (int)tables.path.size() >= kMaxDepth ) return MessageChannel::UNSUPPORTED;
+
+			// a table found again is sent once and received as the one table
+			std::vector<const gmTableObject*>::iterator sent = std::find( tables.sent.begin(), tables.sent.end(), table );
+			if ( sent != tables.sent.end() )
+			{
+				stream << (gmuint8)TAG_TABLEREF << (int)(sent - tables.sent.begin());
+				return MessageChannel::SENT;
+			}
+
+			tables.sent.push_back( table );
+			tables.path.push_back( table );
+			stream << (gmuint8)TAG_TABLE << table->Count();
+
+			gmTableIterator it;
+			gmVariable key, item;
+			for( bool more = table->GetFirst( it, key, item ); more; more = table->GetNext( it, key, item ) )
+			{
+				MessageChannel::SendResult result = Encode( msg, buffers, tables, key );
+				if ( result == MessageChannel::SENT ) result = Encode( msg, buffers, tables, item );
+				if ( result != MessageChannel::SENT ) return result;
+			}
+
+			tables.path.pop_back();
+			return MessageChannel::SENT;
+		}
+
+	default:
+		if ( value.m_type == GM_TYPEID(FloatBuffer) )
+		{
+			// the samples are taken once the whole value is known to encode, a buffer
+			// found twice is sent once and received as the one buffer
+			FloatBuffer * buffer = (FloatBuffer*)value.GetUserSafe( GM_TYPEID(FloatBuffer) );
+			int index = 0;
+			while( index < (int)buffers.size() && buffers[index] != buffer ) ++index;
+			if ( index == (int)buffers.size() ) buffers.push_back( buffer );
+
+			stream << (gmuint8)TAG_FLOATBUFFER << index;
+			return MessageChannel::SENT;
+		}
+		return MessageChannel::UNSUPPORTED;
+	}
+}
+
+static void Decode( gmMachine * vm, Message & msg, std::vector<gmTableObject*> & tables, gmVariable & value )
+{
+	gmStream & stream = msg.data;
+
+	gmuint8 tag = TAG_NULL;
+	stream >> tag;
+
+	switch( tag )
+	{
+	case TAG_INT:
+		{
+			int i;
+			stream >> i;
+			value.SetInt( i );
+			return;
+		}
+
+	case TAG_FLOAT:
+		{
+			float f;
+			stream >> f;
+			value.SetFloat( f );
+			return;
+		}
+
+	case TAG_VEC2:
+		{
+			float x, y;
+			stream >> x >> y;
+			value.SetVec2( vm, v2( x, y ) );
+			return;
+		}
+
+	case TAG_VEC3:
+		{
+			float x, y, z;
+			stream >> x >> y >> z;
+			value.SetVec3( vm, v3( x, y, z ) );
+			return;
+		}
+
+	case TAG_STRING:
+		{
+			int length;
+			stream >> length;
+			const unsigned int pos = msg.data.Tell();
+			value.SetString( vm->AllocStringObject( msg.data.GetData() + pos, length ) );
+			msg.data.Seek( pos + length );
+			return;
+		}
+
+	case TAG_TABLE:
+		{
+			int count;
+			stream >> count;
+
+			// nothing collects until the machine next runs, the new objects are safe unrooted
+			gmTableObject * table = vm->AllocTableObject();
+			tables.push_back( table );
+			for( int i = 0; i < count; ++i )
+			{
+				gmVariable key, item;
+				Decode( vm, msg, tables, key );
+				Decode( vm, msg, tables, item );
+				table->Set( vm, key, item );
+			}
+			value.SetTable( table );
+			return;
+		}
+
+	case TAG_TABLEREF:
+		{
+			int index;
+			stream >> index;
+			value.SetTable( tables[index] );
+			return;
+		}
+
+	case TAG_FLOATBUFFER:
+		{
+			int index;
+			stream >> index;
+
+			MessageSamples & samples = msg.samples[index];
+			if ( !samples.received )
+			{
+				FloatBuffer * buffer = new FloatBuffer();
+				buffer->Adopt( samples.data, samples.size );
+				samples.data = 0;
+				buffer->AddRef();
+				samples.received = vm->AllocUserObject( buffer, GM_TYPEID(FloatBuffer) );
+			}
+			value.SetUser( samples.received );
+			return;
+		}
+
+	default:
+		value.Nullify();
+		return;
+	}
+}
+
+MessageChannel::MessageChannel( const char * name, int capacity )
+{
+	SDL_LockMutex( s_queuesMutex );
+
+	MessageQueue *& queue = s_queues[name];
+	if ( !queue )
+	{
+		queue = new MessageQueue;
+		queue->name = name;
+		queue->capacity = capacity > 0 ? capacity : 0;
+		queue->mutex = SDL_CreateMutex();
+	}
+	m_queue = queue;
+
+	SDL_UnlockMutex( s_queuesMutex );
+}
+
+MessageChannel::~MessageChannel()
+{;}
+
+MessageChannel::SendResult MessageChannel::Send( const gmVariable & value, bool move )
+{
+	Message * msg = new Message;
+	std::vector<FloatBuffer*> buffers;
+	EncodeTables tables;
+
+	const SendResult result = Encode( *msg, buffers, tables, value );
+	if ( result != SENT )
+	{
+		delete msg;
+		return result;
+	}
+
+	for( size_t i = 0; i < buffers.size(); ++i )
+	{
+		MessageSamples samples;
+		samples.received = 0;
+		if ( move )
+		{
+			samples.data = buffers[i]->Release( samples.size );
+		}
+		else
+		{
+			samples.size = buffers[i]->Size();
+			samples.data = samples.size ? (float*)_aligned_malloc( samples.size * sizeof(float), 16 ) : 0;
+			if ( samples.data ) memcpy( samples.data, buffers[i]->Data(), samples.size * sizeof(float) );
+		}
+		msg->samples.push_back( samples );
+	}
+
+	SDL_LockMutex( m_queue->mutex );
+	const bool full = m_queue->capacity > 0 && (int)m_queue->messages.size() >= m_queue->capacity;
+	if ( !full ) m_queue->messages.push_back( msg );
+	SDL_UnlockMutex( m_queue->mutex );
+
+	if ( full )
+	{
+		// moved samples go back where they came from, views handed over a copy
+		for( size_t i = 0; move && i < buffers.size(); ++i )
+		{
+			if ( buffers[i]->IsView() ) continue;
+			buffers[i]->Adopt( msg->samples[i].data, msg->samples[i].size );
+			msg->samples[i].data = 0;
+		}
+		delete msg;
+		return FULL;
+	}
+
+	return SENT;
+}
+
+bool MessageChannel::Receive( gmMachine * vm, gmVariable & value )
+{
+	SDL_LockMutex( m_queue->mutex );
+	Message * msg = 0;
+	if ( !m_queue->messages.empty() )
+	{
+		msg = m_queue->messages.front();
+		m_queue->messages.pop_front();
+	}
+	SDL_UnlockMutex( m_queue->mutex );
+
+	if ( !msg ) return false;
+
+	std::vector<gmTableObject*> tables;
+	msg->data.Seek( 0 );
+	Decode( vm, *msg, tables, value );
+	delete msg;
+
+	return true;
+}
+
+int MessageChannel::Count()
+{
+	SDL_LockMutex( m_queue->mutex );
+	const int count = (int)m_queue->messages.size();
+	SDL_UnlockMutex( m_queue->mutex );
+
+	return count;
+}
+
+const char * MessageChannel::Name() const
+{
+	return m_queue->name.c_str();
+}
+
+void MessageChannel::CloseAll()
+{
+	SDL_LockMutex( s_queuesMutex );
+
+	for( std::map<std::string, MessageQueue*>::iterator it = s_queues.begin(); it != s_queues.end(); ++it )
+	{
+		MessageQueue * queue = it->second;
+		for( size_t i = 0; i < queue->messages.size(); ++i ) delete queue->messages[i];
+		SDL_DestroyMutex( queue->mutex );
+		delete queue;
+	}
+	s_queues.clear();
+
+	SDL_UnlockMutex( s_queuesMutex );
+}
+
+GM_REG_NAMESPACE(MessageChannel)
+{
+	GM_MEMFUNC_CONSTRUCTOR(MessageChannel)
+	{
+		GM_CHECK_STRING_PARAM( name, 0 );
+		GM_INT_PARAM( capacity, 1, 0 );
+		GM_PUSH_USER_HANDLED( MessageChannel, new MessageChannel(name, capacity) );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Send)
+	{
+		GM_CHECK_NUM_PARAMS(1);
+		GM_INT_PARAM( move, 1, 0 );
+		GM_GET_THIS_PTR(MessageChannel, ptr);
+
+		switch( ptr->Send( a_thread->Param(0), move != 0 ) )
+		{
+		case MessageChannel::SENT:
+			a_thread->PushInt( 1 );
+			return GM_OK;
+
+		case MessageChannel::FULL:
+			a_thread->PushInt( 0 );
+			return GM_OK;
+
+		case MessageChannel::CYCLE:
+			GM_EXCEPTION_MSG("'%s' can't send a table that holds itself, directly or through the tables in it", ptr->Name());
+			return GM_EXCEPTION;
+
+		default:
+			GM_EXCEPTION_MSG("'%s' sends null, int, float, v2, v3, string, FloatBuffer and tables of those nested at most %d deep", ptr->Name(), kMaxDepth);
+			return GM_EXCEPTION;
+		}
+	}
+
+	GM_MEMFUNC_DECL(Receive)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(MessageChannel, ptr);
+
+		gmVariable value;
+		if ( ptr->Receive( a_thread->GetMachine(), value ) ) a_thread->Push( value );
+		else a_thread->PushNull();
+
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Count)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(MessageChannel, ptr);
+		a_thread->PushInt( ptr->Count() );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Name)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(MessageChannel, ptr);
+		a_thread->PushNewString( ptr->Name() );
+		return GM_OK;
+	}
+}
+
+GM_REG_MEM_BEGIN(MessageChannel)
+GM_REG_MEMFUNC( MessageChannel, Send )
+GM_REG_MEMFUNC( MessageChannel, Receive )
+GM_REG_MEMFUNC( MessageChannel, Count )
+GM_REG_MEMFUNC( MessageChannel, Name )
+GM_REG_HANDLED_DESTRUCTORS(MessageChannel)
+GM_REG_MEM_END()
+GM_BIND_DEFINE(MessageChannel)
+
+}
@@ -0,0 +1,48 @@
+#ifndef _INCLUDE_MESSAGE_CHANNEL_H_
+#define _INCLUDE_MESSAGE_CHANNEL_H_
+
+#include <gm/gmBindHeader.h>
+#include <common/HandledObj.h>
+
+class gmMachine;
+class gmVariable;
+
+namespace funk
+{
+	struct MessageQueue;
+
+	// a named queue between machines on different threads, every machine opening
+	// the same name shares the queue. values are encoded on send and rebuilt in the
+	// receiving machine, no object is shared: null, int, float, v2, v3, strings,
+	// tables of those and FloatBuffers, whose samples can be moved instead of copied.
+	// a table or buffer found twice in a value arrives as one, a table holding itself is refused
+	class MessageChannel : public HandledObj<MessageChannel>
+	{
+	public:
+
+		// the capacity of the first open wins, 0 is unbounded
+		MessageChannel( const char * name, int capacity = 0 );
+		~MessageChannel();
+
+		GM_BIND_TYPEID(MessageChannel);
+
+		enum SendResult { SENT, FULL, UNSUPPORTED, CYCLE };
+
+		// move hands FloatBuffer samples over, leaving the sender's buffers empty
+		SendResult	Send( const gmVariable & value, bool move );
+		bool		Receive( gmMachine * vm, gmVariable & value );
+		int			Count();
+		const char *Name() const;
+
+		// frees every queue and the messages left in them, once no machine has a channel open
+		static void	CloseAll();
+
+	private:
+
+		MessageQueue * m_queue;
+	};
+
+	GM_BIND_DECL(MessageChannel);
+}
+
+#endif
@@ -0,0 +1,214 @@
+#include "ScriptWorker.h"
+
+#include <algorithm>
+
+#include <gm/gmBind.h>
+#include <gm/gmMachine.h>
+#include <gm/gmThread.h>
+#include <gm/gmStreamBuffer.h>
+#include <common/ResourcePath.h>
+#include <common/Timer.h>
+#include <common/Util.h>
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <SDL_timer.h>
+
+#include "VirtualConsole.h"
+#include "VirtualMachineLibs.h"
+
+namespace funk
+{
+std::vector<ScriptWorker*> ScriptWorker::s_workers;
+
+ScriptWorker::ScriptWorker( const char * file, int hz )
+	: m_file(file), m_periodMs(hz > 0 ? 1000 / hz : 16), m_quit(false), m_running(true), m_updateMs(0.0f)
+{
+	if ( m_periodMs < 1 ) m_periodMs = 1;
+
+	// made and registered here on the main thread, binding writes the user type ids that
+	// every machine shares. they come out the same as every other machine's, so channels agree
+	m_vm = new gmMachine();
+	RegisterCoreLibs( m_vm );
+
+	m_vm->GetGlobals()->Set( m_vm, "g_dt", gmVariable(m_periodMs / 1000.0f) );
+	m_vm->GetGlobals()->Set( m_vm, "g_resourcePathPrefix", gmVariable(m_vm->AllocStringObject(RESOURCE_PATH(""))) );
+
+	s_workers.push_back( this );
+
+	m_mutex = SDL_CreateMutex();
+	m_thread = SDL_CreateThread( Worker, this );
+}
+
+ScriptWorker::~ScriptWorker()
+{
+	Stop();
+	SDL_WaitThread( m_thread, NULL );
+	SDL_DestroyMutex( m_mutex );
+
+	s_workers.erase( std::find( s_workers.begin(), s_workers.end(), this ) );
+}
+
+bool ScriptWorker::IsRunning()
+{
+	SDL_LockMutex( m_mutex );
+	const bool running = m_running;
+	SDL_UnlockMutex( m_mutex );
+
+	return running;
+}
+
+void ScriptWorker::Stop()
+{
+	SDL_LockMutex( m_mutex );
+	m_quit = true;
+	SDL_UnlockMutex( m_mutex );
+}
+
+float ScriptWorker::UpdateMs()
+{
+	SDL_LockMutex( m_mutex );
+	const float ms = m_updateMs;
+	SDL_UnlockMutex( m_mutex );
+
+	return ms;
+}
+
+void ScriptWorker::LogErrors( VirtualConsole & console )
+{
+	for( size_t i = 0; i < s_workers.size(); ++i )
+	{
+		ScriptWorker * worker = s_workers[i];
+
+		std::vector<std::string> errors;
+		SDL_LockMutex( worker->m_mutex );
+		errors.swap( worker->m_errors );
+		SDL_UnlockMutex( worker->m_mutex );
+
+		if ( errors.empty() ) continue;
+
+		console.Log("#############################\n[GameMonkey Worker Error]:", false);
+		console.Log(worker->File());
+		for( size_t j = 0; j < errors.size(); ++j ) console.Log( errors[j].c_str(), false );
+	}
+}
+
+int ScriptWorker::Worker( void * data )
+{
+	((ScriptWorker *)data)->Run();
+	return 0;
+}
+
+void ScriptWorker::Run()
+{
+	gmMachine * vm = m_vm;
+
+	// not gmCompileStr, which waits on a message box until the file compiles. the compiler
+	// of its own leaves the main thread's alone, a worker that fails to compile just ends
+	bool compiled = false;
+	char * code = TextFileRead( m_file.c_str() );
+	if ( code )
+	{
+		gmStreamBufferDynamic lib;
+		compiled = gmMachine::CompileStringToLib( code, lib, vm->GetLog(), vm->GetDebugMode(), vm->GetOptimiseMode(), vm->GetLineOpsMode() ) == 0;
+		delete [] code;
+
+		if ( compiled ) compiled = vm->ExecuteLib( lib, NULL, true, m_file.c_str() );
+	}
+	else
+	{
+		vm->GetLog().LogEntry( "Cannot read '%s'", m_file.c_str() );
+	}
+	TakeErrors( vm->GetLog() );
+
+	while ( compiled )
+	{
+		Timer timer;
+		const int numThreads = vm->Execute( m_periodMs );
+		TakeErrors( vm->GetLog() );
+		// nothing reads a worker's stats, this keeps them from overflowing
+		vm->ResetStatsDotCache();
+		vm->ResetStatsThreads();
+		const float updateMs = timer.GetTimeMs();
+
+		SDL_LockMutex( m_mutex );
+		m_updateMs = updateMs;
+		const bool quit = m_quit;
+		SDL_UnlockMutex( m_mutex );
+
+		if ( quit || numThreads == 0 ) break;
+
+		// keep to the rate, a slow update runs the next straight away
+		const int restMs = m_periodMs - (int)updateMs;
+		SDL_Delay( restMs > 0 ? restMs : 0 );
+	}
+
+	delete vm;
+	m_vm = NULL;
+
+	SDL_LockMutex( m_mutex );
+	m_running = false;
+	SDL_UnlockMutex( m_mutex );
+}
+
+void ScriptWorker::TakeErrors( gmLog & log )
+{
+	bool first = true;
+	const char * msg = log.GetEntry( first );
+	if ( !msg ) return;
+
+	SDL_LockMutex( m_mutex );
+	while ( msg )
+	{
+		m_errors.push_back( msg );
+		msg = log.GetEntry( first );
+	}
+	SDL_UnlockMutex( m_mutex );
+
+	log.Reset();
+}
+
+GM_REG_NAMESPACE(ScriptWorker)
+{
+	GM_MEMFUNC_CONSTRUCTOR(ScriptWorker)
+	{
+		GM_CHECK_STRING_PARAM( file, 0 );
+		GM_INT_PARAM( hz, 1, 60 );
+		GM_PUSH_USER_HANDLED( ScriptWorker, new ScriptWorker(file, hz) );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(IsRunning)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(ScriptWorker, ptr);
+		a_thread->PushInt( ptr->IsRunning() ? 1 : 0 );
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(Stop)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(ScriptWorker, ptr);
+		ptr->Stop();
+		return GM_OK;
+	}
+
+	GM_MEMFUNC_DECL(UpdateMs)
+	{
+		GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(ScriptWorker, ptr);
+		a_thread->PushFloat( ptr->UpdateMs() );
+		return GM_OK;
+	}
+}
+
+GM_REG_MEM_BEGIN(ScriptWorker)
+GM_REG_MEMFUNC( ScriptWorker, IsRunning )
+GM_REG_MEMFUNC( ScriptWorker, Stop )
+GM_REG_MEMFUNC( ScriptWorker, UpdateMs )
+GM_REG_HANDLED_DESTRUCTORS(ScriptWorker)
+GM_REG_MEM_END()
+GM_BIND_DEFINE(ScriptWorker)
+
+}
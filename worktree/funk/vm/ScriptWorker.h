@@ -0,0 +1,69 @@
+#ifndef _INCLUDE_SCRIPT_WORKER_H_
+#define _INCLUDE_SCRIPT_WORKER_H_
+
+#include <gm/gmBindHeader.h>
+#include <common/HandledObj.h>
+
+#include <string>
+#include <vector>
+
+struct SDL_Thread;
+struct SDL_mutex;
+class gmMachine;
+class gmLog;
+
+namespace funk
+{
+	class VirtualConsole;
+
+	// runs a script file in a gmMachine of its own on a thread of its own, so a heavy
+	// behaviour doesn't stall the main machine. the worker machine gets the thread-safe
+	// libraries only (RegisterCoreLibs) and talks to others through MessageChannels.
+	// it runs until its script has no threads left, or until stopped or collected
+	class ScriptWorker : public HandledObj<ScriptWorker>
+	{
+	public:
+
+		ScriptWorker( const char * file, int hz );
+		~ScriptWorker();
+
+		GM_BIND_TYPEID(ScriptWorker);
+
+		bool	IsRunning();
+		void	Stop();
+		float	UpdateMs();	// script and gc time of the last update
+		const char * File() const { return m_file.c_str(); }
+
+		// these are for the main thread, with the workers the main machine has alive
+
+		// moves errors logged by the worker machines to the console
+		static void LogErrors( VirtualConsole & console );
+		static int	NumWorkers() { return (int)s_workers.size(); }
+		static ScriptWorker * GetWorker( int i ) { return s_workers[i]; }
+
+	private:
+
+		static int Worker( void * data );
+		void Run();
+		void TakeErrors( gmLog & log );
+
+		std::string m_file;
+		int m_periodMs;
+		gmMachine * m_vm; // made on the main thread, the worker's until it ends
+
+		SDL_Thread * m_thread;
+		SDL_mutex * m_mutex;
+
+		// guarded by m_mutex
+		bool m_quit;
+		bool m_running;
+		float m_updateMs;
+		std::vector<std::string> m_errors;
+
+		static std::vector<ScriptWorker*> s_workers;
+	};
+
+	GM_BIND_DECL(ScriptWorker);
+}
+
+#endif
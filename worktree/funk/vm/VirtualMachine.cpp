@@ -8,45 +8,73 @@
 #include <gm/gmThread.h>
 #include <gm/gmDebuggerFunk.h>
 #include <gm/gmUtilEx.h>
+#include <gm/gmSampleProfiler.h>
 #include <imgui/Imgui.h>
 #include <common/ResourcePath.h>
 #include <common/IniReader.h>
 #include <common/Timer.h>
 #include <common/Window.h>
+#include <math/Util.h>
 
 #include <map>
 
 #include "VirtualMachineLibs.h"
+#include "MessageChannel.h"
+#include "ScriptWorker.h"
 
 namespace funk
 {
 const char * kEntryFile = RESOURCE_PATH("common/gm/Core.gm");
+const char * kByteCodeCacheDir = RESOURCE_PATH("gmcache/");
+const char * kProfileFile = RESOURCE_PATH("gmprofile.folded");
 
 VirtualMachine::VirtualMachine()
 {
 	m_vm = new gmMachine();
 	m_vm->SetAutoMemoryUsage(false);
+	m_marker = NULL;
+	m_profiler = NULL;
+	m_gcPacing = false;
+	m_beforeExecute = NULL;
 
 	m_dt = 0.0f;
 	m_updateMs = 0.0f;
+	m_gcMs = 0.0f;
+	m_gcMarkMs = 0.0f;
 	m_bUseGmByteCode = false;
 	m_numThreads = 0;
+	m_threadsCreatedPerSec = 0;
+	m_threadReuseRate = 0;
+	m_threadStackGrows = 0;
+	m_dotCacheHits = 0;
+	m_dotCacheMisses = 0;
 	m_threadId = 0;
 
 	InitGuiSettings();
 	InitGuiThreadAllocations();
+	InitGuiProfiler();
 }
 
 VirtualMachine::~VirtualMachine()
 {
 	m_console.Log("Destructing Virtual Machine");
 	if ( m_vm->GetDebugMode() ) m_debugger.Close();
-	delete m_vm;
+	delete m_marker;
+	delete m_profiler;
+	delete m_vm; // stops and joins the script workers
+	MessageChannel::CloseAll();
 	m_console.Log("Virtual Machine destructed!");
 }
 
 void VirtualMachine::Update()
 {
+	// stop marking before touching the machine
+	if ( m_marker )
+	{
+		m_marker->Sync();
+		m_gcMarkMs = m_marker->GetMarkMs();
+	}
+
 #ifndef FUNK_FINAL
 	if( Input::Get()->DidKeyJustGoDown("F5") ) ResetVM();
 #endif
@@ -56,10 +84,37 @@ void VirtualMachine::Update()
 	// run main game only if not debugging
 	if ( !(m_vm->GetDebugMode() && m_debugger.IsDebugging()) )
 	{
+		if ( m_beforeExecute ) m_beforeExecute( m_vm );
+
 		Timer gmTimer;
 		gmuint32 delta = (gmuint32)(m_dt*1000.0f);
-		m_numThreads = m_vm->Execute( delta );
+		if ( m_profiler ) m_profiler->BeginExecute();
+		m_numThreads = m_vm->Execute( delta, false );
+		if ( m_profiler ) m_profiler->EndExecute();
 		m_updateMs = gmTimer.GetTimeMs();
+
+		// per frame, so the counts never grow long enough to overflow
+		const int threadsCreated = m_vm->GetStatsThreadsCreated();
+		m_threadsCreatedPerSec = (int)( threadsCreated / m_dt );
+		m_threadReuseRate = threadsCreated > 0 ? (int)(100.0f * m_vm->GetStatsThreadsReused() / threadsCreated) : 0;
+		m_threadStackGrows = m_vm->GetStatsThreadStackGrows();
+		m_vm->ResetStatsThreads();
+
+		m_dotCacheHits = m_vm->GetStatsDotCacheHits();
+		m_dotCacheMisses = m_vm->GetStatsDotCacheMisses();
+		m_vm->ResetStatsDotCache();
+
+		// collect separately so the gc cost per frame can be seen
+		if ( m_gcPacing )
+		{
+			m_gcMs = m_gcPacer.Collect();
+		}
+		else
+		{
+			Timer gcTimer;
+			m_vm->CollectGarbage();
+			m_gcMs = gcTimer.GetTimeMs();
+		}
 	}
 
 	// update debugger
@@ -80,6 +135,9 @@ void VirtualMachine::ResetVM()
 	m_vm->ResetAndFreeMemory();
 	m_vm->Init();
 
+	// the workers went with the main machine's objects, nothing has a channel open
+	MessageChannel::CloseAll();
+
 	if ( m_vm->GetDebugMode() ) m_debugger.Open(m_vm);
 
 	RunMain();
@@ -95,7 +153,9 @@ void VirtualMachine::Render()
 		if ( !m_vm->GetDebugMode() || !m_debugger.IsDebugging() )
 		{
 			m_vm->GetGlobals()->Set( m_vm, "g_rendering", gmVariable(1) );
+			if ( m_profiler ) m_profiler->BeginExecute();
 			m_vm->ExecuteFunction(m_drawFunc, 0, true, &m_drawManager);
+			if ( m_profiler ) m_profiler->EndExecute();
 			m_vm->GetGlobals()->Set( m_vm, "g_rendering", gmVariable(0) );		
 		}
 		else
@@ -103,6 +163,13 @@ void VirtualMachine::Render()
 			m_vm->ExecuteFunction(m_clearFunc, 0, true, &m_drawManager);
 		}
 	}
+
+	if ( m_profiler ) m_profiler->EndFrame();
+}
+
+void VirtualMachine::Idle()
+{
+	if ( m_marker ) m_marker->Begin();
 }
 
 void VirtualMachine::RunMain()
@@ -121,13 +188,31 @@ void VirtualMachine::RunMain()
 	int gcDestructsPerIncrement = ini.GetInt("VirtualMachine", "GC_DestructPerIncrement");
 	int memUsageSoft = ini.GetInt("VirtualMachine", "MemUsageSoft");
 	int memUsageHard = ini.GetInt("VirtualMachine", "MemUsageHard");
+	int byteCodeCache = ini.GetInt("VirtualMachine", "ByteCodeCache");
+	int lineOps = ini.GetInt("VirtualMachine", "LineOps");
+	int compileStats = ini.GetInt("VirtualMachine", "CompileStats");
+	int gcConcurrentMark = ini.GetInt("VirtualMachine", "GC_ConcurrentMark");
+	float gcFrameBudgetMs = ini.GetFloat("VirtualMachine", "GC_FrameBudgetMs");
+	m_profilerSampleMs = ini.GetInt("VirtualMachine", "ProfilerSampleMs");
 
 	m_vm->GetGC()->SetWorkPerIncrement(gcWorkPerIncrement);
 	m_vm->GetGC()->SetDestructPerIncrement(gcDestructsPerIncrement);
 	m_vm->SetDesiredByteMemoryUsageSoft(memUsageSoft);
 	m_vm->SetDesiredByteMemoryUsageHard(memUsageHard);
 
+	// pace the collector from the measured cost, the static settings are its first guess
+	m_gcPacing = gcFrameBudgetMs > 0.0f;
+	if ( m_gcPacing ) m_gcPacer.Init(m_vm, gcFrameBudgetMs, memUsageSoft);
+
+	// mark on a thread of its own while the frame renders
+	if ( gcConcurrentMark == 1 && !m_marker ) m_marker = new GCMarker(m_vm);
+
+	// sample script call stacks from the start, else the profiler gui turns it on
+	if ( m_profilerSampleMs > 0 && !m_profiler && gmSampleProfiler::IsSupported() ) m_profiler = new gmSampleProfiler(m_vm, m_profilerSampleMs);
+	if ( m_profiler ) m_profiler->Clear();
+
 	m_vm->SetDebugMode(debugMode == 1);
+	m_vm->SetLineOpsMode(lineOps == 1);
 	m_bUseGmByteCode = runGmLibs == 1;
 	m_dt = 1.0f/fps;
 
@@ -135,10 +220,24 @@ void VirtualMachine::RunMain()
 	char buffer[128];
 	sprintf_s(buffer, "Running at %d hz, VM Debug Mode: %d, VM Run Byte-Code: %d", fps, debugMode, runGmLibs );
 	m_console.Log(buffer);
-	sprintf_s(buffer, "GC Works Per Increment: %d, GC Destructs Per Increment: %d", gcWorkPerIncrement, gcDestructsPerIncrement );
+	sprintf_s(buffer, "GC Works Per Increment: %d, GC Destructs Per Increment: %d, GC Concurrent Mark: %d", gcWorkPerIncrement, gcDestructsPerIncrement, gcConcurrentMark );
 	m_console.Log(buffer);
 	sprintf_s(buffer, "Mem Usage Soft: %d bytes, Mem Usage Hard: %d bytes", memUsageSoft, memUsageHard );
 	m_console.Log(buffer);
+	sprintf_s(buffer, "GC Frame Budget: %.2f ms", gcFrameBudgetMs );
+	m_console.Log(buffer);
+	sprintf_s(buffer, "Profiler Sample: %d ms", m_profilerSampleMs );
+	m_console.Log(buffer);
+	sprintf_s(buffer, "Byte Code Cache: %d", byteCodeCache );
+	m_console.Log(buffer);
+	sprintf_s(buffer, "Line Ops: %d (debugger breakpoints and stepping need them)", lineOps );
+	m_console.Log(buffer);
+	sprintf_s(buffer, "Compile Stats: %d", compileStats );
+	m_console.Log(buffer);
+
+	// reuse byte code compiled on a previous run while the script source is unchanged
+	gmSetByteCodeCacheDir( byteCodeCache == 1 ? kByteCodeCacheDir : NULL );
+	gmSetPrintCompileStats( compileStats == 1 );
 
 	// attach debugger
 	if ( m_vm->GetDebugMode() ) m_debugger.Open(m_vm);
@@ -189,16 +288,30 @@ void VirtualMachine::HandleErrors()
 		msg = compileLog.GetEntry(firstErr);
 	}
 	compileLog.Reset();
+
+	ScriptWorker::LogErrors(m_console);
 }
 
 void VirtualMachine::GuiStats()
 {
 	Imgui::Header("GameMonkey");
 	Imgui::FillBarFloat("Update", m_updateMs, 0.0f, 16.0 );
+	Imgui::FillBarFloat("GC Update", m_gcMs, 0.0f, 16.0 );
+	if ( m_marker ) Imgui::FillBarFloat("GC Mark (thread)", m_gcMarkMs, 0.0f, 16.0 );
 	Imgui::FillBarInt("Mem Usage (Bytes)", m_vm->GetCurrentMemoryUsage(), 0, m_vm->GetDesiredByteMemoryUsageHard() );
 	Imgui::FillBarInt("Num Threads", m_numThreads, 0, 500 );
+	for( int i = 0; i < ScriptWorker::NumWorkers(); ++i )
+	{
+		// worker updates are on their own threads, next to the frame
+		ScriptWorker * worker = ScriptWorker::GetWorker(i);
+		const char * file = strrchr( worker->File(), '/' );
+		char buffer[128];
+		sprintf_s(buffer, "Worker %.40s%s", file ? file + 1 : worker->File(), worker->IsRunning() ? "" : " (stopped)" );
+		Imgui::FillBarFloat(buffer, worker->UpdateMs(), 0.0f, 16.0 );
+	}
 	Imgui::CheckBox("Show Settings", m_showSettingsGui );
 	Imgui::CheckBox("Show Allocations", m_showThreadAllocationsGui );
+	Imgui::CheckBox("Show Profiler", m_showProfilerGui );
 }
 
 void VirtualMachine::Gui()
@@ -206,6 +319,7 @@ void VirtualMachine::Gui()
 	if ( m_vm->GetDebugMode() ) m_debugger.Gui();
 	if ( m_showSettingsGui ) GuiSettings();
 	if ( m_showThreadAllocationsGui ) GuiThreadAllocations();
+	if ( m_showProfilerGui ) GuiProfiler();
 	m_console.Gui();
 }
 
@@ -221,6 +335,9 @@ void VirtualMachine::InitGuiSettings()
 
 	m_lineGraphUpdate = new LineGraph( minVal, maxVal, v2i(width, height), numVals );
 	m_lineGraphMemory = new LineGraph( minVal, maxVal, v2i(width, height), numVals );
+	m_lineGraphGC = new LineGraph( minVal, maxVal, v2i(width, height), numVals );
+	m_lineGraphGCWork = new LineGraph( minVal, maxVal, v2i(width, height), numVals );
+	m_lineGraphGCWork->SetAutoSize(true);
 }
 
 void VirtualMachine::GuiSettings()
@@ -229,11 +346,16 @@ void VirtualMachine::GuiSettings()
 	m_lineGraphUpdate->SetMaxVal(m_dt*1000.0f);
 	m_lineGraphMemory->SetMaxVal( (float)m_vm->GetDesiredByteMemoryUsageHard() );
 	m_lineGraphMemory->PushVal( (float)m_vm->GetCurrentMemoryUsage() );
+	m_lineGraphGC->SetMaxVal( m_gcPacing ? m_gcPacer.GetBudgetMs() * 2.0f : 4.0f );
+	m_lineGraphGC->PushVal( m_gcMs );
+	m_lineGraphGCWork->PushVal( (float)m_vm->GetGC()->GetWorkPerIncrement() );
 
 	int workPerIncrement = m_vm->GetGC()->GetWorkPerIncrement();
 	int destructPerIncrement = m_vm->GetGC()->GetDestructPerIncrement();
-	int memUsageSoft = m_vm->GetDesiredByteMemoryUsageSoft();
+	int memUsageSoft = m_gcPacing ? m_gcPacer.GetMemTarget() : m_vm->GetDesiredByteMemoryUsageSoft();
 	int memUsageHard = m_vm->GetDesiredByteMemoryUsageHard();
+	float gcBudgetMs = m_gcPacer.GetBudgetMs();
+	int threadPoolSize = m_vm->GetThreadPoolSize();
 
 	const v2i pos = v2i(300, Window::Get()->Sizei().y - 20 );
 
@@ -242,22 +364,64 @@ void VirtualMachine::GuiSettings()
 	Imgui::LineGraph( m_lineGraphUpdate );
 	Imgui::Print("Memory");
 	Imgui::LineGraph( m_lineGraphMemory );
+	Imgui::Print("GC");
+	Imgui::LineGraph( m_lineGraphGC );
+	Imgui::Print("GC Work Per Increment");
+	Imgui::LineGraph( m_lineGraphGCWork );
 	Imgui::FillBarInt("Mem Usage (Bytes)", m_vm->GetCurrentMemoryUsage(), 0, m_vm->GetDesiredByteMemoryUsageHard() );
 	Imgui::Header("Garbage Collector");
-	Imgui::SliderInt( "Work Per Increment", workPerIncrement, 1, 600 );
-	Imgui::SliderInt( "Destructs Per Increment", destructPerIncrement, 1, 600 );
+	if ( m_gcPacing )
+	{
+		// the pacer picks these each frame
+		Imgui::SliderFloat( "GC Budget (ms)", gcBudgetMs, 0.1f, 8.0f );
+		Imgui::FillBarInt("Work Per Increment", workPerIncrement, 0, m_gcPacer.GetBudgetWork() );
+		Imgui::FillBarInt("Destructs Per Increment", destructPerIncrement, 0, 2*workPerIncrement );
+		Imgui::FillBarInt("GC Start (Bytes)", m_gcPacer.GetMemStart(), 0, memUsageSoft );
+		Imgui::FillBarInt("Alloc Per Frame (Bytes)", (int)m_gcPacer.GetAllocRate(), 0, 100000 );
+	}
+	else
+	{
+		Imgui::SliderInt( "Work Per Increment", workPerIncrement, 1, 600 );
+		Imgui::SliderInt( "Destructs Per Increment", destructPerIncrement, 1, 600 );
+	}
 	Imgui::SliderInt( "Mem Usage Soft", memUsageSoft, 200000, memUsageHard );
 	Imgui::SliderInt( "Mem Usage Hard", memUsageHard, memUsageSoft+500, memUsageSoft+200000 );
 	Imgui::Separator();
 	Imgui::FillBarInt("GC Warnings", m_vm->GetStatsGCNumWarnings(), 0, 200 );
 	Imgui::FillBarInt("GC Full Collects", m_vm->GetStatsGCNumFullCollects(), 0, 200 );
 	Imgui::FillBarInt("GC Inc Collects", m_vm->GetStatsGCNumIncCollects(), 0, 200 );
+	Imgui::FillBarInt("GC Minor Collects", m_vm->GetStatsGCNumMinorCollects(), 0, 2000 );
+	Imgui::FillBarInt("Nursery Objects", m_vm->GetGC()->GetNurseryCount(), 0, m_vm->GetGC()->GetNurseryLimit() );
+	Imgui::FillBarFloat("GC Update", m_gcMs, 0.0f, 16.0 );
+	if ( m_marker ) Imgui::FillBarFloat("GC Mark (thread)", m_gcMarkMs, 0.0f, 16.0 );
+	Imgui::Separator();
+	const int dotCacheLookups = m_dotCacheHits + m_dotCacheMisses;
+	const int dotCacheHitRate = dotCacheLookups > 0 ? (int)(100.0f * m_dotCacheHits / dotCacheLookups) : 0;
+	Imgui::FillBarInt("Dot Cache Hit %", dotCacheHitRate, 0, 100 );
+	Imgui::FillBarInt("Dot Cache Misses", m_dotCacheMisses, 0, 10000 );
+	Imgui::Header("Threads");
+	Imgui::SliderInt( "Thread Pool Size", threadPoolSize, 0, 512 );
+	Imgui::FillBarInt("Pooled Threads", m_vm->GetNumPooledThreads(), 0, threadPoolSize );
+	Imgui::FillBarInt("Threads Created/s", m_threadsCreatedPerSec, 0, 5000 );
+	Imgui::FillBarInt("Thread Reuse %", m_threadReuseRate, 0, 100 );
+	Imgui::FillBarInt("Thread Stack (Bytes)", m_vm->GetThreadStackBytes(), 0, GMTHREAD_MAXBYTESIZE );
+	Imgui::FillBarInt("Thread Stack Grows", m_threadStackGrows, 0, 100 );
 	Imgui::End();
 
-	m_vm->SetDesiredByteMemoryUsageSoft(memUsageSoft);
+	m_vm->SetThreadPoolSize(threadPoolSize);
+
 	m_vm->SetDesiredByteMemoryUsageHard(memUsageHard);
-	m_vm->GetGC()->SetWorkPerIncrement(workPerIncrement);
-	m_vm->GetGC()->SetDestructPerIncrement(destructPerIncrement);
+	if ( m_gcPacing )
+	{
+		m_gcPacer.SetBudgetMs(gcBudgetMs);
+		m_gcPacer.SetMemTarget(memUsageSoft);
+	}
+	else
+	{
+		m_vm->SetDesiredByteMemoryUsageSoft(memUsageSoft);
+		m_vm->GetGC()->SetWorkPerIncrement(workPerIncrement);
+		m_vm->GetGC()->SetDestructPerIncrement(destructPerIncrement);
+	}
 }
 
 void VirtualMachine::InitGuiThreadAllocations()
@@ -333,4 +497,66 @@ void VirtualMachine::GuiThreadAllocations()
 	Imgui::End();
 }
 
+void VirtualMachine::InitGuiProfiler()
+{
+	m_showProfilerGui = false;
+	m_profilerLastFrame = false;
+	m_profilerSampleMs = 0;
+}
+
+void VirtualMachine::GuiProfiler()
+{
+	const v2i pos = v2i(600, Window::Get()->Sizei().y - 20 );
+
+	Imgui::Begin("Script Profiler", pos);
+
+	if ( !gmSampleProfiler::IsSupported() )
+	{
+		Imgui::Print("Built without GMTHREAD_SAMPLING, define GM_PROFILE_BUILD");
+		Imgui::End();
+		return;
+	}
+
+	// the profiler costs nothing until it exists
+	bool sampling = m_profiler != NULL;
+	Imgui::CheckBox("Sampling", sampling);
+	if ( sampling && !m_profiler ) m_profiler = new gmSampleProfiler(m_vm, m_profilerSampleMs > 0 ? m_profilerSampleMs : 1);
+	if ( !sampling && m_profiler )
+	{
+		delete m_profiler;
+		m_profiler = NULL;
+	}
+
+	if ( m_profiler )
+	{
+		Imgui::CheckBox("Last Frame", m_profilerLastFrame);
+		if ( Imgui::Button("Clear") ) m_profiler->Clear();
+		Imgui::SameLine();
+		if ( Imgui::Button("Write Flame Graph") )
+		{
+			const bool written = m_profiler->WriteFolded(kProfileFile);
+			m_console.Log( written ? "Wrote folded stacks to " : "Could not write folded stacks to ", false );
+			m_console.Log( kProfileFile );
+		}
+
+		const int samples = m_profilerLastFrame ? m_profiler->GetLastFrameSamples() : m_profiler->GetTotalSamples();
+		char buffer[128];
+		sprintf_s(buffer, "%d samples, %d ms apart", samples, m_profiler->GetPeriodMs() );
+		Imgui::Print(buffer);
+		Imgui::Separator();
+
+		// self samples of the busiest functions
+		std::vector<gmSampleProfiler::Function> functions;
+		m_profiler->GetFunctions( functions, m_profilerLastFrame );
+		const int numShown = min( (int)functions.size(), 20 );
+		for( int i = 0; i < numShown; ++i )
+		{
+			sprintf_s(buffer, "%.40s [%d total]", functions[i].name.c_str(), functions[i].total );
+			Imgui::FillBarInt( buffer, functions[i].self, 0, max(samples, 1) );
+		}
+	}
+
+	Imgui::End();
+}
+
 }
\ No newline at end of file
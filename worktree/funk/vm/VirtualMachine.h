@@ -11,8 +11,11 @@
 #include <map>
 
 #include "VirtualConsole.h"
+#include "GCPacer.h"
+#include "GCMarker.h"
 
 class gmMachine;
+class gmSampleProfiler;
 
 namespace funk
 {
@@ -21,6 +24,7 @@ namespace funk
 	public:
 		void Update();
 		void Render();
+		void Idle(); // the machine is not used until the next Update
 		void RunMain();
 		void GuiStats();
 		void Gui();
@@ -30,13 +34,30 @@ namespace funk
 
 		bool IsUsingByteCode() const { return m_bUseGmByteCode; }
 
+		// called by Update once the marker has stopped, before the machine runs, to wake
+		// script threads on work finished elsewhere
+		typedef void (*BeforeExecuteCallback)( gmMachine * vm );
+		void SetBeforeExecute( BeforeExecuteCallback callback ) { m_beforeExecute = callback; }
+
 	private:
 		float	m_updateMs;
+		float	m_gcMs;
+		float	m_gcMarkMs; // marking thread, while idle
 		float	m_dt;
 		bool	m_bUseGmByteCode; // uses bytecode version
 		int		m_numThreads;
+		int		m_threadsCreatedPerSec;
+		int		m_threadReuseRate; // percent of last frame's new threads taken from the pool
+		int		m_threadStackGrows; // last frame's
+		int		m_dotCacheHits; // last frame's, the machine's counts are reset every update
+		int		m_dotCacheMisses;
+		BeforeExecuteCallback m_beforeExecute;
 
 		gmMachine *m_vm;
+		GCMarker *m_marker;
+		gmSampleProfiler *m_profiler; // NULL unless sampling
+		GCPacer m_gcPacer;
+		bool m_gcPacing; // work per increment follows GC_FrameBudgetMs
 		int m_threadId;
 
 		// draw manager
@@ -49,6 +70,8 @@ namespace funk
 		bool m_showSettingsGui;
 		StrongHandle<LineGraph> m_lineGraphUpdate;
 		StrongHandle<LineGraph> m_lineGraphMemory;
+		StrongHandle<LineGraph> m_lineGraphGC;
+		StrongHandle<LineGraph> m_lineGraphGCWork;
 		void InitGuiSettings();
 		void GuiSettings();
 
@@ -65,6 +88,13 @@ namespace funk
 		std::map<const gmFunctionObject*, ThreadAllocationItem> m_threadAllocationsHistory;
 		bool m_freezeThreadAllocationsGui;
 
+		// profiler gui
+		bool m_showProfilerGui;
+		bool m_profilerLastFrame;
+		int m_profilerSampleMs;
+		void InitGuiProfiler();
+		void GuiProfiler();
+
 		VirtualConsole m_console;
 
 		void HandleErrors();
@@ -20,6 +20,7 @@
 #include <math/v2.h>
 #include <math/v3.h>
 #include <math/Perlin2d.h>
+#include <math/FloatBuffer.h>
 #include <math/CubicSpline2d.h>
 #include <gfx/Cam2d.h>
 #include <gfx/Cam3d.h>
@@ -34,20 +35,32 @@
 #include <gfx/LineGraph.h>
 #include <imgui/ImguiGM.h>
 
+#include "MessageChannel.h"
+#include "ScriptWorker.h"
+
 extern void RegisterProjectLibs(gmMachine* vm);
 
 namespace funk
 {
 
-void RegisterLibs( gmMachine * vm )
+void RegisterCoreLibs( gmMachine * vm )
 {
-	// Init libraries
-	gmBindDebugLib(vm);
-	gmBindFunkDebugLib(vm);
+	// user type ids are static per type and taken in registration order, so machines
+	// passing values between them must create the shared types first and in the same order
 	gmBindSystemLib(vm);
 	gmBindMathLib(vm);
 	gmBindArrayLib(vm);
 	gmBindStringLib(vm);
+	GM_BIND_INIT( FloatBuffer, vm );
+	GM_BIND_INIT( MessageChannel, vm );
+}
+
+void RegisterLibs( gmMachine * vm )
+{
+	// Init libraries
+	RegisterCoreLibs(vm);
+	gmBindDebugLib(vm);
+	gmBindFunkDebugLib(vm);
 	gmBindInputLib(vm);
 	gmBindWindowLib(vm);
 	gmBindGfxLib(vm);
@@ -70,6 +83,7 @@ void RegisterLibs( gmMachine * vm )
 	GM_BIND_INIT( CubicSpline2d, vm );
 	GM_BIND_INIT( Particles2d, vm );
 	GM_BIND_INIT( Font, vm );
+	GM_BIND_INIT( ScriptWorker, vm );
 
 	// Init game-specific types
 	RegisterProjectLibs( vm );
@@ -6,6 +6,9 @@ class gmMachine;
 namespace funk
 {
 	void RegisterLibs( gmMachine * mv );
+
+	// the libraries safe to use off the main thread, every machine registers these first
+	void RegisterCoreLibs( gmMachine * vm );
 }
 
 #endif
\ No newline at end of file
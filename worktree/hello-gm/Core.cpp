@@ -18,6 +18,8 @@
 #include <gfx/GpuTimer.h>
 #include <gfx/LineGraph.h>
 
+#include "gmalproxy.h"
+
 namespace funk
 {
 Core::Core()
@@ -39,9 +41,13 @@ void Core::Init()
 	ImguiManager::CreateInst();
 	VirtualMachine::CreateInst();
 
+	// wakes the script threads blocked on proxy calls that completed, once the gc marker has stopped
+	VirtualMachine::Get()->SetBeforeExecute( GMALCall::DeliverCompleted );
+
 	IniReader reader( RESOURCE_PATH("common/ini/main.ini") );
 	m_fps = reader.GetInt( "Window", "FPS" );
 	m_showAnalyticsGui = reader.GetInt( "Window", "ShowAnalytics" ) == 1;
+	GMALCall::SetMaxThreads( reader.GetInt( "NAOqi", "CallThreads" ) );
 
 	Timer initTimer;
 	printf("Initializing...\n");
@@ -59,6 +65,7 @@ void Core::HandleArgs( int argc, char ** argv )
 void Core::Deinit()
 {
 	VirtualMachine::DestroyInst();
+	GMALCall::Shutdown();
 	BaseEntityGroup::Deinit();
 
 	ImguiManager::DestroyInst();
@@ -90,6 +97,7 @@ void Core::Run()
 			Update( dt );
 			Render();
 			ImguiManager::Get()->CleanUp();
+			VirtualMachine::Get()->Idle();
 		}
 		m_msTotal = timer.GetTimeMs();
 		m_fpsFrame = 1000.0f / m_msTotal;
@@ -1512,6 +1512,53 @@ void GMAudioStream::ResetMirrorNotes()
     _mirror_notes_index = 0;
 }
 
+std::vector<float>* GMAudioStream::GetFrameBuffer(FrameBuffer which, int channel)
+{
+    switch (which)
+    {
+    case FrameRaw:
+        return channel >= 0 && channel < (int)_channels.size() ? &_channels[channel].raw : NULL;
+    case FrameFFT:
+        return channel >= 0 && channel < (int)_channels.size() ? &_channels[channel].fft : NULL;
+    case FrameAverage:
+        return &_average_fft;
+    case FrameDifference:
+        return &_difference_fft;
+    }
+
+    return NULL;
+}
+
+// looks the vector up each time, _channels and the vectors are resized as input arrives
+class AudioFrameSource
+    : public FloatBuffer::Source
+{
+public:
+    AudioFrameSource(StrongHandle<GMAudioStream> stream, GMAudioStream::FrameBuffer which, int channel)
+        : _stream(stream)
+        , _which(which)
+        , _channel(channel)
+    {
+    }
+
+    virtual float* GetData(int& size)
+    {
+        std::vector<float>* samples = _stream->GetFrameBuffer(_which, _channel);
+        size = samples ? (int)samples->size() : 0;
+        return size ? &(*samples)[0] : NULL;
+    }
+
+private:
+    StrongHandle<GMAudioStream> _stream;
+    GMAudioStream::FrameBuffer _which;
+    int _channel;
+};
+
+StrongHandle<FloatBuffer> GMAudioStream::GetFrameFloatBuffer(FrameBuffer which, int channel)
+{
+    return new FloatBuffer(new AudioFrameSource(this, which, channel));
+}
+
 GM_REG_NAMESPACE(GMAudioStream)
 {
 	GM_MEMFUNC_DECL(CreateGMAudioStream)
@@ -1832,6 +1879,44 @@ GM_REG_NAMESPACE(GMAudioStream)
         return GM_OK;
     }
 
+    GM_MEMFUNC_DECL(GetRawBuffer)
+    {
+        GM_CHECK_NUM_PARAMS(1);
+        GM_CHECK_INT_PARAM(channel, 0);
+		GM_GET_THIS_PTR(GMAudioStream, self);
+        StrongHandle<FloatBuffer> buffer = self->GetFrameFloatBuffer(GMAudioStream::FrameRaw, channel);
+        GM_PUSH_USER_HANDLED(FloatBuffer, buffer.Get());
+        return GM_OK;
+    }
+
+    GM_MEMFUNC_DECL(GetFFTBuffer)
+    {
+        GM_CHECK_NUM_PARAMS(1);
+        GM_CHECK_INT_PARAM(channel, 0);
+		GM_GET_THIS_PTR(GMAudioStream, self);
+        StrongHandle<FloatBuffer> buffer = self->GetFrameFloatBuffer(GMAudioStream::FrameFFT, channel);
+        GM_PUSH_USER_HANDLED(FloatBuffer, buffer.Get());
+        return GM_OK;
+    }
+
+    GM_MEMFUNC_DECL(GetAverageBuffer)
+    {
+        GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(GMAudioStream, self);
+        StrongHandle<FloatBuffer> buffer = self->GetFrameFloatBuffer(GMAudioStream::FrameAverage, 0);
+        GM_PUSH_USER_HANDLED(FloatBuffer, buffer.Get());
+        return GM_OK;
+    }
+
+    GM_MEMFUNC_DECL(GetDifferenceBuffer)
+    {
+        GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(GMAudioStream, self);
+        StrongHandle<FloatBuffer> buffer = self->GetFrameFloatBuffer(GMAudioStream::FrameDifference, 0);
+        GM_PUSH_USER_HANDLED(FloatBuffer, buffer.Get());
+        return GM_OK;
+    }
+
     GM_GEN_MEMFUNC_VOID_VOID( GMAudioStream, PlaybackMirrorNotes )
     GM_GEN_MEMFUNC_VOID_VOID( GMAudioStream, ResetMirrorNotes )
 }
@@ -1869,6 +1954,10 @@ GM_REG_MEMFUNC( GMAudioStream, TestGetPianoNotes )
 GM_REG_MEMFUNC( GMAudioStream, ResetTimers )
 GM_REG_MEMFUNC( GMAudioStream, TestAddSynthNote )
 GM_REG_MEMFUNC( GMAudioStream, GetNoteBrain )
+GM_REG_MEMFUNC( GMAudioStream, GetRawBuffer )
+GM_REG_MEMFUNC( GMAudioStream, GetFFTBuffer )
+GM_REG_MEMFUNC( GMAudioStream, GetAverageBuffer )
+GM_REG_MEMFUNC( GMAudioStream, GetDifferenceBuffer )
 GM_REG_MEMFUNC( GMAudioStream, PlaybackMirrorNotes )
 GM_REG_MEMFUNC( GMAudioStream, ResetMirrorNotes )
 GM_REG_MEM_END()
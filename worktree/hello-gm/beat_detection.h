@@ -7,6 +7,7 @@
 #include <complex>
 #include <sound/MicrophoneRecorder.h>
 #include <common/Timer.h>
+#include <math/FloatBuffer.h>
 
 using namespace funk;
 
@@ -183,6 +184,20 @@ public:
 
     StrongHandle<NoteBrain> GetNoteBrain();
 
+    enum FrameBuffer
+    {
+        FrameRaw,
+        FrameFFT,
+        FrameAverage,
+        FrameDifference,
+    };
+
+    // the frame's samples, NULL if there is no such channel
+    std::vector<float>* GetFrameBuffer(FrameBuffer which, int channel);
+
+    // a script view of the frame's samples, it follows the vector as it is resized
+    StrongHandle<FloatBuffer> GetFrameFloatBuffer(FrameBuffer which, int channel);
+
     void CaptureMirrorNotes();
     void PlaybackMirrorNotes();
     void ResetMirrorNotes();
@@ -1462,6 +1462,74 @@ void Filters::BoxBlurARGB(StrongHandle<Texture> out, StrongHandle<Texture> in)
     delete buffer_vout;
 }
 
+bool Filters::LuminancePlaneARGB(StrongHandle<FloatBuffer> out, StrongHandle<Texture> in)
+{
+    const int w = in->Sizei().x;
+    const int h = in->Sizei().y;
+
+    out->Resize(w * h);
+    if (out->Size() != w * h)
+        return false;
+
+    uint32_t* buffer_in = g_imagecache.Pop<uint32_t>(w, h);
+
+    in->Bind(0);
+    in->GetTexImage(buffer_in);
+    in->Unbind();
+
+    glFinish();
+
+    // straight into the buffer's storage, no float image in between
+    float* plane = out->Data();
+    const float d = 1.0f / 255.0f;
+
+    for (int i = 0; i < w * h; ++i)
+    {
+        const uint32_t pixel = buffer_in[i];
+        const float r = float((pixel & 0x00FF0000) >> 16);
+        const float g = float((pixel & 0x0000FF00) >> 8);
+        const float b = float((pixel & 0x000000FF) >> 0);
+
+        plane[i] = (r * LuminanceCoefficientARGB.y + g * LuminanceCoefficientARGB.z + b * LuminanceCoefficientARGB.w) * d;
+    }
+
+    g_imagecache.Push(buffer_in);
+
+    return true;
+}
+
+bool Filters::PlaneToARGB(StrongHandle<Texture> out, StrongHandle<FloatBuffer> in)
+{
+    const int w = out->Sizei().x;
+    const int h = out->Sizei().y;
+
+    if (in->Size() != w * h)
+        return false;
+
+    uint32_t* buffer_out = g_imagecache.Pop<uint32_t>(w, h);
+
+    const float* plane = in->Data();
+
+    for (int i = 0; i < w * h; ++i)
+    {
+        const uint32_t l = uint32_t(clamp(plane[i], 0.0f, 1.0f) * 255.0f);
+
+        buffer_out[i] =
+            (0xFF << 24) |
+            (l << 16) |
+            (l <<  8) |
+            (l <<  0);
+    }
+
+    out->Bind();
+    out->SubData(buffer_out, w, h, 0, 0);
+    out->Unbind();
+
+    g_imagecache.Push(buffer_out);
+
+    return true;
+}
+
 static int GM_CDECL gmfFilterSobelARGB(gmThread * a_thread)
 {
 	GM_CHECK_NUM_PARAMS(3);
@@ -1542,6 +1610,38 @@ static int GM_CDECL gmfFilterHoughLinesARGB(gmThread * a_thread)
 	return GM_OK;
 }
 
+static int GM_CDECL gmfFilterLuminancePlaneARGB(gmThread * a_thread)
+{
+	GM_CHECK_NUM_PARAMS(2);
+
+	GM_CHECK_USER_PARAM_PTR( FloatBuffer, out, 0 );
+	GM_CHECK_USER_PARAM_PTR( Texture, in, 1 );
+
+    if (!Filters::LuminancePlaneARGB(out, in))
+    {
+        GM_EXCEPTION_MSG("buffer of %d can't hold %dx%d pixels", out->Size(), in->Sizei().x, in->Sizei().y);
+        return GM_EXCEPTION;
+    }
+
+	return GM_OK;
+}
+
+static int GM_CDECL gmfFilterPlaneToARGB(gmThread * a_thread)
+{
+	GM_CHECK_NUM_PARAMS(2);
+
+	GM_CHECK_USER_PARAM_PTR( Texture, out, 0 );
+	GM_CHECK_USER_PARAM_PTR( FloatBuffer, in, 1 );
+
+    if (!Filters::PlaneToARGB(out, in))
+    {
+        GM_EXCEPTION_MSG("buffer of %d is not %dx%d pixels", in->Size(), out->Sizei().x, out->Sizei().y);
+        return GM_EXCEPTION;
+    }
+
+	return GM_OK;
+}
+
 static gmFunctionEntry s_FiltersLib[] = 
 { 
 	{ "SobelARGB", gmfFilterSobelARGB },
@@ -1550,6 +1650,8 @@ static gmFunctionEntry s_FiltersLib[] =
 	{ "GaussianBlurARGB", gmfFilterGaussianBlurARGB },
 	{ "HoughTransformARGB", gmfFilterHoughTransformARGB },
 	{ "HoughLinesARGB", gmfFilterHoughLinesARGB },
+	{ "LuminancePlaneARGB", gmfFilterLuminancePlaneARGB },
+	{ "PlaneToARGB", gmfFilterPlaneToARGB },
 };
 
 void RegisterGmFiltersLib(gmMachine* a_vm)
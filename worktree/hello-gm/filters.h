@@ -4,6 +4,8 @@
 
 #include "main.h"
 
+#include <math/FloatBuffer.h>
+
 using namespace funk;
 
 class Filters
@@ -19,6 +21,10 @@ public:
     static void HoughTransformARGB(StrongHandle<Texture> out, StrongHandle<Texture> in, int theta_steps, int rho_bins, int rho_threshold);
     static void HoughLinesARGB(StrongHandle<Texture> out, StrongHandle<Texture> in, float peak_threshold);
     static void HoughLineSegmentsARGB(StrongHandle<Texture> out, StrongHandle<Texture> in, float peak_threshold);
+
+    // luminance planes for scripts, one float per pixel, row by row; out is resized to fit unless it is a view
+    static bool LuminancePlaneARGB(StrongHandle<FloatBuffer> out, StrongHandle<Texture> in);
+    static bool PlaneToARGB(StrongHandle<Texture> out, StrongHandle<FloatBuffer> in);
 };
 
 void RegisterGmFiltersLib(gmMachine* a_vm);
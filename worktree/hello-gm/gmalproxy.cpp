@@ -4,11 +4,17 @@
 
 #include "gmalproxy.h"
 
+#include <deque>
+
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <SDL_timer.h>
+
 using namespace funk;
 
 GMALProxy::GMALProxy(const char* type, const char* ip, int port)
     : _proxy(std::string(type), std::string(ip), port)
-    , _current_call(-1)
+    , _running_calls(0)
 {
 }
 
@@ -27,6 +33,11 @@ gmVariable GMALProxy::CallReturnVariable(const char* function, gmVariable arg)
     default: result = _proxy.call<AL::ALValue>(function_string); break;
     }
 
+    return ToVariable(&VirtualMachine::Get()->GetVM(), result);
+}
+
+gmVariable GMALProxy::ToVariable(gmMachine* vm, AL::ALValue result)
+{
     gmVariable result_variable;
     result_variable.Nullify();
 
@@ -35,7 +46,13 @@ gmVariable GMALProxy::CallReturnVariable(const char* function, gmVariable arg)
     case AL::ALValue::TypeBool: result_variable = gmVariable(int(result.operator bool &() ? 1 : 0)); break;
     case AL::ALValue::TypeInt: result_variable = gmVariable(int(result.operator int &())); break;
     case AL::ALValue::TypeFloat: result_variable = gmVariable(float(result.operator float &())); break;
-    case AL::ALValue::TypeString: result_variable = gmVariable(VirtualMachine::Get()->GetVM().AllocStringObject(result.toString().c_str())); break;
+    case AL::ALValue::TypeString:
+        {
+            // the length is known, so the string pool hashes it without measuring it first
+            const std::string string = result.toString();
+            result_variable = gmVariable(vm->AllocStringObject(string.c_str(), (int)string.length()));
+        }
+        break;
     default:
         break;
     }
@@ -73,27 +90,197 @@ void GMALProxy::CallVoid(const char* function, gmVariable arg)
     }
 }
 
-void GMALProxy::PostCall(const char* function, gmVariable arg)
+GMALCall* GMALProxy::PostCall(const char* function, gmVariable arg)
 {
-    const std::string function_string = std::string(function);
+    GMALCall* call = new GMALCall(this, function, arg);
+    GMALCall::Post(call);
+    return call;
+}
 
-    int id = -1;
+bool GMALProxy::IsRunning()
+{
+    return _running_calls > 0;
+}
 
+// call threads, idle ones wait on s_call_posted, Shutdown waits on s_call_exited
+
+static SDL_mutex* s_call_mutex = SDL_CreateMutex();
+static SDL_cond* s_call_posted = SDL_CreateCond();
+static SDL_cond* s_call_exited = SDL_CreateCond();
+static std::deque<GMALCall*> s_queued_calls;
+static std::vector<GMALCall*> s_completed_calls;
+static std::vector<SDL_Thread*> s_call_threads;
+static int s_max_call_threads = 4;
+static int s_live_call_threads = 0;
+static int s_idle_call_threads = 0;
+static bool s_quit_call_threads = false;
+
+GMALCall::GMALCall(GMALProxy* proxy, const char* function, gmVariable arg)
+    : _owner(proxy)
+    , _function(function)
+    , _arg_count(0)
+    , _failed(false)
+    , _done(false)
+    , _object(NULL)
+{
+    // the argument is copied out now, the call thread can't read the machine
     switch (arg.m_type)
     {
-    case GM_INT: id = _proxy.pCall(function_string, arg.GetInt()); break;
-    case GM_FLOAT: id = _proxy.pCall(function_string, arg.GetFloat()); break;
-    case GM_VEC2: id = _proxy.pCall(function_string, arg.GetVec2().x, arg.GetVec2().y); break;
-    case GM_STRING: id = _proxy.pCall(function_string, std::string(arg.GetCStringSafe())); break;
-    default: id = _proxy.pCall(function_string); break;
+    case GM_INT: _args[0] = arg.GetInt(); _arg_count = 1; break;
+    case GM_FLOAT: _args[0] = arg.GetFloat(); _arg_count = 1; break;
+    case GM_VEC2: _args[0] = arg.GetVec2().x; _args[1] = arg.GetVec2().y; _arg_count = 2; break;
+    case GM_STRING: _args[0] = std::string(arg.GetCStringSafe()); _arg_count = 1; break;
+    default: break;
     }
+}
+
+void GMALCall::Run()
+{
+    AL::ALProxy& proxy = _owner->_proxy;
 
-    _current_call = id;
+    try
+    {
+        switch (_arg_count)
+        {
+        case 1: _result = proxy.call<AL::ALValue>(_function, _args[0]); break;
+        case 2: _result = proxy.call<AL::ALValue>(_function, _args[0], _args[1]); break;
+        default: _result = proxy.call<AL::ALValue>(_function); break;
+        }
+    }
+    catch (const AL::ALError& e)
+    {
+        _failed = true;
+        _error = e.what();
+    }
 }
 
-bool GMALProxy::IsRunning()
+void GMALCall::Post(GMALCall* call)
+{
+    // the queue's reference, released once the call is delivered
+    call->AddRef();
+    ++call->_owner->_running_calls;
+
+    SDL_LockMutex(s_call_mutex);
+    s_queued_calls.push_back(call);
+    if (s_idle_call_threads < (int)s_queued_calls.size() && (int)s_call_threads.size() < s_max_call_threads)
+    {
+        s_call_threads.push_back(SDL_CreateThread(CallThread, NULL));
+        ++s_live_call_threads;
+    }
+    SDL_CondSignal(s_call_posted);
+    SDL_UnlockMutex(s_call_mutex);
+}
+
+void GMALCall::SetMaxThreads(int count)
+{
+    SDL_LockMutex(s_call_mutex);
+    s_max_call_threads = count > 0 ? count : 1;
+    SDL_UnlockMutex(s_call_mutex);
+}
+
+int GMALCall::CallThread(void* data)
+{
+    SDL_LockMutex(s_call_mutex);
+
+    while (true)
+    {
+        while (!s_quit_call_threads && s_queued_calls.empty())
+        {
+            ++s_idle_call_threads;
+            SDL_CondWait(s_call_posted, s_call_mutex);
+            --s_idle_call_threads;
+        }
+
+        if (s_quit_call_threads)
+            break;
+
+        GMALCall* call = s_queued_calls.front();
+        s_queued_calls.pop_front();
+
+        SDL_UnlockMutex(s_call_mutex);
+        call->Run();
+        SDL_LockMutex(s_call_mutex);
+
+        // a call that outlived Shutdown has no one to deliver it, it is left as it is
+        if (s_quit_call_threads)
+            break;
+
+        s_completed_calls.push_back(call);
+    }
+
+    --s_live_call_threads;
+    SDL_CondBroadcast(s_call_exited);
+    SDL_UnlockMutex(s_call_mutex);
+    return 0;
+}
+
+void GMALCall::DeliverCompleted(gmMachine* vm)
+{
+    std::vector<GMALCall*> completed;
+
+    SDL_LockMutex(s_call_mutex);
+    completed.swap(s_completed_calls);
+    SDL_UnlockMutex(s_call_mutex);
+
+    for (size_t i = 0; i < completed.size(); ++i)
+    {
+        GMALCall* call = completed[i];
+        call->_done = true;
+        --call->_owner->_running_calls;
+
+        // with only the queue's reference left the script dropped the call, nothing is blocked on it
+        if (call->RefCount() > 1 && call->_object)
+        {
+            vm->Signal(gmVariable(call->_object), GM_INVALID_THREAD, GM_INVALID_THREAD);
+        }
+
+        call->ReleaseRef();
+        if (call->RefCount() == 0) delete call;
+    }
+}
+
+void GMALCall::Shutdown(int waitMs)
 {
-    return _proxy.isRunning(_current_call);
+    SDL_LockMutex(s_call_mutex);
+    s_quit_call_threads = true;
+    SDL_CondBroadcast(s_call_posted);
+
+    // idle threads exit straight away, one in a call exits when the call returns
+    const Uint32 start = SDL_GetTicks();
+    while (s_live_call_threads > 0)
+    {
+        const int elapsed = (int)(SDL_GetTicks() - start);
+        if (elapsed >= waitMs)
+            break;
+        SDL_CondWaitTimeout(s_call_exited, s_call_mutex, waitMs - elapsed);
+    }
+    const int hung = s_live_call_threads;
+
+    std::vector<GMALCall*> calls(s_queued_calls.begin(), s_queued_calls.end());
+    calls.insert(calls.end(), s_completed_calls.begin(), s_completed_calls.end());
+    s_queued_calls.clear();
+    s_completed_calls.clear();
+    SDL_UnlockMutex(s_call_mutex);
+
+    // every thread has exited, or some are stuck in a call and none is joined
+    if (hung == 0)
+    {
+        for (size_t i = 0; i < s_call_threads.size(); ++i)
+        {
+            SDL_WaitThread(s_call_threads[i], NULL);
+        }
+    }
+    else
+    {
+        printf("GMALCall: %d calls still running at shutdown, not waiting for them\n", hung);
+    }
+    s_call_threads.clear();
+
+    for (size_t i = 0; i < calls.size(); ++i)
+    {
+        calls[i]->ReleaseRef();
+        if (calls[i]->RefCount() == 0) delete calls[i];
+    }
 }
 
 GM_BIND_DECL(GMALProxy);
@@ -150,7 +337,9 @@ GM_REG_NAMESPACE(GMALProxy)
         //GM_CHECK_STRING_PARAM(str, 1);
 
 		GM_GET_THIS_PTR(GMALProxy, self);
-		GM_AL_EXCEPTION_WRAPPER(self->PostCall(function, a_thread->Param(1)));
+        GMALCall* call = self->PostCall(function, a_thread->Param(1));
+        call->AddRef();
+        call->SetObject(a_thread->PushNewUser(call, GM_TYPEID(GMALCall)));
         return GM_OK;
     }
 
@@ -172,3 +361,54 @@ GM_REG_MEMFUNC( GMALProxy, IsRunning )
 GM_REG_MEM_END()
 
 GM_BIND_DEFINE(GMALProxy);
+
+GM_REG_NAMESPACE(GMALCall)
+{
+    GM_MEMFUNC_DECL(IsDone)
+    {
+        GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(GMALCall, self);
+        a_thread->PushInt(self->IsDone() ? 1 : 0);
+        return GM_OK;
+    }
+
+    GM_MEMFUNC_DECL(Error)
+    {
+        GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(GMALCall, self);
+        if (self->IsDone() && self->Failed()) a_thread->PushNewString(self->Error().c_str(), (int)self->Error().length());
+        else a_thread->PushNull();
+        return GM_OK;
+    }
+
+    GM_MEMFUNC_DECL(Result)
+    {
+        GM_CHECK_NUM_PARAMS(0);
+		GM_GET_THIS_PTR(GMALCall, self);
+
+        if (!self->IsDone())
+        {
+            GM_EXCEPTION_MSG("call has not completed, block() on it first");
+            return GM_EXCEPTION;
+        }
+
+        // as GM_AL_EXCEPTION_WRAPPER, the error is logged and the result is null
+        if (self->Failed())
+        {
+            GM_EXCEPTION_MSG("%s", self->Error().c_str());
+            return GM_OK;
+        }
+
+        a_thread->Push(GMALProxy::ToVariable(a_thread->GetMachine(), self->Result()));
+        return GM_OK;
+    }
+}
+
+GM_REG_MEM_BEGIN_NO_CONSTRUCTOR(GMALCall)
+GM_REG_MEMFUNC( GMALCall, IsDone )
+GM_REG_MEMFUNC( GMALCall, Error )
+GM_REG_MEMFUNC( GMALCall, Result )
+GM_REG_HANDLED_DESTRUCTORS(GMALCall)
+GM_REG_MEM_END()
+
+GM_BIND_DEFINE(GMALCall);
@@ -8,6 +8,8 @@
 
 using namespace funk;
 
+class GMALCall;
+
 class GMALProxy
     : public HandledObj<GMALProxy>
 {
@@ -19,13 +21,71 @@ public:
     gmVariable CallReturnVariable(const char* function, gmVariable arg);
     float CallReturnFloat(const char* function, gmVariable arg);
     void CallVoid(const char* function, gmVariable arg);
-    void PostCall(const char* function, gmVariable arg);
 
+    // the call runs on a thread of its own, the returned call is referenced by the caller
+    GMALCall* PostCall(const char* function, gmVariable arg);
+
+    // true while a posted call has not completed
     bool IsRunning();
 
+    static gmVariable ToVariable(gmMachine* vm, AL::ALValue result);
+
 private:
+    friend class GMALCall;
+
     AL::ALProxy _proxy;
-    int _current_call;
+    int _running_calls;
+};
+
+// a call posted on a GMALProxy. it runs on one of a pool of call threads, which grows
+// while every thread is busy up to SetMaxThreads, calls beyond that wait their turn.
+// completed calls are delivered on the main thread by DeliverCompleted, which signals
+// the call so a script thread can block() on it instead of polling
+class GMALCall
+    : public HandledObj<GMALCall>
+{
+public:
+    GM_BIND_TYPEID(GMALCall);
+
+    GMALCall(GMALProxy* proxy, const char* function, gmVariable arg);
+
+    bool IsDone() const { return _done; }
+    bool Failed() const { return _failed; }
+    const std::string& Error() const { return _error; }
+    const AL::ALValue& Result() const { return _result; }
+
+    // the user object scripts hold, signalled on completion
+    void SetObject(gmUserObject* object) { _object = object; }
+
+    // most calls in flight at once, a hung call holds its thread until it returns
+    static void SetMaxThreads(int count);
+    // main thread, once per frame after the gc marker stops and before the machine runs
+    static void DeliverCompleted(gmMachine* vm);
+    // joins the call threads, calls not yet started are dropped. threads still in a call
+    // after waitMs are left to finish on their own, so a hung call doesn't hang exit
+    static void Shutdown(int waitMs = 1000);
+
+private:
+    void Run();
+
+    static void Post(GMALCall* call);
+    static int CallThread(void* data);
+
+    StrongHandle<GMALProxy> _owner;
+    std::string _function;
+    int _arg_count;
+    AL::ALValue _args[2];
+
+    // written by the call thread before it lists the call as completed
+    AL::ALValue _result;
+    std::string _error;
+    bool _failed;
+
+    // main thread only
+    bool _done;
+    gmUserObject* _object;
+
+    friend class GMALProxy;
 };
 
 class GMALBulkMemoryProxy
@@ -41,3 +101,4 @@ private:
 };
 
 GM_BIND_DECL(GMALProxy);
+GM_BIND_DECL(GMALCall);
@@ -7,19 +7,41 @@
 #include "opencv_tests.h"
 #include "beat_detection.h"
 
+#include "gm/gmBenchLib.h"
+
+// hello-gm --bench binds the Benchmark lib the scripts in scripts/bench call
+static bool s_benchLib = false;
+
 void RegisterProjectLibs(gmMachine* vm)
 {
     RegisterGmFiltersLib(vm);
 
 	GM_BIND_INIT( GMALProxy, vm );
+	GM_BIND_INIT( GMALCall, vm );
 	GM_BIND_INIT( GMVideoDisplay, vm );
 	GM_BIND_INIT( GMOpenCVMat, vm );
 	GM_BIND_INIT( GMAudioStream, vm );
 	GM_BIND_INIT( NoteBrain, vm );
+
+	if (s_benchLib)
+	{
+		funk::gmBindBenchLib(vm);
+	}
 }
 
 int main(int argc, char** argv)
 {
+	// hello-gm --test <name> [args] runs one of the tests in tests.cpp instead of the app
+	if (argc > 2 && strcmp(argv[1], "--test") == 0)
+	{
+		return RunTest(argc - 2, argv + 2);
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--bench") == 0) s_benchLib = true;
+	}
+
 	funk::Core app;
 
 	app.HandleArgs(argc, argv);
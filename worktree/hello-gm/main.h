@@ -64,4 +64,7 @@
 
 #include "gmalproxy.h"
 
+// tests.cpp, argv[0] names the test
+int RunTest(int argc, char** argv);
+
 #endif // _MAIN_H
\ No newline at end of file
@@ -3,6 +3,8 @@
 //
 
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 
 #include <string>
 
@@ -26,6 +28,8 @@
 
 #include "gm/gmMachine.h"
 
+#include "gmalproxy.h"
+
 
 // no exception mode
 //#define MODULE_ERROR(description) do { printf(description); qi::os::exit(1); } while (0)
@@ -435,3 +439,195 @@ int testmain(int argc, char** argv)
 
     return 0;
 }
+
+// answers proxy calls after a delay, standing in for NAOqi modules on a local broker
+class MockALModule
+    : public AL::ALModule
+{
+public:
+    MockALModule(boost::shared_ptr<AL::ALBroker> broker, const std::string& name)
+        : AL::ALModule(broker, name)
+    {
+        setModuleDescription("Answers proxy calls after a delay, for testing without a robot.");
+
+        functionName("echo", getName(), "Returns its argument after 200 ms.");
+        addParam("value", "the string to return");
+        setReturn("value", "the argument");
+        BIND_METHOD(MockALModule::echo);
+
+        functionName("square", getName(), "Returns x * x after 100 ms.");
+        addParam("x", "the number to square");
+        setReturn("square", "x * x");
+        BIND_METHOD(MockALModule::square);
+
+        functionName("fail", getName(), "Throws an ALError.");
+        BIND_METHOD(MockALModule::fail);
+    }
+
+    virtual void init()
+    {
+    }
+
+    std::string echo(const std::string& value)
+    {
+        qi::os::msleep(200);
+        return value;
+    }
+
+    float square(const float& x)
+    {
+        qi::os::msleep(100);
+        return x * x;
+    }
+
+    void fail()
+    {
+        MODULE_ERROR("mock failure");
+    }
+};
+
+// checks one call recorded by testalcalls, returns 1 if it is wrong
+static int CheckALCall(gmMachine& vm, const char* key, gmVariable expected, const char* expected_error)
+{
+    gmTableObject* results = vm.GetGlobals()->Get(&vm, "results").GetTableObjectSafe();
+    gmTableObject* errors = vm.GetGlobals()->Get(&vm, "errors").GetTableObjectSafe();
+    if (!results || !errors)
+    {
+        printf("FAIL %s: the script did not run\n", key);
+        return 1;
+    }
+
+    const gmVariable result = results->Get(&vm, key);
+    const char* error = errors->Get(&vm, key).GetCStringSafe();
+
+    if (expected_error)
+    {
+        if (!strstr(error, expected_error))
+        {
+            printf("FAIL %s: expected an error containing '%s', got '%s'\n", key, expected_error, error);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (*error)
+    {
+        printf("FAIL %s: unexpected error '%s'\n", key, error);
+        return 1;
+    }
+
+    bool matches = false;
+    switch (expected.m_type)
+    {
+    case GM_STRING: matches = result.IsString() && strcmp(result.GetCStringSafe(), expected.GetCStringSafe()) == 0; break;
+    case GM_FLOAT: matches = result.IsNumber() && fabsf(result.GetFloatSafe() - expected.GetFloat()) < 0.0001f; break;
+    default: break;
+    }
+
+    if (!matches)
+    {
+        char buffer[64];
+        printf("FAIL %s: unexpected result '%s'\n", key, result.AsString(&vm, buffer, sizeof(buffer)));
+        return 1;
+    }
+    return 0;
+}
+
+// posts calls to MockALModule from script threads that block on them, all in flight at once
+int testalcalls(int argc, char** argv)
+{
+    const int port = 54010;
+
+    // each call sleeps at most 200 ms, a second is plenty even if they ran one after another
+    const int max_frames = 100;
+
+    AL::ALBrokerManager::getInstance()->killAllBroker();
+    AL::ALBroker::Ptr broker = AL::ALBroker::createBroker("mock", "127.0.0.1", port, "", 0);
+    AL::ALModule::createModule<MockALModule>(broker, "MockALModule");
+
+    gmMachine vm;
+    GM_BIND_INIT( GMALProxy, &vm );
+    GM_BIND_INIT( GMALCall, &vm );
+
+    int failures = vm.ExecuteString(
+        "global finished = 0;"
+        "global results = table();"
+        "global errors = table();"
+        "global proxy = GMALProxy(\"MockALModule\", \"127.0.0.1\", 54010);"
+        "global run = function(key, f, a)"
+        "{"
+        "    local call = proxy.PostCall(f, a);"
+        "    if (!call.IsDone()) { block(call); }"
+        "    local error = call.Error();"
+        "    if (error) { errors[key] = error; }"
+        "    else { results[key] = call.Result(); errors[key] = \"\"; }"
+        "    global finished = finished + 1;"
+        "};"
+        "thread(run, \"echo\", \"echo\", \"hello\");"
+        "thread(run, \"square3\", \"square\", 3.0);"
+        "thread(run, \"square4\", \"square\", 4.0);"
+        "thread(run, \"fail\", \"fail\");");
+
+    int frames = 0;
+    while (failures == 0 && vm.GetGlobals()->Get(&vm, "finished").GetIntSafe() < 4)
+    {
+        if (frames == max_frames)
+        {
+            printf("FAIL: only %d of 4 calls completed in %d frames\n", vm.GetGlobals()->Get(&vm, "finished").GetIntSafe(), frames);
+            ++failures;
+            break;
+        }
+
+        GMALCall::DeliverCompleted(&vm);
+        vm.Execute(10);
+        qi::os::msleep(10);
+        ++frames;
+    }
+
+    if (failures == 0)
+    {
+        // the calls overlap, so they take about as long as the slowest
+        printf("calls completed in %d frames\n", frames);
+
+        failures += CheckALCall(vm, "echo", gmVariable(vm.AllocStringObject("hello")), NULL);
+        failures += CheckALCall(vm, "square3", gmVariable(9.0f), NULL);
+        failures += CheckALCall(vm, "square4", gmVariable(16.0f), NULL);
+        failures += CheckALCall(vm, "fail", gmVariable::s_null, "mock failure");
+    }
+
+    bool first = true;
+    const char* msg;
+    while ((msg = vm.GetLog().GetEntry(first))) printf("%s", msg);
+
+    GMALCall::Shutdown();
+    broker->shutdown();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
+
+struct TestEntry
+{
+    const char* name;
+    int (*run)(int argc, char** argv);
+};
+
+static const TestEntry s_tests[] =
+{
+    { "nao", testmain },
+    { "alcalls", testalcalls },
+};
+
+// argv[0] is the test name, the rest are its own arguments
+int RunTest(int argc, char** argv)
+{
+    for (int i = 0; i < (int)ARRAY_COUNT(s_tests); ++i)
+    {
+        if (strcmp(argv[0], s_tests[i].name) == 0) return s_tests[i].run(argc, argv);
+    }
+
+    printf("unknown test '%s', one of:", argv[0]);
+    for (int i = 0; i < (int)ARRAY_COUNT(s_tests); ++i) printf(" %s", s_tests[i].name);
+    printf("\n");
+    return 1;
+}